@@ -0,0 +1,85 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.h"
+
+using namespace tonnerre_bench;
+
+static std::atomic<std::uint64_t> allocations(0);
+static std::atomic<std::uint64_t> bytesAllocated(0);
+
+//******************************************************************************
+
+static void* countedAllocation(std::size_t size) {
+   allocations.fetch_add(1, std::memory_order_relaxed);
+   bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+   return std::malloc(size > 0 ? size : 1);
+}
+
+//******************************************************************************
+
+std::uint64_t AllocationCounter::getAllocations() {
+   return allocations.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+std::uint64_t AllocationCounter::getBytes() {
+   return bytesAllocated.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+void* operator new(std::size_t size) {
+   void* p = countedAllocation(size);
+   if (p == nullptr) {
+      throw std::bad_alloc();
+   }
+   return p;
+}
+
+void* operator new[](std::size_t size) {
+   void* p = countedAllocation(size);
+   if (p == nullptr) {
+      throw std::bad_alloc();
+   }
+   return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+   return countedAllocation(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+   return countedAllocation(size);
+}
+
+void operator delete(void* p) noexcept {
+   std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+   std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+   std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+   std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+   std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+   std::free(p);
+}
+
+//******************************************************************************
@@ -0,0 +1,35 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_BENCH_ALLOCATIONCOUNTER_H
+#define TONNERRE_BENCH_ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+namespace tonnerre_bench {
+
+/**
+ * AllocationCounter counts calls to the global operator new and the bytes
+ * they ask for. Linking AllocationCounter.cpp into a program replaces the
+ * global allocation functions for the whole program, so only benchmarks
+ * link it.
+ */
+class AllocationCounter
+{
+public:
+   /**
+    * Retrieves the number of allocations made so far
+    * @return allocations since the program started
+    */
+   static std::uint64_t getAllocations();
+
+   /**
+    * Retrieves the number of bytes allocated so far
+    * @return bytes requested since the program started (frees aren't subtracted)
+    */
+   static std::uint64_t getBytes();
+};
+
+}
+
+#endif
@@ -0,0 +1,145 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BenchServer.h"
+#include "BenchUtils.h"
+#include "LoopbackBenchmark.h"
+#include "StrUtils.h"
+
+using namespace tonnerre;
+using namespace tonnerre_bench;
+using namespace chaudiere;
+
+static const int DEFAULT_PORT              = 34900;
+static const int DEFAULT_WARMUP_MILLIS     = 200;
+static const int DEFAULT_DURATION_MILLIS   = 1000;
+static const char* DEFAULT_OUTPUT_PATH     = "tonnerre_bench.jsonl";
+
+//******************************************************************************
+
+static void usage(const char* program) {
+   ::printf("usage: %s [options]\n"
+            "  --models=pool,workstealing,sharded,io_uring   server threading models\n"
+            "  --payloads=text,kvp                            payload types\n"
+            "  --sizes=64,1024,16384                          payload sizes in bytes\n"
+            "  --threads=1,4,16                               client thread counts\n"
+            "  --connections=persistent,transient             client connection reuse\n"
+            "  --warmup-ms=%d --duration-ms=%d              per scenario\n"
+            "  --port=%d                                   first server port\n"
+            "  --output=%s                  results (JSON Lines)\n"
+            "  --quick                                        small sweep, short runs\n",
+            program, DEFAULT_WARMUP_MILLIS, DEFAULT_DURATION_MILLIS,
+            DEFAULT_PORT, DEFAULT_OUTPUT_PATH);
+}
+
+//******************************************************************************
+
+int main(int argc, char* argv[]) {
+   std::vector<std::string> models = BenchServer::getThreadingModels();
+   std::vector<std::string> payloads = BenchUtils::split("text,kvp");
+   std::vector<int> sizes = BenchUtils::splitInts("64,1024,16384");
+   std::vector<int> threads = BenchUtils::splitInts("1,4,16");
+   std::vector<std::string> connections = BenchUtils::split("persistent,transient");
+   int warmupMillis = DEFAULT_WARMUP_MILLIS;
+   int durationMillis = DEFAULT_DURATION_MILLIS;
+   int port = DEFAULT_PORT;
+   std::string outputPath = DEFAULT_OUTPUT_PATH;
+
+   for (int i = 1; i < argc; ++i) {
+      std::string value;
+      const std::string name = BenchUtils::parseArgument(argv[i], value);
+
+      if (name == "--models") {
+         models = BenchUtils::split(value);
+      } else if (name == "--payloads") {
+         payloads = BenchUtils::split(value);
+      } else if (name == "--sizes") {
+         sizes = BenchUtils::splitInts(value);
+      } else if (name == "--threads") {
+         threads = BenchUtils::splitInts(value);
+      } else if (name == "--connections") {
+         connections = BenchUtils::split(value);
+      } else if (name == "--warmup-ms") {
+         warmupMillis = StrUtils::parseInt(value);
+      } else if (name == "--duration-ms") {
+         durationMillis = StrUtils::parseInt(value);
+      } else if (name == "--port") {
+         port = StrUtils::parseInt(value);
+      } else if (name == "--output") {
+         outputPath = value;
+      } else if (name == "--quick") {
+         sizes = BenchUtils::splitInts("64,4096");
+         threads = BenchUtils::splitInts("1,4");
+         warmupMillis = 50;
+         durationMillis = 250;
+      } else {
+         usage(argv[0]);
+         return (name == "--help") ? 0 : 1;
+      }
+   }
+
+   std::ofstream output(outputPath.c_str());
+   if (!output) {
+      ::fprintf(stderr, "unable to open %s\n", outputPath.c_str());
+      return 1;
+   }
+
+   // the servers are started up front, one port each, and left running
+   std::vector<std::unique_ptr<BenchServer>> servers;
+   for (const auto& model : models) {
+      servers.emplace_back(new BenchServer(model, port + (int) servers.size()));
+      if (!servers.back()->start()) {
+         ::fprintf(stderr, "unable to start '%s' server\n", model.c_str());
+         return 1;
+      }
+   }
+
+   int scenariosFailed = 0;
+
+   for (const auto& server : servers) {
+      for (const auto& payload : payloads) {
+         for (const int size : sizes) {
+            for (const int clientThreads : threads) {
+               for (const auto& connection : connections) {
+                  LoopbackBenchmark::Scenario scenario;
+                  scenario.threadingModel = server->getThreadingModel();
+                  scenario.port = server->getPort();
+                  scenario.payloadType =
+                     (payload == "kvp") ? MessageTypeKeyValues : MessageTypeText;
+                  scenario.payloadBytes = size;
+                  scenario.clientThreads = clientThreads;
+                  scenario.isPersistent = (connection != "transient");
+                  scenario.warmupMillis = warmupMillis;
+                  scenario.durationMillis = durationMillis;
+
+                  const LoopbackBenchmark::Result result = LoopbackBenchmark::run(scenario);
+                  if ((result.requests == 0) || (result.errors > 0)) {
+                     ++scenariosFailed;
+                  }
+
+                  ::printf("%s\n", LoopbackBenchmark::toString(scenario, result).c_str());
+                  ::fflush(stdout);
+                  output << LoopbackBenchmark::toJson(scenario, result) << "\n";
+               }
+            }
+         }
+      }
+   }
+
+   ::printf("results written to %s\n", outputPath.c_str());
+
+   // (the servers are still running; don't wait on them)
+   output.close();
+   servers.clear();
+   ::fflush(stdout);
+   std::_Exit(scenariosFailed > 0 ? 2 : 0);
+}
+
+//******************************************************************************
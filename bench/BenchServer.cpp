@@ -0,0 +1,178 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "BenchServer.h"
+#include "IoUring.h"
+#include "KeyValuePairs.h"
+#include "Logger.h"
+#include "MessageHandlerAdapter.h"
+#include "MessagingServer.h"
+
+using namespace tonnerre;
+using namespace tonnerre_bench;
+using namespace chaudiere;
+
+const std::string BenchServer::SERVICE_NAME            = "bench";
+const std::string BenchServer::REQUEST_NAME            = "echo";
+
+const std::string BenchServer::THREADING_POOL          = "pool";
+const std::string BenchServer::THREADING_WORK_STEALING = "workstealing";
+const std::string BenchServer::THREADING_SHARDED       = "sharded";
+const std::string BenchServer::THREADING_IO_URING      = "io_uring";
+
+static const int START_TIMEOUT_MILLIS = 5000;
+
+//******************************************************************************
+//******************************************************************************
+
+class EchoHandler : public MessageHandlerAdapter
+{
+public:
+   void handleTextMessage(const Message& requestMessage,
+                          Message& responseMessage,
+                          const std::string& requestName,
+                          const std::string& requestPayload,
+                          std::string& responsePayload) {
+      responsePayload = requestPayload;
+   }
+
+   void handleKeyValuesMessage(const Message& requestMessage,
+                               Message& responseMessage,
+                               const std::string& requestName,
+                               const KeyValuePairs& requestPayload,
+                               KeyValuePairs& responsePayload) {
+      responsePayload = requestPayload;
+   }
+};
+
+//******************************************************************************
+
+static bool isAccepting(int port) {
+   const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+   if (fd == -1) {
+      return false;
+   }
+
+   struct sockaddr_in address;
+   ::memset(&address, 0, sizeof(address));
+   address.sin_family = AF_INET;
+   address.sin_port = htons((unsigned short) port);
+   address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   const bool isConnected =
+      (::connect(fd, (struct sockaddr*) &address, sizeof(address)) == 0);
+   ::close(fd);
+   return isConnected;
+}
+
+//******************************************************************************
+
+std::vector<std::string> BenchServer::getThreadingModels() {
+   std::vector<std::string> models;
+   models.push_back(THREADING_POOL);
+   models.push_back(THREADING_WORK_STEALING);
+   models.push_back(THREADING_SHARDED);
+   if (IoUring::isSupported()) {
+      models.push_back(THREADING_IO_URING);
+   }
+   return models;
+}
+
+//******************************************************************************
+
+BenchServer::BenchServer(const std::string& threadingModel, int port) :
+   m_threadingModel(threadingModel),
+   m_configFilePath("/tmp/tonnerre_bench_" + std::to_string(::getpid()) +
+                    "_" + std::to_string(port) + ".ini"),
+   m_server(nullptr),
+   m_port(port) {
+   Logger::logInstanceCreate("BenchServer");
+}
+
+//******************************************************************************
+
+BenchServer::~BenchServer() {
+   Logger::logInstanceDestroy("BenchServer");
+   ::remove(m_configFilePath.c_str());
+}
+
+//******************************************************************************
+
+bool BenchServer::start() {
+   if (isAccepting(m_port)) {
+      Logger::error("bench port " + std::to_string(m_port) + " is already in use");
+      return false;
+   }
+
+   if (!writeConfigFile()) {
+      Logger::error("unable to write bench server config " + m_configFilePath);
+      return false;
+   }
+
+   // (shared by every server, and like them never torn down)
+   static EchoHandler echoHandler;
+   m_server = new MessagingServer(m_configFilePath, SERVICE_NAME, &echoHandler);
+
+   MessagingServer* server = m_server;
+   std::thread([server]() { server->run(); }).detach();
+
+   const std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(START_TIMEOUT_MILLIS);
+   while (std::chrono::steady_clock::now() < deadline) {
+      if (isAccepting(m_port)) {
+         return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+   }
+
+   Logger::error("bench server (" + m_threadingModel + ") did not start");
+   return false;
+}
+
+//******************************************************************************
+
+bool BenchServer::writeConfigFile() const {
+   std::ofstream config(m_configFilePath.c_str());
+   if (!config) {
+      return false;
+   }
+
+   config << "[server]\n";
+   config << "port = " << m_port << "\n";
+   // persistent clients send many requests per connection
+   config << "keep_alive = true\n";
+
+   if (m_threadingModel == THREADING_WORK_STEALING) {
+      config << "threading = workstealing\n";
+   } else if (m_threadingModel == THREADING_SHARDED) {
+      config << "threading = sharded\n";
+   } else if (m_threadingModel == THREADING_IO_URING) {
+      config << "io_backend = io_uring\n";
+   }
+
+   return config.good();
+}
+
+//******************************************************************************
+
+const std::string& BenchServer::getThreadingModel() const {
+   return m_threadingModel;
+}
+
+//******************************************************************************
+
+int BenchServer::getPort() const {
+   return m_port;
+}
+
+//******************************************************************************
@@ -0,0 +1,86 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_BENCH_BENCHSERVER_H
+#define TONNERRE_BENCH_BENCHSERVER_H
+
+#include <string>
+#include <vector>
+
+namespace tonnerre
+{
+   class MessagingServer;
+}
+
+namespace tonnerre_bench {
+
+/**
+ * BenchServer runs an in-process MessagingServer on loopback with one of
+ * the server threading models. Its service ('bench') echoes text and
+ * key/value payloads back unchanged. MessagingServer::run() doesn't return
+ * for every threading model, so a started server keeps running until the
+ * process exits.
+ */
+class BenchServer
+{
+public:
+   static const std::string SERVICE_NAME;
+   static const std::string REQUEST_NAME;
+
+   static const std::string THREADING_POOL;
+   static const std::string THREADING_WORK_STEALING;
+   static const std::string THREADING_SHARDED;
+   static const std::string THREADING_IO_URING;
+
+   /**
+    * Retrieves the threading models that can run on this host
+    * @return names of the threading models (io_uring only when supported)
+    */
+   static std::vector<std::string> getThreadingModels();
+
+   /**
+    * Constructs a server that has not been started
+    * @param threadingModel one of the THREADING_* names
+    * @param port the loopback port to listen on
+    */
+   BenchServer(const std::string& threadingModel, int port);
+
+   /**
+    * Destructor (removes the generated configuration file)
+    */
+   ~BenchServer();
+
+   /**
+    * Starts the server on a background thread and waits until it accepts
+    * connections
+    * @return boolean indicating if the server is accepting connections
+    */
+   bool start();
+
+   /**
+    * Retrieves the threading model
+    * @return the threading model name
+    */
+   const std::string& getThreadingModel() const;
+
+   /**
+    * Retrieves the port the server listens on
+    * @return the port
+    */
+   int getPort() const;
+
+private:
+   bool writeConfigFile() const;
+
+   std::string m_threadingModel;
+   std::string m_configFilePath;
+   tonnerre::MessagingServer* m_server;
+   int m_port;
+
+   BenchServer(const BenchServer&);
+   BenchServer& operator=(const BenchServer&);
+};
+
+}
+
+#endif
@@ -0,0 +1,54 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "BenchUtils.h"
+#include "StrUtils.h"
+
+using namespace tonnerre_bench;
+using namespace chaudiere;
+
+//******************************************************************************
+
+std::vector<std::string> BenchUtils::split(const std::string& list) {
+   std::vector<std::string> values;
+   std::string::size_type start = 0;
+   while (start <= list.length()) {
+      std::string::size_type end = list.find(',', start);
+      if (end == std::string::npos) {
+         end = list.length();
+      }
+      if (end > start) {
+         values.push_back(list.substr(start, end - start));
+      }
+      start = end + 1;
+   }
+   return values;
+}
+
+//******************************************************************************
+
+std::vector<int> BenchUtils::splitInts(const std::string& list) {
+   std::vector<int> values;
+   for (const auto& value : split(list)) {
+      const int parsed = StrUtils::parseInt(value);
+      if (parsed > 0) {
+         values.push_back(parsed);
+      }
+   }
+   return values;
+}
+
+//******************************************************************************
+
+std::string BenchUtils::parseArgument(const std::string& arg, std::string& value) {
+   const std::string::size_type equals = arg.find('=');
+   if (equals == std::string::npos) {
+      value.clear();
+      return arg;
+   }
+
+   value = arg.substr(equals + 1);
+   return arg.substr(0, equals);
+}
+
+//******************************************************************************
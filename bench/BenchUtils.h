@@ -0,0 +1,43 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_BENCH_BENCHUTILS_H
+#define TONNERRE_BENCH_BENCHUTILS_H
+
+#include <string>
+#include <vector>
+
+namespace tonnerre_bench {
+
+/**
+ * BenchUtils holds the command-line parsing shared by the benchmarks
+ */
+class BenchUtils
+{
+public:
+   /**
+    * Splits a comma-separated list (e.g., '--sizes=64,1024')
+    * @param list the list
+    * @return the non-empty values
+    */
+   static std::vector<std::string> split(const std::string& list);
+
+   /**
+    * Splits a comma-separated list of positive integers
+    * @param list the list
+    * @return the values (anything not a positive integer is skipped)
+    */
+   static std::vector<int> splitInts(const std::string& list);
+
+   /**
+    * Splits a '--name=value' argument
+    * @param arg the argument
+    * @param value set to the text after '=' (empty if there is none)
+    * @return the name, including the leading dashes
+    */
+   static std::string parseArgument(const std::string& arg, std::string& value);
+};
+
+}
+
+#endif
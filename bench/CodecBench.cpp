@@ -0,0 +1,231 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "BenchUtils.h"
+#include "KeyValuePairs.h"
+#include "Message.h"
+#include "Microbenchmark.h"
+#include "Socket.h"
+#include "StrUtils.h"
+
+using namespace tonnerre;
+using namespace tonnerre_bench;
+using namespace chaudiere;
+
+static const int DEFAULT_MIN_MILLIS        = 200;
+static const int DEFAULT_VALUE_BYTES       = 16;
+static const char* DEFAULT_OUTPUT_PATH     = "tonnerre_codec_bench.jsonl";
+
+// Message::reconstitute reads at most 32K of headers or payload from a
+// socket (and a frame this size fits in the socket buffers)
+static const int MAX_SOCKET_FRAME_BYTES    = 32768;
+
+//******************************************************************************
+
+/**
+ * SocketPairSource feeds encoded frames to Message::reconstitute through a
+ * connected socket pair: the frame is written to one end and read back
+ * from the other by a chaudiere::Socket.
+ */
+class SocketPairSource
+{
+public:
+   SocketPairSource() :
+      m_writeFd(-1) {
+      int fds[2];
+      if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0) {
+         m_readSocket.reset(new Socket(fds[0]));
+         m_writeFd = fds[1];
+      }
+   }
+
+   ~SocketPairSource() {
+      if (m_writeFd != -1) {
+         ::close(m_writeFd);
+      }
+   }
+
+   bool isOpen() const {
+      return m_readSocket != nullptr;
+   }
+
+   Socket* feed(const std::string& frame) {
+      std::size_t offset = 0;
+      while (offset < frame.length()) {
+         const ssize_t written =
+            ::write(m_writeFd, frame.data() + offset, frame.length() - offset);
+         if (written <= 0) {
+            break;
+         }
+         offset += (std::size_t) written;
+      }
+      return m_readSocket.get();
+   }
+
+private:
+   std::unique_ptr<Socket> m_readSocket;
+   int m_writeFd;
+
+   SocketPairSource(const SocketPairSource&);
+   SocketPairSource& operator=(const SocketPairSource&);
+};
+
+//******************************************************************************
+
+static void makePairs(int pairCount, int valueBytes, KeyValuePairs& kvp) {
+   kvp.clear();
+   for (int i = 0; i < pairCount; ++i) {
+      kvp.addPair("key" + std::to_string(i), std::string(valueBytes, 'v'));
+   }
+}
+
+//******************************************************************************
+
+static void usage(const char* program) {
+   ::printf("usage: %s [options]\n"
+            "  --text-sizes=16,1024,65536   text payload sizes in bytes\n"
+            "  --pair-counts=1,8,64         key/value pairs per payload\n"
+            "  --value-bytes=%d             length of each value\n"
+            "  --min-ms=%d                 minimum time per measurement\n"
+            "  --filter=NAME                only benchmarks whose name contains NAME\n"
+            "  --output=%s  results (JSON Lines)\n",
+            program, DEFAULT_VALUE_BYTES, DEFAULT_MIN_MILLIS, DEFAULT_OUTPUT_PATH);
+}
+
+//******************************************************************************
+
+int main(int argc, char* argv[]) {
+   std::vector<int> textSizes = BenchUtils::splitInts("16,1024,65536");
+   std::vector<int> pairCounts = BenchUtils::splitInts("1,8,64");
+   int valueBytes = DEFAULT_VALUE_BYTES;
+   int minMillis = DEFAULT_MIN_MILLIS;
+   std::string filter;
+   std::string outputPath = DEFAULT_OUTPUT_PATH;
+
+   for (int i = 1; i < argc; ++i) {
+      std::string value;
+      const std::string name = BenchUtils::parseArgument(argv[i], value);
+
+      if (name == "--text-sizes") {
+         textSizes = BenchUtils::splitInts(value);
+      } else if (name == "--pair-counts") {
+         pairCounts = BenchUtils::splitInts(value);
+      } else if (name == "--value-bytes") {
+         valueBytes = StrUtils::parseInt(value);
+      } else if (name == "--min-ms") {
+         minMillis = StrUtils::parseInt(value);
+      } else if (name == "--filter") {
+         filter = value;
+      } else if (name == "--output") {
+         outputPath = value;
+      } else {
+         usage(argv[0]);
+         return (name == "--help") ? 0 : 1;
+      }
+   }
+
+   std::ofstream output(outputPath.c_str());
+   if (!output) {
+      ::fprintf(stderr, "unable to open %s\n", outputPath.c_str());
+      return 1;
+   }
+
+   SocketPairSource socketPair;
+   if (!socketPair.isOpen()) {
+      ::fprintf(stderr, "unable to create socket pair\n");
+      return 1;
+   }
+
+   const Microbenchmark microbenchmark(minMillis);
+   std::vector<Microbenchmark::Result> results;
+
+   auto run = [&](const std::string& name, const std::string& params, auto op) {
+      if (!filter.empty() && (name.find(filter) == std::string::npos)) {
+         return;
+      }
+      const Microbenchmark::Result result = microbenchmark.measure(name, params, op);
+      ::printf("%s\n", Microbenchmark::toString(result).c_str());
+      ::fflush(stdout);
+      output << Microbenchmark::toJson(result) << "\n";
+   };
+
+   for (const std::size_t length : { (std::size_t) 7, (std::size_t) 65536, (std::size_t) 1234567890 }) {
+      run("Message::encodeLength", "length=" + std::to_string(length), [length]() {
+         Microbenchmark::keep(Message::encodeLength(length));
+      });
+   }
+
+   for (const int pairCount : pairCounts) {
+      KeyValuePairs kvp;
+      makePairs(pairCount, valueBytes, kvp);
+      const std::string params = "pairs=" + std::to_string(pairCount) +
+                                 " value=" + std::to_string(valueBytes);
+      const std::string encodedPairs = Message::toString(kvp);
+
+      run("Message::toString(KeyValuePairs)", params, [&kvp]() {
+         Microbenchmark::keep(Message::toString(kvp));
+      });
+
+      run("Message::fromString", params, [&encodedPairs]() {
+         KeyValuePairs decoded;
+         Microbenchmark::keep(Message::fromString(encodedPairs, decoded));
+      });
+
+      Message message("lookup", MessageTypeKeyValues);
+      message.setKeyValuesPayload(kvp);
+      const std::string frame = message.toString();
+
+      run("Message::toString", "kvp " + params, [&message]() {
+         Microbenchmark::keep(message.toString());
+      });
+
+      run("Message::reconstituteFromFrame", "kvp " + params, [&frame]() {
+         Message decoded;
+         Microbenchmark::keep(decoded.reconstituteFromFrame(frame));
+      });
+
+      if ((int) frame.length() <= MAX_SOCKET_FRAME_BYTES) {
+         run("Message::reconstitute(socketpair)", "kvp " + params, [&frame, &socketPair]() {
+            Message decoded;
+            Microbenchmark::keep(decoded.reconstitute(socketPair.feed(frame)));
+         });
+      }
+   }
+
+   for (const int textSize : textSizes) {
+      Message message("lookup", MessageTypeText);
+      message.setTextPayload(std::string(textSize, 'x'));
+      const std::string params = "text bytes=" + std::to_string(textSize);
+      const std::string frame = message.toString();
+
+      run("Message::toString", params, [&message]() {
+         Microbenchmark::keep(message.toString());
+      });
+
+      run("Message::reconstituteFromFrame", params, [&frame]() {
+         Message decoded;
+         Microbenchmark::keep(decoded.reconstituteFromFrame(frame));
+      });
+
+      if ((int) frame.length() <= MAX_SOCKET_FRAME_BYTES) {
+         run("Message::reconstitute(socketpair)", params, [&frame, &socketPair]() {
+            Message decoded;
+            Microbenchmark::keep(decoded.reconstitute(socketPair.feed(frame)));
+         });
+      }
+   }
+
+   ::printf("results written to %s\n", outputPath.c_str());
+   return 0;
+}
+
+//******************************************************************************
@@ -0,0 +1,124 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "LoadGenerator.h"
+#include "LoadScenario.h"
+#include "StrUtils.h"
+
+using namespace tonnerre_bench;
+using namespace chaudiere;
+
+//******************************************************************************
+
+static void usage(const char* program) {
+   ::printf("usage: %s --scenario=path [options]\n"
+            "  --scenario=loadgen.ini      server, rate and request mix (INI)\n"
+            "  --host=address --port=n     override the scenario's server\n"
+            "  --rate=n                    override the target requests per second\n"
+            "  --connections=n             override the number of connections\n"
+            "  --duration-s=n --warmup-s=n override the run length\n"
+            "  --output=path               also write the result (JSON Lines)\n"
+            "  --histogram=path            also write the latency histogram (CSV)\n",
+            program);
+}
+
+//******************************************************************************
+
+int main(int argc, char* argv[]) {
+   std::string scenarioPath;
+   std::string outputPath;
+   std::string histogramPath;
+   std::vector<std::pair<std::string, std::string>> overrides;
+
+   for (int i = 1; i < argc; ++i) {
+      std::string value;
+      const std::string name = BenchUtils::parseArgument(argv[i], value);
+
+      if (name == "--scenario") {
+         scenarioPath = value;
+      } else if (name == "--output") {
+         outputPath = value;
+      } else if (name == "--histogram") {
+         histogramPath = value;
+      } else if ((name == "--host") || (name == "--port") || (name == "--rate") ||
+                 (name == "--connections") || (name == "--duration-s") ||
+                 (name == "--warmup-s")) {
+         overrides.push_back(std::make_pair(name, value));
+      } else {
+         usage(argv[0]);
+         return (name == "--help") ? 0 : 1;
+      }
+   }
+
+   if (scenarioPath.empty()) {
+      usage(argv[0]);
+      return 1;
+   }
+
+   LoadScenario scenario;
+   if (!scenario.load(scenarioPath)) {
+      ::fprintf(stderr, "%s\n", scenario.getError().c_str());
+      return 1;
+   }
+
+   LoadScenario::Settings& settings = scenario.getSettings();
+   for (const auto& override : overrides) {
+      if (override.first == "--host") {
+         settings.host = override.second;
+      } else if (override.first == "--port") {
+         settings.port = StrUtils::parseInt(override.second);
+      } else if (override.first == "--rate") {
+         settings.rate = StrUtils::parseInt(override.second);
+      } else if (override.first == "--connections") {
+         settings.connections = StrUtils::parseInt(override.second);
+      } else if (override.first == "--duration-s") {
+         settings.durationSeconds = StrUtils::parseInt(override.second);
+      } else if (override.first == "--warmup-s") {
+         settings.warmupSeconds = StrUtils::parseInt(override.second);
+      }
+   }
+
+   if ((settings.rate <= 0) || (settings.connections <= 0) ||
+       (settings.durationSeconds <= 0) || (settings.warmupSeconds < 0)) {
+      ::fprintf(stderr, "rate, connections and duration must be positive\n");
+      return 1;
+   }
+
+   const LoadGenerator::Result result = LoadGenerator::run(scenario);
+   ::printf("%s", LoadGenerator::toString(scenario, result).c_str());
+
+   if (!outputPath.empty()) {
+      std::ofstream output(outputPath.c_str(), std::ios::app);
+      if (!output) {
+         ::fprintf(stderr, "unable to open %s\n", outputPath.c_str());
+         return 1;
+      }
+      output << LoadGenerator::toJson(scenario, result) << "\n";
+   }
+
+   if (!histogramPath.empty()) {
+      std::ofstream histogram(histogramPath.c_str());
+      if (!histogram) {
+         ::fprintf(stderr, "unable to open %s\n", histogramPath.c_str());
+         return 1;
+      }
+      histogram << LoadGenerator::toCsv(result.latency);
+   }
+
+   if (result.connectionsOpened == 0) {
+      ::fprintf(stderr, "unable to connect to %s:%d\n",
+                settings.host.c_str(), settings.port);
+      return 2;
+   }
+
+   return (result.completed > 0) ? 0 : 2;
+}
+
+//******************************************************************************
@@ -0,0 +1,411 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <sys/socket.h>
+
+#include "LoadGenerator.h"
+#include "BasicException.h"
+#include "Message.h"
+#include "Socket.h"
+
+using namespace tonnerre;
+using namespace tonnerre_bench;
+using namespace chaudiere;
+
+typedef std::chrono::steady_clock Clock;
+
+static const double PERCENTILES[] = { 50.0, 75.0, 90.0, 99.0, 99.9, 99.99 };
+static const int NUMBER_PERCENTILES = sizeof(PERCENTILES) / sizeof(PERCENTILES[0]);
+
+namespace {
+
+struct InFlight {
+   Clock::time_point intendedAt;
+   Clock::time_point sentAt;
+   int requestIndex;
+   bool isMeasured;
+};
+
+// one pipelined connection: the sender appends to inFlight before each
+// write, and the reader pops the oldest entry for each response
+struct Connection {
+   std::unique_ptr<Socket> socket;
+   std::mutex mutex;
+   std::deque<InFlight> inFlight;
+   std::atomic<bool> isBroken;
+   LoadGenerator::Result result;
+
+   Connection() : isBroken(false) {}
+};
+
+std::uint64_t elapsedMicros(Clock::time_point from, Clock::time_point to) {
+   return (to > from) ?
+      std::chrono::duration_cast<std::chrono::microseconds>(to - from).count() : 0;
+}
+
+}
+
+//******************************************************************************
+
+LoadGenerator::Result::Result() :
+   sent(0),
+   completed(0),
+   overloaded(0),
+   errors(0),
+   timedOut(0),
+   connectionsOpened(0),
+   elapsedSeconds(0.0) {
+}
+
+//******************************************************************************
+
+double LoadGenerator::Result::getRequestsPerSecond() const {
+   return (elapsedSeconds > 0.0) ? completed / elapsedSeconds : 0.0;
+}
+
+//******************************************************************************
+
+static void sendRequests(const LoadScenario& scenario,
+                         Connection& connection,
+                         int connectionIndex,
+                         Clock::time_point startAt,
+                         Clock::time_point measureAt,
+                         Clock::time_point endAt) {
+   const LoadScenario::Settings& settings = scenario.getSettings();
+   const std::chrono::nanoseconds interval(
+      (std::int64_t) (1.0e9 * settings.connections / settings.rate));
+   // stagger the connections so the requests are evenly spread
+   const Clock::time_point firstAt =
+      startAt + (interval * connectionIndex) / settings.connections;
+
+   std::minstd_rand rng(settings.seed + connectionIndex);
+   std::uint64_t sequence = connectionIndex;
+
+   for (std::uint64_t i = 0; ; ++i) {
+      const Clock::time_point intendedAt = firstAt + interval * (std::int64_t) i;
+      if (intendedAt >= endAt) {
+         break;
+      }
+
+      // when behind schedule, send straight away until caught up
+      std::this_thread::sleep_until(intendedAt);
+
+      const bool isMeasured = (intendedAt >= measureAt);
+      const int requestIndex = scenario.pick(rng);
+
+      if (connection.isBroken.load()) {
+         // a request that couldn't be sent still counts against the schedule
+         if (isMeasured) {
+            std::lock_guard<std::mutex> lock(connection.mutex);
+            ++connection.result.errors;
+         }
+         continue;
+      }
+
+      const std::string frame = scenario.encode(requestIndex, sequence, rng);
+      sequence += settings.connections;
+
+      InFlight request;
+      request.intendedAt = intendedAt;
+      request.sentAt = Clock::now();
+      request.requestIndex = requestIndex;
+      request.isMeasured = isMeasured;
+
+      {
+         std::lock_guard<std::mutex> lock(connection.mutex);
+         connection.inFlight.push_back(request);
+         if (isMeasured) {
+            ++connection.result.sent;
+         }
+      }
+
+      if (!connection.socket->write(frame)) {
+         connection.isBroken.store(true);
+      }
+   }
+}
+
+//******************************************************************************
+
+static void readResponses(Connection& connection) {
+   for (;;) {
+      Message response;
+      const bool isRead = response.reconstitute(connection.socket.get());
+      const Clock::time_point receivedAt = Clock::now();
+
+      std::lock_guard<std::mutex> lock(connection.mutex);
+      if (!isRead || connection.inFlight.empty()) {
+         // (requests still in flight are counted once the run is over)
+         connection.isBroken.store(true);
+         break;
+      }
+
+      const InFlight request = connection.inFlight.front();
+      connection.inFlight.pop_front();
+      if (!request.isMeasured) {
+         continue;
+      }
+
+      LoadGenerator::Result& result = connection.result;
+      if (response.isOverloaded()) {
+         ++result.overloaded;
+      } else {
+         ++result.completed;
+         const std::uint64_t latency = elapsedMicros(request.intendedAt, receivedAt);
+         result.latency.record(latency);
+         result.serviceTime.record(elapsedMicros(request.sentAt, receivedAt));
+         result.latencyByRequest[request.requestIndex].record(latency);
+      }
+   }
+}
+
+//******************************************************************************
+
+LoadGenerator::Result LoadGenerator::run(const LoadScenario& scenario) {
+   const LoadScenario::Settings& settings = scenario.getSettings();
+   const std::size_t numberRequests = scenario.getRequests().size();
+
+   Result result;
+   result.latencyByRequest.resize(numberRequests);
+
+   std::vector<std::unique_ptr<Connection>> connections;
+   for (int i = 0; i < settings.connections; ++i) {
+      std::unique_ptr<Connection> connection(new Connection);
+      connection->result.latencyByRequest.resize(numberRequests);
+      try {
+         connection->socket.reset(new Socket(settings.host, settings.port));
+      } catch (const BasicException&) {
+         connection->socket.reset();
+      }
+
+      if ((connection->socket == nullptr) || !connection->socket->isConnected()) {
+         connection->socket.reset();
+         connection->isBroken.store(true);
+      } else {
+         connection->socket->setTcpNoDelay(true);
+         ++result.connectionsOpened;
+      }
+      connections.push_back(std::move(connection));
+   }
+
+   const Clock::time_point startAt = Clock::now() + std::chrono::milliseconds(10);
+   const Clock::time_point measureAt = startAt + std::chrono::seconds(settings.warmupSeconds);
+   const Clock::time_point endAt = measureAt + std::chrono::seconds(settings.durationSeconds);
+
+   std::vector<std::thread> threads;
+   for (int i = 0; i < settings.connections; ++i) {
+      Connection& connection = *connections[i];
+      if (connection.socket != nullptr) {
+         threads.emplace_back(readResponses, std::ref(connection));
+      }
+      threads.emplace_back(sendRequests, std::cref(scenario), std::ref(connection),
+                           i, startAt, measureAt, endAt);
+   }
+
+   // wait out the schedule, then give the last responses a chance to arrive
+   std::this_thread::sleep_until(endAt);
+   const Clock::time_point drainUntil = endAt + std::chrono::seconds(settings.drainSeconds);
+   for (const auto& connection : connections) {
+      for (;;) {
+         {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            if (connection->inFlight.empty() || connection->isBroken.load()) {
+               break;
+            }
+         }
+         if (Clock::now() >= drainUntil) {
+            break;
+         }
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+   }
+
+   result.elapsedSeconds = settings.durationSeconds;
+
+   // requests left on a connection that failed are errors, not time-outs
+   std::vector<bool> isBroken;
+   for (const auto& connection : connections) {
+      isBroken.push_back(connection->isBroken.load());
+   }
+
+   // unblock the readers still waiting on a response
+   for (const auto& connection : connections) {
+      if (connection->socket != nullptr) {
+         ::shutdown(connection->socket->getFileDescriptor(), SHUT_RDWR);
+      }
+   }
+
+   for (auto& thread : threads) {
+      thread.join();
+   }
+
+   for (std::size_t c = 0; c < connections.size(); ++c) {
+      const Connection& connection = *connections[c];
+      const Result& connectionResult = connection.result;
+      result.sent += connectionResult.sent;
+      result.completed += connectionResult.completed;
+      result.overloaded += connectionResult.overloaded;
+      result.errors += connectionResult.errors;
+      result.latency.merge(connectionResult.latency);
+      result.serviceTime.merge(connectionResult.serviceTime);
+      for (std::size_t i = 0; i < numberRequests; ++i) {
+         result.latencyByRequest[i].merge(connectionResult.latencyByRequest[i]);
+      }
+
+      for (const auto& request : connection.inFlight) {
+         if (request.isMeasured) {
+            if (isBroken[c]) {
+               ++result.errors;
+            } else {
+               ++result.timedOut;
+            }
+         }
+      }
+   }
+
+   return result;
+}
+
+//******************************************************************************
+
+std::string LoadGenerator::toJson(const LoadScenario& scenario, const Result& result) {
+   const LoadScenario::Settings& settings = scenario.getSettings();
+   char buffer[1024];
+   ::snprintf(buffer, sizeof(buffer),
+              "{\"host\":\"%s\",\"port\":%d,\"target_rate\":%d,\"connections\":%d,"
+              "\"duration_s\":%d,\"sent\":%llu,\"completed\":%llu,\"overloaded\":%llu,"
+              "\"errors\":%llu,\"timed_out\":%llu,\"requests_per_sec\":%.1f,",
+              settings.host.c_str(),
+              settings.port,
+              settings.rate,
+              settings.connections,
+              settings.durationSeconds,
+              (unsigned long long) result.sent,
+              (unsigned long long) result.completed,
+              (unsigned long long) result.overloaded,
+              (unsigned long long) result.errors,
+              (unsigned long long) result.timedOut,
+              result.getRequestsPerSecond());
+   std::string json = buffer;
+
+   const tonnerre::LatencyHistogram* histograms[] = { &result.latency, &result.serviceTime };
+   const char* names[] = { "latency_us", "service_time_us" };
+   for (int h = 0; h < 2; ++h) {
+      ::snprintf(buffer, sizeof(buffer), "\"%s\":{\"mean\":%.1f", names[h],
+                 histograms[h]->getMean());
+      json += buffer;
+      for (int i = 0; i < NUMBER_PERCENTILES; ++i) {
+         ::snprintf(buffer, sizeof(buffer), ",\"p%g\":%llu", PERCENTILES[i],
+                    (unsigned long long) histograms[h]->getValueAtPercentile(PERCENTILES[i]));
+         json += buffer;
+      }
+      ::snprintf(buffer, sizeof(buffer), ",\"max\":%llu},",
+                 (unsigned long long) histograms[h]->getMax());
+      json += buffer;
+   }
+
+   json += "\"requests\":{";
+   const std::vector<LoadScenario::RequestTemplate>& requests = scenario.getRequests();
+   for (std::size_t i = 0; i < requests.size(); ++i) {
+      const tonnerre::LatencyHistogram& latency = result.latencyByRequest[i];
+      ::snprintf(buffer, sizeof(buffer),
+                 "%s\"%s\":{\"completed\":%llu,\"p50\":%llu,\"p99\":%llu,\"max\":%llu}",
+                 (i > 0) ? "," : "",
+                 requests[i].name.c_str(),
+                 (unsigned long long) latency.getCount(),
+                 (unsigned long long) latency.getValueAtPercentile(50.0),
+                 (unsigned long long) latency.getValueAtPercentile(99.0),
+                 (unsigned long long) latency.getMax());
+      json += buffer;
+   }
+   json += "}}";
+
+   return json;
+}
+
+//******************************************************************************
+
+std::string LoadGenerator::toString(const LoadScenario& scenario, const Result& result) {
+   const LoadScenario::Settings& settings = scenario.getSettings();
+   char buffer[256];
+   ::snprintf(buffer, sizeof(buffer),
+              "target %d req/s over %d connections (%d open) for %ds: "
+              "%.0f req/s completed\n"
+              "sent=%llu completed=%llu overloaded=%llu errors=%llu timed_out=%llu\n\n",
+              settings.rate,
+              settings.connections,
+              result.connectionsOpened,
+              settings.durationSeconds,
+              result.getRequestsPerSecond(),
+              (unsigned long long) result.sent,
+              (unsigned long long) result.completed,
+              (unsigned long long) result.overloaded,
+              (unsigned long long) result.errors,
+              (unsigned long long) result.timedOut);
+   std::string report = buffer;
+
+   ::snprintf(buffer, sizeof(buffer), "%-10s %14s %14s\n",
+              "percentile", "latency_us", "service_us");
+   report += buffer;
+   for (int i = 0; i < NUMBER_PERCENTILES; ++i) {
+      ::snprintf(buffer, sizeof(buffer), "%-10g %14llu %14llu\n",
+                 PERCENTILES[i],
+                 (unsigned long long) result.latency.getValueAtPercentile(PERCENTILES[i]),
+                 (unsigned long long) result.serviceTime.getValueAtPercentile(PERCENTILES[i]));
+      report += buffer;
+   }
+   ::snprintf(buffer, sizeof(buffer), "%-10s %14llu %14llu\n\n", "max",
+              (unsigned long long) result.latency.getMax(),
+              (unsigned long long) result.serviceTime.getMax());
+   report += buffer;
+
+   const std::vector<LoadScenario::RequestTemplate>& requests = scenario.getRequests();
+   for (std::size_t i = 0; i < requests.size(); ++i) {
+      const tonnerre::LatencyHistogram& latency = result.latencyByRequest[i];
+      ::snprintf(buffer, sizeof(buffer),
+                 "%-20s %10llu completed  p50=%lluus p99=%lluus p999=%lluus max=%lluus\n",
+                 requests[i].name.c_str(),
+                 (unsigned long long) latency.getCount(),
+                 (unsigned long long) latency.getValueAtPercentile(50.0),
+                 (unsigned long long) latency.getValueAtPercentile(99.0),
+                 (unsigned long long) latency.getValueAtPercentile(99.9),
+                 (unsigned long long) latency.getMax());
+      report += buffer;
+   }
+
+   return report;
+}
+
+//******************************************************************************
+
+std::string LoadGenerator::toCsv(const tonnerre::LatencyHistogram& histogram) {
+   std::string csv = "upper_bound_us,count,cumulative_fraction\n";
+   const std::uint64_t total = histogram.getCount();
+   std::uint64_t cumulative = 0;
+   char buffer[128];
+
+   for (int i = 0; i < LatencyHistogram::NUMBER_BUCKETS; ++i) {
+      const std::uint64_t count = histogram.getBucketCount(i);
+      if (count == 0) {
+         continue;
+      }
+
+      cumulative += count;
+      ::snprintf(buffer, sizeof(buffer), "%llu,%llu,%.6f\n",
+                 (unsigned long long) LatencyHistogram::bucketUpperBound(i),
+                 (unsigned long long) count,
+                 (double) cumulative / total);
+      csv += buffer;
+   }
+
+   return csv;
+}
+
+//******************************************************************************
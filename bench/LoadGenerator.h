@@ -0,0 +1,79 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_BENCH_LOADGENERATOR_H
+#define TONNERRE_BENCH_LOADGENERATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "LatencyHistogram.h"
+#include "LoadScenario.h"
+
+namespace tonnerre_bench {
+
+/**
+ * LoadGenerator drives a server open loop: requests are sent on a fixed
+ * schedule (rate / connections apart on each connection) whether or not
+ * earlier ones have been answered, and are pipelined on each connection,
+ * with a reader thread per connection matching responses to requests in
+ * order. Latency is measured from when a request was due to be sent, not
+ * from when it was written, so a stalled server (or a backed-up connection)
+ * is charged for the requests it held up -- the correction for coordinated
+ * omission. The time from the actual write is kept as well, for comparison.
+ */
+class LoadGenerator
+{
+public:
+   struct Result {
+      std::uint64_t sent;
+      std::uint64_t completed;
+      std::uint64_t overloaded;   // shed by the server
+      std::uint64_t errors;       // not written, or the connection failed
+      std::uint64_t timedOut;     // no response by the end of the drain
+      int connectionsOpened;
+      double elapsedSeconds;
+      tonnerre::LatencyHistogram latency;      // from the intended send time
+      tonnerre::LatencyHistogram serviceTime;  // from the actual write
+      std::vector<tonnerre::LatencyHistogram> latencyByRequest;
+
+      Result();
+      double getRequestsPerSecond() const;
+   };
+
+   /**
+    * Runs a scenario (warm-up, measured period, then the drain)
+    * @param scenario what to send, and where
+    * @return counts and latencies of the requests due in the measured period
+    */
+   static Result run(const LoadScenario& scenario);
+
+   /**
+    * Formats a result as a single-line JSON object
+    * @param scenario the scenario that was run
+    * @param result its result
+    * @return the JSON text (no trailing newline)
+    */
+   static std::string toJson(const LoadScenario& scenario, const Result& result);
+
+   /**
+    * Formats a result for a human reader, with a percentile table
+    * @param scenario the scenario that was run
+    * @param result its result
+    * @return the report (ending in a newline)
+    */
+   static std::string toString(const LoadScenario& scenario, const Result& result);
+
+   /**
+    * Formats a histogram as CSV: each non-empty bucket's upper bound, count
+    * and the cumulative fraction of values at or below it
+    * @param histogram the histogram
+    * @return the CSV text, with a header line
+    */
+   static std::string toCsv(const tonnerre::LatencyHistogram& histogram);
+};
+
+}
+
+#endif
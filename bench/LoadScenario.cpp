@@ -0,0 +1,238 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "LoadScenario.h"
+#include "IniReader.h"
+#include "KeyValuePairs.h"
+#include "StrUtils.h"
+
+using namespace tonnerre;
+using namespace tonnerre_bench;
+using namespace chaudiere;
+
+static const std::string SECTION_LOADGEN    = "loadgen";
+static const std::string SECTION_REQUESTS   = "requests";
+
+static const std::string KEY_CONNECTIONS    = "connections";
+static const std::string KEY_DRAIN_S        = "drain_s";
+static const std::string KEY_DURATION_S     = "duration_s";
+static const std::string KEY_HOST           = "host";
+static const std::string KEY_PAYLOAD        = "payload";
+static const std::string KEY_PORT           = "port";
+static const std::string KEY_RATE           = "rate";
+static const std::string KEY_REQUEST        = "request";
+static const std::string KEY_SEED           = "seed";
+static const std::string KEY_SERVICE        = "service";
+static const std::string KEY_TYPE           = "type";
+static const std::string KEY_WARMUP_S       = "warmup_s";
+static const std::string KEY_WEIGHT         = "weight";
+
+static const std::string VALUE_KVP          = "kvp";
+
+static const std::string PLACEHOLDER_SEQ    = "${seq}";
+static const std::string PLACEHOLDER_RANDOM = "${random:";
+
+//******************************************************************************
+
+static int intValue(const KeyValuePairs& kvp, const std::string& key, int defaultValue) {
+   return kvp.hasKey(key) ? StrUtils::parseInt(kvp.getValue(key)) : defaultValue;
+}
+
+//******************************************************************************
+
+LoadScenario::LoadScenario() {
+   m_settings.host = "127.0.0.1";
+   m_settings.port = 9000;
+   m_settings.rate = 1000;
+   m_settings.connections = 8;
+   m_settings.durationSeconds = 30;
+   m_settings.warmupSeconds = 5;
+   m_settings.drainSeconds = 5;
+   m_settings.seed = 1;
+}
+
+//******************************************************************************
+
+bool LoadScenario::load(const std::string& path) {
+   IniReader reader(path);
+
+   if (reader.hasSection(SECTION_LOADGEN)) {
+      KeyValuePairs kvp;
+      reader.readSection(SECTION_LOADGEN, kvp);
+      if (kvp.hasKey(KEY_HOST)) {
+         m_settings.host = kvp.getValue(KEY_HOST);
+      }
+      m_settings.port = intValue(kvp, KEY_PORT, m_settings.port);
+      m_settings.rate = intValue(kvp, KEY_RATE, m_settings.rate);
+      m_settings.connections = intValue(kvp, KEY_CONNECTIONS, m_settings.connections);
+      m_settings.durationSeconds = intValue(kvp, KEY_DURATION_S, m_settings.durationSeconds);
+      m_settings.warmupSeconds = intValue(kvp, KEY_WARMUP_S, m_settings.warmupSeconds);
+      m_settings.drainSeconds = intValue(kvp, KEY_DRAIN_S, m_settings.drainSeconds);
+      m_settings.seed = (unsigned int) intValue(kvp, KEY_SEED, (int) m_settings.seed);
+   }
+
+   KeyValuePairs kvpRequests;
+   if (!reader.hasSection(SECTION_REQUESTS) ||
+       !reader.readSection(SECTION_REQUESTS, kvpRequests)) {
+      m_error = "no [" + SECTION_REQUESTS + "] section in " + path;
+      return false;
+   }
+
+   std::vector<std::string> names;
+   kvpRequests.getKeys(names);
+
+   int totalWeight = 0;
+   for (const auto& name : names) {
+      const std::string& sectionName = kvpRequests.getValue(name);
+      KeyValuePairs kvp;
+      if (!reader.readSection(sectionName, kvp) || !kvp.hasKey(KEY_REQUEST)) {
+         m_error = "request '" + name + "' needs a [" + sectionName +
+                   "] section with a '" + KEY_REQUEST + "' name";
+         return false;
+      }
+
+      RequestTemplate requestTemplate;
+      requestTemplate.name = name;
+      requestTemplate.serviceName = kvp.hasKey(KEY_SERVICE) ? kvp.getValue(KEY_SERVICE) : "";
+      requestTemplate.requestName = kvp.getValue(KEY_REQUEST);
+      requestTemplate.type = (kvp.hasKey(KEY_TYPE) && (kvp.getValue(KEY_TYPE) == VALUE_KVP)) ?
+         MessageTypeKeyValues : MessageTypeText;
+      requestTemplate.payloadTemplate = kvp.hasKey(KEY_PAYLOAD) ? kvp.getValue(KEY_PAYLOAD) : "";
+      requestTemplate.weight = intValue(kvp, KEY_WEIGHT, 1);
+      if (requestTemplate.weight <= 0) {
+         continue;
+      }
+
+      totalWeight += requestTemplate.weight;
+      m_requests.push_back(requestTemplate);
+      m_cumulativeWeights.push_back(totalWeight);
+
+      // a payload without placeholders is the same every time
+      if ((requestTemplate.payloadTemplate.find(PLACEHOLDER_SEQ) == std::string::npos) &&
+          (requestTemplate.payloadTemplate.find(PLACEHOLDER_RANDOM) == std::string::npos)) {
+         std::minstd_rand unused;
+         m_requests.back().encodedFrame = encode((int) m_requests.size() - 1, 0, unused);
+      }
+   }
+
+   if (m_requests.empty()) {
+      m_error = "no requests with a positive weight in " + path;
+      return false;
+   }
+
+   if ((m_settings.rate <= 0) || (m_settings.connections <= 0) ||
+       (m_settings.durationSeconds <= 0)) {
+      m_error = "rate, connections and duration_s must be positive";
+      return false;
+   }
+
+   return true;
+}
+
+//******************************************************************************
+
+const std::string& LoadScenario::getError() const {
+   return m_error;
+}
+
+//******************************************************************************
+
+int LoadScenario::pick(std::minstd_rand& rng) const {
+   const int total = m_cumulativeWeights.back();
+   const int roll = (int) (rng() % (unsigned int) total);
+   for (std::size_t i = 0; i < m_cumulativeWeights.size(); ++i) {
+      if (roll < m_cumulativeWeights[i]) {
+         return (int) i;
+      }
+   }
+   return (int) m_cumulativeWeights.size() - 1;
+}
+
+//******************************************************************************
+
+std::string LoadScenario::encode(int index,
+                                 std::uint64_t sequence,
+                                 std::minstd_rand& rng) const {
+   const RequestTemplate& requestTemplate = m_requests[index];
+   if (!requestTemplate.encodedFrame.empty()) {
+      return requestTemplate.encodedFrame;
+   }
+
+   Message request(requestTemplate.requestName, requestTemplate.type);
+   const std::string payload = expand(requestTemplate.payloadTemplate, sequence, rng);
+   if (requestTemplate.type == MessageTypeKeyValues) {
+      KeyValuePairs kvp;
+      Message::fromString(payload, kvp);
+      request.setKeyValuesPayload(kvp);
+   } else {
+      request.setTextPayload(payload);
+   }
+
+   if (requestTemplate.serviceName.empty()) {
+      return request.toString();
+   }
+
+   return request.encodeForService(requestTemplate.serviceName);
+}
+
+//******************************************************************************
+
+std::string LoadScenario::expand(const std::string& payloadTemplate,
+                                 std::uint64_t sequence,
+                                 std::minstd_rand& rng) {
+   std::string payload;
+   payload.reserve(payloadTemplate.length() + 16);
+
+   std::string::size_type position = 0;
+   for (;;) {
+      const std::string::size_type start = payloadTemplate.find("${", position);
+      if (start == std::string::npos) {
+         payload.append(payloadTemplate, position, std::string::npos);
+         break;
+      }
+
+      payload.append(payloadTemplate, position, start - position);
+      const std::string::size_type end = payloadTemplate.find('}', start);
+      if (end == std::string::npos) {
+         payload.append(payloadTemplate, start, std::string::npos);
+         break;
+      }
+
+      const std::string placeholder = payloadTemplate.substr(start, end - start + 1);
+      if (placeholder == PLACEHOLDER_SEQ) {
+         payload += std::to_string(sequence);
+      } else if (placeholder.compare(0, PLACEHOLDER_RANDOM.length(), PLACEHOLDER_RANDOM) == 0) {
+         const int bound = StrUtils::parseInt(
+            placeholder.substr(PLACEHOLDER_RANDOM.length(),
+                               placeholder.length() - PLACEHOLDER_RANDOM.length() - 1));
+         payload += std::to_string((bound > 0) ? (rng() % (unsigned int) bound) : 0);
+      } else {
+         // not ours; leave it as written
+         payload += placeholder;
+      }
+
+      position = end + 1;
+   }
+
+   return payload;
+}
+
+//******************************************************************************
+
+const std::vector<LoadScenario::RequestTemplate>& LoadScenario::getRequests() const {
+   return m_requests;
+}
+
+//******************************************************************************
+
+LoadScenario::Settings& LoadScenario::getSettings() {
+   return m_settings;
+}
+
+//******************************************************************************
+
+const LoadScenario::Settings& LoadScenario::getSettings() const {
+   return m_settings;
+}
+
+//******************************************************************************
@@ -0,0 +1,134 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_BENCH_LOADSCENARIO_H
+#define TONNERRE_BENCH_LOADSCENARIO_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Message.h"
+
+namespace tonnerre_bench {
+
+/**
+ * LoadScenario is what tonnerre_loadgen sends: the target server, the
+ * request rate and number of connections, and a weighted mix of request
+ * templates, read from an INI file:
+ *
+ *    [loadgen]
+ *    host = 127.0.0.1
+ *    port = 9000
+ *    rate = 5000
+ *    connections = 16
+ *    duration_s = 30
+ *    warmup_s = 5
+ *
+ *    [requests]
+ *    lookup = LookupRequest
+ *
+ *    [LookupRequest]
+ *    service = user_service
+ *    request = lookup
+ *    type = kvp
+ *    payload = id=${seq};shard=${random:16}
+ *    weight = 9
+ *
+ * Payload templates may use ${seq} (the request's sequence number) and
+ * ${random:N} (a number from 0 to N-1); key/value payloads are written as
+ * 'key=value;' pairs.
+ */
+class LoadScenario
+{
+public:
+   struct Settings {
+      std::string host;
+      int port;
+      int rate;               // requests per second, across all connections
+      int connections;
+      int durationSeconds;    // measured, after the warm-up
+      int warmupSeconds;
+      int drainSeconds;       // how long to wait for the last responses
+      unsigned int seed;
+   };
+
+   struct RequestTemplate {
+      std::string name;
+      std::string serviceName;
+      std::string requestName;
+      tonnerre::MessageType type;
+      std::string payloadTemplate;
+      int weight;
+      std::string encodedFrame;  // set when the payload has no placeholders
+   };
+
+   /**
+    * Default constructor
+    */
+   LoadScenario();
+
+   /**
+    * Reads the scenario from an INI file
+    * @param path the path to the scenario file
+    * @return boolean indicating if the scenario is usable (see getError())
+    */
+   bool load(const std::string& path);
+
+   /**
+    * Retrieves why the scenario couldn't be loaded
+    * @return the error (empty if none)
+    */
+   const std::string& getError() const;
+
+   /**
+    * Chooses a request template according to the weights
+    * @param rng the random source
+    * @return the index of the template
+    */
+   int pick(std::minstd_rand& rng) const;
+
+   /**
+    * Encodes a request from a template
+    * @param index the template's index
+    * @param sequence the request's sequence number
+    * @param rng the random source
+    * @return the encoded request
+    */
+   std::string encode(int index, std::uint64_t sequence, std::minstd_rand& rng) const;
+
+   /**
+    * Substitutes the placeholders in a payload template
+    * @param payloadTemplate the template
+    * @param sequence the value of ${seq}
+    * @param rng the random source for ${random:N}
+    * @return the payload
+    */
+   static std::string expand(const std::string& payloadTemplate,
+                             std::uint64_t sequence,
+                             std::minstd_rand& rng);
+
+   /**
+    * Retrieves the request templates
+    * @return the templates, in the order listed in [requests]
+    */
+   const std::vector<RequestTemplate>& getRequests() const;
+
+   /**
+    * Retrieves the settings (which may be overridden from the command line)
+    * @return the settings
+    */
+   Settings& getSettings();
+   const Settings& getSettings() const;
+
+private:
+   Settings m_settings;
+   std::vector<RequestTemplate> m_requests;
+   std::vector<int> m_cumulativeWeights;
+   std::string m_error;
+};
+
+}
+
+#endif
@@ -0,0 +1,213 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "LoopbackBenchmark.h"
+#include "BenchServer.h"
+#include "Messaging.h"
+#include "ServiceInfo.h"
+
+using namespace tonnerre;
+using namespace tonnerre_bench;
+using namespace chaudiere;
+
+// each pair's value is this long; the last one takes up the remainder
+static const int KVP_VALUE_BYTES = 32;
+
+static const int PHASE_WARMUP    = 0;
+static const int PHASE_MEASURING = 1;
+static const int PHASE_STOPPED   = 2;
+
+//******************************************************************************
+
+LoopbackBenchmark::Result::Result() :
+   requests(0),
+   errors(0),
+   elapsedSeconds(0.0) {
+}
+
+//******************************************************************************
+
+double LoopbackBenchmark::Result::getRequestsPerSecond() const {
+   return (elapsedSeconds > 0.0) ? (requests / elapsedSeconds) : 0.0;
+}
+
+//******************************************************************************
+
+std::string LoopbackBenchmark::makePayload(int payloadBytes, KeyValuePairs& kvp) {
+   kvp.clear();
+
+   int remaining = payloadBytes;
+   for (int i = 0; remaining > 0; ++i) {
+      const std::string key = "k" + std::to_string(i);
+      // 'key=value;'
+      const int overhead = (int) key.length() + 2;
+      int valueBytes = remaining - overhead;
+      if (valueBytes > KVP_VALUE_BYTES) {
+         valueBytes = KVP_VALUE_BYTES;
+      } else if (valueBytes < 1) {
+         valueBytes = 1;
+      }
+
+      kvp.addPair(key, std::string(valueBytes, 'v'));
+      remaining -= overhead + valueBytes;
+   }
+
+   return std::string(payloadBytes, 'x');
+}
+
+//******************************************************************************
+
+LoopbackBenchmark::Result LoopbackBenchmark::run(const Scenario& scenario) {
+   std::shared_ptr<Messaging> messaging(Messaging::getMessaging());
+   if (messaging == nullptr) {
+      Messaging::setMessaging(new Messaging);
+      messaging = Messaging::getMessaging();
+   }
+
+   // one service name per client thread: a persistent connection is pooled
+   // per service, so threads sharing one would trade connections around
+   std::vector<std::string> serviceNames;
+   for (int i = 0; i < scenario.clientThreads; ++i) {
+      const std::string serviceName = BenchServer::SERVICE_NAME + ":" +
+         std::to_string(scenario.port) + ":" +
+         (scenario.isPersistent ? "persistent" : "transient") + ":" +
+         std::to_string(i);
+      ServiceInfo serviceInfo(serviceName, "127.0.0.1", (unsigned short) scenario.port);
+      serviceInfo.setPersistentConnection(scenario.isPersistent);
+      messaging->registerService(serviceName, serviceInfo);
+      serviceNames.push_back(serviceName);
+   }
+
+   KeyValuePairs kvpPayload;
+   const std::string textPayload = makePayload(scenario.payloadBytes, kvpPayload);
+
+   std::atomic<int> phase(PHASE_WARMUP);
+   std::mutex mutexResult;
+   Result result;
+
+   std::vector<std::thread> clients;
+   for (int i = 0; i < scenario.clientThreads; ++i) {
+      const std::string& serviceName = serviceNames[i];
+      clients.emplace_back([&, serviceName]() {
+         typedef std::chrono::steady_clock Clock;
+         LatencyHistogram latency;
+         std::uint64_t requests = 0;
+         std::uint64_t errors = 0;
+
+         Message request(BenchServer::REQUEST_NAME, scenario.payloadType);
+         if (scenario.payloadType == MessageTypeText) {
+            request.setTextPayload(textPayload);
+         } else {
+            request.setKeyValuesPayload(kvpPayload);
+         }
+
+         for (;;) {
+            const int currentPhase = phase.load(std::memory_order_relaxed);
+            if (currentPhase == PHASE_STOPPED) {
+               break;
+            }
+
+            Message response;
+            const Clock::time_point sentAt = Clock::now();
+            bool isEchoed = request.send(serviceName, response);
+            const Clock::time_point receivedAt = Clock::now();
+
+            if (isEchoed) {
+               if (scenario.payloadType == MessageTypeText) {
+                  isEchoed = (response.getTextPayload().length() == textPayload.length());
+               } else {
+                  isEchoed = (response.getKeyValuesPayload().size() == kvpPayload.size());
+               }
+            }
+
+            if (currentPhase == PHASE_MEASURING) {
+               if (isEchoed) {
+                  ++requests;
+                  latency.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                     receivedAt - sentAt).count());
+               } else {
+                  ++errors;
+               }
+            }
+         }
+
+         std::lock_guard<std::mutex> lock(mutexResult);
+         result.requests += requests;
+         result.errors += errors;
+         result.latency.merge(latency);
+      });
+   }
+
+   std::this_thread::sleep_for(std::chrono::milliseconds(scenario.warmupMillis));
+   const std::chrono::steady_clock::time_point startedAt = std::chrono::steady_clock::now();
+   phase.store(PHASE_MEASURING);
+
+   std::this_thread::sleep_for(std::chrono::milliseconds(scenario.durationMillis));
+   phase.store(PHASE_STOPPED);
+
+   for (auto& client : clients) {
+      client.join();
+   }
+
+   // (includes the requests that were in flight when the period ended)
+   result.elapsedSeconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - startedAt).count();
+
+   return result;
+}
+
+//******************************************************************************
+
+std::string LoopbackBenchmark::toJson(const Scenario& scenario, const Result& result) {
+   char buffer[512];
+   ::snprintf(buffer, sizeof(buffer),
+              "{\"threading\":\"%s\",\"payload\":\"%s\",\"payload_bytes\":%d,"
+              "\"client_threads\":%d,\"persistent\":%s,\"duration_ms\":%d,"
+              "\"requests\":%llu,\"errors\":%llu,\"requests_per_sec\":%.1f,"
+              "\"latency_us\":{\"mean\":%.1f,\"p50\":%llu,\"p99\":%llu,"
+              "\"p999\":%llu,\"max\":%llu}}",
+              scenario.threadingModel.c_str(),
+              (scenario.payloadType == MessageTypeText) ? "text" : "kvp",
+              scenario.payloadBytes,
+              scenario.clientThreads,
+              scenario.isPersistent ? "true" : "false",
+              scenario.durationMillis,
+              (unsigned long long) result.requests,
+              (unsigned long long) result.errors,
+              result.getRequestsPerSecond(),
+              result.latency.getMean(),
+              (unsigned long long) result.latency.getValueAtPercentile(50.0),
+              (unsigned long long) result.latency.getValueAtPercentile(99.0),
+              (unsigned long long) result.latency.getValueAtPercentile(99.9),
+              (unsigned long long) result.latency.getMax());
+   return buffer;
+}
+
+//******************************************************************************
+
+std::string LoopbackBenchmark::toString(const Scenario& scenario, const Result& result) {
+   char buffer[256];
+   ::snprintf(buffer, sizeof(buffer),
+              "%-12s %-4s %7dB %3d clients %-10s %10.0f req/s  p50=%lluus p99=%lluus p999=%lluus errors=%llu",
+              scenario.threadingModel.c_str(),
+              (scenario.payloadType == MessageTypeText) ? "text" : "kvp",
+              scenario.payloadBytes,
+              scenario.clientThreads,
+              scenario.isPersistent ? "persistent" : "transient",
+              result.getRequestsPerSecond(),
+              (unsigned long long) result.latency.getValueAtPercentile(50.0),
+              (unsigned long long) result.latency.getValueAtPercentile(99.0),
+              (unsigned long long) result.latency.getValueAtPercentile(99.9),
+              (unsigned long long) result.errors);
+   return buffer;
+}
+
+//******************************************************************************
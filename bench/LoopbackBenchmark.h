@@ -0,0 +1,80 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_BENCH_LOOPBACKBENCHMARK_H
+#define TONNERRE_BENCH_LOOPBACKBENCHMARK_H
+
+#include <cstdint>
+#include <string>
+
+#include "KeyValuePairs.h"
+#include "LatencyHistogram.h"
+#include "Message.h"
+
+namespace tonnerre_bench {
+
+/**
+ * LoopbackBenchmark drives a BenchServer with closed-loop clients: each
+ * client thread sends an echo request with Message::send() and waits for
+ * the response before sending the next, for a warm-up period and then for
+ * the measured period.
+ */
+class LoopbackBenchmark
+{
+public:
+   struct Scenario {
+      std::string threadingModel;
+      int port;
+      tonnerre::MessageType payloadType;
+      int payloadBytes;
+      int clientThreads;
+      bool isPersistent;
+      int warmupMillis;
+      int durationMillis;
+   };
+
+   struct Result {
+      std::uint64_t requests;
+      std::uint64_t errors;
+      double elapsedSeconds;
+      tonnerre::LatencyHistogram latency;
+
+      Result();
+      double getRequestsPerSecond() const;
+   };
+
+   /**
+    * Builds a payload of about the given size
+    * @param payloadBytes the encoded payload size wanted
+    * @param kvp populated with equal-sized pairs adding up to the size
+    * @return a text payload of exactly the size
+    */
+   static std::string makePayload(int payloadBytes, chaudiere::KeyValuePairs& kvp);
+
+   /**
+    * Runs one scenario against a server that is already started
+    * @param scenario what to run
+    * @return throughput, error count and the latency of each request
+    */
+   static Result run(const Scenario& scenario);
+
+   /**
+    * Formats a scenario's result as a single-line JSON object
+    * @param scenario the scenario that was run
+    * @param result its result
+    * @return the JSON text (no trailing newline)
+    */
+   static std::string toJson(const Scenario& scenario, const Result& result);
+
+   /**
+    * Formats a scenario's result for a human reader
+    * @param scenario the scenario that was run
+    * @param result its result
+    * @return one line of text (no trailing newline)
+    */
+   static std::string toString(const Scenario& scenario, const Result& result);
+};
+
+}
+
+#endif
@@ -0,0 +1,40 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <cstdio>
+
+#include "Microbenchmark.h"
+
+using namespace tonnerre_bench;
+
+//******************************************************************************
+
+std::string Microbenchmark::toJson(const Result& result) {
+   char buffer[512];
+   ::snprintf(buffer, sizeof(buffer),
+              "{\"benchmark\":\"%s\",\"params\":\"%s\",\"iterations\":%llu,"
+              "\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,\"bytes_per_op\":%.1f}",
+              result.name.c_str(),
+              result.params.c_str(),
+              (unsigned long long) result.iterations,
+              result.nanosPerOp,
+              result.allocationsPerOp,
+              result.bytesPerOp);
+   return buffer;
+}
+
+//******************************************************************************
+
+std::string Microbenchmark::toString(const Result& result) {
+   char buffer[256];
+   ::snprintf(buffer, sizeof(buffer),
+              "%-36s %-24s %12.1f ns/op %8.2f allocs/op %10.1f B/op",
+              result.name.c_str(),
+              result.params.c_str(),
+              result.nanosPerOp,
+              result.allocationsPerOp,
+              result.bytesPerOp);
+   return buffer;
+}
+
+//******************************************************************************
@@ -0,0 +1,122 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_BENCH_MICROBENCHMARK_H
+#define TONNERRE_BENCH_MICROBENCHMARK_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "AllocationCounter.h"
+
+namespace tonnerre_bench {
+
+/**
+ * Microbenchmark times a single-threaded operation over enough iterations
+ * to run for at least the minimum time, and reports the time, allocations
+ * and bytes allocated per operation.
+ */
+class Microbenchmark
+{
+public:
+   struct Result {
+      std::string name;
+      std::string params;
+      std::uint64_t iterations;
+      double nanosPerOp;
+      double allocationsPerOp;
+      double bytesPerOp;
+   };
+
+   /**
+    * Keeps the compiler from optimizing away a value nothing else reads
+    * @param value the value to keep
+    */
+   template <typename T>
+   static void keep(const T& value) {
+      asm volatile("" : : "g"(&value) : "memory");
+   }
+
+   /**
+    * Constructs a benchmark runner
+    * @param minMillis how long each measurement runs for at least
+    */
+   explicit Microbenchmark(int minMillis) :
+      m_minMillis(minMillis) {
+   }
+
+   /**
+    * Measures an operation
+    * @param name what is measured (e.g., 'Message::toString')
+    * @param params the shape of its input (e.g., 'text bytes=1024')
+    * @param op the operation, called once per iteration
+    * @return the per-operation measurements
+    */
+   template <typename Op>
+   Result measure(const std::string& name, const std::string& params, Op op) const {
+      typedef std::chrono::steady_clock Clock;
+
+      // the first call pays for one-time setup (and warms the caches)
+      op();
+
+      // grow the batch until it takes a tenth of the minimum time, then
+      // size the measured batch from its rate
+      std::uint64_t iterations = 1;
+      const std::int64_t calibrationNanos = (std::int64_t) m_minMillis * 100000;
+      for (;;) {
+         const Clock::time_point startedAt = Clock::now();
+         for (std::uint64_t i = 0; i < iterations; ++i) {
+            op();
+         }
+         const std::int64_t elapsedNanos =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startedAt).count();
+         if (elapsedNanos >= calibrationNanos) {
+            iterations = (std::uint64_t) ((double) iterations * 10.0 *
+                                          calibrationNanos / (elapsedNanos > 0 ? elapsedNanos : 1)) + 1;
+            break;
+         }
+         iterations *= 2;
+      }
+
+      const std::uint64_t allocationsBefore = AllocationCounter::getAllocations();
+      const std::uint64_t bytesBefore = AllocationCounter::getBytes();
+      const Clock::time_point startedAt = Clock::now();
+      for (std::uint64_t i = 0; i < iterations; ++i) {
+         op();
+      }
+      const double elapsedNanos = (double)
+         std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startedAt).count();
+
+      Result result;
+      result.name = name;
+      result.params = params;
+      result.iterations = iterations;
+      result.nanosPerOp = elapsedNanos / iterations;
+      result.allocationsPerOp =
+         (double) (AllocationCounter::getAllocations() - allocationsBefore) / iterations;
+      result.bytesPerOp = (double) (AllocationCounter::getBytes() - bytesBefore) / iterations;
+      return result;
+   }
+
+   /**
+    * Formats a result as a single-line JSON object
+    * @param result the result
+    * @return the JSON text (no trailing newline)
+    */
+   static std::string toJson(const Result& result);
+
+   /**
+    * Formats a result for a human reader
+    * @param result the result
+    * @return one line of text (no trailing newline)
+    */
+   static std::string toString(const Result& result);
+
+private:
+   int m_minMillis;
+};
+
+}
+
+#endif
@@ -0,0 +1,133 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "AdmissionController.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+//******************************************************************************
+
+AdmissionController::AdmissionController(int maxInFlight,
+                                         int maxQueueDepth,
+                                         int codelTargetMillis,
+                                         int codelIntervalMillis) :
+   m_intervalEnd(),
+   m_minDelay(Clock::duration::zero()),
+   m_codelTarget(std::chrono::milliseconds(codelTargetMillis)),
+   m_codelInterval(std::chrono::milliseconds(codelIntervalMillis)),
+   m_shedCount(0),
+   m_inFlight(0),
+   m_queueDepth(0),
+   m_maxInFlight(maxInFlight),
+   m_maxQueueDepth(maxQueueDepth),
+   m_isQueueStanding(false) {
+   TONNERRE_LOG_INSTANCE_CREATE("AdmissionController");
+}
+
+//******************************************************************************
+
+AdmissionController::~AdmissionController() {
+   TONNERRE_LOG_INSTANCE_DESTROY("AdmissionController");
+}
+
+//******************************************************************************
+
+bool AdmissionController::enqueue() {
+   const int depth = m_queueDepth.fetch_add(1, std::memory_order_relaxed);
+   if ((m_maxQueueDepth > 0) && (depth >= m_maxQueueDepth)) {
+      m_queueDepth.fetch_sub(1, std::memory_order_relaxed);
+      m_shedCount.fetch_add(1, std::memory_order_relaxed);
+      return false;
+   }
+
+   return true;
+}
+
+//******************************************************************************
+
+void AdmissionController::dequeue() {
+   m_queueDepth.fetch_sub(1, std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+bool AdmissionController::admit(Clock::duration queueDelay) {
+   return admit(queueDelay, Clock::now());
+}
+
+//******************************************************************************
+
+bool AdmissionController::admit(Clock::duration queueDelay, Clock::time_point now) {
+   if (isDelayExcessive(queueDelay, now)) {
+      m_shedCount.fetch_add(1, std::memory_order_relaxed);
+      return false;
+   }
+
+   const int inFlight = m_inFlight.fetch_add(1, std::memory_order_relaxed);
+   if ((m_maxInFlight > 0) && (inFlight >= m_maxInFlight)) {
+      m_inFlight.fetch_sub(1, std::memory_order_relaxed);
+      m_shedCount.fetch_add(1, std::memory_order_relaxed);
+      return false;
+   }
+
+   return true;
+}
+
+//******************************************************************************
+
+void AdmissionController::release() {
+   m_inFlight.fetch_sub(1, std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+int AdmissionController::getInFlight() const {
+   return m_inFlight.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+int AdmissionController::getQueueDepth() const {
+   return m_queueDepth.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+std::uint64_t AdmissionController::getShedCount() const {
+   return m_shedCount.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+bool AdmissionController::isQueueStanding() const {
+   std::lock_guard<std::mutex> lock(m_codelMutex);
+   return m_isQueueStanding;
+}
+
+//******************************************************************************
+
+bool AdmissionController::isDelayExcessive(Clock::duration queueDelay,
+                                           Clock::time_point now) {
+   if (m_codelTarget <= Clock::duration::zero()) {
+      return false;
+   }
+
+   std::lock_guard<std::mutex> lock(m_codelMutex);
+
+   if (now >= m_intervalEnd) {
+      // judge the interval that just ended by its best case: a burst drains
+      // within an interval, a standing queue never gets below target
+      m_isQueueStanding = (m_minDelay > m_codelTarget);
+      m_minDelay = queueDelay;
+      m_intervalEnd = now + m_codelInterval;
+   } else if (queueDelay < m_minDelay) {
+      m_minDelay = queueDelay;
+   }
+
+   // while the queue stands, shed what has waited too long to be useful
+   return m_isQueueStanding && (queueDelay > 2 * m_codelTarget);
+}
+
+//******************************************************************************
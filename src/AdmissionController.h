@@ -0,0 +1,128 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_ADMISSIONCONTROLLER_H
+#define TONNERRE_ADMISSIONCONTROLLER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+
+namespace tonnerre
+{
+
+/**
+ * AdmissionController decides whether a server takes on another request or
+ * sheds it with an immediate 'overloaded' response. Three limits are
+ * applied, each optional: the number of requests being handled at once,
+ * the number of connections waiting for a worker, and (CoDel-style) how
+ * long requests have been waiting. For the last, once the shortest wait
+ * seen during an interval stays above the target the queue is known to be
+ * standing rather than bursting, and requests that waited more than twice
+ * the target are shed until an interval's shortest wait drops back below
+ * the target.
+ */
+class AdmissionController
+{
+public:
+   typedef std::chrono::steady_clock Clock;
+
+   /**
+    * Constructs a controller (a limit of 0 disables that check)
+    * @param maxInFlight maximum requests being handled at once
+    * @param maxQueueDepth maximum connections waiting for a worker
+    * @param codelTargetMillis acceptable queueing delay
+    * @param codelIntervalMillis how often the queueing delay is judged
+    */
+   AdmissionController(int maxInFlight,
+                       int maxQueueDepth,
+                       int codelTargetMillis,
+                       int codelIntervalMillis);
+
+   /**
+    * Destructor
+    */
+   ~AdmissionController();
+
+   /**
+    * Counts a connection that is waiting for a worker
+    * @return boolean indicating if there was room in the queue (if not, the
+    * connection isn't counted and its next request is to be shed)
+    */
+   bool enqueue();
+
+   /**
+    * Uncounts a connection that was waiting (it was picked up by a worker)
+    */
+   void dequeue();
+
+   /**
+    * Decides whether a request is handled or shed
+    * @param queueDelay how long the request waited before a worker took it
+    * @return boolean indicating if the request was admitted (admitted
+    * requests must be paired with a call to release())
+    */
+   bool admit(Clock::duration queueDelay);
+
+   /**
+    * Decides whether a request is handled or shed (as of a given time)
+    * @param queueDelay how long the request waited before a worker took it
+    * @param now the current time
+    * @return boolean indicating if the request was admitted
+    */
+   bool admit(Clock::duration queueDelay, Clock::time_point now);
+
+   /**
+    * Marks an admitted request as finished
+    */
+   void release();
+
+   /**
+    * Retrieves the number of requests currently being handled
+    * @return number of admitted requests in flight
+    */
+   int getInFlight() const;
+
+   /**
+    * Retrieves the number of connections waiting for a worker
+    * @return queue depth
+    */
+   int getQueueDepth() const;
+
+   /**
+    * Retrieves the number of requests shed so far
+    * @return number of shed requests
+    */
+   std::uint64_t getShedCount() const;
+
+   /**
+    * Determines if the queueing delay has been above target for a whole
+    * interval (the state in which delayed requests are shed)
+    * @return boolean indicating if the queue is considered standing
+    */
+   bool isQueueStanding() const;
+
+private:
+   bool isDelayExcessive(Clock::duration queueDelay, Clock::time_point now);
+
+   mutable std::mutex m_codelMutex;
+   Clock::time_point m_intervalEnd;
+   Clock::duration m_minDelay;
+   const Clock::duration m_codelTarget;
+   const Clock::duration m_codelInterval;
+   std::atomic<std::uint64_t> m_shedCount;
+   std::atomic<int> m_inFlight;
+   std::atomic<int> m_queueDepth;
+   const int m_maxInFlight;
+   const int m_maxQueueDepth;
+   bool m_isQueueStanding;
+
+   AdmissionController(const AdmissionController&);
+   AdmissionController& operator=(const AdmissionController&);
+};
+
+}
+
+#endif
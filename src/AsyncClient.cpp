@@ -0,0 +1,168 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "AsyncClient.h"
+#include "CoroutineReactor.h"
+#include "Messaging.h"
+#include "ServiceInfo.h"
+#include "UnixSocket.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+static const std::size_t READ_CHUNK_SIZE = 4096;
+
+namespace {
+
+// Closes the descriptor when the coroutine frame is left (or destroyed).
+class FdCloser {
+public:
+   explicit FdCloser(int fd) : m_fd(fd) {}
+   ~FdCloser() {
+      if (m_fd != -1) {
+         ::close(m_fd);
+      }
+   }
+
+private:
+   int m_fd;
+};
+
+// Starts a non-blocking connect; returns -1 if it failed outright.
+int startConnect(const std::string& host, unsigned short port, bool& isPending) {
+   isPending = false;
+
+   struct addrinfo hints;
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+
+   struct addrinfo* addresses = nullptr;
+   const std::string portAsString = std::to_string(port);
+   if (::getaddrinfo(host.c_str(), portAsString.c_str(), &hints, &addresses) != 0) {
+      TONNERRE_LOG_ERROR("unable to resolve service host '" + host + "'");
+      return -1;
+   }
+
+   int fd = -1;
+   for (struct addrinfo* address = addresses; address != nullptr; address = address->ai_next) {
+      fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+      if (fd == -1) {
+         continue;
+      }
+
+      ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+      if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+         break;
+      } else if (errno == EINPROGRESS) {
+         isPending = true;
+         break;
+      }
+
+      ::close(fd);
+      fd = -1;
+   }
+
+   ::freeaddrinfo(addresses);
+   return fd;
+}
+
+}
+
+//******************************************************************************
+
+Task<bool> AsyncClient::send(Message& requestMessage,
+                             const std::string& serviceName,
+                             Message& responseMessage) {
+   std::shared_ptr<Messaging> messaging(Messaging::getMessaging());
+   if (messaging == nullptr) {
+      TONNERRE_LOG_ERROR("messaging not initialized");
+      co_return false;
+   }
+
+   if (!messaging->isServiceRegistered(serviceName)) {
+      TONNERRE_LOG_ERROR("service is not registered");
+      co_return false;
+   }
+
+   const ServiceInfo serviceInfo = messaging->getInfoForService(serviceName);
+   const std::string encodedRequest = requestMessage.encodeForService(serviceName);
+
+   // (a 'path=' service is registered with its socket path as the host)
+   bool isPending = false;
+   const int fd = UnixSocket::isUnixService(serviceInfo) ?
+      UnixSocket::startConnect(serviceInfo.host(), isPending) :
+      startConnect(serviceInfo.host(), serviceInfo.port(), isPending);
+   if (fd == -1) {
+      TONNERRE_LOG_ERROR("unable to connect to service");
+      co_return false;
+   }
+   FdCloser closer(fd);
+
+   if (isPending) {
+      co_await FdAwaitable(fd, POLLOUT);
+
+      int connectError = 0;
+      socklen_t errorLength = sizeof(connectError);
+      ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &connectError, &errorLength);
+      if (connectError != 0) {
+         TONNERRE_LOG_ERROR("unable to connect to service");
+         co_return false;
+      }
+   }
+
+   std::size_t bytesWritten = 0;
+   while (bytesWritten < encodedRequest.length()) {
+      const ssize_t rc = ::send(fd,
+                                encodedRequest.data() + bytesWritten,
+                                encodedRequest.length() - bytesWritten,
+                                MSG_NOSIGNAL);
+      if (rc > 0) {
+         bytesWritten += rc;
+      } else if ((rc < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+         co_await FdAwaitable(fd, POLLOUT);
+      } else if ((rc < 0) && (errno == EINTR)) {
+         continue;
+      } else {
+         TONNERRE_LOG_ERROR("unable to write to socket");
+         co_return false;
+      }
+   }
+
+   std::string received;
+   char chunk[READ_CHUNK_SIZE];
+   for (;;) {
+      const std::size_t length = Message::frameLength(received);
+      if (length == std::string::npos) {
+         TONNERRE_LOG_ERROR("malformed response from service");
+         co_return false;
+      } else if ((length > 0) && (received.length() >= length)) {
+         co_return responseMessage.reconstituteFromFrame(received.substr(0, length));
+      }
+
+      const ssize_t rc = ::recv(fd, chunk, sizeof(chunk), 0);
+      if (rc > 0) {
+         received.append(chunk, rc);
+      } else if ((rc < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+         co_await FdAwaitable(fd, POLLIN);
+      } else if ((rc < 0) && (errno == EINTR)) {
+         continue;
+      } else {
+         TONNERRE_LOG_ERROR("connection closed before response was received");
+         co_return false;
+      }
+   }
+}
+
+//******************************************************************************
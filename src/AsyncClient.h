@@ -0,0 +1,43 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_ASYNCCLIENT_H
+#define TONNERRE_ASYNCCLIENT_H
+
+#include <string>
+
+#include "Task.h"
+#include "Message.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * AsyncClient sends messages from inside coroutines. Connecting, writing
+ * the request and waiting for the response all suspend the calling
+ * coroutine on the CoroutineReactor instead of blocking a thread.
+ */
+class AsyncClient
+{
+public:
+   /**
+    * Sends a message and retrieves the message response
+    * @param requestMessage the message to send (must outlive the send)
+    * @param serviceName the name of the service to send to (as registered with Messaging)
+    * @param responseMessage the response (must outlive the send)
+    * @return task yielding a boolean indicating whether a response was received
+    * @see Messaging()
+    */
+   static Task<bool> send(Message& requestMessage,
+                          const std::string& serviceName,
+                          Message& responseMessage);
+
+private:
+   AsyncClient();
+};
+
+}
+
+#endif
+
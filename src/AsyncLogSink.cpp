@@ -0,0 +1,292 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "AsyncLogSink.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+const int AsyncLogSink::DEFAULT_RECORDS_PER_THREAD = 1024;
+// (a record is 256 bytes in all)
+const std::size_t AsyncLogSink::MAX_MESSAGE_LENGTH = 248;
+
+static std::shared_ptr<AsyncLogSink> sinkInstance;
+static std::mutex mutexSinkInstance;
+static std::atomic<std::uint64_t> nextSinkId(1);
+
+//******************************************************************************
+
+class AsyncLogSink::Ring
+{
+public:
+   explicit Ring(std::size_t capacity) :
+      m_records(capacity),
+      m_mask(capacity - 1),
+      m_head(0),
+      m_tail(0) {
+   }
+
+   // called only by the thread that owns the ring
+   bool push(LogLevel level, const std::string& message) {
+      const std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+      if (tail - m_head.load(std::memory_order_acquire) > m_mask) {
+         return false;
+      }
+
+      Record& record = m_records[tail & m_mask];
+      record.level = level;
+      record.length = (std::uint32_t) std::min(message.length(), MAX_MESSAGE_LENGTH);
+      std::memcpy(record.text, message.data(), record.length);
+      m_tail.store(tail + 1, std::memory_order_release);
+      return true;
+   }
+
+   // called only by the thread draining the rings
+   bool pop(LogLevel& level, std::string& message) {
+      const std::uint64_t head = m_head.load(std::memory_order_relaxed);
+      if (head == m_tail.load(std::memory_order_acquire)) {
+         return false;
+      }
+
+      const Record& record = m_records[head & m_mask];
+      level = record.level;
+      message.assign(record.text, record.length);
+      m_head.store(head + 1, std::memory_order_release);
+      return true;
+   }
+
+   bool isEmpty() const {
+      return m_head.load(std::memory_order_acquire) ==
+             m_tail.load(std::memory_order_acquire);
+   }
+
+private:
+   struct Record {
+      LogLevel level;
+      std::uint32_t length;
+      char text[MAX_MESSAGE_LENGTH];
+   };
+
+   std::vector<Record> m_records;
+   const std::size_t m_mask;
+   alignas(64) std::atomic<std::uint64_t> m_head;
+   alignas(64) std::atomic<std::uint64_t> m_tail;
+};
+
+//******************************************************************************
+
+void AsyncLogSink::start(int recordsPerThread) {
+   std::lock_guard<std::mutex> lock(mutexSinkInstance);
+   if (std::atomic_load(&sinkInstance) == nullptr) {
+      std::atomic_store(&sinkInstance,
+                        std::shared_ptr<AsyncLogSink>(new AsyncLogSink(recordsPerThread)));
+   }
+}
+
+//******************************************************************************
+
+void AsyncLogSink::stop() {
+   std::lock_guard<std::mutex> lock(mutexSinkInstance);
+   // (the sink is destroyed, and flushed, once the last thread logging
+   // through it lets go)
+   std::atomic_store(&sinkInstance, std::shared_ptr<AsyncLogSink>());
+}
+
+//******************************************************************************
+
+bool AsyncLogSink::isRunning() {
+   return std::atomic_load(&sinkInstance) != nullptr;
+}
+
+//******************************************************************************
+
+void AsyncLogSink::log(LogLevel level, const std::string& message) {
+   std::shared_ptr<AsyncLogSink> sink(std::atomic_load(&sinkInstance));
+   if (sink != nullptr) {
+      sink->append(level, message);
+   } else {
+      writeToLogger(level, message);
+   }
+}
+
+//******************************************************************************
+
+std::uint64_t AsyncLogSink::getDroppedRecords() {
+   std::shared_ptr<AsyncLogSink> sink(std::atomic_load(&sinkInstance));
+   return (sink != nullptr) ? sink->getDropped() : 0;
+}
+
+//******************************************************************************
+
+void AsyncLogSink::writeToLogger(LogLevel level, const std::string& message) {
+   switch (level) {
+      case Critical:
+         Logger::critical(message);
+         break;
+      case Error:
+         Logger::error(message);
+         break;
+      case Warning:
+         Logger::warning(message);
+         break;
+      case Info:
+         Logger::info(message);
+         break;
+      case Debug:
+         Logger::debug(message);
+         break;
+      default:
+         Logger::verbose(message);
+         break;
+   }
+}
+
+//******************************************************************************
+
+AsyncLogSink::AsyncLogSink(int recordsPerThread,
+                           const Writer& writer,
+                           int drainIntervalMillis) :
+   m_writer(writer),
+   m_dropped(0),
+   m_droppedReported(0),
+   m_id(nextSinkId.fetch_add(1)),
+   m_recordsPerThread(recordsPerThread),
+   m_drainIntervalMillis(drainIntervalMillis),
+   m_isStopping(false) {
+   TONNERRE_LOG_INSTANCE_CREATE("AsyncLogSink");
+
+   m_thread = std::thread(&AsyncLogSink::run, this);
+}
+
+//******************************************************************************
+
+AsyncLogSink::~AsyncLogSink() {
+   TONNERRE_LOG_INSTANCE_DESTROY("AsyncLogSink");
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutexWake);
+      m_isStopping = true;
+   }
+   m_condWake.notify_one();
+   m_thread.join();
+
+   drain();
+}
+
+//******************************************************************************
+
+bool AsyncLogSink::append(LogLevel level, const std::string& message) {
+   if (!ringForThread()->push(level, message)) {
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+   }
+
+   return true;
+}
+
+//******************************************************************************
+
+void AsyncLogSink::flush() {
+   drain();
+}
+
+//******************************************************************************
+
+std::uint64_t AsyncLogSink::getDropped() const {
+   return m_dropped.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+std::shared_ptr<AsyncLogSink::Ring> AsyncLogSink::ringForThread() {
+   // (a thread almost always logs through the one sink, so its ring is
+   // found without taking the lock)
+   thread_local std::uint64_t cachedSinkId = 0;
+   thread_local std::shared_ptr<Ring> cachedRing;
+   if (cachedSinkId == m_id) {
+      return cachedRing;
+   }
+
+   std::lock_guard<std::mutex> lock(m_mutexRings);
+   std::shared_ptr<Ring>& ring = m_rings[std::this_thread::get_id()];
+   if (ring == nullptr) {
+      std::size_t capacity = 1;
+      while (capacity < (std::size_t) m_recordsPerThread) {
+         capacity <<= 1;
+      }
+      ring.reset(new Ring(capacity));
+   }
+
+   cachedSinkId = m_id;
+   cachedRing = ring;
+   return ring;
+}
+
+//******************************************************************************
+
+std::size_t AsyncLogSink::drain() {
+   std::lock_guard<std::mutex> lockDrain(m_mutexDrain);
+
+   std::vector<std::shared_ptr<Ring>> rings;
+   {
+      std::lock_guard<std::mutex> lock(m_mutexRings);
+      for (auto it = m_rings.begin(); it != m_rings.end(); ) {
+         // a ring held only here belongs to a thread that has exited (or
+         // moved to another sink); once it's empty it can go
+         if ((it->second.use_count() == 1) && it->second->isEmpty()) {
+            it = m_rings.erase(it);
+         } else {
+            rings.push_back(it->second);
+            ++it;
+         }
+      }
+   }
+
+   std::size_t written = 0;
+   LogLevel level;
+   std::string message;
+   for (const auto& ring : rings) {
+      while (ring->pop(level, message)) {
+         m_writer(level, message);
+         ++written;
+      }
+   }
+
+   const std::uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+   if (dropped != m_droppedReported) {
+      m_writer(Warning, "log sink dropped " + std::to_string(dropped - m_droppedReported) +
+                        " records (" + std::to_string(dropped) + " in all)");
+      m_droppedReported = dropped;
+   }
+
+   return written;
+}
+
+//******************************************************************************
+
+void AsyncLogSink::run() {
+   std::size_t written = 0;
+   for (;;) {
+      {
+         std::unique_lock<std::mutex> lock(m_mutexWake);
+         // (while there's a backlog, keep draining)
+         if (written == 0) {
+            m_condWake.wait_for(lock, std::chrono::milliseconds(m_drainIntervalMillis),
+                                [this]() { return m_isStopping; });
+         }
+
+         if (m_isStopping) {
+            break;
+         }
+      }
+
+      written = drain();
+   }
+}
+
+//******************************************************************************
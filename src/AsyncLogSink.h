@@ -0,0 +1,150 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_ASYNCLOGSINK_H
+#define TONNERRE_ASYNCLOGSINK_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Logger.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * AsyncLogSink takes log writes off the threads that do the messaging.
+ * Each thread that logs gets its own ring of fixed-size records (a single
+ * producer, single consumer queue, so appending is a couple of atomic
+ * operations and a copy); a background thread drains the rings into
+ * chaudière's Logger. When a thread's ring is full the record is dropped
+ * and counted rather than waited for, and the drain thread reports the
+ * drops as a warning. Messages longer than a record are truncated.
+ *
+ * Once started, everything tonnerre logs with TONNERRE_LOG_ERROR or
+ * TONNERRE_LOG_WARNING goes through the sink; servers with
+ * 'async_logging = true' start it themselves.
+ * @see Logging.h
+ */
+class AsyncLogSink
+{
+public:
+   typedef std::function<void(chaudiere::LogLevel, const std::string&)> Writer;
+
+   static const int DEFAULT_RECORDS_PER_THREAD;
+   static const std::size_t MAX_MESSAGE_LENGTH;
+
+   /**
+    * Starts the process-wide sink (if it isn't already running)
+    * @param recordsPerThread the size of each thread's ring (rounded up to
+    * a power of two)
+    */
+   static void start(int recordsPerThread=DEFAULT_RECORDS_PER_THREAD);
+
+   /**
+    * Stops the process-wide sink, writing out whatever it still holds;
+    * later messages are written directly again
+    */
+   static void stop();
+
+   /**
+    * Determines if the process-wide sink is running
+    * @return boolean indicating if the sink is running
+    */
+   static bool isRunning();
+
+   /**
+    * Logs a message through the process-wide sink, or directly to the
+    * Logger if the sink isn't running
+    * @param level the level of the message
+    * @param message the message
+    */
+   static void log(chaudiere::LogLevel level, const std::string& message);
+
+   /**
+    * Retrieves the number of records the process-wide sink has dropped
+    * @return the number dropped (0 if the sink isn't running)
+    */
+   static std::uint64_t getDroppedRecords();
+
+   /**
+    * Writes a message to chaudière's Logger (the default writer)
+    * @param level the level of the message
+    * @param message the message
+    */
+   static void writeToLogger(chaudiere::LogLevel level, const std::string& message);
+
+   /**
+    * Constructs a sink and starts its drain thread
+    * @param recordsPerThread the size of each thread's ring (rounded up to
+    * a power of two)
+    * @param writer where drained messages are written
+    * @param drainIntervalMillis how long the drain thread sleeps when the
+    * rings are empty
+    */
+   AsyncLogSink(int recordsPerThread,
+                const Writer& writer=writeToLogger,
+                int drainIntervalMillis=10);
+
+   /**
+    * Destructor (stops the drain thread and writes out what's left)
+    */
+   ~AsyncLogSink();
+
+   /**
+    * Adds a message to the calling thread's ring; never blocks
+    * @param level the level of the message
+    * @param message the message
+    * @return boolean indicating if the message was queued (false if the
+    * ring was full and it was dropped)
+    */
+   bool append(chaudiere::LogLevel level, const std::string& message);
+
+   /**
+    * Writes out every queued message on the calling thread
+    */
+   void flush();
+
+   /**
+    * Retrieves the number of records dropped because a ring was full
+    * @return the number dropped
+    */
+   std::uint64_t getDropped() const;
+
+private:
+   class Ring;
+
+   std::shared_ptr<Ring> ringForThread();
+   std::size_t drain();
+   void run();
+
+   Writer m_writer;
+   std::unordered_map<std::thread::id, std::shared_ptr<Ring>> m_rings;
+   std::mutex m_mutexRings;
+   std::mutex m_mutexDrain;
+   std::mutex m_mutexWake;
+   std::condition_variable m_condWake;
+   std::thread m_thread;
+   std::atomic<std::uint64_t> m_dropped;
+   std::uint64_t m_droppedReported;
+   const std::uint64_t m_id;
+   const int m_recordsPerThread;
+   const int m_drainIntervalMillis;
+   bool m_isStopping;
+
+   AsyncLogSink(const AsyncLogSink&);
+   AsyncLogSink& operator=(const AsyncLogSink&);
+};
+
+}
+
+#endif
@@ -0,0 +1,57 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "AsyncMessageHandler.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+//******************************************************************************
+
+void AsyncMessageHandler::handleTextMessage(const Message& requestMessage,
+                                            Message& responseMessage,
+                                            const std::string& requestName,
+                                            const std::string& requestPayload,
+                                            std::string& responsePayload) {
+   std::shared_ptr<Responder::Completion> completion(new Responder::Completion);
+   std::shared_ptr<Responder> responder(new Responder(completion, requestMessage));
+
+   // the handler gets the only reference, so dropping it uncompleted still
+   // releases the wait below
+   handleTextMessageAsync(requestMessage,
+                          requestName,
+                          requestPayload,
+                          std::move(responder));
+
+   const Message& completed = completion->wait();
+   responseMessage = completed;
+   responsePayload = completed.getTextPayload();
+}
+
+//******************************************************************************
+
+void AsyncMessageHandler::handleKeyValuesMessage(const Message& requestMessage,
+                                                 Message& responseMessage,
+                                                 const std::string& requestName,
+                                                 const KeyValuePairs& requestPayload,
+                                                 KeyValuePairs& responsePayload) {
+   std::shared_ptr<Responder::Completion> completion(new Responder::Completion);
+   std::shared_ptr<Responder> responder(new Responder(completion, requestMessage));
+
+   handleKeyValuesMessageAsync(requestMessage,
+                               requestName,
+                               requestPayload,
+                               std::move(responder));
+
+   const Message& completed = completion->wait();
+   responseMessage = completed;
+   responsePayload = completed.getKeyValuesPayload();
+}
+
+//******************************************************************************
+
+AsyncMessageHandler* AsyncMessageHandler::asyncHandlerFor(const Message&) {
+   return this;
+}
+
+//******************************************************************************
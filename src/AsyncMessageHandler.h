@@ -0,0 +1,78 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_ASYNCMESSAGEHANDLER_H
+#define TONNERRE_ASYNCMESSAGEHANDLER_H
+
+#include <memory>
+#include <string>
+
+#include "MessageHandler.h"
+#include "Responder.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * AsyncMessageHandler is the interface (abstract base class) for handlers
+ * that respond to requests after returning, e.g. once a database query or a
+ * call to another service finishes. Each request comes with a Responder;
+ * the worker thread is released as soon as the handler returns, and the
+ * response is written whenever (and on whichever thread) the responder is
+ * completed.
+ *
+ * Called synchronously (through the MessageHandler methods, as in-process
+ * callers do), the handler runs and the caller waits for the responder.
+ */
+class AsyncMessageHandler : public MessageHandler
+{
+public:
+   virtual ~AsyncMessageHandler() {}
+
+   /**
+    * Handles a message with a text payload (Text type)
+    * @param requestMessage the request message
+    * @param requestName the name of the request
+    * @param requestPayload the request payload text
+    * @param responder completes the request (keep it for as long as the request is outstanding)
+    * @see Responder()
+    */
+   virtual void handleTextMessageAsync(const Message& requestMessage,
+                                       const std::string& requestName,
+                                       const std::string& requestPayload,
+                                       std::shared_ptr<Responder> responder) = 0;
+
+   /**
+    * Handles a message with a payload of key-value pairs (KeyValues type)
+    * @param requestMessage the request message
+    * @param requestName the name of the request
+    * @param requestPayload the request payload as key-value pairs
+    * @param responder completes the request (keep it for as long as the request is outstanding)
+    * @see Responder()
+    */
+   virtual void handleKeyValuesMessageAsync(const Message& requestMessage,
+                                            const std::string& requestName,
+                                            const chaudiere::KeyValuePairs& requestPayload,
+                                            std::shared_ptr<Responder> responder) = 0;
+
+   // MessageHandler
+   void handleTextMessage(const Message& requestMessage,
+                          Message& responseMessage,
+                          const std::string& requestName,
+                          const std::string& requestPayload,
+                          std::string& responsePayload) override;
+
+   void handleKeyValuesMessage(const Message& requestMessage,
+                               Message& responseMessage,
+                               const std::string& requestName,
+                               const chaudiere::KeyValuePairs& requestPayload,
+                               chaudiere::KeyValuePairs& responsePayload) override;
+
+   AsyncMessageHandler* asyncHandlerFor(const Message& requestMessage) override;
+};
+
+}
+
+#endif
+
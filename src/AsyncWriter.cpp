@@ -0,0 +1,190 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <chrono>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "AsyncWriter.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+
+// upper bound on any sleep so that a missed wakeup can only ever cost
+// this much latency
+static const int MAX_IDLE_WAIT_MILLIS      = 100;
+static const int BLOCKED_PRODUCER_WAIT_MS  = 1;
+static const std::size_t DISCARD_BUFFER_SIZE = 4096;
+
+//******************************************************************************
+
+AsyncWriter::AsyncWriter(BackpressurePolicy backpressure) :
+   m_backpressure(backpressure),
+   m_isRunning(false),
+   m_isWriterIdle(false),
+   m_numBlockedProducers(0),
+   m_sentCount(0),
+   m_droppedCount(0),
+   m_failedCount(0) {
+   TONNERRE_LOG_INSTANCE_CREATE("AsyncWriter");
+}
+
+//******************************************************************************
+
+AsyncWriter::~AsyncWriter() {
+   TONNERRE_LOG_INSTANCE_DESTROY("AsyncWriter");
+   stop();
+}
+
+//******************************************************************************
+
+void AsyncWriter::start() {
+   m_isRunning.store(true, std::memory_order_release);
+   m_thread = std::thread(&AsyncWriter::run, this);
+}
+
+//******************************************************************************
+
+bool AsyncWriter::isRunning() const {
+   return m_isRunning.load(std::memory_order_acquire);
+}
+
+//******************************************************************************
+
+bool AsyncWriter::waitForSpace() {
+   wakeWriter();
+   std::unique_lock<std::mutex> lock(m_mutex);
+   if (!m_isRunning.load(std::memory_order_acquire)) {
+      return false;
+   }
+   m_numBlockedProducers.fetch_add(1);
+   m_spaceCond.wait_for(lock,
+                        std::chrono::milliseconds(BLOCKED_PRODUCER_WAIT_MS));
+   m_numBlockedProducers.fetch_sub(1);
+   return true;
+}
+
+//******************************************************************************
+
+void AsyncWriter::notifyEnqueued() {
+   // pairs with the fence in run() so that either the writer sees the new
+   // entry before sleeping or we see that it's idle and wake it
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if (m_isWriterIdle.load(std::memory_order_relaxed)) {
+      wakeWriter();
+   }
+}
+
+//******************************************************************************
+
+void AsyncWriter::wakeWriter() {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   m_writerCond.notify_one();
+}
+
+//******************************************************************************
+
+void AsyncWriter::stop() {
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (!m_isRunning.exchange(false)) {
+         return;
+      }
+      m_writerCond.notify_one();
+      m_spaceCond.notify_all();
+   }
+
+   if (m_thread.joinable()) {
+      m_thread.join();
+   }
+}
+
+//******************************************************************************
+
+void AsyncWriter::run() {
+   for (;;) {
+      const bool isStopping = !m_isRunning.load(std::memory_order_acquire);
+      const int waitMillis = writeQueued(isStopping);
+
+      if (m_numBlockedProducers.load(std::memory_order_relaxed) > 0) {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_spaceCond.notify_all();
+      }
+
+      if (isStopping) {
+         // final drain: anything enqueued before stop() is still written
+         if (isQueueEmpty()) {
+            break;
+         }
+         continue;
+      }
+
+      if (waitMillis == 0) {
+         continue;
+      }
+
+      std::chrono::milliseconds waitTime(MAX_IDLE_WAIT_MILLIS);
+      if ((waitMillis > 0) && (waitMillis < MAX_IDLE_WAIT_MILLIS)) {
+         waitTime = std::chrono::milliseconds(waitMillis);
+      }
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_isWriterIdle.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (isQueueEmpty() && m_isRunning.load(std::memory_order_acquire)) {
+         m_writerCond.wait_for(lock, waitTime);
+      }
+      m_isWriterIdle.store(false, std::memory_order_relaxed);
+   }
+}
+
+//******************************************************************************
+
+bool AsyncWriter::discardResponses(int fd) {
+   char buffer[DISCARD_BUFFER_SIZE];
+   ssize_t rc;
+   do {
+      rc = ::recv(fd, buffer, DISCARD_BUFFER_SIZE, MSG_DONTWAIT);
+   } while (rc > 0);
+
+   // (zero means the peer has closed its end)
+   return (rc != 0);
+}
+
+//******************************************************************************
+
+void AsyncWriter::countSent(std::uint64_t numberMessages) {
+   m_sentCount.fetch_add(numberMessages, std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+void AsyncWriter::countDropped(std::uint64_t numberMessages) {
+   m_droppedCount.fetch_add(numberMessages, std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+void AsyncWriter::countFailed(std::uint64_t numberMessages) {
+   m_failedCount.fetch_add(numberMessages, std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+std::uint64_t AsyncWriter::getSentCount() const {
+   return m_sentCount.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+std::uint64_t AsyncWriter::getDroppedCount() const {
+   return m_droppedCount.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+std::uint64_t AsyncWriter::getFailedCount() const {
+   return m_failedCount.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
@@ -0,0 +1,217 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_ASYNCWRITER_H
+#define TONNERRE_ASYNCWRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "BoundedQueue.h"
+#include "ServiceOptions.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * AsyncWriter is the background thread behind the one-way senders
+ * (BatchingSender, TopicSubscriber, UdpSender). Callers enqueue and return;
+ * the thread calls writeQueued to drain the queue and sleeps when there's
+ * nothing to write. A full queue is handled by the backpressure policy.
+ * The queue itself lives in AsyncQueueWriter, which is what a sender
+ * derives from.
+ * @see AsyncQueueWriter()
+ */
+class AsyncWriter
+{
+public:
+   /**
+    * Destructor
+    */
+   virtual ~AsyncWriter();
+
+   /**
+    * Writes whatever is still queued and stops the background thread
+    */
+   void stop();
+
+   /**
+    * Retrieves the number of messages written
+    * @return count of messages sent
+    */
+   std::uint64_t getSentCount() const;
+
+   /**
+    * Retrieves the number of messages discarded because of a full queue
+    * (drop-oldest) or rejected (fail)
+    * @return count of messages dropped
+    */
+   std::uint64_t getDroppedCount() const;
+
+   /**
+    * Retrieves the number of messages lost because a write failed
+    * @return count of messages that could not be written
+    */
+   std::uint64_t getFailedCount() const;
+
+protected:
+   // writeQueued return value for 'nothing pending, sleep until woken'
+   static const int NO_DEADLINE = -1;
+
+   /**
+    * Constructs the writer without starting its thread
+    * @param backpressure what enqueue does when the queue is full
+    */
+   explicit AsyncWriter(BackpressurePolicy backpressure);
+
+   /**
+    * Starts the background thread. Called at the end of the derived
+    * constructor, and the derived destructor must call stop(), since the
+    * thread calls writeQueued.
+    */
+   void start();
+
+   /**
+    * Drains the queue and writes what was taken (called on the background
+    * thread)
+    * @param isStopping true once stop() has been called, when nothing may
+    * be held back for later
+    * @return how long (in milliseconds) to sleep before the next call if
+    * nothing else is enqueued, 0 to call again right away, or NO_DEADLINE
+    */
+   virtual int writeQueued(bool isStopping) = 0;
+
+   /**
+    * Determines whether anything is waiting in the queue
+    * @return boolean indicating if the queue is empty
+    */
+   virtual bool isQueueEmpty() const = 0;
+
+   /**
+    * Determines whether enqueueing is still allowed
+    * @return boolean indicating if the writer is running
+    */
+   bool isRunning() const;
+
+   /**
+    * Holds up a producer briefly while the queue is full
+    * (BackpressureBlock)
+    * @return boolean indicating whether to retry (false after stop)
+    */
+   bool waitForSpace();
+
+   /**
+    * Wakes the background thread if it's asleep. Called after every
+    * successful enqueue.
+    */
+   void notifyEnqueued();
+
+   void countSent(std::uint64_t numberMessages);
+   void countDropped(std::uint64_t numberMessages);
+   void countFailed(std::uint64_t numberMessages);
+
+   /**
+    * Reads and throws away whatever the peer has sent back on a socket
+    * that's only written to; left unread, responses to one-way messages
+    * would eventually fill the socket buffers and stall the peer's writes
+    * @param fd the connected socket
+    * @return boolean indicating whether the connection is still open
+    */
+   static bool discardResponses(int fd);
+
+   const BackpressurePolicy m_backpressure;
+
+private:
+   void run();
+   void wakeWriter();
+
+   std::thread m_thread;
+   std::mutex m_mutex;
+   std::condition_variable m_writerCond;
+   std::condition_variable m_spaceCond;
+   std::atomic<bool> m_isRunning;
+   std::atomic<bool> m_isWriterIdle;
+   std::atomic<int> m_numBlockedProducers;
+   std::atomic<std::uint64_t> m_sentCount;
+   std::atomic<std::uint64_t> m_droppedCount;
+   std::atomic<std::uint64_t> m_failedCount;
+
+   AsyncWriter(const AsyncWriter&);
+   AsyncWriter& operator=(const AsyncWriter&);
+};
+
+/**
+ * AsyncQueueWriter adds the bounded queue of messages (of type T) to an
+ * AsyncWriter.
+ */
+template <typename T>
+class AsyncQueueWriter : public AsyncWriter
+{
+public:
+   /**
+    * Queues a message for the background thread
+    * @param message the message to write
+    * @return boolean indicating whether the message was queued (false when
+    * the queue is full and the policy is BackpressureFail, or after stop)
+    */
+   bool enqueue(const T& message) {
+      if (!isRunning()) {
+         return false;
+      }
+
+      T item(message);
+
+      while (!m_queue.tryPush(item)) {
+         if (m_backpressure == BackpressureFail) {
+            countDropped(1);
+            return false;
+         } else if (m_backpressure == BackpressureDropOldest) {
+            T oldest;
+            if (m_queue.tryPop(oldest)) {
+               countDropped(1);
+            }
+         } else if (!waitForSpace()) {
+            return false;
+         }
+      }
+
+      notifyEnqueued();
+      return true;
+   }
+
+protected:
+   /**
+    * Constructs the queue (the derived constructor calls start())
+    * @param capacity most messages that may wait to be written
+    * @param backpressure what enqueue does when the queue is full
+    */
+   AsyncQueueWriter(std::size_t capacity, BackpressurePolicy backpressure) :
+      AsyncWriter(backpressure),
+      m_queue(capacity) {
+   }
+
+   /**
+    * Takes the oldest queued message (called by writeQueued)
+    * @param item receives the message
+    * @return boolean indicating whether there was one
+    */
+   bool dequeue(T& item) {
+      return m_queue.tryPop(item);
+   }
+
+   bool isQueueEmpty() const override {
+      return m_queue.empty();
+   }
+
+private:
+   BoundedQueue<T> m_queue;
+};
+
+}
+
+#endif
@@ -0,0 +1,131 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <chrono>
+
+#include "BatchingSender.h"
+#include "UnixSocket.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+//******************************************************************************
+
+BatchingSender::BatchingSender(const ServiceInfo& serviceInfo,
+                               const ServiceOptions& options) :
+   AsyncQueueWriter<std::string>(options.getAsyncQueueSize(),
+                                 options.getAsyncBackpressure()),
+   m_serviceInfo(serviceInfo),
+   m_messagesInBatch(0),
+   m_batchCount(0),
+   m_batchBytes(options.getAsyncBatchBytes()),
+   m_lingerMillis(options.getAsyncLingerMillis()) {
+   TONNERRE_LOG_INSTANCE_CREATE("BatchingSender");
+   start();
+}
+
+//******************************************************************************
+
+BatchingSender::~BatchingSender() {
+   TONNERRE_LOG_INSTANCE_DESTROY("BatchingSender");
+   stop();
+}
+
+//******************************************************************************
+
+int BatchingSender::writeQueued(bool isStopping) {
+   // drain as much as fits in one batch
+   std::string message;
+   while ((m_batch.length() < m_batchBytes) && dequeue(message)) {
+      if (m_batch.empty()) {
+         m_batchStarted = std::chrono::steady_clock::now();
+      }
+      m_batch += message;
+      ++m_messagesInBatch;
+   }
+
+   if ((m_batch.length() >= m_batchBytes) || isStopping) {
+      flush();
+      return 0;
+   }
+
+   if (m_batch.empty()) {
+      return NO_DEADLINE;
+   }
+
+   const auto lingerDeadline =
+      m_batchStarted + std::chrono::milliseconds(m_lingerMillis);
+   const auto now = std::chrono::steady_clock::now();
+   if (now >= lingerDeadline) {
+      flush();
+      return 0;
+   }
+
+   return std::chrono::duration_cast<std::chrono::milliseconds>(
+             lingerDeadline - now).count() + 1;
+}
+
+//******************************************************************************
+
+void BatchingSender::flush() {
+   if (m_batch.empty()) {
+      return;
+   }
+
+   if (writeBatch(m_batch)) {
+      countSent(m_messagesInBatch);
+   } else {
+      countFailed(m_messagesInBatch);
+   }
+
+   m_batchCount.fetch_add(1, std::memory_order_relaxed);
+   m_batch.clear();
+   m_messagesInBatch = 0;
+}
+
+//******************************************************************************
+
+bool BatchingSender::writeBatch(const std::string& batch) {
+   // one reconnect attempt per batch: a connection the server has since
+   // closed shows up as a failed write
+   for (int attempt = 0; attempt < 2; ++attempt) {
+      if ((m_socket != nullptr) &&
+          !discardResponses(m_socket->getFileDescriptor())) {
+         // closed since the last batch -- after one message by a server
+         // with neither ingestion nor keep-alive enabled, or after
+         // keep_alive_idle_timeout_ms by one that has either
+         TONNERRE_LOG_WARNING("async sender's connection closed by service "
+                              "(is ingestion or keep_alive enabled?), reconnecting");
+         m_socket.reset();
+      }
+
+      if (m_socket == nullptr) {
+         m_socket.reset(UnixSocket::connectToService(m_serviceInfo));
+         if ((m_socket == nullptr) || !m_socket->isConnected()) {
+            m_socket.reset();
+            TONNERRE_LOG_ERROR("async sender unable to connect to service");
+            return false;
+         }
+      }
+
+      if (m_socket->write(batch)) {
+         // (a close noticed here is handled before the next batch)
+         discardResponses(m_socket->getFileDescriptor());
+         return true;
+      }
+
+      m_socket.reset();
+   }
+
+   TONNERRE_LOG_ERROR("async sender unable to write to socket");
+   return false;
+}
+
+//******************************************************************************
+
+std::uint64_t BatchingSender::getBatchCount() const {
+   return m_batchCount.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
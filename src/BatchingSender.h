@@ -0,0 +1,82 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_BATCHINGSENDER_H
+#define TONNERRE_BATCHINGSENDER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "AsyncWriter.h"
+#include "ServiceOptions.h"
+#include "ServiceInfo.h"
+#include "Socket.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * BatchingSender delivers one-way messages for a single service from a
+ * background thread. Callers only enqueue the flattened message; the sender
+ * drains the queue and coalesces consecutive messages into a single socket
+ * write, flushed when the batch reaches the configured size or when the
+ * oldest queued message has lingered for the configured time.
+ *
+ * All messages travel over one persistent connection, so the receiving
+ * server must run with ingestion or keep-alive enabled. A server with
+ * neither reads only the first message of each connection and closes it;
+ * the sender then logs a warning and reconnects, but the rest of that
+ * batch is lost.
+ * @see AsyncQueueWriter()
+ */
+class BatchingSender : public AsyncQueueWriter<std::string>
+{
+public:
+   /**
+    * Constructs a sender and starts its background thread
+    * @param serviceInfo the destination service
+    * @param options the async settings for the service
+    * @see ServiceInfo()
+    * @see ServiceOptions()
+    */
+   BatchingSender(const chaudiere::ServiceInfo& serviceInfo,
+                  const ServiceOptions& options);
+
+   /**
+    * Destructor. Flushes whatever is still queued before returning.
+    */
+   ~BatchingSender();
+
+   /**
+    * Retrieves the number of socket writes performed (one per batch)
+    * @return count of batch writes
+    */
+   std::uint64_t getBatchCount() const;
+
+protected:
+   int writeQueued(bool isStopping) override;
+
+private:
+   void flush();
+   bool writeBatch(const std::string& batch);
+
+   chaudiere::ServiceInfo m_serviceInfo;
+   std::unique_ptr<chaudiere::Socket> m_socket;
+   std::string m_batch;
+   std::uint64_t m_messagesInBatch;
+   std::chrono::steady_clock::time_point m_batchStarted;
+   std::atomic<std::uint64_t> m_batchCount;
+   const std::size_t m_batchBytes;
+   const int m_lingerMillis;
+
+   BatchingSender(const BatchingSender&);
+   BatchingSender& operator=(const BatchingSender&);
+};
+
+}
+
+#endif
@@ -0,0 +1,158 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_BOUNDEDQUEUE_H
+#define TONNERRE_BOUNDEDQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+
+namespace tonnerre
+{
+
+/**
+ * BoundedQueue is a fixed-capacity lock-free queue (a ring of sequenced
+ * cells). Any number of threads may push and pop concurrently. It is used
+ * as an MPSC queue for the one-way batching sender, where a producer may
+ * also pop to discard the oldest entry when the queue is full.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+   /**
+    * Constructs a queue
+    * @param capacity the maximum number of entries (rounded up to a power of 2)
+    */
+   explicit BoundedQueue(std::size_t capacity) :
+      m_capacity(roundUpToPowerOfTwo(capacity)),
+      m_mask(m_capacity - 1),
+      m_cells(new Cell[m_capacity]),
+      m_enqueuePos(0),
+      m_dequeuePos(0) {
+      for (std::size_t i = 0; i < m_capacity; ++i) {
+         m_cells[i].sequence.store(i, std::memory_order_relaxed);
+      }
+   }
+
+   /**
+    * Attempts to add an entry to the tail of the queue
+    * @param item the entry to add (moved from only on success)
+    * @return boolean indicating whether the entry was added (false if full)
+    */
+   bool tryPush(T& item) {
+      Cell* cell;
+      std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+
+      for (;;) {
+         cell = &m_cells[pos & m_mask];
+         const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+         const std::intptr_t dif = (std::intptr_t) seq - (std::intptr_t) pos;
+         if (dif == 0) {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                                   std::memory_order_relaxed)) {
+               break;
+            }
+         } else if (dif < 0) {
+            return false;
+         } else {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+         }
+      }
+
+      cell->data = std::move(item);
+      cell->sequence.store(pos + 1, std::memory_order_release);
+      return true;
+   }
+
+   /**
+    * Attempts to remove the entry at the head of the queue
+    * @param item populated with the removed entry
+    * @return boolean indicating whether an entry was removed (false if empty)
+    */
+   bool tryPop(T& item) {
+      Cell* cell;
+      std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+
+      for (;;) {
+         cell = &m_cells[pos & m_mask];
+         const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+         const std::intptr_t dif =
+            (std::intptr_t) seq - (std::intptr_t) (pos + 1);
+         if (dif == 0) {
+            if (m_dequeuePos.compare_exchange_weak(pos, pos + 1,
+                                                   std::memory_order_relaxed)) {
+               break;
+            }
+         } else if (dif < 0) {
+            return false;
+         } else {
+            pos = m_dequeuePos.load(std::memory_order_relaxed);
+         }
+      }
+
+      item = std::move(cell->data);
+      cell->data = T();
+      cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+      return true;
+   }
+
+   /**
+    * Retrieves the capacity of the queue
+    * @return maximum number of entries
+    */
+   std::size_t capacity() const {
+      return m_capacity;
+   }
+
+   /**
+    * Retrieves the number of entries (only approximate while other threads
+    * are pushing or popping)
+    * @return approximate number of entries
+    */
+   std::size_t sizeApprox() const {
+      const std::size_t enqueuePos = m_enqueuePos.load(std::memory_order_acquire);
+      const std::size_t dequeuePos = m_dequeuePos.load(std::memory_order_acquire);
+      return (enqueuePos > dequeuePos) ? (enqueuePos - dequeuePos) : 0;
+   }
+
+   /**
+    * Determines if the queue is empty (only approximate while other threads
+    * are pushing or popping)
+    * @return boolean indicating if the queue appears empty
+    */
+   bool empty() const {
+      return sizeApprox() == 0;
+   }
+
+private:
+   struct Cell {
+      std::atomic<std::size_t> sequence;
+      T data;
+   };
+
+   static std::size_t roundUpToPowerOfTwo(std::size_t value) {
+      std::size_t capacity = 2;
+      while (capacity < value) {
+         capacity <<= 1;
+      }
+      return capacity;
+   }
+
+   const std::size_t m_capacity;
+   const std::size_t m_mask;
+   std::unique_ptr<Cell[]> m_cells;
+   alignas(64) std::atomic<std::size_t> m_enqueuePos;
+   alignas(64) std::atomic<std::size_t> m_dequeuePos;
+
+   BoundedQueue(const BoundedQueue&);
+   BoundedQueue& operator=(const BoundedQueue&);
+};
+
+}
+
+#endif
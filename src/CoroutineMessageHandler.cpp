@@ -0,0 +1,103 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <coroutine>
+#include <exception>
+
+#include "CoroutineMessageHandler.h"
+#include "BasicException.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+namespace {
+
+// A coroutine nobody awaits: it runs until its first suspension on the
+// caller's thread and frees itself when it finishes.
+struct DetachedCoroutine {
+   struct promise_type {
+      DetachedCoroutine get_return_object() noexcept {
+         return {};
+      }
+
+      std::suspend_never initial_suspend() const noexcept {
+         return {};
+      }
+
+      std::suspend_never final_suspend() const noexcept {
+         return {};
+      }
+
+      void return_void() noexcept {
+      }
+
+      void unhandled_exception() noexcept {
+         TONNERRE_LOG_ERROR("exception escaped coroutine handler driver");
+      }
+   };
+};
+
+void logCoroutineException(std::exception_ptr exception) {
+   try {
+      std::rethrow_exception(exception);
+   } catch (const BasicException& be) {
+      TONNERRE_LOG_ERROR("exception caught in coroutine handler: " + be.whatString());
+   } catch (const std::exception& e) {
+      TONNERRE_LOG_ERROR("exception caught in coroutine handler: " + std::string(e.what()));
+   } catch (...) {
+      TONNERRE_LOG_ERROR("exception caught in coroutine handler");
+   }
+}
+
+// Runs the handler's task and completes the responder with its result. If
+// the handler throws, the responder is released uncompleted (sending an
+// empty response).
+template <typename T>
+DetachedCoroutine completeWith(Task<T> task, std::shared_ptr<Responder> responder) {
+   std::exception_ptr failure;
+   try {
+      T payload = co_await task;
+      responder->complete(payload);
+   } catch (...) {
+      failure = std::current_exception();
+   }
+
+   if (failure) {
+      logCoroutineException(failure);
+   }
+}
+
+}
+
+//******************************************************************************
+
+Task<std::string> CoroutineMessageHandler::handleTextMessageCoroutine(Message) {
+   co_return std::string();
+}
+
+//******************************************************************************
+
+Task<KeyValuePairs> CoroutineMessageHandler::handleKeyValuesMessageCoroutine(Message) {
+   co_return KeyValuePairs();
+}
+
+//******************************************************************************
+
+void CoroutineMessageHandler::handleTextMessageAsync(const Message& requestMessage,
+                                                     const std::string&,
+                                                     const std::string&,
+                                                     std::shared_ptr<Responder> responder) {
+   completeWith(handleTextMessageCoroutine(requestMessage), std::move(responder));
+}
+
+//******************************************************************************
+
+void CoroutineMessageHandler::handleKeyValuesMessageAsync(const Message& requestMessage,
+                                                          const std::string&,
+                                                          const KeyValuePairs&,
+                                                          std::shared_ptr<Responder> responder) {
+   completeWith(handleKeyValuesMessageCoroutine(requestMessage), std::move(responder));
+}
+
+//******************************************************************************
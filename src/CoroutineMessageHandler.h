@@ -0,0 +1,61 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_COROUTINEMESSAGEHANDLER_H
+#define TONNERRE_COROUTINEMESSAGEHANDLER_H
+
+#include <memory>
+#include <string>
+
+#include "AsyncMessageHandler.h"
+#include "Message.h"
+#include "Task.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * CoroutineMessageHandler is the base class for handlers written as C++20
+ * coroutines. A handler co_returns its response payload and can co_await
+ * downstream calls (AsyncClient::send) and timers (sleepFor) in between;
+ * while suspended, the request holds no thread.
+ *
+ * The request is passed by value so that it lives in the coroutine frame
+ * for as long as the coroutine runs.
+ */
+class CoroutineMessageHandler : public AsyncMessageHandler
+{
+public:
+   virtual ~CoroutineMessageHandler() {}
+
+   /**
+    * Handles a message with a text payload (Text type)
+    * @param requestMessage the request message
+    * @return task yielding the response payload text
+    */
+   virtual Task<std::string> handleTextMessageCoroutine(Message requestMessage);
+
+   /**
+    * Handles a message with a payload of key-value pairs (KeyValues type)
+    * @param requestMessage the request message
+    * @return task yielding the response payload
+    */
+   virtual Task<chaudiere::KeyValuePairs> handleKeyValuesMessageCoroutine(Message requestMessage);
+
+   // AsyncMessageHandler
+   void handleTextMessageAsync(const Message& requestMessage,
+                               const std::string& requestName,
+                               const std::string& requestPayload,
+                               std::shared_ptr<Responder> responder) override;
+
+   void handleKeyValuesMessageAsync(const Message& requestMessage,
+                                    const std::string& requestName,
+                                    const chaudiere::KeyValuePairs& requestPayload,
+                                    std::shared_ptr<Responder> responder) override;
+};
+
+}
+
+#endif
+
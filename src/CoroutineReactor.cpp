@@ -0,0 +1,202 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "CoroutineReactor.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+static const int MAX_POLL_WAIT_MILLIS = 1000;
+
+//******************************************************************************
+
+CoroutineReactor& CoroutineReactor::getReactor() {
+   static CoroutineReactor reactor;
+   return reactor;
+}
+
+//******************************************************************************
+
+CoroutineReactor::CoroutineReactor() :
+   m_isRunning(true) {
+   TONNERRE_LOG_INSTANCE_CREATE("CoroutineReactor");
+
+   if (::pipe(m_wakePipe) != 0) {
+      Logger::error("unable to create wake pipe for coroutine reactor");
+      m_wakePipe[0] = -1;
+      m_wakePipe[1] = -1;
+   } else {
+      ::fcntl(m_wakePipe[0], F_SETFL, O_NONBLOCK);
+      ::fcntl(m_wakePipe[1], F_SETFL, O_NONBLOCK);
+   }
+
+   m_thread = std::thread(&CoroutineReactor::run, this);
+}
+
+//******************************************************************************
+
+CoroutineReactor::~CoroutineReactor() {
+   TONNERRE_LOG_INSTANCE_DESTROY("CoroutineReactor");
+   stop();
+
+   if (m_wakePipe[0] != -1) {
+      ::close(m_wakePipe[0]);
+      ::close(m_wakePipe[1]);
+   }
+}
+
+//******************************************************************************
+
+void CoroutineReactor::resumeAfter(std::chrono::milliseconds delay,
+                                   std::coroutine_handle<> handle) {
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_timers.emplace(std::chrono::steady_clock::now() + delay, handle);
+   }
+   wake();
+}
+
+//******************************************************************************
+
+void CoroutineReactor::resumeWhenReady(int fd,
+                                       short events,
+                                       std::coroutine_handle<> handle) {
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_fdWaits.push_back(FdWait{fd, events, handle});
+   }
+   wake();
+}
+
+//******************************************************************************
+
+void CoroutineReactor::wake() {
+   if (m_wakePipe[1] != -1) {
+      const char wakeByte = 0;
+      ssize_t rc = ::write(m_wakePipe[1], &wakeByte, 1);
+      (void) rc;  // a full pipe already guarantees a wakeup
+   }
+}
+
+//******************************************************************************
+
+void CoroutineReactor::stop() {
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (!m_isRunning) {
+         return;
+      }
+      m_isRunning = false;
+   }
+
+   wake();
+
+   if (m_thread.joinable()) {
+      m_thread.join();
+   }
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+   const std::size_t waiting = m_fdWaits.size() + m_timers.size();
+   if (waiting > 0) {
+      Logger::warning("coroutine reactor stopped with " +
+                      std::to_string(waiting) + " coroutines waiting");
+   }
+}
+
+//******************************************************************************
+
+std::size_t CoroutineReactor::getWaitingCount() const {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   return m_fdWaits.size() + m_timers.size();
+}
+
+//******************************************************************************
+
+void CoroutineReactor::run() {
+   std::vector<struct pollfd> pollFds;
+   std::vector<FdWait> polledWaits;
+   std::vector<std::coroutine_handle<>> ready;
+
+   for (;;) {
+      int waitMillis = MAX_POLL_WAIT_MILLIS;
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if (!m_isRunning) {
+            return;
+         }
+
+         // the waits being polled are taken out of the shared list; anything
+         // registered meanwhile wakes us and is picked up next time round
+         polledWaits.swap(m_fdWaits);
+         m_fdWaits.clear();
+
+         if (!m_timers.empty()) {
+            const auto untilNext =
+               std::chrono::duration_cast<std::chrono::milliseconds>(
+                  m_timers.begin()->first - std::chrono::steady_clock::now()).count();
+            if (untilNext < waitMillis) {
+               waitMillis = (untilNext > 0) ? (int) untilNext : 0;
+            }
+         }
+      }
+
+      pollFds.resize(polledWaits.size() + 1);
+      pollFds[0].fd = m_wakePipe[0];
+      pollFds[0].events = POLLIN;
+      pollFds[0].revents = 0;
+
+      for (std::size_t i = 0; i < polledWaits.size(); ++i) {
+         pollFds[i+1].fd = polledWaits[i].fd;
+         pollFds[i+1].events = polledWaits[i].events;
+         pollFds[i+1].revents = 0;
+      }
+
+      const int rc = ::poll(pollFds.data(), pollFds.size(), waitMillis);
+      if ((rc < 0) && (errno != EINTR)) {
+         TONNERRE_LOG_ERROR("poll failed in coroutine reactor");
+      }
+
+      if (pollFds[0].revents & POLLIN) {
+         char drain[64];
+         while (::read(m_wakePipe[0], drain, sizeof(drain)) > 0) {
+         }
+      }
+
+      ready.clear();
+      std::vector<FdWait> stillWaiting;
+      for (std::size_t i = 0; i < polledWaits.size(); ++i) {
+         const short revents = (rc > 0) ? pollFds[i+1].revents : 0;
+         if (revents != 0) {
+            // readiness includes errors/hangup; the coroutine finds out
+            // what happened from its own read or write
+            ready.push_back(polledWaits[i].handle);
+         } else {
+            stillWaiting.push_back(polledWaits[i]);
+         }
+      }
+      polledWaits.clear();
+
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_fdWaits.insert(m_fdWaits.end(), stillWaiting.begin(), stillWaiting.end());
+
+         const auto now = std::chrono::steady_clock::now();
+         while (!m_timers.empty() && (m_timers.begin()->first <= now)) {
+            ready.push_back(m_timers.begin()->second);
+            m_timers.erase(m_timers.begin());
+         }
+      }
+
+      for (auto handle : ready) {
+         handle.resume();
+      }
+   }
+}
+
+//******************************************************************************
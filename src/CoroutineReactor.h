@@ -0,0 +1,156 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_COROUTINEREACTOR_H
+#define TONNERRE_COROUTINEREACTOR_H
+
+#include <chrono>
+#include <coroutine>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace tonnerre
+{
+
+/**
+ * CoroutineReactor is the I/O loop that suspended coroutines wait on: a
+ * single thread polling the descriptors coroutines are waiting to read or
+ * write, and sleeping until the next timer is due. Waiting coroutines hold
+ * no thread; they are resumed on the reactor's thread, so the code between
+ * two co_awaits should be short (or hand heavy work off elsewhere).
+ */
+class CoroutineReactor
+{
+public:
+   /**
+    * Retrieves the process-wide reactor, starting it on first use
+    * @return the reactor
+    */
+   static CoroutineReactor& getReactor();
+
+   /**
+    * Constructs and starts a reactor
+    */
+   CoroutineReactor();
+
+   /**
+    * Destructor (stops the reactor)
+    */
+   ~CoroutineReactor();
+
+   /**
+    * Resumes the coroutine once the delay has passed
+    * @param delay how long to wait
+    * @param handle the suspended coroutine
+    */
+   void resumeAfter(std::chrono::milliseconds delay, std::coroutine_handle<> handle);
+
+   /**
+    * Resumes the coroutine once the descriptor is ready (or in error)
+    * @param fd the descriptor
+    * @param events the poll events to wait for (POLLIN and/or POLLOUT)
+    * @param handle the suspended coroutine
+    */
+   void resumeWhenReady(int fd, short events, std::coroutine_handle<> handle);
+
+   /**
+    * Stops the reactor thread. Coroutines still waiting are not resumed.
+    */
+   void stop();
+
+   /**
+    * Retrieves the number of coroutines waiting on the reactor
+    * @return the number of waiting coroutines
+    */
+   std::size_t getWaitingCount() const;
+
+private:
+   struct FdWait {
+      int fd;
+      short events;
+      std::coroutine_handle<> handle;
+   };
+
+   void run();
+   void wake();
+
+   mutable std::mutex m_mutex;
+   std::vector<FdWait> m_fdWaits;
+   std::multimap<std::chrono::steady_clock::time_point, std::coroutine_handle<>> m_timers;
+   int m_wakePipe[2];
+   bool m_isRunning;
+   std::thread m_thread;
+
+   // disallow copies
+   CoroutineReactor(const CoroutineReactor&);
+   CoroutineReactor& operator=(const CoroutineReactor&);
+};
+
+/**
+ * SleepAwaitable suspends a coroutine for a fixed time (see sleepFor)
+ */
+class SleepAwaitable
+{
+public:
+   explicit SleepAwaitable(std::chrono::milliseconds delay) :
+      m_delay(delay) {
+   }
+
+   bool await_ready() const noexcept {
+      return m_delay.count() <= 0;
+   }
+
+   void await_suspend(std::coroutine_handle<> handle) {
+      CoroutineReactor::getReactor().resumeAfter(m_delay, handle);
+   }
+
+   void await_resume() const noexcept {
+   }
+
+private:
+   std::chrono::milliseconds m_delay;
+};
+
+/**
+ * FdAwaitable suspends a coroutine until a descriptor is ready
+ */
+class FdAwaitable
+{
+public:
+   FdAwaitable(int fd, short events) :
+      m_fd(fd),
+      m_events(events) {
+   }
+
+   bool await_ready() const noexcept {
+      return false;
+   }
+
+   void await_suspend(std::coroutine_handle<> handle) {
+      CoroutineReactor::getReactor().resumeWhenReady(m_fd, m_events, handle);
+   }
+
+   void await_resume() const noexcept {
+   }
+
+private:
+   int m_fd;
+   short m_events;
+};
+
+/**
+ * Suspends the calling coroutine (without holding a thread) for a time
+ * @param delay how long to wait
+ * @return the awaitable to co_await
+ */
+inline SleepAwaitable sleepFor(std::chrono::milliseconds delay) {
+   return SleepAwaitable(delay);
+}
+
+}
+
+#endif
+
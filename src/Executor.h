@@ -0,0 +1,47 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_EXECUTOR_H
+#define TONNERRE_EXECUTOR_H
+
+#include "Runnable.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * Executor is the interface (abstract base class) for the worker pools that
+ * tonnerre itself runs request handlers on (as opposed to the thread pool
+ * managed by chaudière's SocketServer).
+ */
+class Executor
+{
+public:
+   virtual ~Executor() {}
+
+   /**
+    * Queues a task to be run on one of the executor's threads
+    * @param task the task to run; ownership passes to the executor, which
+    * deletes it after its run() returns
+    * @return boolean indicating whether the task was accepted (false once
+    * the executor has been stopped, in which case the task is deleted)
+    * @see Runnable()
+    */
+   virtual bool execute(chaudiere::Runnable* task) = 0;
+
+   /**
+    * Stops accepting tasks, runs those already queued, and joins the threads
+    */
+   virtual void stop() = 0;
+
+   /**
+    * Retrieves the number of worker threads
+    * @return number of worker threads
+    */
+   virtual int getNumberWorkers() const = 0;
+};
+
+}
+
+#endif
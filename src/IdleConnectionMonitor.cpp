@@ -0,0 +1,216 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "IdleConnectionMonitor.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+static const int MAX_POLL_WAIT_MILLIS = 1000;
+
+//******************************************************************************
+
+IdleConnectionMonitor::IdleConnectionMonitor(int idleTimeoutMillis,
+                                             const ResumeCallback& resumeCallback) :
+   m_resumeCallback(resumeCallback),
+   m_idleTimeoutMillis(idleTimeoutMillis),
+   m_isRunning(true) {
+   TONNERRE_LOG_INSTANCE_CREATE("IdleConnectionMonitor");
+
+   if (::pipe(m_wakePipe) != 0) {
+      Logger::error("unable to create wake pipe for idle connection monitor");
+      m_wakePipe[0] = -1;
+      m_wakePipe[1] = -1;
+   } else {
+      ::fcntl(m_wakePipe[0], F_SETFL, O_NONBLOCK);
+      ::fcntl(m_wakePipe[1], F_SETFL, O_NONBLOCK);
+   }
+
+   m_thread = std::thread(&IdleConnectionMonitor::run, this);
+}
+
+//******************************************************************************
+
+IdleConnectionMonitor::~IdleConnectionMonitor() {
+   TONNERRE_LOG_INSTANCE_DESTROY("IdleConnectionMonitor");
+   stop();
+
+   if (m_wakePipe[0] != -1) {
+      ::close(m_wakePipe[0]);
+      ::close(m_wakePipe[1]);
+   }
+}
+
+//******************************************************************************
+
+bool IdleConnectionMonitor::park(Socket* socket, int requestsServed) {
+   if (socket == nullptr) {
+      return false;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_isRunning) {
+         ParkedConnection parked;
+         parked.socket = socket;
+         parked.requestsServed = requestsServed;
+         parked.idleDeadline = std::chrono::steady_clock::now() +
+            std::chrono::milliseconds(m_idleTimeoutMillis);
+         m_incoming.push_back(parked);
+      } else {
+         socket = nullptr;
+      }
+   }
+
+   if (socket == nullptr) {
+      return false;
+   }
+
+   wake();
+   return true;
+}
+
+//******************************************************************************
+
+void IdleConnectionMonitor::wake() {
+   if (m_wakePipe[1] != -1) {
+      const char wakeByte = 0;
+      ssize_t rc = ::write(m_wakePipe[1], &wakeByte, 1);
+      (void) rc;  // a full pipe already guarantees a wakeup
+   }
+}
+
+//******************************************************************************
+
+void IdleConnectionMonitor::stop() {
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (!m_isRunning) {
+         return;
+      }
+      m_isRunning = false;
+   }
+
+   wake();
+
+   if (m_thread.joinable()) {
+      m_thread.join();
+   }
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+   for (auto& parked : m_parked) {
+      delete parked.socket;
+   }
+   for (auto& parked : m_incoming) {
+      delete parked.socket;
+   }
+   m_parked.clear();
+   m_incoming.clear();
+}
+
+//******************************************************************************
+
+std::size_t IdleConnectionMonitor::getParkedCount() const {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   return m_parked.size() + m_incoming.size();
+}
+
+//******************************************************************************
+
+void IdleConnectionMonitor::run() {
+   std::vector<struct pollfd> pollFds;
+   std::vector<ParkedConnection> resumable;
+
+   for (;;) {
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if (!m_isRunning) {
+            return;
+         }
+         m_parked.insert(m_parked.end(), m_incoming.begin(), m_incoming.end());
+         m_incoming.clear();
+
+         pollFds.resize(m_parked.size() + 1);
+         pollFds[0].fd = m_wakePipe[0];
+         pollFds[0].events = POLLIN;
+         pollFds[0].revents = 0;
+
+         for (std::size_t i = 0; i < m_parked.size(); ++i) {
+            pollFds[i+1].fd = m_parked[i].socket->getFileDescriptor();
+            pollFds[i+1].events = POLLIN;
+            pollFds[i+1].revents = 0;
+         }
+      }
+
+      // sleep until the nearest idle deadline (the list only changes on
+      // this thread, apart from appends to m_incoming which wake us)
+      const auto now = std::chrono::steady_clock::now();
+      int waitMillis = MAX_POLL_WAIT_MILLIS;
+      for (const auto& parked : m_parked) {
+         const auto remaining =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+               parked.idleDeadline - now).count();
+         if (remaining < waitMillis) {
+            waitMillis = (remaining > 0) ? (int) remaining : 0;
+         }
+      }
+
+      const int rc = ::poll(pollFds.data(), pollFds.size(), waitMillis);
+      if ((rc < 0) && (errno != EINTR)) {
+         TONNERRE_LOG_ERROR("poll failed in idle connection monitor");
+      }
+
+      if (pollFds[0].revents & POLLIN) {
+         char drain[64];
+         while (::read(m_wakePipe[0], drain, sizeof(drain)) > 0) {
+         }
+      }
+
+      const auto afterPoll = std::chrono::steady_clock::now();
+      std::vector<ParkedConnection> stillParked;
+      resumable.clear();
+
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         for (std::size_t i = 0; i < m_parked.size(); ++i) {
+            ParkedConnection& parked = m_parked[i];
+            const short revents = (rc > 0) ? pollFds[i+1].revents : 0;
+
+            if (revents & POLLIN) {
+               // readable could also mean the peer closed its end
+               char peekByte;
+               const ssize_t peeked =
+                  ::recv(parked.socket->getFileDescriptor(), &peekByte, 1,
+                         MSG_PEEK | MSG_DONTWAIT);
+               if (peeked > 0) {
+                  resumable.push_back(parked);
+               } else {
+                  delete parked.socket;
+               }
+            } else if (revents & (POLLHUP | POLLERR | POLLNVAL)) {
+               delete parked.socket;
+            } else if (afterPoll >= parked.idleDeadline) {
+               // idle timeout
+               delete parked.socket;
+            } else {
+               stillParked.push_back(parked);
+            }
+         }
+         m_parked.swap(stillParked);
+      }
+
+      for (auto& parked : resumable) {
+         m_resumeCallback(parked.socket, parked.requestsServed);
+      }
+   }
+}
+
+//******************************************************************************
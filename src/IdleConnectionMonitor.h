@@ -0,0 +1,94 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_IDLECONNECTIONMONITOR_H
+#define TONNERRE_IDLECONNECTIONMONITOR_H
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Socket.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * IdleConnectionMonitor is a small poll-based event loop that holds
+ * keep-alive connections between requests, so that no worker thread has to
+ * sit in a blocking read waiting for a client's next message. When a parked
+ * connection becomes readable it is handed to the resume callback; when it
+ * stays idle past the idle timeout (or the peer closes it) it is closed.
+ */
+class IdleConnectionMonitor
+{
+public:
+   /**
+    * Callback invoked (on the monitor's thread) when a parked connection has
+    * a new message waiting. Receives ownership of the socket along with the
+    * number of requests already served on the connection.
+    */
+   typedef std::function<void(chaudiere::Socket*, int)> ResumeCallback;
+
+   /**
+    * Constructs the monitor and starts its thread
+    * @param idleTimeoutMillis how long a parked connection may stay idle
+    * @param resumeCallback called when a parked connection becomes readable
+    */
+   IdleConnectionMonitor(int idleTimeoutMillis,
+                         const ResumeCallback& resumeCallback);
+
+   /**
+    * Destructor (stops the monitor, closing any parked connections)
+    */
+   ~IdleConnectionMonitor();
+
+   /**
+    * Parks an idle connection until it becomes readable or times out
+    * @param socket the connection (ownership passes to the monitor)
+    * @param requestsServed the number of requests served on it so far
+    * @return boolean indicating if the connection was parked (if not, the
+    * monitor has been stopped and the socket has been deleted)
+    */
+   bool park(chaudiere::Socket* socket, int requestsServed);
+
+   /**
+    * Stops the monitor thread and closes all parked connections
+    */
+   void stop();
+
+   /**
+    * Retrieves the number of connections currently parked
+    * @return number of parked connections
+    */
+   std::size_t getParkedCount() const;
+
+private:
+   struct ParkedConnection {
+      chaudiere::Socket* socket;
+      int requestsServed;
+      std::chrono::steady_clock::time_point idleDeadline;
+   };
+
+   void run();
+   void wake();
+
+   std::vector<ParkedConnection> m_parked;
+   std::vector<ParkedConnection> m_incoming;
+   ResumeCallback m_resumeCallback;
+   std::thread m_thread;
+   mutable std::mutex m_mutex;
+   const int m_idleTimeoutMillis;
+   int m_wakePipe[2];
+   bool m_isRunning;
+
+   IdleConnectionMonitor(const IdleConnectionMonitor&);
+   IdleConnectionMonitor& operator=(const IdleConnectionMonitor&);
+};
+
+}
+
+#endif
@@ -0,0 +1,136 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "InProcessRegistry.h"
+#include "Message.h"
+#include "MessageHandler.h"
+#include "MessageRequestHandler.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+std::unordered_map<std::string, std::shared_ptr<InProcessRegistry::Registration>>
+   InProcessRegistry::registrations;
+std::shared_mutex InProcessRegistry::mutex;
+std::mutex InProcessRegistry::mutexCallsDone;
+std::condition_variable InProcessRegistry::callsDone;
+std::atomic<bool> InProcessRegistry::hasRegistrations(false);
+
+//******************************************************************************
+
+void InProcessRegistry::registerService(const std::string& serviceName,
+                                        MessageHandler* handler,
+                                        AdmissionController* admissionController,
+                                        ServerMetrics* metrics) {
+   std::shared_ptr<Registration> registration(new Registration);
+   registration->handler = handler;
+   registration->admissionController = admissionController;
+   registration->metrics = metrics;
+   registration->callsInFlight.store(0);
+   registration->isRemoved.store(false);
+
+   std::unique_lock<std::shared_mutex> lock(mutex);
+   registrations[serviceName] = registration;
+   hasRegistrations.store(true);
+}
+
+//******************************************************************************
+
+void InProcessRegistry::unregisterService(const std::string& serviceName) {
+   std::shared_ptr<Registration> registration;
+   {
+      std::unique_lock<std::shared_mutex> lock(mutex);
+      auto it = registrations.find(serviceName);
+      if (it == registrations.end()) {
+         return;
+      }
+
+      registration = (*it).second;
+      registrations.erase(it);
+      hasRegistrations.store(!registrations.empty());
+   }
+
+   // the handler may be destroyed once this returns
+   std::unique_lock<std::mutex> lock(mutexCallsDone);
+   registration->isRemoved.store(true);
+   callsDone.wait(lock, [&registration]() {
+      return registration->callsInFlight.load() == 0;
+   });
+}
+
+//******************************************************************************
+
+bool InProcessRegistry::hasService(const std::string& serviceName) {
+   // (processes without an in-process server never take the lock)
+   if (!hasRegistrations.load()) {
+      return false;
+   }
+
+   std::shared_lock<std::shared_mutex> lock(mutex);
+   return registrations.find(serviceName) != registrations.end();
+}
+
+//******************************************************************************
+
+bool InProcessRegistry::call(const std::string& serviceName,
+                             Message& requestMessage,
+                             Message& responseMessage) {
+   if (!hasRegistrations.load()) {
+      return false;
+   }
+
+   std::shared_ptr<Registration> registration(acquire(serviceName));
+   if (registration == nullptr) {
+      return false;
+   }
+
+   // lets a handler hosting several services route the request
+   requestMessage.setServiceName(serviceName);
+
+   if (registration->handler->asyncHandlerFor(requestMessage) != nullptr) {
+      release(registration);
+      return false;
+   }
+
+   responseMessage = Message(requestMessage.getRequestName(),
+                             requestMessage.getType());
+
+   // (nothing crosses the wire, so no bytes are counted)
+   MessageRequestHandler::serveRequest(registration->handler,
+                                       registration->admissionController,
+                                       registration->metrics,
+                                       requestMessage, 0, responseMessage,
+                                       MessageRequestHandler::ResponseWriter(),
+                                       nullptr);
+
+   release(registration);
+   return true;
+}
+
+//******************************************************************************
+
+std::shared_ptr<InProcessRegistry::Registration>
+InProcessRegistry::acquire(const std::string& serviceName) {
+   // (senders only ever share the lock, so concurrent calls don't contend)
+   std::shared_lock<std::shared_mutex> lock(mutex);
+   auto it = registrations.find(serviceName);
+   if (it == registrations.end()) {
+      return nullptr;
+   }
+
+   (*it).second->callsInFlight.fetch_add(1);
+   return (*it).second;
+}
+
+//******************************************************************************
+
+void InProcessRegistry::release(const std::shared_ptr<Registration>& registration) {
+   if ((registration->callsInFlight.fetch_sub(1) == 1) &&
+       registration->isRemoved.load()) {
+      std::lock_guard<std::mutex> lock(mutexCallsDone);
+      callsDone.notify_all();
+   }
+}
+
+//******************************************************************************
@@ -0,0 +1,98 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_INPROCESSREGISTRY_H
+#define TONNERRE_INPROCESSREGISTRY_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+
+namespace tonnerre
+{
+   class AdmissionController;
+   class Message;
+   class MessageHandler;
+   class ServerMetrics;
+
+/**
+ * InProcessRegistry records the services hosted by the messaging servers
+ * running in this process, so that a message sent to one of them from the
+ * same process is handed straight to its handler: no encoding, no socket,
+ * no parsing. The request is handled on the sender's thread, with the
+ * server's stats, admission control, tracing and metrics applied just as
+ * for a request read off a connection, and a handler exception produces
+ * the same (empty) response. Requests for asynchronous handlers still go
+ * over the network, since their responders answer through a connection.
+ * @see MessagingServer()
+ */
+class InProcessRegistry
+{
+public:
+   /**
+    * Registers a service hosted in this process (replacing any existing
+    * registration)
+    * @param serviceName the name of the service (as clients send to it)
+    * @param handler the handler for the service's requests (not owned)
+    * @param admissionController the server's admission controller (not
+    * owned; may be null)
+    * @param metrics the server's metrics (not owned; may be null)
+    */
+   static void registerService(const std::string& serviceName,
+                               MessageHandler* handler,
+                               AdmissionController* admissionController,
+                               ServerMetrics* metrics);
+
+   /**
+    * Removes a service, waiting for requests already handed to its
+    * handler to complete
+    * @param serviceName the name of the service
+    */
+   static void unregisterService(const std::string& serviceName);
+
+   /**
+    * Determines if a service is hosted in this process
+    * @param serviceName the name of the service
+    * @return boolean indicating if the service is registered
+    */
+   static bool hasService(const std::string& serviceName);
+
+   /**
+    * Hands a request to an in-process service's handler (used internally)
+    * @param serviceName the name of the destination service
+    * @param requestMessage the request (its service name is set)
+    * @param responseMessage the message to populate with the response
+    * @return boolean indicating if the request was handled in-process (if
+    * not, it should be sent over the network)
+    */
+   static bool call(const std::string& serviceName,
+                    Message& requestMessage,
+                    Message& responseMessage);
+
+private:
+   struct Registration {
+      MessageHandler* handler;
+      AdmissionController* admissionController;
+      ServerMetrics* metrics;
+      std::atomic<int> callsInFlight;
+      std::atomic<bool> isRemoved;
+   };
+
+   static std::shared_ptr<Registration> acquire(const std::string& serviceName);
+   static void release(const std::shared_ptr<Registration>& registration);
+
+   static std::unordered_map<std::string, std::shared_ptr<Registration>> registrations;
+   static std::shared_mutex mutex;
+   static std::mutex mutexCallsDone;
+   static std::condition_variable callsDone;
+   static std::atomic<bool> hasRegistrations;
+};
+
+}
+
+#endif
@@ -0,0 +1,502 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <cstring>
+#include <errno.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+// headers from before 6.0 lack multishot receive
+#if defined(IORING_RECV_MULTISHOT) && defined(IORING_SETUP_SINGLE_ISSUER)
+#define TONNERRE_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+#include "IoUring.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+#if defined(TONNERRE_HAVE_IO_URING)
+
+// every provided buffer belongs to this one group
+static const unsigned short BUFFER_GROUP_ID        = 0;
+
+// multishot operations can post several completions per submission
+static const unsigned CQ_ENTRIES_PER_SQ_ENTRY      = 4;
+
+//******************************************************************************
+
+static bool probeSupport() {
+   IoUring ring(8);
+   return ring.isValid() && ring.registerBuffers(2, 64);
+}
+
+#endif
+
+//******************************************************************************
+
+bool IoUring::isSupported() {
+#if defined(TONNERRE_HAVE_IO_URING)
+   static const bool supported = probeSupport();
+   return supported;
+#else
+   return false;
+#endif
+}
+
+//******************************************************************************
+
+bool IoUring::hasMore(unsigned flags) {
+#if defined(TONNERRE_HAVE_IO_URING)
+   return (flags & IORING_CQE_F_MORE) != 0;
+#else
+   (void) flags;
+   return false;
+#endif
+}
+
+//******************************************************************************
+
+int IoUring::bufferId(unsigned flags) {
+#if defined(TONNERRE_HAVE_IO_URING)
+   if (flags & IORING_CQE_F_BUFFER) {
+      return (int) (flags >> IORING_CQE_BUFFER_SHIFT);
+   }
+#else
+   (void) flags;
+#endif
+   return -1;
+}
+
+//******************************************************************************
+
+IoUring::IoUring(unsigned entries) :
+   m_ringFd(-1),
+   m_sqEntries(0),
+   m_ring(nullptr),
+   m_ringSize(0),
+   m_sqes(nullptr),
+   m_sqesSize(0),
+   m_sqHead(nullptr),
+   m_sqTail(nullptr),
+   m_sqMask(nullptr),
+   m_sqArray(nullptr),
+   m_cqHead(nullptr),
+   m_cqTail(nullptr),
+   m_cqMask(nullptr),
+   m_cqes(nullptr),
+   m_sqeTail(0),
+   m_sqeSubmitted(0),
+   m_bufferRing(nullptr),
+   m_bufferRingSize(0),
+   m_buffers(nullptr),
+   m_numberBuffers(0),
+   m_bufferSize(0) {
+   TONNERRE_LOG_INSTANCE_CREATE("IoUring");
+
+#if defined(TONNERRE_HAVE_IO_URING)
+   struct io_uring_params params;
+   std::memset(&params, 0, sizeof(params));
+   // single issuer doubles as the check for a 6.0+ kernel (multishot recv)
+   params.flags = IORING_SETUP_SINGLE_ISSUER |
+                  IORING_SETUP_COOP_TASKRUN |
+                  IORING_SETUP_SUBMIT_ALL |
+                  IORING_SETUP_CQSIZE;
+   params.cq_entries = entries * CQ_ENTRIES_PER_SQ_ENTRY;
+
+   const int ringFd = (int) ::syscall(__NR_io_uring_setup, entries, &params);
+   if (ringFd < 0) {
+      return;
+   }
+
+   if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP)) {
+      ::close(ringFd);
+      return;
+   }
+
+   const std::size_t sqRingSize =
+      params.sq_off.array + params.sq_entries * sizeof(unsigned);
+   const std::size_t cqRingSize =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+   const std::size_t ringSize = (sqRingSize > cqRingSize) ? sqRingSize : cqRingSize;
+
+   void* ring = ::mmap(nullptr, ringSize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+   if (ring == MAP_FAILED) {
+      ::close(ringFd);
+      return;
+   }
+
+   const std::size_t sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+   void* sqes = ::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+   if (sqes == MAP_FAILED) {
+      ::munmap(ring, ringSize);
+      ::close(ringFd);
+      return;
+   }
+
+   char* base = (char*) ring;
+   m_ringFd = ringFd;
+   m_sqEntries = params.sq_entries;
+   m_ring = ring;
+   m_ringSize = ringSize;
+   m_sqes = sqes;
+   m_sqesSize = sqesSize;
+   m_sqHead = (unsigned*) (base + params.sq_off.head);
+   m_sqTail = (unsigned*) (base + params.sq_off.tail);
+   m_sqMask = (unsigned*) (base + params.sq_off.ring_mask);
+   m_sqArray = (unsigned*) (base + params.sq_off.array);
+   m_cqHead = (unsigned*) (base + params.cq_off.head);
+   m_cqTail = (unsigned*) (base + params.cq_off.tail);
+   m_cqMask = (unsigned*) (base + params.cq_off.ring_mask);
+   m_cqes = base + params.cq_off.cqes;
+   m_sqeTail = *m_sqTail;
+   m_sqeSubmitted = m_sqeTail;
+
+   if (!probeOperations()) {
+      Logger::info("io_uring lacks operations needed by tonnerre");
+      ::munmap(m_sqes, m_sqesSize);
+      ::munmap(m_ring, m_ringSize);
+      ::close(m_ringFd);
+      m_ringFd = -1;
+   }
+#else
+   (void) entries;
+#endif
+}
+
+//******************************************************************************
+
+IoUring::~IoUring() {
+   TONNERRE_LOG_INSTANCE_DESTROY("IoUring");
+
+#if defined(TONNERRE_HAVE_IO_URING)
+   if (m_ringFd != -1) {
+      // closing the ring cancels whatever is still in flight and drops the
+      // kernel's references to the buffer ring
+      ::close(m_ringFd);
+      ::munmap(m_sqes, m_sqesSize);
+      ::munmap(m_ring, m_ringSize);
+   }
+
+   if (m_bufferRing != nullptr) {
+      ::munmap(m_bufferRing, m_bufferRingSize);
+   }
+#endif
+
+   delete [] m_buffers;
+}
+
+//******************************************************************************
+
+bool IoUring::isValid() const {
+   return m_ringFd != -1;
+}
+
+//******************************************************************************
+
+bool IoUring::probeOperations() const {
+#if defined(TONNERRE_HAVE_IO_URING)
+   const unsigned numberOps = 256;
+   std::vector<char> storage(sizeof(struct io_uring_probe) +
+                             numberOps * sizeof(struct io_uring_probe_op));
+   struct io_uring_probe* probe = (struct io_uring_probe*) storage.data();
+
+   if (::syscall(__NR_io_uring_register, m_ringFd, IORING_REGISTER_PROBE,
+                 probe, numberOps) != 0) {
+      return false;
+   }
+
+   const unsigned required[] = {
+      IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_READ
+   };
+   for (unsigned op : required) {
+      if ((op >= probe->ops_len) ||
+          !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+         return false;
+      }
+   }
+
+   return true;
+#else
+   return false;
+#endif
+}
+
+//******************************************************************************
+
+bool IoUring::registerBuffers(unsigned numberBuffers, unsigned bufferSize) {
+#if defined(TONNERRE_HAVE_IO_URING)
+   if ((m_ringFd == -1) || (m_bufferRing != nullptr) ||
+       (numberBuffers == 0) || ((numberBuffers & (numberBuffers - 1)) != 0)) {
+      return false;
+   }
+
+   const std::size_t ringSize = numberBuffers * sizeof(struct io_uring_buf);
+   void* bufferRing = ::mmap(nullptr, ringSize, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (bufferRing == MAP_FAILED) {
+      return false;
+   }
+
+   struct io_uring_buf_reg reg;
+   std::memset(&reg, 0, sizeof(reg));
+   reg.ring_addr = (unsigned long) bufferRing;
+   reg.ring_entries = numberBuffers;
+   reg.bgid = BUFFER_GROUP_ID;
+
+   if (::syscall(__NR_io_uring_register, m_ringFd, IORING_REGISTER_PBUF_RING,
+                 &reg, 1) != 0) {
+      ::munmap(bufferRing, ringSize);
+      return false;
+   }
+
+   m_bufferRing = bufferRing;
+   m_bufferRingSize = ringSize;
+   m_buffers = new char[(std::size_t) numberBuffers * bufferSize];
+   m_numberBuffers = numberBuffers;
+   m_bufferSize = bufferSize;
+
+   for (unsigned i = 0; i < numberBuffers; ++i) {
+      recycleBuffer((int) i);
+   }
+
+   return true;
+#else
+   (void) numberBuffers;
+   (void) bufferSize;
+   return false;
+#endif
+}
+
+//******************************************************************************
+
+const char* IoUring::bufferData(int bufferId) const {
+   return m_buffers + ((std::size_t) bufferId * m_bufferSize);
+}
+
+//******************************************************************************
+
+void IoUring::recycleBuffer(int bufferId) {
+#if defined(TONNERRE_HAVE_IO_URING)
+   // the ring is addressed as a plain array of entries: compiled as C++,
+   // the uapi's flexible array in io_uring_buf_ring starts 8 bytes late.
+   // The ring's tail overlays the first entry's reserved field.
+   struct io_uring_buf* bufs = (struct io_uring_buf*) m_bufferRing;
+   unsigned short* ringTail = &bufs[0].resv;
+   const unsigned short tail = *ringTail;
+
+   struct io_uring_buf* buf = &bufs[tail & (m_numberBuffers - 1)];
+   buf->addr = (unsigned long) bufferData(bufferId);
+   buf->len = m_bufferSize;
+   buf->bid = (unsigned short) bufferId;
+
+   // the kernel may pick the buffer as soon as it sees the new tail
+   __atomic_store_n(ringTail, (unsigned short) (tail + 1), __ATOMIC_RELEASE);
+#else
+   (void) bufferId;
+#endif
+}
+
+//******************************************************************************
+
+void* IoUring::nextSqe() {
+#if defined(TONNERRE_HAVE_IO_URING)
+   if (m_ringFd == -1) {
+      return nullptr;
+   }
+
+   unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+   if ((m_sqeTail - head) >= m_sqEntries) {
+      // submission queue full -- push this batch out early
+      if (!submitPending(0)) {
+         return nullptr;
+      }
+      head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+      if ((m_sqeTail - head) >= m_sqEntries) {
+         return nullptr;
+      }
+   }
+
+   const unsigned index = m_sqeTail & *m_sqMask;
+   struct io_uring_sqe* sqe = ((struct io_uring_sqe*) m_sqes) + index;
+   std::memset(sqe, 0, sizeof(*sqe));
+   m_sqArray[index] = index;
+   ++m_sqeTail;
+   return sqe;
+#else
+   return nullptr;
+#endif
+}
+
+//******************************************************************************
+
+bool IoUring::prepareAccept(int listenFd, std::uint64_t userData) {
+#if defined(TONNERRE_HAVE_IO_URING)
+   struct io_uring_sqe* sqe = (struct io_uring_sqe*) nextSqe();
+   if (sqe == nullptr) {
+      return false;
+   }
+
+   sqe->opcode = IORING_OP_ACCEPT;
+   sqe->fd = listenFd;
+   sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+   sqe->accept_flags = SOCK_CLOEXEC;
+   sqe->user_data = userData;
+   return true;
+#else
+   (void) listenFd;
+   (void) userData;
+   return false;
+#endif
+}
+
+//******************************************************************************
+
+bool IoUring::prepareRecv(int fd, std::uint64_t userData) {
+#if defined(TONNERRE_HAVE_IO_URING)
+   struct io_uring_sqe* sqe = (struct io_uring_sqe*) nextSqe();
+   if (sqe == nullptr) {
+      return false;
+   }
+
+   sqe->opcode = IORING_OP_RECV;
+   sqe->fd = fd;
+   sqe->ioprio = IORING_RECV_MULTISHOT;
+   sqe->flags = IOSQE_BUFFER_SELECT;
+   sqe->buf_group = BUFFER_GROUP_ID;
+   sqe->user_data = userData;
+   return true;
+#else
+   (void) fd;
+   (void) userData;
+   return false;
+#endif
+}
+
+//******************************************************************************
+
+bool IoUring::prepareSend(int fd, const char* data, std::size_t length,
+                          std::uint64_t userData) {
+#if defined(TONNERRE_HAVE_IO_URING)
+   struct io_uring_sqe* sqe = (struct io_uring_sqe*) nextSqe();
+   if (sqe == nullptr) {
+      return false;
+   }
+
+   sqe->opcode = IORING_OP_SEND;
+   sqe->fd = fd;
+   sqe->addr = (unsigned long) data;
+   sqe->len = (unsigned) length;
+   sqe->msg_flags = MSG_NOSIGNAL;
+   sqe->user_data = userData;
+   return true;
+#else
+   (void) fd;
+   (void) data;
+   (void) length;
+   (void) userData;
+   return false;
+#endif
+}
+
+//******************************************************************************
+
+bool IoUring::prepareRead(int fd, void* buffer, std::size_t length,
+                          std::uint64_t userData) {
+#if defined(TONNERRE_HAVE_IO_URING)
+   struct io_uring_sqe* sqe = (struct io_uring_sqe*) nextSqe();
+   if (sqe == nullptr) {
+      return false;
+   }
+
+   sqe->opcode = IORING_OP_READ;
+   sqe->fd = fd;
+   sqe->addr = (unsigned long) buffer;
+   sqe->len = (unsigned) length;
+   sqe->off = (std::uint64_t) -1;
+   sqe->user_data = userData;
+   return true;
+#else
+   (void) fd;
+   (void) buffer;
+   (void) length;
+   (void) userData;
+   return false;
+#endif
+}
+
+//******************************************************************************
+
+bool IoUring::submitAndWait() {
+   return submitPending(1);
+}
+
+//******************************************************************************
+
+bool IoUring::submitPending(unsigned minComplete) {
+#if defined(TONNERRE_HAVE_IO_URING)
+   if (m_ringFd == -1) {
+      return false;
+   }
+
+   __atomic_store_n(m_sqTail, m_sqeTail, __ATOMIC_RELEASE);
+
+   const unsigned toSubmit = m_sqeTail - m_sqeSubmitted;
+   const unsigned flags = (minComplete > 0) ? IORING_ENTER_GETEVENTS : 0;
+   const int rc = (int) ::syscall(__NR_io_uring_enter, m_ringFd, toSubmit,
+                                  minComplete, flags, nullptr, 0);
+   if (rc < 0) {
+      // interrupted before anything was submitted; the batch is still
+      // queued and goes out with the next call
+      return (errno == EINTR) || (errno == EAGAIN) || (errno == EBUSY);
+   }
+
+   m_sqeSubmitted += (unsigned) rc;
+   return true;
+#else
+   (void) minComplete;
+   return false;
+#endif
+}
+
+//******************************************************************************
+
+std::size_t IoUring::reapCompletions(std::vector<Completion>& completions) {
+#if defined(TONNERRE_HAVE_IO_URING)
+   if (m_ringFd == -1) {
+      return 0;
+   }
+
+   unsigned head = *m_cqHead;
+   const unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+   const struct io_uring_cqe* cqes = (const struct io_uring_cqe*) m_cqes;
+   std::size_t reaped = 0;
+
+   for (; head != tail; ++head, ++reaped) {
+      const struct io_uring_cqe& cqe = cqes[head & *m_cqMask];
+      Completion completion;
+      completion.userData = cqe.user_data;
+      completion.result = cqe.res;
+      completion.flags = cqe.flags;
+      completions.push_back(completion);
+   }
+
+   __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+   return reaped;
+#else
+   (void) completions;
+   return 0;
+#endif
+}
+
+//******************************************************************************
@@ -0,0 +1,187 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_IOURING_H
+#define TONNERRE_IOURING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace tonnerre
+{
+
+/**
+ * IoUring is a minimal wrapper over a Linux io_uring instance, made with
+ * the raw system calls (no liburing dependency). Besides queueing the few
+ * operations the messaging server needs, it owns one ring of provided
+ * receive buffers registered with the kernel, from which multishot
+ * receives pick a buffer per completion.
+ *
+ * An instance must be created and used by a single thread. On platforms
+ * (or kernel headers) without the needed io_uring features isSupported()
+ * is false and no instance is ever valid.
+ */
+class IoUring
+{
+public:
+   /**
+    * A completed operation, copied out of the completion queue
+    */
+   struct Completion {
+      std::uint64_t userData;
+      int result;
+      unsigned flags;
+   };
+
+   /**
+    * Determines whether the running kernel supports everything the
+    * io_uring backend uses (multishot accept and receive, provided buffer
+    * rings, single-issuer rings). The answer is cached after the first call.
+    * @return boolean indicating if io_uring can be used
+    */
+   static bool isSupported();
+
+   /**
+    * Determines whether more completions will follow for a multishot operation
+    * @param flags the completion's flags
+    * @return boolean indicating if the operation is still armed
+    */
+   static bool hasMore(unsigned flags);
+
+   /**
+    * Retrieves the provided buffer that a receive completion filled
+    * @param flags the completion's flags
+    * @return the buffer id, or -1 if the completion carries no buffer
+    */
+   static int bufferId(unsigned flags);
+
+   /**
+    * Constructs a ring
+    * @param entries the submission queue size (a power of 2)
+    */
+   explicit IoUring(unsigned entries);
+
+   /**
+    * Destructor (unregisters the buffer ring and tears down the ring)
+    */
+   ~IoUring();
+
+   /**
+    * Determines whether the ring was set up successfully
+    * @return boolean indicating if the ring can be used
+    */
+   bool isValid() const;
+
+   /**
+    * Registers the ring of provided receive buffers
+    * @param numberBuffers the number of buffers (a power of 2)
+    * @param bufferSize the size of each buffer in bytes
+    * @return boolean indicating if the buffers were registered
+    */
+   bool registerBuffers(unsigned numberBuffers, unsigned bufferSize);
+
+   /**
+    * Retrieves the memory of a provided buffer
+    * @param bufferId the id of the buffer (from a receive completion)
+    * @return pointer to the buffer's bytes
+    */
+   const char* bufferData(int bufferId) const;
+
+   /**
+    * Hands a provided buffer back to the kernel once its bytes are consumed
+    * @param bufferId the id of the buffer
+    */
+   void recycleBuffer(int bufferId);
+
+   /**
+    * Queues a multishot accept on a listening socket
+    * @param listenFd the listening socket
+    * @param userData the value reported with each completion
+    * @return boolean indicating if the operation was queued
+    */
+   bool prepareAccept(int listenFd, std::uint64_t userData);
+
+   /**
+    * Queues a multishot receive into the provided buffers
+    * @param fd the connected socket
+    * @param userData the value reported with each completion
+    * @return boolean indicating if the operation was queued
+    */
+   bool prepareRecv(int fd, std::uint64_t userData);
+
+   /**
+    * Queues a send
+    * @param fd the connected socket
+    * @param data the bytes to send (must stay valid until the completion)
+    * @param length the number of bytes to send
+    * @param userData the value reported with the completion
+    * @return boolean indicating if the operation was queued
+    */
+   bool prepareSend(int fd, const char* data, std::size_t length,
+                    std::uint64_t userData);
+
+   /**
+    * Queues a read
+    * @param fd the descriptor to read from
+    * @param buffer where to read to (must stay valid until the completion)
+    * @param length the number of bytes to read
+    * @param userData the value reported with the completion
+    * @return boolean indicating if the operation was queued
+    */
+   bool prepareRead(int fd, void* buffer, std::size_t length,
+                    std::uint64_t userData);
+
+   /**
+    * Submits everything queued since the last submit (one system call for
+    * the whole batch) and waits for at least one completion
+    * @return boolean indicating success (false on a ring error)
+    */
+   bool submitAndWait();
+
+   /**
+    * Moves all available completions out of the completion queue
+    * @param completions receives the completions (appended)
+    * @return the number of completions reaped
+    */
+   std::size_t reapCompletions(std::vector<Completion>& completions);
+
+private:
+   bool probeOperations() const;
+   void* nextSqe();
+   bool submitPending(unsigned minComplete);
+
+   int m_ringFd;
+   unsigned m_sqEntries;
+
+   // submission and completion rings share one mapping
+   void* m_ring;
+   std::size_t m_ringSize;
+   void* m_sqes;
+   std::size_t m_sqesSize;
+
+   unsigned* m_sqHead;
+   unsigned* m_sqTail;
+   unsigned* m_sqMask;
+   unsigned* m_sqArray;
+   unsigned* m_cqHead;
+   unsigned* m_cqTail;
+   unsigned* m_cqMask;
+   void* m_cqes;
+   unsigned m_sqeTail;
+   unsigned m_sqeSubmitted;
+
+   void* m_bufferRing;
+   std::size_t m_bufferRingSize;
+   char* m_buffers;
+   unsigned m_numberBuffers;
+   unsigned m_bufferSize;
+
+   IoUring(const IoUring&);
+   IoUring& operator=(const IoUring&);
+};
+
+}
+
+#endif
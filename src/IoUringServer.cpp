@@ -0,0 +1,611 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "IoUringServer.h"
+#include "IoUring.h"
+#include "Message.h"
+#include "MessageHandler.h"
+#include "MessageRequestHandler.h"
+#include "ResponseQueue.h"
+#include "ServerOptions.h"
+#include "ServerShard.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+static const unsigned RING_ENTRIES         = 256;
+static const unsigned NUMBER_BUFFERS       = 512;
+static const unsigned BUFFER_SIZE          = 4096;
+
+// completions carry the connection id in the high bits and the operation
+// in the low bits
+static const int OP_BITS                   = 3;
+static const std::uint64_t OP_MASK         = (1 << OP_BITS) - 1;
+static const std::uint64_t OP_ACCEPT       = 1;
+static const std::uint64_t OP_RECV         = 2;
+static const std::uint64_t OP_SEND         = 3;
+static const std::uint64_t OP_WAKE         = 4;
+
+static std::uint64_t userData(std::uint64_t connectionId, std::uint64_t op) {
+   return (connectionId << OP_BITS) | op;
+}
+
+//******************************************************************************
+
+IoUringServer::IoUringServer(int port,
+                             MessageHandler* handler,
+                             const ServerOptions* serverOptions,
+                             int cpu) :
+   m_handler(handler),
+   m_serverOptions(serverOptions),
+   m_admissionController(nullptr),
+   m_metrics(nullptr),
+   m_acceptCount(0),
+   m_connectionCount(0),
+   m_isRunning(false),
+   m_nextConnectionId(0),
+   m_nextResponseKey(0),
+   m_wakeValue(0),
+   m_port(port),
+   m_cpu(cpu),
+   m_listenFd(-1),
+   m_sendsInFlight(0),
+   m_isStarting(false),
+   m_isStopped(true) {
+   TONNERRE_LOG_INSTANCE_CREATE("IoUringServer");
+
+   m_wakePipe[0] = -1;
+   m_wakePipe[1] = -1;
+}
+
+//******************************************************************************
+
+IoUringServer::~IoUringServer() {
+   TONNERRE_LOG_INSTANCE_DESTROY("IoUringServer");
+   stop();
+}
+
+//******************************************************************************
+
+void IoUringServer::setAdmissionController(AdmissionController* admissionController) {
+   m_admissionController = admissionController;
+}
+
+//******************************************************************************
+
+void IoUringServer::setServerMetrics(ServerMetrics* metrics) {
+   m_metrics = metrics;
+}
+
+//******************************************************************************
+
+bool IoUringServer::start() {
+   if (m_isRunning.load() || !IoUring::isSupported()) {
+      return false;
+   }
+
+   m_listenFd = ServerShard::openReusePortListener(m_port);
+   if (m_listenFd == -1) {
+      return false;
+   }
+
+   if (::pipe(m_wakePipe) != 0) {
+      Logger::error("unable to create wake pipe for io_uring server");
+      ::close(m_listenFd);
+      m_listenFd = -1;
+      return false;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_isStarting = true;
+      m_isStopped = false;
+   }
+
+   // async handlers' responses are sent by the loop's thread, which the
+   // wake pipe brings round to collect them
+   m_responses = std::make_shared<ResponseQueue>([this] {
+      const char wakeByte = 0;
+      if (::write(m_wakePipe[1], &wakeByte, 1) < 0) {
+         // pipe full -- the loop is already being woken
+      }
+   });
+
+   // the ring is single-issuer, so it's created on the thread that uses it;
+   // wait here to learn whether that worked
+   m_isRunning.store(true);
+   m_thread = std::thread(&IoUringServer::run, this);
+
+   bool isRunning;
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_stateCond.wait(lock, [this] { return !m_isStarting; });
+      isRunning = m_isRunning.load();
+   }
+
+   if (!isRunning) {
+      m_thread.join();
+      m_responses->close();
+      ::close(m_wakePipe[0]);
+      ::close(m_wakePipe[1]);
+      m_wakePipe[0] = -1;
+      m_wakePipe[1] = -1;
+   }
+
+   return isRunning;
+}
+
+//******************************************************************************
+
+void IoUringServer::stop() {
+   if (!m_isRunning.exchange(false)) {
+      return;
+   }
+
+   // responders completing from now on have nowhere to send to
+   m_responses->close();
+
+   const char wakeByte = 0;
+   if (::write(m_wakePipe[1], &wakeByte, 1) < 0) {
+      // pipe full -- the loop is already being woken
+   }
+
+   if (m_thread.joinable()) {
+      m_thread.join();
+   }
+
+   ::close(m_wakePipe[0]);
+   ::close(m_wakePipe[1]);
+   m_wakePipe[0] = -1;
+   m_wakePipe[1] = -1;
+}
+
+//******************************************************************************
+
+void IoUringServer::waitUntilStopped() {
+   std::unique_lock<std::mutex> lock(m_mutex);
+   m_stateCond.wait(lock, [this] { return m_isStopped; });
+}
+
+//******************************************************************************
+
+std::uint64_t IoUringServer::getAcceptCount() const {
+   return m_acceptCount.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+std::size_t IoUringServer::getConnectionCount() const {
+   return m_connectionCount.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+void IoUringServer::run() {
+   ServerShard::pinThreadToCpu(m_cpu);
+
+   {
+      IoUring ring(RING_ENTRIES);
+      const bool isSetUp = setUp(ring);
+      signalStarted(isSetUp);
+
+      std::vector<IoUring::Completion> completions;
+
+      while (isSetUp && m_isRunning.load(std::memory_order_acquire)) {
+         // everything queued while handling the last batch goes out in
+         // this one call
+         if (!ring.submitAndWait()) {
+            TONNERRE_LOG_ERROR("io_uring submit failed");
+            break;
+         }
+
+         completions.clear();
+         ring.reapCompletions(completions);
+
+         for (const IoUring::Completion& completion : completions) {
+            const std::uint64_t op = completion.userData & OP_MASK;
+            const std::uint64_t connectionId = completion.userData >> OP_BITS;
+
+            if (op == OP_WAKE) {
+               if (m_isRunning.load(std::memory_order_acquire)) {
+                  ring.prepareRead(m_wakePipe[0], &m_wakeValue,
+                                   sizeof(m_wakeValue), userData(0, OP_WAKE));
+                  deliverResponses(ring);
+               }
+               continue;
+            } else if (op == OP_ACCEPT) {
+               onAccept(ring, completion.result, completion.flags);
+               continue;
+            }
+
+            if (op == OP_SEND) {
+               --m_sendsInFlight;
+            }
+
+            auto it = m_connections.find(connectionId);
+            if (it == m_connections.end()) {
+               // late completion for a connection already closed
+               const int bufferId = IoUring::bufferId(completion.flags);
+               if (bufferId >= 0) {
+                  ring.recycleBuffer(bufferId);
+               }
+               continue;
+            }
+
+            if (op == OP_RECV) {
+               onRecv(ring, it->second.get(), completion.result, completion.flags);
+            } else if (op == OP_SEND) {
+               onSend(ring, it->second.get(), completion.result);
+            }
+         }
+
+         m_connectionCount.store(m_connections.size(), std::memory_order_relaxed);
+      }
+
+      if (isSetUp) {
+         drain(ring);
+      }
+   }
+
+   ::close(m_listenFd);
+   m_listenFd = -1;
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+   m_isStopped = true;
+   m_stateCond.notify_all();
+}
+
+//******************************************************************************
+
+bool IoUringServer::setUp(IoUring& ring) {
+   if (!ring.isValid()) {
+      Logger::error("unable to set up io_uring");
+      return false;
+   }
+
+   if (!ring.registerBuffers(NUMBER_BUFFERS, BUFFER_SIZE)) {
+      Logger::error("unable to register io_uring receive buffers");
+      return false;
+   }
+
+   return ring.prepareAccept(m_listenFd, userData(0, OP_ACCEPT)) &&
+          ring.prepareRead(m_wakePipe[0], &m_wakeValue, sizeof(m_wakeValue),
+                           userData(0, OP_WAKE));
+}
+
+//******************************************************************************
+
+void IoUringServer::signalStarted(bool isRunning) {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   if (!isRunning) {
+      m_isRunning.store(false);
+      m_isStopped = true;
+   }
+   m_isStarting = false;
+   m_stateCond.notify_all();
+}
+
+//******************************************************************************
+
+void IoUringServer::onAccept(IoUring& ring, int result, unsigned flags) {
+   if (!IoUring::hasMore(flags) && m_isRunning.load(std::memory_order_acquire)) {
+      // the kernel ended the multishot accept; arm a new one
+      ring.prepareAccept(m_listenFd, userData(0, OP_ACCEPT));
+   }
+
+   if (result < 0) {
+      if (result != -ECANCELED) {
+         TONNERRE_LOG_ERROR("unable to accept connection in io_uring server");
+      }
+      return;
+   }
+
+   const int on = 1;
+   ::setsockopt(result, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+   std::unique_ptr<Connection> connection(new Connection);
+   connection->id = ++m_nextConnectionId;
+   connection->fd = result;
+   connection->nextSequence = 0;
+   connection->nextToSend = 0;
+   connection->sendOffset = 0;
+   connection->requestsServed = 0;
+   connection->responsesPending = 0;
+   connection->isSending = false;
+   connection->isClosing = false;
+
+   ring.prepareRecv(connection->fd, userData(connection->id, OP_RECV));
+   m_connections[connection->id] = std::move(connection);
+   m_acceptCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+void IoUringServer::onRecv(IoUring& ring,
+                           Connection* connection,
+                           int result,
+                           unsigned flags) {
+   const int bufferId = IoUring::bufferId(flags);
+   if (bufferId >= 0) {
+      if (result > 0) {
+         connection->inbound.append(ring.bufferData(bufferId), (std::size_t) result);
+      }
+      ring.recycleBuffer(bufferId);
+   }
+
+   if (result > 0) {
+      processInbound(connection);
+      flushOutbound(ring, connection);
+   } else if (result != -ENOBUFS) {
+      // peer closed its end (or the connection failed); whatever response
+      // is already going out still finishes first
+      connection->isClosing = true;
+   }
+
+   if (connection->isClosing) {
+      if (!connection->isSending && (connection->responsesPending == 0)) {
+         closeConnection(connection);
+      }
+      return;
+   }
+
+   if (!IoUring::hasMore(flags)) {
+      // the kernel ended the multishot receive (e.g., it ran out of
+      // buffers); arm a new one
+      ring.prepareRecv(connection->fd, userData(connection->id, OP_RECV));
+   }
+}
+
+//******************************************************************************
+
+void IoUringServer::onSend(IoUring& ring, Connection* connection, int result) {
+   connection->isSending = false;
+
+   if (result < 0) {
+      TONNERRE_LOG_ERROR("writing response message to socket failed");
+      closeConnection(connection);
+      return;
+   }
+
+   connection->sendOffset += (std::size_t) result;
+   if (connection->sendOffset < connection->sending.size()) {
+      // short send -- queue the rest
+      if (ring.prepareSend(connection->fd,
+                           connection->sending.data() + connection->sendOffset,
+                           connection->sending.size() - connection->sendOffset,
+                           userData(connection->id, OP_SEND))) {
+         connection->isSending = true;
+         ++m_sendsInFlight;
+      } else {
+         closeConnection(connection);
+      }
+      return;
+   }
+
+   connection->sending.clear();
+   connection->sendOffset = 0;
+   flushOutbound(ring, connection);
+
+   if (connection->isClosing && !connection->isSending &&
+       (connection->responsesPending == 0)) {
+      closeConnection(connection);
+   }
+}
+
+//******************************************************************************
+
+void IoUringServer::processInbound(Connection* connection) {
+   const bool isIngestionMode =
+      (m_serverOptions != nullptr) && m_serverOptions->isIngestionMode();
+   const bool isKeepAlive =
+      (m_serverOptions != nullptr) && m_serverOptions->isKeepAlive();
+   const int maxRequests =
+      (m_serverOptions != nullptr) ? m_serverOptions->getKeepAliveMaxRequests() : 0;
+
+   while (!connection->isClosing) {
+      const std::size_t length = Message::frameLength(connection->inbound);
+      if (length == std::string::npos) {
+         TONNERRE_LOG_ERROR("malformed message received");
+         connection->isClosing = true;
+         break;
+      }
+
+      if ((length == 0) || (length > connection->inbound.size())) {
+         // rest of the message hasn't arrived yet
+         break;
+      }
+
+      Message requestMessage;
+      const bool isReconstituted =
+         requestMessage.reconstituteFromFrame(connection->inbound.substr(0, length));
+      connection->inbound.erase(0, length);
+
+      if (!isReconstituted || requestMessage.getRequestName().empty()) {
+         TONNERRE_LOG_ERROR("unable to reconstruct request message");
+         connection->isClosing = true;
+         break;
+      }
+
+      Message responseMessage(requestMessage.getRequestName(),
+                              requestMessage.getType());
+
+      // nobody reads the response to a one-way message
+      const bool isResponding = !isIngestionMode || !requestMessage.isOneWay();
+
+      // waiting on an async handler's responder would stall every
+      // connection on the ring, so its response comes back through
+      // m_responses, under a key of its own, to be sent from here
+      std::uint64_t responseKey = 0;
+      std::shared_ptr<Responder::Connection> responderConnection;
+      if (isResponding && !requestMessage.isOneWay() &&
+          (m_handler->asyncHandlerFor(requestMessage) != nullptr)) {
+         responseKey = ++m_nextResponseKey;
+         responderConnection = m_responses->connectionFor(responseKey);
+      }
+
+      // responses to pipelined requests are coalesced into one send (so
+      // the total in the metrics stops at the response being queued)
+      MessageRequestHandler::ResponseWriter writeResponse;
+      if (isResponding) {
+         writeResponse = [this, connection](const std::string& response) {
+            queueResponse(connection, connection->nextSequence++, response);
+            return true;
+         };
+      }
+
+      const MessageRequestHandler::RequestDisposition disposition =
+         MessageRequestHandler::serveRequest(m_handler, m_admissionController, m_metrics,
+                                             requestMessage, length, responseMessage,
+                                             writeResponse, responderConnection);
+      if ((disposition == MessageRequestHandler::RequestDeferred) &&
+          (responderConnection != nullptr)) {
+         // (even a responder completed inside the handler is only taken
+         // from m_responses once this returns to the loop)
+         DeferredResponse& deferred = m_deferredResponses[responseKey];
+         deferred.connectionId = connection->id;
+         deferred.sequence = connection->nextSequence++;
+         ++connection->responsesPending;
+      }
+
+      if (!isResponding) {
+         continue;
+      }
+
+      ++connection->requestsServed;
+      if (!isKeepAlive ||
+          ((maxRequests > 0) && (connection->requestsServed >= maxRequests))) {
+         connection->isClosing = true;
+      }
+   }
+}
+
+//******************************************************************************
+
+void IoUringServer::queueResponse(Connection* connection,
+                                  std::uint64_t sequence,
+                                  const std::string& response) {
+   // the protocol has no request ids, so a client matches responses to its
+   // requests by order; one that's ready before an earlier request's waits
+   if (sequence != connection->nextToSend) {
+      connection->heldResponses[sequence] = response;
+      return;
+   }
+
+   connection->outbound += response;
+   ++connection->nextToSend;
+
+   auto it = connection->heldResponses.begin();
+   while ((it != connection->heldResponses.end()) &&
+          (it->first == connection->nextToSend)) {
+      connection->outbound += it->second;
+      ++connection->nextToSend;
+      it = connection->heldResponses.erase(it);
+   }
+}
+
+//******************************************************************************
+
+void IoUringServer::deliverResponses(IoUring& ring) {
+   std::vector<ResponseQueue::Response> responses;
+   m_responses->take(responses);
+
+   for (ResponseQueue::Response& response : responses) {
+      auto deferredIt = m_deferredResponses.find(response.first);
+      if (deferredIt == m_deferredResponses.end()) {
+         continue;
+      }
+
+      const DeferredResponse deferred = deferredIt->second;
+      m_deferredResponses.erase(deferredIt);
+
+      auto it = m_connections.find(deferred.connectionId);
+      if (it == m_connections.end()) {
+         // the connection failed while its request was outstanding
+         continue;
+      }
+
+      Connection* connection = it->second.get();
+      --connection->responsesPending;
+      queueResponse(connection, deferred.sequence, response.second);
+      flushOutbound(ring, connection);
+
+      if (connection->isClosing && !connection->isSending &&
+          (connection->responsesPending == 0)) {
+         closeConnection(connection);
+      }
+   }
+}
+
+//******************************************************************************
+
+void IoUringServer::flushOutbound(IoUring& ring, Connection* connection) {
+   if (connection->isSending || connection->outbound.empty()) {
+      return;
+   }
+
+   // the bytes must stay put until the send completes, so they move to
+   // their own buffer while new responses collect in outbound
+   connection->sending.swap(connection->outbound);
+   connection->outbound.clear();
+   connection->sendOffset = 0;
+
+   if (ring.prepareSend(connection->fd,
+                        connection->sending.data(),
+                        connection->sending.size(),
+                        userData(connection->id, OP_SEND))) {
+      connection->isSending = true;
+      ++m_sendsInFlight;
+   } else {
+      TONNERRE_LOG_ERROR("unable to queue response in io_uring server");
+      connection->isClosing = true;
+   }
+}
+
+//******************************************************************************
+
+void IoUringServer::closeConnection(Connection* connection) {
+   // shutdown ends the connection's multishot receive; its last completion
+   // finds no connection and is dropped
+   ::shutdown(connection->fd, SHUT_RDWR);
+   ::close(connection->fd);
+   m_connections.erase(connection->id);
+}
+
+//******************************************************************************
+
+void IoUringServer::drain(IoUring& ring) {
+   for (auto& entry : m_connections) {
+      ::shutdown(entry.second->fd, SHUT_RDWR);
+   }
+
+   // sends reference connection buffers, so they have to finish (they fail
+   // fast now) before the connections can go
+   std::vector<IoUring::Completion> completions;
+   while ((m_sendsInFlight > 0) && ring.submitAndWait()) {
+      completions.clear();
+      ring.reapCompletions(completions);
+      for (const IoUring::Completion& completion : completions) {
+         if ((completion.userData & OP_MASK) == OP_SEND) {
+            --m_sendsInFlight;
+         }
+      }
+   }
+
+   for (auto& entry : m_connections) {
+      ::close(entry.second->fd);
+   }
+   m_connections.clear();
+   m_deferredResponses.clear();
+   m_connectionCount.store(0, std::memory_order_relaxed);
+}
+
+//******************************************************************************
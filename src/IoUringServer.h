@@ -0,0 +1,175 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_IOURINGSERVER_H
+#define TONNERRE_IOURINGSERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+
+namespace tonnerre
+{
+   class AdmissionController;
+   class ServerMetrics;
+   class IoUring;
+   class MessageHandler;
+   class ResponseQueue;
+   class ServerOptions;
+
+/**
+ * IoUringServer is an io_uring event loop that accepts connections, reads
+ * requests and writes responses for a messaging server (Linux 6.0+).
+ * Accepts and receives are multishot, receives land in buffers registered
+ * with the kernel, and everything queued while handling one batch of
+ * completions is submitted with a single system call. Requests are
+ * dispatched to the message handler on the loop's own thread, so like a
+ * server shard it is meant to be run one per core. An async handler's
+ * response comes back to the loop's thread to be sent, so the loop never
+ * waits on a responder; responses that complete ahead of an earlier
+ * request's are held back so that each connection's go out in request
+ * order.
+ * @see IoUring()
+ */
+class IoUringServer
+{
+public:
+   /**
+    * Constructs a loop (nothing is opened until start())
+    * @param port the port to listen on (SO_REUSEPORT, shared by all loops)
+    * @param handler the handler for requests
+    * @param serverOptions the server options (not owned; must outlive the loop)
+    * @param cpu the core to pin the loop's thread to (-1 for no pinning)
+    */
+   IoUringServer(int port,
+                 MessageHandler* handler,
+                 const ServerOptions* serverOptions,
+                 int cpu);
+
+   /**
+    * Destructor (stops the loop and closes its connections)
+    */
+   ~IoUringServer();
+
+   /**
+    * Sets the admission controller consulted before each request is
+    * dispatched (call before start())
+    * @param admissionController the controller (not owned)
+    * @see AdmissionController()
+    */
+   void setAdmissionController(AdmissionController* admissionController);
+
+   /**
+    * Sets the metrics that each request is recorded in (call before
+    * start())
+    * @param metrics the metrics (not owned)
+    * @see ServerMetrics()
+    */
+   void setServerMetrics(ServerMetrics* metrics);
+
+   /**
+    * Opens the listener, sets up the ring on the loop's thread and starts
+    * accepting
+    * @return boolean indicating whether the loop is running
+    */
+   bool start();
+
+   /**
+    * Stops the loop and closes its listener and connections
+    */
+   void stop();
+
+   /**
+    * Blocks until the loop has stopped
+    */
+   void waitUntilStopped();
+
+   /**
+    * Retrieves the number of connections accepted by this loop
+    * @return number of accepted connections
+    */
+   std::uint64_t getAcceptCount() const;
+
+   /**
+    * Retrieves the number of connections currently open on this loop
+    * @return number of open connections
+    */
+   std::size_t getConnectionCount() const;
+
+private:
+   struct Connection {
+      std::uint64_t id;
+      int fd;
+      std::string inbound;
+      std::string outbound;
+      std::string sending;
+      std::map<std::uint64_t, std::string> heldResponses;
+      std::uint64_t nextSequence;
+      std::uint64_t nextToSend;
+      std::size_t sendOffset;
+      int requestsServed;
+      int responsesPending;
+      bool isSending;
+      bool isClosing;
+   };
+
+   void run();
+   bool setUp(IoUring& ring);
+   void onAccept(IoUring& ring, int result, unsigned flags);
+   void onRecv(IoUring& ring, Connection* connection, int result, unsigned flags);
+   void onSend(IoUring& ring, Connection* connection, int result);
+   void processInbound(Connection* connection);
+   void queueResponse(Connection* connection,
+                      std::uint64_t sequence,
+                      const std::string& response);
+   void deliverResponses(IoUring& ring);
+   void flushOutbound(IoUring& ring, Connection* connection);
+   void closeConnection(Connection* connection);
+   void drain(IoUring& ring);
+   void signalStarted(bool isRunning);
+
+   // where an async handler's response goes: its connection, and its
+   // place among the connection's responses
+   struct DeferredResponse {
+      std::uint64_t connectionId;
+      std::uint64_t sequence;
+   };
+
+   std::unordered_map<std::uint64_t, std::unique_ptr<Connection>> m_connections;
+   std::unordered_map<std::uint64_t, DeferredResponse> m_deferredResponses;
+   std::shared_ptr<ResponseQueue> m_responses;
+   MessageHandler* m_handler;
+   const ServerOptions* m_serverOptions;
+   AdmissionController* m_admissionController;
+   ServerMetrics* m_metrics;
+   std::thread m_thread;
+   std::mutex m_mutex;
+   std::condition_variable m_stateCond;
+   std::atomic<std::uint64_t> m_acceptCount;
+   std::atomic<std::size_t> m_connectionCount;
+   std::atomic<bool> m_isRunning;
+   std::uint64_t m_nextConnectionId;
+   std::uint64_t m_nextResponseKey;
+   std::uint64_t m_wakeValue;
+   const int m_port;
+   const int m_cpu;
+   int m_listenFd;
+   int m_wakePipe[2];
+   int m_sendsInFlight;
+   bool m_isStarting;
+   bool m_isStopped;
+
+   IoUringServer(const IoUringServer&);
+   IoUringServer& operator=(const IoUringServer&);
+};
+
+}
+
+#endif
@@ -0,0 +1,197 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "LatencyHistogram.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+// values below SUB_BUCKET_COUNT get a bucket each; every power of two above
+// that is split into SUB_BUCKET_HALF buckets
+static const int SUB_BUCKET_BITS = 5;
+static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+static const int SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+
+// (2^40us is about 12 days; anything longer lands in the last bucket)
+static const int MAX_VALUE_BITS = 40;
+
+const int LatencyHistogram::NUMBER_BUCKETS =
+   SUB_BUCKET_COUNT + (MAX_VALUE_BITS - SUB_BUCKET_BITS) * SUB_BUCKET_HALF;
+
+//******************************************************************************
+
+int LatencyHistogram::bucketIndex(std::uint64_t micros) {
+   if (micros < (std::uint64_t) SUB_BUCKET_COUNT) {
+      return (int) micros;
+   }
+
+   int msb = 63 - __builtin_clzll(micros);
+   if (msb >= MAX_VALUE_BITS) {
+      return NUMBER_BUCKETS - 1;
+   }
+
+   // the top SUB_BUCKET_BITS bits of the value pick the bucket within its
+   // power of two
+   const int shift = msb - (SUB_BUCKET_BITS - 1);
+   return SUB_BUCKET_COUNT + (shift - 1) * SUB_BUCKET_HALF +
+          (int) ((micros >> shift) - SUB_BUCKET_HALF);
+}
+
+//******************************************************************************
+
+std::uint64_t LatencyHistogram::bucketUpperBound(int index) {
+   if (index < SUB_BUCKET_COUNT) {
+      return (std::uint64_t) index;
+   }
+
+   const int shift = (index - SUB_BUCKET_COUNT) / SUB_BUCKET_HALF + 1;
+   const std::uint64_t subBucket =
+      (std::uint64_t) ((index - SUB_BUCKET_COUNT) % SUB_BUCKET_HALF + SUB_BUCKET_HALF);
+   return ((subBucket + 1) << shift) - 1;
+}
+
+//******************************************************************************
+
+LatencyHistogram::LatencyHistogram() :
+   m_buckets(NUMBER_BUCKETS, 0),
+   m_count(0),
+   m_sum(0) {
+   TONNERRE_LOG_INSTANCE_CREATE("LatencyHistogram");
+}
+
+//******************************************************************************
+
+LatencyHistogram::LatencyHistogram(const LatencyHistogram& copy) :
+   m_buckets(copy.m_buckets),
+   m_count(copy.m_count),
+   m_sum(copy.m_sum) {
+   TONNERRE_LOG_INSTANCE_CREATE("LatencyHistogram");
+}
+
+//******************************************************************************
+
+LatencyHistogram::~LatencyHistogram() {
+   TONNERRE_LOG_INSTANCE_DESTROY("LatencyHistogram");
+}
+
+//******************************************************************************
+
+LatencyHistogram& LatencyHistogram::operator=(const LatencyHistogram& copy) {
+   if (this == &copy) {
+      return *this;
+   }
+
+   m_buckets = copy.m_buckets;
+   m_count = copy.m_count;
+   m_sum = copy.m_sum;
+
+   return *this;
+}
+
+//******************************************************************************
+
+void LatencyHistogram::record(std::uint64_t micros) {
+   ++m_buckets[bucketIndex(micros)];
+   ++m_count;
+   m_sum += micros;
+}
+
+//******************************************************************************
+
+void LatencyHistogram::addToBucket(int index, std::uint64_t count) {
+   if ((index >= 0) && (index < NUMBER_BUCKETS)) {
+      m_buckets[index] += count;
+      m_count += count;
+   }
+}
+
+//******************************************************************************
+
+std::uint64_t LatencyHistogram::getBucketCount(int index) const {
+   if ((index < 0) || (index >= NUMBER_BUCKETS)) {
+      return 0;
+   }
+
+   return m_buckets[index];
+}
+
+//******************************************************************************
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+   for (int i = 0; i < NUMBER_BUCKETS; ++i) {
+      m_buckets[i] += other.m_buckets[i];
+   }
+   m_count += other.m_count;
+   m_sum += other.m_sum;
+}
+
+//******************************************************************************
+
+std::uint64_t LatencyHistogram::getCount() const {
+   return m_count;
+}
+
+//******************************************************************************
+
+std::uint64_t LatencyHistogram::getSum() const {
+   return m_sum;
+}
+
+//******************************************************************************
+
+void LatencyHistogram::addToSum(std::uint64_t sumMicros) {
+   m_sum += sumMicros;
+}
+
+//******************************************************************************
+
+double LatencyHistogram::getMean() const {
+   if (m_count == 0) {
+      return 0.0;
+   }
+
+   return (double) m_sum / (double) m_count;
+}
+
+//******************************************************************************
+
+std::uint64_t LatencyHistogram::getMax() const {
+   for (int i = NUMBER_BUCKETS - 1; i >= 0; --i) {
+      if (m_buckets[i] > 0) {
+         return bucketUpperBound(i);
+      }
+   }
+
+   return 0;
+}
+
+//******************************************************************************
+
+std::uint64_t LatencyHistogram::getValueAtPercentile(double percentile) const {
+   if (m_count == 0) {
+      return 0;
+   }
+
+   if (percentile > 100.0) {
+      percentile = 100.0;
+   }
+
+   // the rank of the value wanted, counting from 1
+   std::uint64_t rank = (std::uint64_t) ((percentile / 100.0) * m_count + 0.5);
+   if (rank == 0) {
+      rank = 1;
+   }
+
+   std::uint64_t seen = 0;
+   for (int i = 0; i < NUMBER_BUCKETS; ++i) {
+      seen += m_buckets[i];
+      if (seen >= rank) {
+         return bucketUpperBound(i);
+      }
+   }
+
+   return getMax();
+}
+
+//******************************************************************************
@@ -0,0 +1,135 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_LATENCYHISTOGRAM_H
+#define TONNERRE_LATENCYHISTOGRAM_H
+
+#include <cstdint>
+#include <vector>
+
+
+namespace tonnerre
+{
+
+/**
+ * LatencyHistogram counts latencies (in microseconds) in HDR-style
+ * log-linear buckets: exact below 32us, then 16 buckets per power of two,
+ * so that any recorded value is reported within about 6% no matter its
+ * magnitude. Recording is a single increment; the histogram is not
+ * thread-safe (ServerMetrics keeps one per thread and merges them).
+ */
+class LatencyHistogram
+{
+public:
+   static const int NUMBER_BUCKETS;
+
+   /**
+    * Determines the bucket that a value is counted in
+    * @param micros the value in microseconds
+    * @return the bucket index
+    */
+   static int bucketIndex(std::uint64_t micros);
+
+   /**
+    * Retrieves the largest value counted in a bucket
+    * @param index the bucket index
+    * @return the bucket's upper bound in microseconds
+    */
+   static std::uint64_t bucketUpperBound(int index);
+
+   /**
+    * Default constructor
+    */
+   LatencyHistogram();
+
+   /**
+    * Copy constructor
+    * @param copy the source of the copy
+    */
+   LatencyHistogram(const LatencyHistogram& copy);
+
+   /**
+    * Destructor
+    */
+   ~LatencyHistogram();
+
+   /**
+    * Copy operator
+    * @param copy the source of the copy
+    * @return reference to the updated instance
+    */
+   LatencyHistogram& operator=(const LatencyHistogram& copy);
+
+   /**
+    * Records one value
+    * @param micros the value in microseconds
+    */
+   void record(std::uint64_t micros);
+
+   /**
+    * Adds counts directly to a bucket (used when merging)
+    * @param index the bucket index
+    * @param count the number of values to add
+    */
+   void addToBucket(int index, std::uint64_t count);
+
+   /**
+    * Retrieves the number of values recorded in a bucket
+    * @param index the bucket index
+    * @return the bucket's count (0 for an index out of range)
+    * @see bucketUpperBound()
+    */
+   std::uint64_t getBucketCount(int index) const;
+
+   /**
+    * Adds another histogram's counts to this one
+    * @param other the histogram to merge in
+    */
+   void merge(const LatencyHistogram& other);
+
+   /**
+    * Retrieves the number of values recorded
+    * @return the count
+    */
+   std::uint64_t getCount() const;
+
+   /**
+    * Retrieves the sum of the values recorded
+    * @return the sum in microseconds
+    */
+   std::uint64_t getSum() const;
+
+   /**
+    * Adds to the sum of the values recorded (used along with addToBucket)
+    * @param sumMicros the sum in microseconds
+    */
+   void addToSum(std::uint64_t sumMicros);
+
+   /**
+    * Retrieves the mean of the values recorded
+    * @return the mean in microseconds (0 when empty)
+    */
+   double getMean() const;
+
+   /**
+    * Retrieves the largest value recorded, to bucket precision
+    * @return the maximum in microseconds (0 when empty)
+    */
+   std::uint64_t getMax() const;
+
+   /**
+    * Retrieves the value below which the given share of the values fall
+    * @param percentile the percentile (e.g., 99.0)
+    * @return the value in microseconds, to bucket precision (0 when empty)
+    */
+   std::uint64_t getValueAtPercentile(double percentile) const;
+
+private:
+   std::vector<std::uint64_t> m_buckets;
+   std::uint64_t m_count;
+   std::uint64_t m_sum;
+};
+
+}
+
+#endif
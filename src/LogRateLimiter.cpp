@@ -0,0 +1,51 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <chrono>
+
+#include "LogRateLimiter.h"
+
+using namespace tonnerre;
+
+//******************************************************************************
+
+bool LogRateLimiter::allow() {
+   return allowAt(std::chrono::duration_cast<std::chrono::seconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+//******************************************************************************
+
+bool LogRateLimiter::allowAt(std::int64_t second) {
+   std::int64_t windowSecond = m_windowSecond.load(std::memory_order_relaxed);
+   if ((second != windowSecond) &&
+       m_windowSecond.compare_exchange_strong(windowSecond, second)) {
+      m_messagesInWindow.store(0, std::memory_order_relaxed);
+   }
+
+   if (m_messagesInWindow.fetch_add(1, std::memory_order_relaxed) < m_messagesPerSecond) {
+      return true;
+   }
+
+   m_suppressed.fetch_add(1, std::memory_order_relaxed);
+   return false;
+}
+
+//******************************************************************************
+
+std::string LogRateLimiter::annotate(const std::string& message) {
+   const std::uint64_t suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+   if (suppressed == 0) {
+      return message;
+   }
+
+   return message + " (" + std::to_string(suppressed) + " similar messages suppressed)";
+}
+
+//******************************************************************************
+
+std::uint64_t LogRateLimiter::getSuppressed() const {
+   return m_suppressed.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
@@ -0,0 +1,79 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_LOGRATELIMITER_H
+#define TONNERRE_LOGRATELIMITER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+
+namespace tonnerre
+{
+
+/**
+ * LogRateLimiter caps how often one log statement writes: a few messages
+ * per second get through, and the rest are counted and reported with the
+ * next message that does. The constructor is constexpr so that the static
+ * limiter TONNERRE_LOG_ERROR declares at each call site needs no guarded
+ * initialization. The count per second is approximate when several
+ * threads log at the turn of a second.
+ * @see Logging.h
+ */
+class LogRateLimiter
+{
+public:
+   static const int DEFAULT_MESSAGES_PER_SECOND = 10;
+
+   /**
+    * Constructs a limiter
+    * @param messagesPerSecond the number of messages let through each second
+    */
+   constexpr explicit LogRateLimiter(int messagesPerSecond=DEFAULT_MESSAGES_PER_SECOND) :
+      m_messagesPerSecond(messagesPerSecond),
+      m_windowSecond(-1),
+      m_messagesInWindow(0),
+      m_suppressed(0) {
+   }
+
+   /**
+    * Determines if a message may be written now
+    * @return boolean indicating if the message should be written
+    */
+   bool allow();
+
+   /**
+    * Determines if a message may be written in the given second
+    * @param second the current second (of any monotonic clock)
+    * @return boolean indicating if the message should be written
+    */
+   bool allowAt(std::int64_t second);
+
+   /**
+    * Adds the number of messages suppressed since the last one written
+    * @param message the message about to be written
+    * @return the message, with '(N similar messages suppressed)' appended
+    * if any were
+    */
+   std::string annotate(const std::string& message);
+
+   /**
+    * Retrieves the number of messages suppressed since the last annotate()
+    * @return the number suppressed
+    */
+   std::uint64_t getSuppressed() const;
+
+private:
+   const int m_messagesPerSecond;
+   std::atomic<std::int64_t> m_windowSecond;
+   std::atomic<int> m_messagesInWindow;
+   std::atomic<std::uint64_t> m_suppressed;
+
+   LogRateLimiter(const LogRateLimiter&);
+   LogRateLimiter& operator=(const LogRateLimiter&);
+};
+
+}
+
+#endif
@@ -0,0 +1,41 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_LOGGING_H
+#define TONNERRE_LOGGING_H
+
+#include "AsyncLogSink.h"
+#include "Logger.h"
+#include "LogRateLimiter.h"
+
+// Object lifecycle logging. Building with TONNERRE_NO_INSTANCE_LOGGING
+// defined (the TONNERRE_LOG_INSTANCES=OFF CMake option, or
+// 'make LOG_INSTANCES=no') removes the calls, and the std::string each one
+// constructs, from every constructor and destructor.
+#if defined(TONNERRE_NO_INSTANCE_LOGGING)
+#define TONNERRE_LOG_INSTANCE_CREATE(className) ((void) 0)
+#define TONNERRE_LOG_INSTANCE_DESTROY(className) ((void) 0)
+#else
+#define TONNERRE_LOG_INSTANCE_CREATE(className) \
+   chaudiere::Logger::logInstanceCreate(className)
+#define TONNERRE_LOG_INSTANCE_DESTROY(className) \
+   chaudiere::Logger::logInstanceDestroy(className)
+#endif
+
+// Logging for failures that can repeat once per request. Each call site
+// writes at most LogRateLimiter::DEFAULT_MESSAGES_PER_SECOND messages a
+// second, and the message expression is only evaluated (and its string
+// built) for the messages that are written. Messages go through the
+// AsyncLogSink when it's running.
+#define TONNERRE_LOG_RATE_LIMITED(level, message) \
+   do { \
+      static tonnerre::LogRateLimiter tonnerreLogRateLimiter; \
+      if (tonnerreLogRateLimiter.allow()) { \
+         tonnerre::AsyncLogSink::log(level, tonnerreLogRateLimiter.annotate(message)); \
+      } \
+   } while (false)
+
+#define TONNERRE_LOG_ERROR(message) TONNERRE_LOG_RATE_LIMITED(chaudiere::Error, message)
+#define TONNERRE_LOG_WARNING(message) TONNERRE_LOG_RATE_LIMITED(chaudiere::Warning, message)
+
+#endif
@@ -9,10 +9,14 @@
 #include <string.h>
 
 #include "Message.h"
-#include "Logger.h"
+#include "Logging.h"
 #include "StrUtils.h"
 #include "Socket.h"
 #include "Messaging.h"
+#include "InProcessRegistry.h"
+#include "RequestCoalescer.h"
+#include "RequestTrace.h"
+#include "ShmClient.h"
 #include "CharBuffer.h"
 
 using namespace std;
@@ -31,15 +35,23 @@ static const std::string DELIMITER_KEY_VALUE    = "=";
 static const std::string DELIMITER_PAIR         = ";";
 
 static const std::string KEY_ONE_WAY            = "1way";
+static const std::string KEY_OVERLOADED         = "overloaded";
 static const std::string KEY_PAYLOAD_LENGTH     = "payload_length";
 static const std::string KEY_PAYLOAD_TYPE       = "payload_type";
+static const std::string KEY_PRIORITY           = "priority";
 static const std::string KEY_REQUEST_NAME       = "request";
+static const std::string KEY_SERVICE_NAME       = "service";
+static const std::string KEY_TRACE              = "trace";
 
 static const std::string VALUE_PAYLOAD_KVP      = "kvp";
 static const std::string VALUE_PAYLOAD_TEXT     = "text";
 static const std::string VALUE_PAYLOAD_UNKNOWN  = "unknown";
 static const std::string VALUE_TRUE             = "true";
 
+static const std::string PRIORITY_NAMES[NUMBER_MESSAGE_PRIORITIES] = {
+   "high", "normal", "low"
+};
+
 using namespace chaudiere;
 using namespace tonnerre;
 
@@ -58,19 +70,23 @@ tonnerre::Message* Message::reconstruct(Socket* socket) {
 //******************************************************************************
 
 Message::Message() :
+   m_wireLength(0),
    m_messageType(MessageTypeUnknown),
    m_isOneWay(false),
+   m_isCoalescing(false),
    m_persistentConnection(false) {
-   Logger::logInstanceCreate("Message");
+   TONNERRE_LOG_INSTANCE_CREATE("Message");
 }
 
 //******************************************************************************
 
 Message::Message(const std::string& requestName, MessageType messageType) :
+   m_wireLength(0),
    m_messageType(messageType),
    m_isOneWay(false),
+   m_isCoalescing(false),
    m_persistentConnection(false) {
-   Logger::logInstanceCreate("Message");
+   TONNERRE_LOG_INSTANCE_CREATE("Message");
    m_kvpHeaders.addPair(KEY_REQUEST_NAME, requestName);
 }
 
@@ -81,16 +97,18 @@ Message::Message(const Message& copy) :
    m_textPayload(copy.m_textPayload),
    m_kvpPayload(copy.m_kvpPayload),
    m_kvpHeaders(copy.m_kvpHeaders),
+   m_wireLength(copy.m_wireLength),
    m_messageType(copy.m_messageType),
    m_isOneWay(copy.m_isOneWay),
+   m_isCoalescing(copy.m_isCoalescing),
    m_persistentConnection(false) {
-   Logger::logInstanceCreate("Message");
+   TONNERRE_LOG_INSTANCE_CREATE("Message");
 }
 
 //******************************************************************************
 
 Message::~Message() {
-   Logger::logInstanceDestroy("Message");
+   TONNERRE_LOG_INSTANCE_DESTROY("Message");
 }
 
 //******************************************************************************
@@ -104,8 +122,10 @@ Message& Message::operator=(const Message& copy) {
    m_textPayload = copy.m_textPayload;
    m_kvpPayload = copy.m_kvpPayload;
    m_kvpHeaders = copy.m_kvpHeaders;
+   m_wireLength = copy.m_wireLength;
    m_messageType = copy.m_messageType;
    m_isOneWay = copy.m_isOneWay;
+   m_isCoalescing = copy.m_isCoalescing;
    m_persistentConnection = false;
 
    return *this;
@@ -115,27 +135,69 @@ Message& Message::operator=(const Message& copy) {
 
 bool Message::send(const std::string& serviceName) {
    if (m_messageType == MessageTypeUnknown) {
-      Logger::error("unable to send message, no message type set");
+      TONNERRE_LOG_ERROR("unable to send message, no message type set");
       return false;
    }
 
+   // a service hosted in this process is handed the message itself
+   if (InProcessRegistry::hasService(serviceName)) {
+      m_isOneWay = true;
+      Message responseMessage;
+      if (InProcessRegistry::call(serviceName, *this, responseMessage)) {
+         return true;
+      }
+   }
+
+   std::shared_ptr<Messaging> messaging(Messaging::getMessaging());
+   if (messaging != nullptr) {
+      std::shared_ptr<ShmClient> shmClient(messaging->shmClientForService(serviceName));
+      if (shmClient != nullptr) {
+         m_isOneWay = true;
+         const std::string encodedMessage(encodeForService(serviceName));
+         if ((encodedMessage.length() <= shmClient->getMaxFrameLength()) &&
+             shmClient->sendOneWay(encodedMessage)) {
+            return true;
+         }
+         // (too large for the segment's rings, or no channel free)
+      }
+
+      UdpSender* udpSender = messaging->udpSenderForService(serviceName);
+      if (udpSender != nullptr) {
+         m_isOneWay = true;
+         const std::string encodedMessage(encodeForService(serviceName));
+         if (encodedMessage.length() <= UdpSender::MAX_DATAGRAM_BYTES) {
+            // delivery is best effort: a queued datagram may still be lost
+            return udpSender->enqueue(encodedMessage);
+         }
+         // (too large for a datagram)
+      }
+
+      BatchingSender* sender = messaging->batchingSenderForService(serviceName);
+      if (sender != nullptr) {
+         // hand off to the service's background sender; delivery (and any
+         // delivery failure) happens off the caller's thread
+         m_isOneWay = true;
+         return sender->enqueue(encodeForService(serviceName));
+      }
+   }
+
    Socket* socket(socketForService(serviceName));
 
    if (socket != nullptr) {
       m_isOneWay = true;
 
-      if (socket->write(toString())) {
+      if (socket->write(encodeForService(serviceName))) {
          returnSocketForService(serviceName, socket);
          return true;
       } else {
          // unable to write to socket
-         Logger::error("unable to write to socket");
+         TONNERRE_LOG_ERROR("unable to write to socket");
       }
 
       returnSocketForService(serviceName, socket);
    } else {
       // unable to connect to service
-      Logger::error("unable to connect to service");
+      TONNERRE_LOG_ERROR("unable to connect to service");
    }
 
    return false;
@@ -145,26 +207,183 @@ bool Message::send(const std::string& serviceName) {
 
 bool Message::send(const std::string& serviceName, Message& responseMessage) {
    if (m_messageType == MessageTypeUnknown) {
-      Logger::error("unable to send message, no message type set");
+      TONNERRE_LOG_ERROR("unable to send message, no message type set");
       return false;
    }
 
+   // a service hosted in this process is handed the message itself (no
+   // encoding, and so no coalescing or trace sampling either)
+   if (InProcessRegistry::call(serviceName, *this, responseMessage)) {
+      return true;
+   }
+
+   // a sampled request is traced for this send only
+   const bool isSampled = !isTraced() && Messaging::isTraceSampled(serviceName);
+   const bool isTracing = isSampled || isTraced();
+   const std::int64_t traceEncodeNanos = isTracing ? RequestTrace::now() : 0;
+
+   if (isSampled) {
+      setTraced(true);
+   }
+
+   const std::string encodedMessage = encodeForService(serviceName);
+
+   if (isSampled) {
+      setTraced(false);
+   }
+
+   if (m_isCoalescing) {
+      std::shared_ptr<Messaging> messaging(Messaging::getMessaging());
+      if (messaging != nullptr) {
+         RequestCoalescer& coalescer = messaging->getRequestCoalescer();
+         const std::string key =
+            RequestCoalescer::keyFor(serviceName,
+                                     getRequestName(),
+                                     encodedMessage);
+         bool isLeader = false;
+         std::shared_ptr<RequestCoalescer::Call> call =
+            coalescer.join(key, encodedMessage, isLeader);
+
+         if (call != nullptr) {
+            if (!isLeader) {
+               return coalescer.wait(call, responseMessage);
+            }
+
+            bool rc = false;
+            try {
+               rc = sendEncoded(serviceName, encodedMessage, responseMessage,
+                                traceEncodeNanos);
+            } catch (...) {
+               // don't strand the followers
+               coalescer.complete(key, call, false, responseMessage);
+               throw;
+            }
+
+            coalescer.complete(key, call, rc, responseMessage);
+            return rc;
+         }
+      }
+   }
+
+   return sendEncoded(serviceName, encodedMessage, responseMessage,
+                      traceEncodeNanos);
+}
+
+//******************************************************************************
+
+bool Message::sendEncoded(const std::string& serviceName,
+                          const std::string& encodedMessage,
+                          Message& responseMessage,
+                          std::int64_t traceEncodeNanos) {
+   std::shared_ptr<Messaging> messaging(Messaging::getMessaging());
+   std::shared_ptr<ShmClient> shmClient(
+      (messaging != nullptr) ? messaging->shmClientForService(serviceName) : nullptr);
+
+   // (messages too large for the segment's rings go over TCP, as do those
+   // that find no channel free)
+   if ((shmClient != nullptr) &&
+       (encodedMessage.length() <= shmClient->getMaxFrameLength())) {
+      const std::int64_t traceWriteNanos =
+         (traceEncodeNanos != 0) ? RequestTrace::now() : 0;
+      std::string responseFrame;
+      bool isSent = false;
+      if (shmClient->call(encodedMessage, responseFrame, isSent)) {
+         const bool rc = responseMessage.reconstituteFromFrame(responseFrame);
+         if (rc && (traceEncodeNanos != 0)) {
+            RequestTrace::stampClientStages(responseMessage,
+                                            traceEncodeNanos,
+                                            traceWriteNanos);
+         }
+         return rc;
+      } else if (isSent) {
+         // not retried over TCP -- the server may have handled it already
+         TONNERRE_LOG_ERROR("no response received over shared memory");
+         return false;
+      }
+   }
+
    Socket* socket(socketForService(serviceName));
 
    if (socket != nullptr) {
-      if (socket->write(toString())) {
+      const std::int64_t traceWriteNanos =
+         (traceEncodeNanos != 0) ? RequestTrace::now() : 0;
+      if (socket->write(encodedMessage)) {
          const bool rc = responseMessage.reconstitute(socket);
          returnSocketForService(serviceName, socket);
+         if (rc && (traceEncodeNanos != 0)) {
+            RequestTrace::stampClientStages(responseMessage,
+                                            traceEncodeNanos,
+                                            traceWriteNanos);
+         }
          return rc;
       } else {
          // unable to write to socket
-         Logger::error("unable to write to socket");
+         TONNERRE_LOG_ERROR("unable to write to socket");
       }
 
       returnSocketForService(serviceName, socket);
    } else {
       // unable to connect to service
-      Logger::error("unable to connect to service");
+      TONNERRE_LOG_ERROR("unable to connect to service");
+   }
+
+   return false;
+}
+
+//******************************************************************************
+
+void Message::setCoalescing(bool coalescing) {
+   m_isCoalescing = coalescing;
+}
+
+//******************************************************************************
+
+bool Message::isCoalescing() const {
+   return m_isCoalescing;
+}
+
+//******************************************************************************
+
+bool Message::isOneWay() const {
+   return m_isOneWay;
+}
+
+//******************************************************************************
+
+void Message::setOneWay(bool oneWay) {
+   m_isOneWay = oneWay;
+}
+
+//******************************************************************************
+
+bool Message::hasPriority() const {
+   return m_kvpHeaders.hasKey(KEY_PRIORITY);
+}
+
+//******************************************************************************
+
+MessagePriority Message::getPriority() const {
+   MessagePriority priority = MessagePriorityNormal;
+   if (m_kvpHeaders.hasKey(KEY_PRIORITY)) {
+      parsePriority(m_kvpHeaders.getValue(KEY_PRIORITY), priority);
+   }
+   return priority;
+}
+
+//******************************************************************************
+
+void Message::setPriority(MessagePriority priority) {
+   m_kvpHeaders.addPair(KEY_PRIORITY, priorityName(priority));
+}
+
+//******************************************************************************
+
+bool Message::parsePriority(const std::string& name, MessagePriority& priority) {
+   for (int i = 0; i < NUMBER_MESSAGE_PRIORITIES; ++i) {
+      if (name == PRIORITY_NAMES[i]) {
+         priority = (MessagePriority) i;
+         return true;
+      }
    }
 
    return false;
@@ -172,6 +391,51 @@ bool Message::send(const std::string& serviceName, Message& responseMessage) {
 
 //******************************************************************************
 
+const std::string& Message::priorityName(MessagePriority priority) {
+   return PRIORITY_NAMES[priority];
+}
+
+//******************************************************************************
+
+bool Message::isTraced() const {
+   return m_kvpHeaders.hasKey(KEY_TRACE);
+}
+
+//******************************************************************************
+
+void Message::setTraced(bool traced) {
+   if (traced) {
+      m_kvpHeaders.addPair(KEY_TRACE, VALUE_TRUE);
+   } else {
+      m_kvpHeaders.removePair(KEY_TRACE);
+   }
+}
+
+//******************************************************************************
+
+std::size_t Message::getWireLength() const {
+   return m_wireLength;
+}
+
+//******************************************************************************
+
+bool Message::isOverloaded() const {
+   return m_kvpHeaders.hasKey(KEY_OVERLOADED) &&
+          (m_kvpHeaders.getValue(KEY_OVERLOADED) == VALUE_TRUE);
+}
+
+//******************************************************************************
+
+void Message::setOverloaded(bool overloaded) {
+   if (overloaded) {
+      m_kvpHeaders.addPair(KEY_OVERLOADED, VALUE_TRUE);
+   } else {
+      m_kvpHeaders.removePair(KEY_OVERLOADED);
+   }
+}
+
+//******************************************************************************
+
 void Message::setType(MessageType messageType) {
    m_messageType = messageType;
 }
@@ -214,6 +478,12 @@ const std::string& Message::getServiceName() const {
 
 //******************************************************************************
 
+void Message::setServiceName(const std::string& serviceName) {
+   m_serviceName = serviceName;
+}
+
+//******************************************************************************
+
 std::string Message::getRequestName() const {
    if (m_kvpHeaders.hasKey(KEY_REQUEST_NAME)) {
       return std::string(m_kvpHeaders.getValue(KEY_REQUEST_NAME));
@@ -240,11 +510,11 @@ Socket* Message::socketForService(const std::string& serviceName) const {
 
          return messaging->socketForService(serviceInfo);
       } else {
-         Logger::error("service is not registered");
+         TONNERRE_LOG_ERROR("service is not registered");
          printf("service is not registered\n");
       }
    } else {
-      Logger::error("messaging not initialized");
+      TONNERRE_LOG_ERROR("messaging not initialized");
    }
 
    return nullptr;
@@ -291,7 +561,7 @@ std::string Message::readSocketBytes(Socket* socket,
          success = true;
          return std::string(stackBuffer);
       } else {
-         Logger::error("reading socket for header failed");
+         TONNERRE_LOG_ERROR("reading socket for header failed");
          success = false;
          return EMPTY_STRING;
       }
@@ -304,13 +574,13 @@ std::string Message::readSocketBytes(Socket* socket,
             success = true;
             returnValue = heapBuffer.data();
          } else {
-            Logger::error("reading socket for header failed");
+            TONNERRE_LOG_ERROR("reading socket for header failed");
             success = false;
          }
 
          return returnValue;
       } else {
-         Logger::error("header length exceeds 32K");
+         TONNERRE_LOG_ERROR("header length exceeds 32K");
          success = false;
          return EMPTY_STRING;
       }
@@ -328,10 +598,8 @@ bool Message::reconstitute(Socket* socket) {
       if (socket->readSocket(headerLengthPrefixBuffer, NUM_CHARS_HEADER_LENGTH)) {
          headerLengthPrefixBuffer[NUM_CHARS_HEADER_LENGTH] = '\0';
 
-         std::string headerLengthPrefix = headerLengthPrefixBuffer;
-         StrUtils::stripTrailing(headerLengthPrefix, ' ');
          const std::size_t headerLength =
-            StrUtils::parseLong(headerLengthPrefix);
+            decodeHeaderLength(headerLengthPrefixBuffer);
 
          if (headerLength > 0) {
             bool headerRead = false;
@@ -339,78 +607,46 @@ bool Message::reconstitute(Socket* socket) {
                readSocketBytes(socket, headerLength, headerRead);
 
             if (headerRead && !headerAsString.empty()) {
-               if (fromString(headerAsString, m_kvpHeaders)) {
-                  if (m_kvpHeaders.hasKey(KEY_PAYLOAD_TYPE)) {
-                     const std::string& valuePayloadType =
-                        m_kvpHeaders.getValue(KEY_PAYLOAD_TYPE);
-
-                     if (valuePayloadType == VALUE_PAYLOAD_TEXT) {
-                        m_messageType = MessageTypeText;
-                     } else if (valuePayloadType == VALUE_PAYLOAD_KVP) {
-                        m_messageType = MessageTypeKeyValues;
-                     } else {
-                        Logger::error("unrecognized payload type");
-                     }
-                  }
-
-                  if (m_messageType == MessageTypeUnknown) {
-                     Logger::error("unable to identify message type from header");
-                     return false;
-                  }
-
-                  if (m_kvpHeaders.hasKey(KEY_PAYLOAD_LENGTH)) {
-                     const std::string& valuePayloadLength =
-                        m_kvpHeaders.getValue(KEY_PAYLOAD_LENGTH);
-
-                     if (!valuePayloadLength.empty()) {
-                        const std::size_t payloadLength =
-                           StrUtils::parseLong(valuePayloadLength);
-
-                        if (payloadLength > 0) {
-                           bool payloadRead = false;
-                           std::string payloadAsString =
-                              readSocketBytes(socket, payloadLength, payloadRead);
-
-                           if (payloadRead && !payloadAsString.empty()) {
-                              if (m_messageType == MessageTypeText) {
-                                 m_textPayload = payloadAsString;
-                              } else if (m_messageType == MessageTypeKeyValues) {
-                                 fromString(payloadAsString, m_kvpPayload);
-                              }
-                           }
-                        }
-                     }
-                  }
-
-                  if (m_kvpHeaders.hasKey(KEY_ONE_WAY)) {
-                     const std::string& valueOneWay =
-                        m_kvpHeaders.getValue(KEY_ONE_WAY);
-                     if (valueOneWay == VALUE_TRUE) {
-                        // mark it as being a 1-way message
-                        m_isOneWay = true;
-                     }
-                  }
-
-                  return true;
-               } else {
-                  // unable to parse header
-                  Logger::error("unable to parse header");
+               std::size_t payloadLength = 0;
+               if (!applyHeaders(headerAsString, payloadLength)) {
+                  return false;
+               }
+
+               m_wireLength = NUM_CHARS_HEADER_LENGTH + headerLength + payloadLength;
+
+               std::string payloadAsString;
+               bool payloadRead = false;
+               if (payloadLength > 0) {
+                  payloadAsString = readSocketBytes(socket, payloadLength, payloadRead);
+               }
+
+               const std::int64_t traceReadNanos =
+                  isTraced() ? RequestTrace::now() : 0;
+
+               if (payloadRead && !payloadAsString.empty()) {
+                  applyPayload(payloadAsString);
                }
+
+               if (traceReadNanos != 0) {
+                  RequestTrace::stampReceipt(*this, traceReadNanos, RequestTrace::now());
+               }
+
+               return true;
             } else {
                // unable to read header
-               Logger::error("unable to read header");
+               TONNERRE_LOG_ERROR("unable to read header");
             }
          } else {
             // header length is empty
-            Logger::error("header length is empty");
+            TONNERRE_LOG_ERROR("header length is empty");
          }
       } else {
          // socket read failed
-         Logger::error("socket read failed");
+         TONNERRE_LOG_ERROR("socket read failed");
       }
    } else {
       // no socket given
-      Logger::error("no socket given to reconstitute");
+      TONNERRE_LOG_ERROR("no socket given to reconstitute");
    }
 
    return false;
@@ -418,6 +654,163 @@ bool Message::reconstitute(Socket* socket) {
 
 //******************************************************************************
 
+bool Message::reconstituteFromFrame(const std::string& frame) {
+   if (frame.length() < (std::size_t) NUM_CHARS_HEADER_LENGTH) {
+      TONNERRE_LOG_ERROR("message frame is truncated");
+      return false;
+   }
+
+   const std::size_t headerLength =
+      decodeHeaderLength(frame.substr(0, NUM_CHARS_HEADER_LENGTH));
+   if ((headerLength == 0) ||
+       (frame.length() < NUM_CHARS_HEADER_LENGTH + headerLength)) {
+      TONNERRE_LOG_ERROR("message frame has invalid header length");
+      return false;
+   }
+
+   std::size_t payloadLength = 0;
+   if (!applyHeaders(frame.substr(NUM_CHARS_HEADER_LENGTH, headerLength),
+                     payloadLength)) {
+      return false;
+   }
+
+   // (the frame has already been read in full; only the payload is left
+   // to decode)
+   const std::int64_t traceReadNanos = isTraced() ? RequestTrace::now() : 0;
+
+   const std::size_t payloadOffset = NUM_CHARS_HEADER_LENGTH + headerLength;
+   if (frame.length() < payloadOffset + payloadLength) {
+      TONNERRE_LOG_ERROR("message frame is truncated");
+      return false;
+   }
+
+   m_wireLength = payloadOffset + payloadLength;
+
+   if (payloadLength > 0) {
+      applyPayload(frame.substr(payloadOffset, payloadLength));
+   }
+
+   if (traceReadNanos != 0) {
+      RequestTrace::stampReceipt(*this, traceReadNanos, RequestTrace::now());
+   }
+
+   return true;
+}
+
+//******************************************************************************
+
+std::size_t Message::frameLength(const std::string& buffer) {
+   if (buffer.length() < (std::size_t) NUM_CHARS_HEADER_LENGTH) {
+      return 0;
+   }
+
+   const std::size_t headerLength =
+      decodeHeaderLength(buffer.substr(0, NUM_CHARS_HEADER_LENGTH));
+   if (headerLength == 0) {
+      return std::string::npos;
+   }
+
+   if (buffer.length() < NUM_CHARS_HEADER_LENGTH + headerLength) {
+      return 0;
+   }
+
+   KeyValuePairs kvpHeaders;
+   if (!fromString(buffer.substr(NUM_CHARS_HEADER_LENGTH, headerLength),
+                   kvpHeaders)) {
+      return std::string::npos;
+   }
+
+   std::size_t payloadLength = 0;
+   if (kvpHeaders.hasKey(KEY_PAYLOAD_LENGTH)) {
+      payloadLength = StrUtils::parseLong(kvpHeaders.getValue(KEY_PAYLOAD_LENGTH));
+   }
+
+   return NUM_CHARS_HEADER_LENGTH + headerLength + payloadLength;
+}
+
+//******************************************************************************
+
+std::size_t Message::decodeHeaderLength(const std::string& headerLengthPrefix) {
+   std::string prefix(headerLengthPrefix);
+   StrUtils::stripTrailing(prefix, ' ');
+   return StrUtils::parseLong(prefix);
+}
+
+//******************************************************************************
+
+bool Message::applyHeaders(const std::string& headerAsString,
+                           std::size_t& payloadLength) {
+   payloadLength = 0;
+
+   if (!fromString(headerAsString, m_kvpHeaders)) {
+      // unable to parse header
+      TONNERRE_LOG_ERROR("unable to parse header");
+      return false;
+   }
+
+   if (m_kvpHeaders.hasKey(KEY_PAYLOAD_TYPE)) {
+      const std::string& valuePayloadType =
+         m_kvpHeaders.getValue(KEY_PAYLOAD_TYPE);
+
+      if (valuePayloadType == VALUE_PAYLOAD_TEXT) {
+         m_messageType = MessageTypeText;
+      } else if (valuePayloadType == VALUE_PAYLOAD_KVP) {
+         m_messageType = MessageTypeKeyValues;
+      } else {
+         TONNERRE_LOG_ERROR("unrecognized payload type");
+      }
+   }
+
+   if (m_messageType == MessageTypeUnknown) {
+      TONNERRE_LOG_ERROR("unable to identify message type from header");
+      return false;
+   }
+
+   if (m_kvpHeaders.hasKey(KEY_PAYLOAD_LENGTH)) {
+      const std::string& valuePayloadLength =
+         m_kvpHeaders.getValue(KEY_PAYLOAD_LENGTH);
+
+      if (!valuePayloadLength.empty()) {
+         payloadLength = StrUtils::parseLong(valuePayloadLength);
+      }
+   }
+
+   if (m_kvpHeaders.hasKey(KEY_SERVICE_NAME)) {
+      m_serviceName = m_kvpHeaders.getValue(KEY_SERVICE_NAME);
+   }
+
+   if (m_kvpHeaders.hasKey(KEY_ONE_WAY)) {
+      const std::string& valueOneWay =
+         m_kvpHeaders.getValue(KEY_ONE_WAY);
+      if (valueOneWay == VALUE_TRUE) {
+         // mark it as being a 1-way message
+         m_isOneWay = true;
+      }
+   }
+
+   return true;
+}
+
+//******************************************************************************
+
+void Message::applyPayload(const std::string& payloadAsString) {
+   if (m_messageType == MessageTypeText) {
+      m_textPayload = payloadAsString;
+   } else if (m_messageType == MessageTypeKeyValues) {
+      fromString(payloadAsString, m_kvpPayload);
+   }
+}
+
+//******************************************************************************
+
+std::string Message::encodeForService(const std::string& serviceName) {
+   // lets a server hosting several services route the message
+   m_serviceName = serviceName;
+   return toString();
+}
+
+//******************************************************************************
+
 std::string Message::toString() const {
    KeyValuePairs kvpHeaders(m_kvpHeaders);
    std::string payload;
@@ -436,6 +829,10 @@ std::string Message::toString() const {
       kvpHeaders.addPair(KEY_ONE_WAY, VALUE_TRUE);
    }
 
+   if (!m_serviceName.empty()) {
+      kvpHeaders.addPair(KEY_SERVICE_NAME, m_serviceName);
+   }
+
    if (m_kvpHeaders.hasKey(KEY_REQUEST_NAME)) {
       kvpHeaders.addPair(KEY_REQUEST_NAME,
                          m_kvpHeaders.getValue(KEY_REQUEST_NAME));
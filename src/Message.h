@@ -4,6 +4,7 @@
 #ifndef TONNERRE_MESSAGE_H
 #define TONNERRE_MESSAGE_H
 
+#include <cstdint>
 #include <string>
 
 #include "KeyValuePairs.h"
@@ -19,6 +20,16 @@ enum MessageType {
    MessageTypeText
 };
 
+// scheduling classes, highest first (servers with 'scheduling' enabled
+// keep a queue per class)
+enum MessagePriority {
+   MessagePriorityHigh,
+   MessagePriorityNormal,
+   MessagePriorityLow
+};
+
+static const int NUMBER_MESSAGE_PRIORITIES = 3;
+
 
 /**
  * The Message class is the primary object used for sending and receiving messages.
@@ -63,9 +74,11 @@ public:
 
    /**
     * Sends a message to the specified service and disregards any response that the
-    * server handler might generate.
+    * server handler might generate. If the service is configured with
+    * 'async = true', the message is queued for the service's background sender
+    * instead of being written on the caller's thread.
     * @param serviceName the name of the service destination
-    * @return boolean indicating if message was successfully delivered
+    * @return boolean indicating if message was successfully delivered (or queued)
     */
    bool send(const std::string& serviceName);
 
@@ -77,6 +90,22 @@ public:
     */
    bool send(const std::string& serviceName, Message& responseMessage);
 
+   /**
+    * Opts this message in to (or out of) request coalescing. When enabled, a
+    * synchronous send that is identical to one already in flight (same
+    * service, request name, headers and payload) shares that request's
+    * network round trip and receives a copy of its response. Only enable it
+    * for read-style requests that are safe to answer with a shared response.
+    * @param coalescing whether identical in-flight requests may be coalesced
+    */
+   void setCoalescing(bool coalescing);
+
+   /**
+    * Determines if the message is opted in to request coalescing
+    * @return boolean indicating if coalescing is enabled for the message
+    */
+   bool isCoalescing() const;
+
    /**
     * Copy operator
     * @param copy the source of the copy
@@ -92,6 +121,106 @@ public:
     */
    bool reconstitute(chaudiere::Socket* socket);
 
+   /**
+    * Reconstitute a message from a complete encoded message held in memory (used internally)
+    * @param frame the encoded message (as produced by toString)
+    * @return boolean indicating whether the message was reconstituted
+    * @see frameLength()
+    */
+   bool reconstituteFromFrame(const std::string& frame);
+
+   /**
+    * Determines the length of the encoded message at the start of a buffer,
+    * for readers that receive a message in pieces (used internally)
+    * @param buffer the bytes received so far
+    * @return the full length of the encoded message, 0 if not enough has
+    * been received to tell, or std::string::npos if the buffer is malformed
+    */
+   static std::size_t frameLength(const std::string& buffer);
+
+   /**
+    * Determines if the message is one-way (the sender won't read a response)
+    * @return boolean indicating if the message is one-way
+    */
+   bool isOneWay() const;
+
+   /**
+    * Marks the message as one-way (used internally; send(serviceName) does
+    * this automatically)
+    * @param oneWay whether the message is one-way
+    */
+   void setOneWay(bool oneWay);
+
+   /**
+    * Determines if the sender gave the message a priority
+    * @return boolean indicating if a priority header is present
+    */
+   bool hasPriority() const;
+
+   /**
+    * Retrieves the message's priority
+    * @return the priority (MessagePriorityNormal if none was set)
+    */
+   MessagePriority getPriority() const;
+
+   /**
+    * Sets the message's priority, which a server with priority scheduling
+    * uses to pick the queue the request waits in
+    * @param priority the priority
+    */
+   void setPriority(MessagePriority priority);
+
+   /**
+    * Converts a priority name ('high', 'normal' or 'low') to its value
+    * @param name the name of the priority
+    * @param priority the value (set only if the name is recognized)
+    * @return boolean indicating if the name was recognized
+    */
+   static bool parsePriority(const std::string& name, MessagePriority& priority);
+
+   /**
+    * Retrieves the name of a priority
+    * @param priority the priority
+    * @return the priority's name
+    */
+   static const std::string& priorityName(MessagePriority priority);
+
+   /**
+    * Determines if the message is traced: the server stamps the stages of a
+    * traced request on its response
+    * @return boolean indicating if the message is traced
+    * @see RequestTrace()
+    */
+   bool isTraced() const;
+
+   /**
+    * Sets whether the message is traced (requests to services with a
+    * 'trace_sample_rate' are also traced when sampled)
+    * @param traced whether the message is traced
+    */
+   void setTraced(bool traced);
+
+   /**
+    * Retrieves the number of bytes the message occupied on the wire when it
+    * was read
+    * @return the length of the message as read (0 for a message that was
+    * constructed locally)
+    */
+   std::size_t getWireLength() const;
+
+   /**
+    * Determines if the message is an 'overloaded' response: the server shed
+    * the request without handling it, and it may be retried later
+    * @return boolean indicating if the server was overloaded
+    */
+   bool isOverloaded() const;
+
+   /**
+    * Marks the message as an 'overloaded' response (used internally)
+    * @param overloaded whether the server shed the request
+    */
+   void setOverloaded(bool overloaded);
+
    /**
     * Sets the type of the message
     * @param messageType the type of the message
@@ -137,17 +266,34 @@ public:
    void setTextPayload(const std::string& text);
 
    /**
-    * Retrieves the service name from a reconstituted message (used internally)
-    * @return the name of the service
+    * Retrieves the service name from a reconstituted message (used internally).
+    * send() records the target service in the message header so that a
+    * server hosting several services can route on it.
+    * @return the name of the service (empty if the sender didn't name one)
     */
    const std::string& getServiceName() const;
 
+   /**
+    * Records the target service in the message without flattening it, for
+    * a message handed to an in-process handler (used internally)
+    * @param serviceName the name of the service the message is sent to
+    * @see InProcessRegistry()
+    */
+   void setServiceName(const std::string& serviceName);
+
    /**
     * Flatten the message state to a string so that it can be sent over network connection (used internally)
     * @return string representation of message state ready to be sent over network
     */
    std::string toString() const;
 
+   /**
+    * Records the target service in the message and flattens it (used internally)
+    * @param serviceName the name of the service the message is sent to
+    * @return string representation of message state ready to be sent over network
+    */
+   std::string encodeForService(const std::string& serviceName);
+
    /**
     * Flatten a KeyValuePairs object as part of flattening the Message
     * @param kvp the KeyValuePairs object whose string representation is needed
@@ -221,12 +367,23 @@ public:
                                bool& success);
 
 private:
+   static std::size_t decodeHeaderLength(const std::string& headerLengthPrefix);
+   bool applyHeaders(const std::string& headerAsString, std::size_t& payloadLength);
+   void applyPayload(const std::string& payloadAsString);
+
+   bool sendEncoded(const std::string& serviceName,
+                    const std::string& encodedMessage,
+                    Message& responseMessage,
+                    std::int64_t traceEncodeNanos);
+
    std::string m_serviceName;
    std::string m_textPayload;
    chaudiere::KeyValuePairs m_kvpPayload;
    chaudiere::KeyValuePairs m_kvpHeaders;
+   std::size_t m_wireLength;
    MessageType m_messageType;
    bool m_isOneWay;
+   bool m_isCoalescing;
    mutable bool m_persistentConnection;
 
 };
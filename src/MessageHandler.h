@@ -12,6 +12,7 @@
 namespace tonnerre
 {
    class Message;
+   class AsyncMessageHandler;
 
 /**
  * MessageHandler is the interface (abstract based class) to use for all
@@ -53,6 +54,18 @@ public:
                                        const chaudiere::KeyValuePairs& requestPayload,
                                        chaudiere::KeyValuePairs& responsePayload) = 0;
 
+   /**
+    * Retrieves the asynchronous handler that the request should be given to
+    * instead of the synchronous methods above (used internally)
+    * @param requestMessage the request message
+    * @return the asynchronous handler, or null to handle the request synchronously
+    * @see AsyncMessageHandler()
+    */
+   virtual AsyncMessageHandler* asyncHandlerFor(const Message& requestMessage) {
+      (void) requestMessage;
+      return nullptr;
+   }
+
 };
 
 }
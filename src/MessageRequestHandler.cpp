@@ -2,24 +2,203 @@
 // BSD License
 
 #include <memory>
+#include <errno.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include "MessageRequestHandler.h"
 #include "MessageHandler.h"
+#include "AdmissionController.h"
+#include "AsyncMessageHandler.h"
 #include "BasicException.h"
+#include "IdleConnectionMonitor.h"
 #include "Message.h"
-#include "Logger.h"
+#include "Logging.h"
+#include "PriorityExecutor.h"
+#include "RequestTrace.h"
+#include "ServerMetrics.h"
+#include "ServerOptions.h"
 #include "Socket.h"
 #include "KeyValuePairs.h"
 
 using namespace tonnerre;
 using namespace chaudiere;
 
+// how many messages an event-loop connection may have served, one after
+// another, before the loop's thread goes back to its other connections
+static const int MAX_MESSAGES_PER_WAKEUP = 16;
+
+//******************************************************************************
+
+void MessageRequestHandler::logHandlerException() {
+   // called from a catch block; rethrow to recover the exception's type
+   try {
+      throw;
+   } catch (const BasicException& be) {
+      // BasicException caught
+      TONNERRE_LOG_ERROR("execption caught in handling message: " + be.whatString());
+   } catch (const std::exception& e) {
+      // exception caught
+      TONNERRE_LOG_ERROR("exception caught in handling message: " + std::string(e.what()));
+   } catch (...) {
+      // unknown exception caught
+      TONNERRE_LOG_ERROR("exception caught in handling message");
+   }
+}
+
+//******************************************************************************
+
+bool MessageRequestHandler::invokeHandler(MessageHandler* messageHandler,
+                                          const Message& requestMessage,
+                                          Message& responseMessage,
+                                          KeyValuePairs& kvpResponsePayload,
+                                          std::string& textResponsePayload) {
+   const std::string& requestName = requestMessage.getRequestName();
+   const MessageType messageType = requestMessage.getType();
+
+   try {
+      if (messageType == MessageTypeKeyValues) {
+         messageHandler->handleKeyValuesMessage(requestMessage,
+                                                responseMessage,
+                                                requestName,
+                                                requestMessage.getKeyValuesPayload(),
+                                                kvpResponsePayload);
+         return true;
+      } else if (messageType == MessageTypeText) {
+         messageHandler->handleTextMessage(requestMessage,
+                                           responseMessage,
+                                           requestName,
+                                           requestMessage.getTextPayload(),
+                                           textResponsePayload);
+         return true;
+      }
+   } catch (...) {
+      logHandlerException();
+   }
+
+   return false;
+}
+
+//******************************************************************************
+
+bool MessageRequestHandler::dispatch(MessageHandler* messageHandler,
+                                     const Message& requestMessage,
+                                     Message& responseMessage) {
+   const MessageType messageType = requestMessage.getType();
+   KeyValuePairs kvpResponsePayload;
+   std::string textResponsePayload;
+
+   if (invokeHandler(messageHandler,
+                     requestMessage,
+                     responseMessage,
+                     kvpResponsePayload,
+                     textResponsePayload)) {
+      if (messageType == MessageTypeKeyValues) {
+         responseMessage.setKeyValuesPayload(kvpResponsePayload);
+      } else if (messageType == MessageTypeText) {
+         responseMessage.setTextPayload(textResponsePayload);
+      }
+      return true;
+   }
+
+   return false;
+}
+
+//******************************************************************************
+
+MessageRequestHandler::RequestDisposition
+MessageRequestHandler::serveRequest(MessageHandler* messageHandler,
+                                    AdmissionController* admissionController,
+                                    ServerMetrics* metrics,
+                                    const Message& requestMessage,
+                                    std::size_t requestBytes,
+                                    Message& responseMessage,
+                                    const ResponseWriter& writeResponse,
+                                    std::shared_ptr<Responder::Connection> asyncConnection) {
+   typedef std::chrono::steady_clock Clock;
+   const bool isStatsRequest =
+      (metrics != nullptr) && ServerMetrics::isStatsRequest(requestMessage);
+   const bool isMeasured = (metrics != nullptr) && !isStatsRequest;
+   const Clock::time_point startedAt = isMeasured ? Clock::now() : Clock::time_point();
+   Clock::time_point handledAt = startedAt;
+   RequestDisposition disposition = RequestHandled;
+   bool isError = false;
+
+   // requests are handled as soon as they're read, so there's no queueing
+   // delay to judge -- only the in-flight limit applies
+   if (isStatsRequest) {
+      metrics->respondToStats(requestMessage, responseMessage);
+   } else if ((admissionController == nullptr) ||
+              admissionController->admit(Clock::duration::zero())) {
+      AsyncMessageHandler* asyncHandler = messageHandler->asyncHandlerFor(requestMessage);
+      if (asyncHandler != nullptr) {
+         // (the responder stamps the trace when it's completed)
+         invokeAsyncHandler(asyncHandler, requestMessage, asyncConnection, 0);
+         disposition = RequestDeferred;
+      } else {
+         const bool isTraced = requestMessage.isTraced();
+         const std::int64_t handlerStartNanos = isTraced ? RequestTrace::now() : 0;
+         isError = !dispatch(messageHandler, requestMessage, responseMessage);
+         if (isTraced) {
+            RequestTrace::stampServerStages(requestMessage, responseMessage, 0,
+                                            handlerStartNanos, RequestTrace::now());
+            RequestTrace::stamp(responseMessage, RequestTrace::StageServerWrite,
+                                RequestTrace::now());
+         }
+      }
+
+      if (admissionController != nullptr) {
+         admissionController->release();
+      }
+      if (isMeasured) {
+         handledAt = Clock::now();
+      }
+   } else {
+      responseMessage.setOverloaded(true);
+      disposition = RequestShed;
+      isError = true;
+   }
+
+   std::size_t bytesOut = 0;
+   if ((disposition != RequestDeferred) && writeResponse) {
+      const std::string response(responseMessage.toString());
+      bytesOut = response.length();
+      if (!writeResponse(response)) {
+         disposition = RequestUnanswered;
+         isError = true;
+      }
+   }
+
+   if (isMeasured) {
+      metrics->record(requestMessage.getRequestName(), isError,
+                      requestBytes, bytesOut, Clock::duration::zero(),
+                      handledAt - startedAt, Clock::now() - startedAt);
+   }
+
+   return disposition;
+}
+
 //******************************************************************************
 
 MessageRequestHandler::MessageRequestHandler(Socket* socket, MessageHandler* handler) :
    RequestHandler(socket),
-   m_handler(handler) {
-   Logger::logInstanceCreate("MessageRequestHandler");
+   m_handler(handler),
+   m_serverOptions(nullptr),
+   m_idleMonitor(nullptr),
+   m_admissionController(nullptr),
+   m_priorityExecutor(nullptr),
+   m_metrics(nullptr),
+   m_enqueuedAt(std::chrono::steady_clock::now()),
+   m_acceptedAt(m_enqueuedAt),
+   m_queueDelay(std::chrono::steady_clock::duration::zero()),
+   m_requestsServed(0),
+   m_messagesThisWakeup(0),
+   m_isEventLoopConnection(false),
+   m_isQueued(false),
+   m_isOverQueueDepth(false) {
+   TONNERRE_LOG_INSTANCE_CREATE("MessageRequestHandler");
 }
 
 //******************************************************************************
@@ -27,14 +206,86 @@ MessageRequestHandler::MessageRequestHandler(Socket* socket, MessageHandler* han
 MessageRequestHandler::MessageRequestHandler(SocketRequest* socketRequest,
                                              MessageHandler* handler) :
    RequestHandler(socketRequest),
-   m_handler(handler) {
-   Logger::logInstanceCreate("MessageRequestHandler");
+   m_handler(handler),
+   m_serverOptions(nullptr),
+   m_idleMonitor(nullptr),
+   m_admissionController(nullptr),
+   m_priorityExecutor(nullptr),
+   m_metrics(nullptr),
+   m_enqueuedAt(std::chrono::steady_clock::now()),
+   m_acceptedAt(m_enqueuedAt),
+   m_queueDelay(std::chrono::steady_clock::duration::zero()),
+   m_requestsServed(0),
+   m_messagesThisWakeup(0),
+   m_isEventLoopConnection(true),
+   m_isQueued(false),
+   m_isOverQueueDepth(false) {
+   TONNERRE_LOG_INSTANCE_CREATE("MessageRequestHandler");
 }
 
 //******************************************************************************
 
 MessageRequestHandler::~MessageRequestHandler() {
-   Logger::logInstanceDestroy("MessageRequestHandler");
+   TONNERRE_LOG_INSTANCE_DESTROY("MessageRequestHandler");
+
+   if (m_isQueued) {
+      // dropped without being run (e.g., the executor was stopped)
+      m_admissionController->dequeue();
+   }
+}
+
+//******************************************************************************
+
+void MessageRequestHandler::setServerOptions(const ServerOptions* serverOptions) {
+   m_serverOptions = serverOptions;
+}
+
+//******************************************************************************
+
+void MessageRequestHandler::setIdleConnectionMonitor(IdleConnectionMonitor* idleMonitor) {
+   m_idleMonitor = idleMonitor;
+}
+
+//******************************************************************************
+
+void MessageRequestHandler::setAdmissionController(AdmissionController* admissionController) {
+   if (m_isQueued) {
+      m_admissionController->dequeue();
+      m_isQueued = false;
+   }
+
+   m_admissionController = admissionController;
+   m_isOverQueueDepth = false;
+
+   if (m_admissionController != nullptr) {
+      m_enqueuedAt = std::chrono::steady_clock::now();
+      m_isQueued = m_admissionController->enqueue();
+      m_isOverQueueDepth = !m_isQueued;
+   }
+}
+
+//******************************************************************************
+
+void MessageRequestHandler::setPriorityExecutor(PriorityExecutor* priorityExecutor) {
+   m_priorityExecutor = priorityExecutor;
+}
+
+//******************************************************************************
+
+void MessageRequestHandler::setServerMetrics(ServerMetrics* metrics) {
+   m_metrics = metrics;
+}
+
+//******************************************************************************
+
+void MessageRequestHandler::setRequestsServed(int requestsServed) {
+   m_requestsServed = requestsServed;
+}
+
+//******************************************************************************
+
+int MessageRequestHandler::getRequestsServed() const {
+   return m_requestsServed;
 }
 
 //******************************************************************************
@@ -43,76 +294,508 @@ void MessageRequestHandler::run() {
    Socket* socket(getSocket());
    MessageHandler* messageHandler = m_handler;
 
+   // a worker has picked the connection up
+   m_queueDelay = std::chrono::steady_clock::now() - m_enqueuedAt;
+   if (m_isQueued) {
+      m_admissionController->dequeue();
+      m_isQueued = false;
+   }
+
    if ((socket != nullptr) && (messageHandler != nullptr)) {
-      std::unique_ptr<Message> requestMessage(Message::reconstruct(socket));
-      if (requestMessage != nullptr) {
+      const bool isIngestionMode =
+         (m_serverOptions != nullptr) && m_serverOptions->isIngestionMode();
+      const bool isKeepAlive =
+         (m_serverOptions != nullptr) && m_serverOptions->isKeepAlive();
+
+      // without keep-alive this is exactly one pass: one request, one response
+      for (;;) {
+         // a request handed over by the handler that scheduled it is handled
+         // here; any that follow on the connection are read and scheduled
+         // in turn
+         const bool isScheduled = (m_pendingRequest != nullptr);
+         std::unique_ptr<Message> requestMessage(
+            isScheduled ? m_pendingRequest.release() : Message::reconstruct(socket));
+         if (requestMessage == nullptr) {
+            // unable to reconstruct request message
+            TONNERRE_LOG_ERROR("unable to reconstruct request message");
+            break;
+         }
+
          const std::string& requestName = requestMessage->getRequestName();
-         if (!requestName.empty()) {
-            const MessageType messageType = requestMessage->getType();
-            Message responseMessage(requestName, messageType);
-            if (messageType == MessageTypeKeyValues) {
-               KeyValuePairs responsePayload;
-
-               try {
-                  messageHandler->handleKeyValuesMessage(*requestMessage,
-                                                         responseMessage,
-                                                         requestName,
-                                                         requestMessage->getKeyValuesPayload(),
-                                                         responsePayload);
-                  responseMessage.setKeyValuesPayload(responsePayload);
-               } catch (const BasicException& be) {
-                  // BasicException caught
-                  Logger::error("execption caught in handling message: " + be.whatString());
-               } catch (const std::exception& e) {
-                  // exception caught
-                  Logger::error("exception caught in handling message: " + std::string(e.what()));
-               } catch (...) {
-                  // unknown exception caught
-                  Logger::error("exception caught in handling message");
-               }
-            } else if (messageType == MessageTypeText) {
-               std::string responsePayload;
-
-               try {
-                  messageHandler->handleTextMessage(*requestMessage,
-                                                    responseMessage,
-                                                    requestName,
-                                                    requestMessage->getTextPayload(),
-                                                    responsePayload);
-                  responseMessage.setTextPayload(responsePayload);
-               } catch (const BasicException& be) {
-                  // BasicException caught
-                  Logger::error("execption caught in handling message: " + be.whatString());
-               } catch (const std::exception& e) {
-                  // exception caught
-                  Logger::error("exception caught in handling message: " + std::string(e.what()));
-               } catch (...) {
-                  // unknown exception caught
-                  Logger::error("exception caught in handling message");
-               }
-            }
-
-            if (!socket->write(responseMessage.toString())) {
-               Logger::error("writing response message to socket failed");
-            }
-
-         } else {
+         if (requestName.empty()) {
             // request name is empty
-            Logger::error("request name is empty");
+            TONNERRE_LOG_ERROR("request name is empty");
+            break;
          }
-      } else {
-         // unable to reconstruct request message
-         Logger::error("unable to reconstruct request message");
+
+         if (isIngestionMode && requestMessage->isOneWay()) {
+            ingest(socket, messageHandler, *requestMessage);
+            break;
+         }
+
+         if (!isScheduled && schedule(socket, requestMessage)) {
+            break;
+         }
+
+         respond(socket, messageHandler, *requestMessage);
+         ++m_requestsServed;
+
+         if (!isKeepAlive || !awaitNextMessage(socket)) {
+            break;
+         }
+
+         // (the next request's trace starts once it is on the wire)
+         m_acceptedAt = std::chrono::steady_clock::now();
       }
    } else {
       if (socket == nullptr) {
-         Logger::error("no socket provided");
+         TONNERRE_LOG_ERROR("no socket provided");
       }
 
       if (messageHandler == nullptr) {
-         Logger::error("no message handler provided");
+         TONNERRE_LOG_ERROR("no message handler provided");
       }
    }
 }
 
 //******************************************************************************
+
+bool MessageRequestHandler::schedule(Socket* socket,
+                                     std::unique_ptr<Message>& requestMessage) {
+   // an event-loop connection would be dispatched again while its request
+   // waits, and a request that is to be shed needn't wait at all
+   if ((m_priorityExecutor == nullptr) || m_isEventLoopConnection || m_isOverQueueDepth) {
+      return false;
+   }
+
+   // as with parked connections, the new handler gets its own descriptor
+   // so that this one can still close the socket it owns
+   const int fd = ::dup(socket->getFileDescriptor());
+   if (fd == -1) {
+      TONNERRE_LOG_ERROR("unable to hand request to priority scheduler");
+      return false;
+   }
+
+   MessagePriority priority = requestMessage->getPriority();
+   if (!requestMessage->hasPriority() && (m_serverOptions != nullptr)) {
+      priority = m_serverOptions->getRequestPriority(requestMessage->getRequestName());
+   }
+
+   MessageRequestHandler* scheduled = new MessageRequestHandler(new Socket(fd), m_handler);
+   scheduled->setServerOptions(m_serverOptions);
+   scheduled->setIdleConnectionMonitor(m_idleMonitor);
+   scheduled->setPriorityExecutor(m_priorityExecutor);
+   scheduled->setServerMetrics(m_metrics);
+   scheduled->setRequestsServed(m_requestsServed);
+   // time spent in the priority queue is queueing delay like any other
+   scheduled->setAdmissionController(m_admissionController);
+   scheduled->m_pendingRequest = std::move(requestMessage);
+   scheduled->m_acceptedAt = m_acceptedAt;
+   scheduled->m_responseConnection = m_responseConnection;
+
+   if (!m_priorityExecutor->execute(scheduled, priority)) {
+      TONNERRE_LOG_WARNING("server stopping, closing scheduled connection");
+   }
+
+   return true;
+}
+
+//******************************************************************************
+
+bool MessageRequestHandler::admitRequest(std::chrono::steady_clock::duration queueDelay) {
+   if (m_admissionController == nullptr) {
+      return true;
+   }
+
+   if (m_isOverQueueDepth) {
+      // already counted as shed when the queue turned it away
+      m_isOverQueueDepth = false;
+      return false;
+   }
+
+   return m_admissionController->admit(queueDelay);
+}
+
+//******************************************************************************
+
+std::size_t MessageRequestHandler::shed(Socket* socket, const Message& requestMessage) {
+   // the whole point is to be cheap: no handler, no payload
+   Message responseMessage(requestMessage.getRequestName(),
+                           requestMessage.getType());
+   responseMessage.setOverloaded(true);
+
+   const std::string response(responseMessage.toString());
+   if (!writeResponse(socket, response)) {
+      TONNERRE_LOG_ERROR("writing overloaded response to socket failed");
+   }
+
+   return response.length();
+}
+
+//******************************************************************************
+
+void MessageRequestHandler::respondToStats(Socket* socket, const Message& requestMessage) {
+   Message responseMessage(requestMessage.getRequestName(),
+                           requestMessage.getType());
+   m_metrics->respondToStats(requestMessage, responseMessage);
+
+   if (!writeResponse(socket, responseMessage.toString())) {
+      TONNERRE_LOG_ERROR("writing stats response to socket failed");
+   }
+}
+
+//******************************************************************************
+
+void MessageRequestHandler::respond(Socket* socket,
+                                    MessageHandler* messageHandler,
+                                    const Message& requestMessage) {
+   typedef std::chrono::steady_clock Clock;
+
+   // only the connection's first request has waited in the queue; later
+   // ones on a kept-alive connection are read as soon as they arrive
+   const Clock::duration queueDelay = m_queueDelay;
+   m_queueDelay = Clock::duration::zero();
+
+   // stats requests are answered (and never shed) so that an overloaded
+   // server can still be looked at, and aren't counted themselves
+   if ((m_metrics != nullptr) && ServerMetrics::isStatsRequest(requestMessage)) {
+      respondToStats(socket, requestMessage);
+      return;
+   }
+
+   const bool isMeasured = (m_metrics != nullptr);
+   const Clock::time_point startedAt = isMeasured ? Clock::now() : Clock::time_point();
+
+   if (!admitRequest(queueDelay)) {
+      const std::size_t bytesOut = shed(socket, requestMessage);
+      if (isMeasured) {
+         const Clock::duration elapsed = Clock::now() - startedAt;
+         m_metrics->record(requestMessage.getRequestName(), true,
+                           requestMessage.getWireLength(), bytesOut,
+                           queueDelay, Clock::duration::zero(), queueDelay + elapsed);
+      }
+      return;
+   }
+
+   bool isError = false;
+   std::size_t bytesOut = 0;
+   Clock::time_point handledAt;
+
+   // an async handler counts as in flight until it returns, not until its
+   // responder completes (and is measured the same way)
+   if (dispatchAsync(socket, messageHandler, requestMessage)) {
+      if (isMeasured) {
+         handledAt = Clock::now();
+      }
+   } else {
+      Message responseMessage(requestMessage.getRequestName(),
+                              requestMessage.getType());
+      const bool isTraced = requestMessage.isTraced();
+      const std::int64_t handlerStartNanos = isTraced ? RequestTrace::now() : 0;
+      isError = !dispatch(messageHandler, requestMessage, responseMessage);
+      if (isMeasured) {
+         handledAt = Clock::now();
+      }
+
+      if (isTraced) {
+         RequestTrace::stampServerStages(requestMessage, responseMessage,
+                                         traceAcceptNanos(), handlerStartNanos,
+                                         RequestTrace::now());
+         RequestTrace::stamp(responseMessage, RequestTrace::StageServerWrite,
+                             RequestTrace::now());
+      }
+
+      const std::string response(responseMessage.toString());
+      bytesOut = response.length();
+      if (!writeResponse(socket, response)) {
+         TONNERRE_LOG_ERROR("writing response message to socket failed");
+         isError = true;
+      }
+   }
+
+   if (m_admissionController != nullptr) {
+      m_admissionController->release();
+   }
+
+   if (isMeasured) {
+      const Clock::time_point finishedAt = Clock::now();
+      m_metrics->record(requestMessage.getRequestName(), isError,
+                        requestMessage.getWireLength(), bytesOut,
+                        queueDelay, handledAt - startedAt,
+                        queueDelay + (finishedAt - startedAt));
+   }
+}
+
+//******************************************************************************
+
+bool MessageRequestHandler::dispatchAsync(Socket* socket,
+                                          MessageHandler* messageHandler,
+                                          const Message& requestMessage) {
+   AsyncMessageHandler* asyncHandler =
+      messageHandler->asyncHandlerFor(requestMessage);
+   if (asyncHandler == nullptr) {
+      return false;
+   }
+
+   std::shared_ptr<Responder::Connection> connection;
+   if (!requestMessage.isOneWay()) {
+      connection = responseConnection(socket);
+   }
+
+   invokeAsyncHandler(asyncHandler, requestMessage, connection, traceAcceptNanos());
+   return true;
+}
+
+//******************************************************************************
+
+void MessageRequestHandler::invokeAsyncHandler(AsyncMessageHandler* asyncHandler,
+                                               const Message& requestMessage,
+                                               std::shared_ptr<Responder::Connection> connection,
+                                               std::int64_t acceptNanos) {
+   std::shared_ptr<Responder> responder(new Responder(connection, requestMessage));
+   if (requestMessage.isTraced()) {
+      // the responder stamps the handler's end when it is completed
+      RequestTrace::stampServerStages(requestMessage, responder->getResponseMessage(),
+                                      acceptNanos, RequestTrace::now(), 0);
+   }
+   const std::string& requestName = requestMessage.getRequestName();
+   const MessageType messageType = requestMessage.getType();
+
+   // if the handler throws without keeping the responder, the responder's
+   // destructor still sends the (empty) response
+   try {
+      if (messageType == MessageTypeKeyValues) {
+         asyncHandler->handleKeyValuesMessageAsync(requestMessage,
+                                                   requestName,
+                                                   requestMessage.getKeyValuesPayload(),
+                                                   std::move(responder));
+      } else if (messageType == MessageTypeText) {
+         asyncHandler->handleTextMessageAsync(requestMessage,
+                                              requestName,
+                                              requestMessage.getTextPayload(),
+                                              std::move(responder));
+      }
+   } catch (...) {
+      logHandlerException();
+   }
+}
+
+//******************************************************************************
+
+std::shared_ptr<Responder::Connection> MessageRequestHandler::responseConnection(Socket* socket) {
+   if (m_responseConnection == nullptr) {
+      // responses may be written after this handler (and the socket it
+      // owns) is gone, so the responders share their own descriptor
+      const int fd = ::dup(socket->getFileDescriptor());
+      if (fd != -1) {
+         m_responseConnection.reset(new Responder::Connection(new Socket(fd)));
+      } else {
+         TONNERRE_LOG_ERROR("unable to duplicate socket for async responses");
+      }
+   }
+
+   return m_responseConnection;
+}
+
+//******************************************************************************
+
+bool MessageRequestHandler::writeResponse(Socket* socket,
+                                          const std::string& encodedResponse) {
+   // once a responder has the connection, every response goes through it
+   // so that writes from different threads can't interleave
+   if (m_responseConnection != nullptr) {
+      return m_responseConnection->write(encodedResponse);
+   }
+
+   return socket->write(encodedResponse);
+}
+
+//******************************************************************************
+
+bool MessageRequestHandler::awaitResponses(Socket* socket) {
+   if (m_responseConnection == nullptr) {
+      return true;
+   }
+
+   // the protocol has no request ids, so a client matches responses to its
+   // requests by order: nothing more is read (or handed to another
+   // handler) until the async responses already owed have been written
+   if (m_responseConnection->awaitResponses(
+          m_serverOptions->getKeepAliveIdleTimeoutMillis())) {
+      return true;
+   }
+
+   TONNERRE_LOG_WARNING("async responses not completed within idle timeout, closing connection");
+   socket->close();
+   return false;
+}
+
+//******************************************************************************
+
+void MessageRequestHandler::ingest(Socket* socket,
+                                   MessageHandler* messageHandler,
+                                   const Message& firstMessage) {
+   // nobody reads the response to a one-way message, so in ingestion mode
+   // one-way messages are dispatched without building, flattening or
+   // writing a response. The handler signature still needs a response
+   // object to write into; one scratch instance serves the whole stream.
+   Message scratchResponse;
+   typedef std::chrono::steady_clock Clock;
+
+   const Message* message = &firstMessage;
+   std::unique_ptr<Message> nextMessage;
+
+   for (;;) {
+      if (message->isOneWay()) {
+         const Clock::duration queueDelay = m_queueDelay;
+         m_queueDelay = Clock::duration::zero();
+         const Clock::time_point startedAt =
+            (m_metrics != nullptr) ? Clock::now() : Clock::time_point();
+
+         bool isError = false;
+         if (!dispatchAsync(socket, messageHandler, *message)) {
+            KeyValuePairs kvpResponsePayload;
+            std::string textResponsePayload;
+            isError = !invokeHandler(messageHandler,
+                                     *message,
+                                     scratchResponse,
+                                     kvpResponsePayload,
+                                     textResponsePayload);
+         }
+
+         if (m_metrics != nullptr) {
+            const Clock::duration elapsed = Clock::now() - startedAt;
+            m_metrics->record(message->getRequestName(), isError,
+                              message->getWireLength(), 0,
+                              queueDelay, elapsed, queueDelay + elapsed);
+         }
+      } else {
+         respond(socket, messageHandler, *message);
+      }
+
+      // the sender closing its end is the normal end of a stream, so check
+      // for that before trying to read (and logging a failed read)
+      if (!awaitReadable(socket)) {
+         break;
+      }
+
+      nextMessage.reset(Message::reconstruct(socket));
+      if (nextMessage == nullptr) {
+         TONNERRE_LOG_ERROR("unable to reconstruct message from ingestion stream");
+         break;
+      }
+
+      message = nextMessage.get();
+   }
+}
+
+//******************************************************************************
+
+std::int64_t MessageRequestHandler::traceAcceptNanos() const {
+   // (RequestTrace::now() reads the same clock)
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      m_acceptedAt.time_since_epoch()).count();
+}
+
+//******************************************************************************
+
+bool MessageRequestHandler::awaitNextMessage(Socket* socket) {
+   const int maxRequests = m_serverOptions->getKeepAliveMaxRequests();
+   if ((maxRequests > 0) && (m_requestsServed >= maxRequests)) {
+      socket->close();
+      return false;
+   }
+
+   return awaitReadable(socket);
+}
+
+//******************************************************************************
+
+bool MessageRequestHandler::awaitReadable(Socket* socket) {
+   // (a connection parked or left to the event loop has none outstanding,
+   // so the handler that picks it up can start a connection of its own)
+   if (!awaitResponses(socket)) {
+      return false;
+   }
+
+   if (m_isEventLoopConnection) {
+      // the loop's thread serves every connection it watches, so only
+      // messages already on the wire are taken, and only a few of them;
+      // returning leaves the connection open, and the loop dispatches it
+      // again when the next message arrives
+      if (++m_messagesThisWakeup >= MAX_MESSAGES_PER_WAKEUP) {
+         return false;
+      }
+      return waitForReadable(socket, 0) == SocketReadable;
+   }
+
+   // a client issuing back-to-back requests usually has the next one on
+   // the wire within the linger time, so check briefly before giving up
+   // the thread
+   const int lingerMillis = m_serverOptions->getKeepAliveLingerMillis();
+   const SocketReadiness readiness = waitForReadable(socket, lingerMillis);
+   if (readiness == SocketReadable) {
+      return true;
+   } else if (readiness == SocketClosed) {
+      return false;
+   }
+
+   if (m_idleMonitor != nullptr) {
+      // the monitor gets its own descriptor for the connection so that this
+      // handler can still delete (and close) the socket it owns
+      const int fd = ::dup(socket->getFileDescriptor());
+      if (fd != -1) {
+         Socket* parkedSocket = new Socket(fd);
+         if (!m_idleMonitor->park(parkedSocket, m_requestsServed)) {
+            // monitor is shutting down
+            delete parkedSocket;
+         }
+      } else {
+         TONNERRE_LOG_ERROR("unable to hand idle connection to monitor");
+      }
+      return false;
+   }
+
+   // no event loop to hand it to -- wait out the idle timeout here
+   const int idleMillis =
+      m_serverOptions->getKeepAliveIdleTimeoutMillis() - lingerMillis;
+   if (waitForReadable(socket, (idleMillis > 0) ? idleMillis : 0) == SocketReadable) {
+      return true;
+   }
+
+   socket->close();
+   return false;
+}
+
+//******************************************************************************
+
+MessageRequestHandler::SocketReadiness
+MessageRequestHandler::waitForReadable(Socket* socket, int timeoutMillis) {
+   const int fd = socket->getFileDescriptor();
+
+   struct pollfd pfd;
+   pfd.fd = fd;
+   pfd.events = POLLIN;
+   pfd.revents = 0;
+
+   int rc;
+   do {
+      rc = ::poll(&pfd, 1, timeoutMillis);
+   } while ((rc < 0) && (errno == EINTR));
+
+   if (rc == 0) {
+      return SocketIdle;
+   } else if (rc < 0) {
+      return SocketClosed;
+   }
+
+   // readable also covers the peer closing its end
+   char peekByte;
+   if (::recv(fd, &peekByte, 1, MSG_PEEK) <= 0) {
+      return SocketClosed;
+   }
+
+   return SocketReadable;
+}
+
+//******************************************************************************
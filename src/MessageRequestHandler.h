@@ -4,12 +4,27 @@
 #ifndef TONNERRE_MESSAGEREQUESTHANDLER_H
 #define TONNERRE_MESSAGEREQUESTHANDLER_H
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
 #include "RequestHandler.h"
+#include "KeyValuePairs.h"
+#include "Responder.h"
 
 
 namespace tonnerre
 {
+   class Message;
+   class AdmissionController;
+   class AsyncMessageHandler;
+   class IdleConnectionMonitor;
    class MessageHandler;
+   class PriorityExecutor;
+   class ServerMetrics;
+   class ServerOptions;
 
 /**
  *
@@ -17,6 +32,81 @@ namespace tonnerre
 class MessageRequestHandler : public chaudiere::RequestHandler
 {
 public:
+   /**
+    * What became of a request passed to serveRequest()
+    */
+   enum RequestDisposition {
+      RequestHandled,     // handled (or answered from the metrics)
+      RequestDeferred,    // handed to an async handler; its responder answers
+      RequestShed,        // turned away by the admission controller
+      RequestUnanswered   // handled, but the response couldn't be written
+   };
+
+   /**
+    * Takes an encoded response for a transport to send
+    */
+   typedef std::function<bool(const std::string& encodedResponse)> ResponseWriter;
+
+   /**
+    * Serves one request for a transport that reads requests and handles
+    * them on its own thread (io_uring, shared memory, UDP, in-process):
+    * answers a stats request from the metrics, asks the admission
+    * controller (there's no queueing delay to judge -- only the in-flight
+    * limit applies), dispatches to the handler, stamps the trace, writes
+    * the response and records the request in the metrics. An async
+    * handler is given a responder on asyncConnection and isn't waited for.
+    * @param handler the handler for the request
+    * @param admissionController the controller to consult (may be null)
+    * @param metrics the metrics to record in (may be null)
+    * @param requestMessage the request message
+    * @param requestBytes the request's size on the wire (for the metrics)
+    * @param responseMessage the response message to populate
+    * @param writeResponse sends the encoded response (empty if nobody reads it)
+    * @param asyncConnection where an async handler's response is written
+    * (null if nobody reads it)
+    * @return what became of the request
+    * @see RequestDisposition
+    */
+   static RequestDisposition serveRequest(MessageHandler* handler,
+                                          AdmissionController* admissionController,
+                                          ServerMetrics* metrics,
+                                          const Message& requestMessage,
+                                          std::size_t requestBytes,
+                                          Message& responseMessage,
+                                          const ResponseWriter& writeResponse,
+                                          std::shared_ptr<Responder::Connection> asyncConnection);
+
+   /**
+    * Invokes the handler method matching the request's payload type and
+    * populates the response payload, logging (and swallowing) any exception
+    * the handler throws
+    * @param handler the handler to invoke
+    * @param requestMessage the request message
+    * @param responseMessage the response message to populate
+    * @return boolean indicating if the handler completed without throwing
+    * @see MessageHandler()
+    */
+   static bool dispatch(MessageHandler* handler,
+                        const Message& requestMessage,
+                        Message& responseMessage);
+
+   /**
+    * Hands a request to an async handler along with a responder that
+    * writes to the given connection, returning as soon as the handler
+    * returns (the responder may complete later, on any thread)
+    * @param asyncHandler the handler to invoke
+    * @param requestMessage the request message
+    * @param connection where the response is written (null if nobody reads it)
+    * @param acceptNanos when the request's connection was accepted, for its
+    * trace (0 if not known)
+    * @see AsyncMessageHandler()
+    * @see Responder()
+    */
+   static void invokeAsyncHandler(AsyncMessageHandler* asyncHandler,
+                                  const Message& requestMessage,
+                                  std::shared_ptr<Responder::Connection> connection,
+                                  std::int64_t acceptNanos);
+
    /**
     *
     * @param socket
@@ -41,13 +131,124 @@ public:
     */
    ~MessageRequestHandler();
 
+   /**
+    * Sets the server options that govern how the connection is serviced
+    * @param serverOptions the options (not owned; must outlive the handler)
+    * @see ServerOptions()
+    */
+   void setServerOptions(const ServerOptions* serverOptions);
+
+   /**
+    * Sets the monitor that idle keep-alive connections are parked with
+    * instead of holding this handler's thread (used internally)
+    * @param idleMonitor the monitor (not owned)
+    * @see IdleConnectionMonitor()
+    */
+   void setIdleConnectionMonitor(IdleConnectionMonitor* idleMonitor);
+
+   /**
+    * Sets the admission controller that decides whether each request is
+    * handled or answered with an 'overloaded' response. The handler counts
+    * as waiting in the controller's queue from this call until it's run.
+    * @param admissionController the controller (not owned)
+    * @see AdmissionController()
+    */
+   void setAdmissionController(AdmissionController* admissionController);
+
+   /**
+    * Sets the executor that requests are queued on by priority. Each request
+    * read by this handler is then handled by a new handler on that
+    * executor (which keeps the connection) instead of on this thread.
+    * Connections serviced from chaudière's event loop are never handed
+    * over.
+    * @param priorityExecutor the executor (not owned)
+    * @see PriorityExecutor()
+    */
+   void setPriorityExecutor(PriorityExecutor* priorityExecutor);
+
+   /**
+    * Sets the metrics that each request is recorded in. With metrics set,
+    * the reserved '__stats' request is answered from them rather than
+    * passed to the message handler.
+    * @param metrics the metrics (not owned)
+    * @see ServerMetrics()
+    */
+   void setServerMetrics(ServerMetrics* metrics);
+
+   /**
+    * Sets the number of requests already served on the connection (used
+    * internally when a parked connection is resumed)
+    * @param requestsServed the number of requests served so far
+    */
+   void setRequestsServed(int requestsServed);
+
+   /**
+    * Retrieves the number of requests served on the connection so far
+    * @return the number of requests served
+    */
+   int getRequestsServed() const;
+
    /**
     *
     */
    virtual void run();
 
 private:
+   static bool invokeHandler(MessageHandler* handler,
+                             const Message& requestMessage,
+                             Message& responseMessage,
+                             chaudiere::KeyValuePairs& kvpResponsePayload,
+                             std::string& textResponsePayload);
+   static void logHandlerException();
+
+   bool dispatchAsync(chaudiere::Socket* socket,
+                      MessageHandler* handler,
+                      const Message& requestMessage);
+   std::shared_ptr<Responder::Connection> responseConnection(chaudiere::Socket* socket);
+   bool writeResponse(chaudiere::Socket* socket, const std::string& encodedResponse);
+   bool awaitResponses(chaudiere::Socket* socket);
+
+   bool schedule(chaudiere::Socket* socket,
+                 std::unique_ptr<Message>& requestMessage);
+   bool admitRequest(std::chrono::steady_clock::duration queueDelay);
+   std::size_t shed(chaudiere::Socket* socket, const Message& requestMessage);
+   void respondToStats(chaudiere::Socket* socket, const Message& requestMessage);
+
+   void respond(chaudiere::Socket* socket,
+                MessageHandler* handler,
+                const Message& requestMessage);
+   void ingest(chaudiere::Socket* socket,
+               MessageHandler* handler,
+               const Message& firstMessage);
+   bool awaitNextMessage(chaudiere::Socket* socket);
+   bool awaitReadable(chaudiere::Socket* socket);
+   std::int64_t traceAcceptNanos() const;
+
+   enum SocketReadiness {
+      SocketReadable,
+      SocketClosed,
+      SocketIdle
+   };
+
+   SocketReadiness waitForReadable(chaudiere::Socket* socket,
+                                   int timeoutMillis);
+
    MessageHandler* m_handler;
+   const ServerOptions* m_serverOptions;
+   IdleConnectionMonitor* m_idleMonitor;
+   AdmissionController* m_admissionController;
+   PriorityExecutor* m_priorityExecutor;
+   ServerMetrics* m_metrics;
+   std::unique_ptr<Message> m_pendingRequest;
+   std::chrono::steady_clock::time_point m_enqueuedAt;
+   std::chrono::steady_clock::time_point m_acceptedAt;
+   std::chrono::steady_clock::duration m_queueDelay;
+   int m_requestsServed;
+   int m_messagesThisWakeup;
+   bool m_isEventLoopConnection;
+   bool m_isQueued;
+   bool m_isOverQueueDepth;
+   std::shared_ptr<Responder::Connection> m_responseConnection;
 };
 
 }
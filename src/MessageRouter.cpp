@@ -0,0 +1,254 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "MessageRouter.h"
+#include "Message.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+static const std::size_t INITIAL_NUMBER_SLOTS = 16;
+
+//******************************************************************************
+
+MessageRouter::Route::Route(const std::string& requestName) :
+   m_requestName(requestName),
+   m_fallback(nullptr) {
+}
+
+//******************************************************************************
+
+MessageRouter::Route& MessageRouter::Route::onText(const TextHandler& handler) {
+   m_textHandler = handler;
+   return *this;
+}
+
+//******************************************************************************
+
+MessageRouter::Route& MessageRouter::Route::onKeyValues(const KeyValuesHandler& handler) {
+   m_keyValuesHandler = handler;
+   return *this;
+}
+
+//******************************************************************************
+
+MessageRouter::Route& MessageRouter::Route::before(const BeforeHook& hook) {
+   m_beforeHook = hook;
+   return *this;
+}
+
+//******************************************************************************
+
+MessageRouter::Route& MessageRouter::Route::after(const AfterHook& hook) {
+   m_afterHook = hook;
+   return *this;
+}
+
+//******************************************************************************
+
+MessageRouter::Route& MessageRouter::Route::fallback(MessageHandler* fallback) {
+   m_fallback = fallback;
+   return *this;
+}
+
+//******************************************************************************
+
+const std::string& MessageRouter::Route::getRequestName() const {
+   return m_requestName;
+}
+
+//******************************************************************************
+
+MessageRouter::MessageRouter() :
+   m_slots(INITIAL_NUMBER_SLOTS, Slot{0, nullptr}),
+   m_mask(INITIAL_NUMBER_SLOTS - 1),
+   m_fallback(nullptr) {
+   TONNERRE_LOG_INSTANCE_CREATE("MessageRouter");
+}
+
+//******************************************************************************
+
+MessageRouter::~MessageRouter() {
+   TONNERRE_LOG_INSTANCE_DESTROY("MessageRouter");
+}
+
+//******************************************************************************
+
+MessageRouter::Route& MessageRouter::route(const RouteKey& key) {
+   Route* existing = lookup(key.hash(), key.name());
+   if (existing != nullptr) {
+      return *existing;
+   }
+
+   // keep the table at most half full so probe sequences stay short
+   if ((m_routes.size() + 1) * 2 > m_slots.size()) {
+      grow();
+   }
+
+   m_routes.emplace_back(std::string(key.name()));
+   Route* route = &m_routes.back();
+   insert(key.hash(), route);
+   return *route;
+}
+
+//******************************************************************************
+
+MessageRouter::Route& MessageRouter::route(std::string_view requestName) {
+   return route(RouteKey(requestName));
+}
+
+//******************************************************************************
+
+const MessageRouter::Route* MessageRouter::findRoute(const RouteKey& key) const {
+   return lookup(key.hash(), key.name());
+}
+
+//******************************************************************************
+
+const MessageRouter::Route* MessageRouter::findRoute(std::string_view requestName) const {
+   return lookup(RouteKey::hashName(requestName), requestName);
+}
+
+//******************************************************************************
+
+void MessageRouter::setFallback(MessageHandler* fallback) {
+   m_fallback = fallback;
+}
+
+//******************************************************************************
+
+std::size_t MessageRouter::getNumberRoutes() const {
+   return m_routes.size();
+}
+
+//******************************************************************************
+
+MessageRouter::Route* MessageRouter::lookup(std::uint64_t hash,
+                                            std::string_view requestName) const {
+   std::size_t index = hash & m_mask;
+   for (;;) {
+      const Slot& slot = m_slots[index];
+      if (slot.route == nullptr) {
+         return nullptr;
+      }
+
+      if ((slot.hash == hash) && (slot.route->m_requestName == requestName)) {
+         return slot.route;
+      }
+
+      index = (index + 1) & m_mask;
+   }
+}
+
+//******************************************************************************
+
+void MessageRouter::insert(std::uint64_t hash, Route* route) {
+   std::size_t index = hash & m_mask;
+   while (m_slots[index].route != nullptr) {
+      index = (index + 1) & m_mask;
+   }
+
+   m_slots[index].hash = hash;
+   m_slots[index].route = route;
+}
+
+//******************************************************************************
+
+void MessageRouter::grow() {
+   std::vector<Slot> oldSlots(m_slots.size() * 2, Slot{0, nullptr});
+   oldSlots.swap(m_slots);
+   m_mask = m_slots.size() - 1;
+
+   for (const Slot& slot : oldSlots) {
+      if (slot.route != nullptr) {
+         insert(slot.hash, slot.route);
+      }
+   }
+}
+
+//******************************************************************************
+
+MessageHandler* MessageRouter::fallbackFor(const Route* route) const {
+   if ((route != nullptr) && (route->m_fallback != nullptr)) {
+      return route->m_fallback;
+   }
+
+   return m_fallback;
+}
+
+//******************************************************************************
+
+void MessageRouter::handleTextMessage(const Message& requestMessage,
+                                      Message& responseMessage,
+                                      const std::string& requestName,
+                                      const std::string& requestPayload,
+                                      std::string& responsePayload) {
+   const Route* route = findRoute(requestName);
+
+   if ((route != nullptr) && route->m_beforeHook &&
+       !route->m_beforeHook(requestMessage, responseMessage)) {
+      return;
+   }
+
+   if ((route != nullptr) && route->m_textHandler) {
+      route->m_textHandler(requestMessage,
+                           responseMessage,
+                           requestPayload,
+                           responsePayload);
+   } else {
+      MessageHandler* fallback = fallbackFor(route);
+      if (fallback != nullptr) {
+         fallback->handleTextMessage(requestMessage,
+                                     responseMessage,
+                                     requestName,
+                                     requestPayload,
+                                     responsePayload);
+      } else {
+         TONNERRE_LOG_WARNING("no route for text request '" + requestName + "'");
+      }
+   }
+
+   if ((route != nullptr) && route->m_afterHook) {
+      route->m_afterHook(requestMessage, responseMessage);
+   }
+}
+
+//******************************************************************************
+
+void MessageRouter::handleKeyValuesMessage(const Message& requestMessage,
+                                           Message& responseMessage,
+                                           const std::string& requestName,
+                                           const KeyValuePairs& requestPayload,
+                                           KeyValuePairs& responsePayload) {
+   const Route* route = findRoute(requestName);
+
+   if ((route != nullptr) && route->m_beforeHook &&
+       !route->m_beforeHook(requestMessage, responseMessage)) {
+      return;
+   }
+
+   if ((route != nullptr) && route->m_keyValuesHandler) {
+      route->m_keyValuesHandler(requestMessage,
+                                responseMessage,
+                                requestPayload,
+                                responsePayload);
+   } else {
+      MessageHandler* fallback = fallbackFor(route);
+      if (fallback != nullptr) {
+         fallback->handleKeyValuesMessage(requestMessage,
+                                          responseMessage,
+                                          requestName,
+                                          requestPayload,
+                                          responsePayload);
+      } else {
+         TONNERRE_LOG_WARNING("no route for key-values request '" + requestName + "'");
+      }
+   }
+
+   if ((route != nullptr) && route->m_afterHook) {
+      route->m_afterHook(requestMessage, responseMessage);
+   }
+}
+
+//******************************************************************************
@@ -0,0 +1,184 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_MESSAGEROUTER_H
+#define TONNERRE_MESSAGEROUTER_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MessageHandler.h"
+#include "RouteKey.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * MessageRouter is a MessageHandler that hands each request to the handler
+ * registered for its request name, replacing chains of request name
+ * comparisons inside a single handler. Routes live in a flat open-addressing
+ * table keyed by the request name's hash, so dispatch costs one hash of the
+ * incoming name and (almost always) one probe, however many routes there
+ * are. Register routes with a constexpr RouteKey to have their hashes
+ * computed at compile time.
+ *
+ * Requests with no route go to the router's fallback handler. A route may
+ * also name its own fallback for payload types it has no handler for, and
+ * may have hooks that run before and after its handler.
+ *
+ * Routes must be registered before the server starts running -- lookups on
+ * the request path are not synchronized with registration.
+ */
+class MessageRouter : public MessageHandler
+{
+public:
+   typedef std::function<void(const Message& requestMessage,
+                              Message& responseMessage,
+                              const std::string& requestPayload,
+                              std::string& responsePayload)> TextHandler;
+
+   typedef std::function<void(const Message& requestMessage,
+                              Message& responseMessage,
+                              const chaudiere::KeyValuePairs& requestPayload,
+                              chaudiere::KeyValuePairs& responsePayload)> KeyValuesHandler;
+
+   /**
+    * Hook run before a route's handler; returning false skips the handler
+    * (and the after hook), e.g. for a failed authorization check
+    */
+   typedef std::function<bool(const Message& requestMessage,
+                              Message& responseMessage)> BeforeHook;
+
+   /**
+    * Hook run after a route's handler has returned normally
+    */
+   typedef std::function<void(const Message& requestMessage,
+                              Message& responseMessage)> AfterHook;
+
+   /**
+    * Route holds the handlers and hooks for one request name. Setters
+    * return the route so that registration can be chained.
+    */
+   class Route
+   {
+   public:
+      explicit Route(const std::string& requestName);
+
+      Route& onText(const TextHandler& handler);
+      Route& onKeyValues(const KeyValuesHandler& handler);
+      Route& before(const BeforeHook& hook);
+      Route& after(const AfterHook& hook);
+
+      /**
+       * Sets the handler for payload types this route has no handler for
+       * (overrides the router's fallback for this route)
+       * @param fallback the fallback handler (not owned)
+       */
+      Route& fallback(MessageHandler* fallback);
+
+      const std::string& getRequestName() const;
+
+   private:
+      friend class MessageRouter;
+
+      std::string m_requestName;
+      TextHandler m_textHandler;
+      KeyValuesHandler m_keyValuesHandler;
+      BeforeHook m_beforeHook;
+      AfterHook m_afterHook;
+      MessageHandler* m_fallback;
+   };
+
+   /**
+    * Default constructor
+    */
+   MessageRouter();
+
+   /**
+    * Destructor
+    */
+   ~MessageRouter();
+
+   /**
+    * Retrieves the route for a request name, adding it if not yet registered
+    * @param key the request name (and its precomputed hash)
+    * @return the route
+    */
+   Route& route(const RouteKey& key);
+
+   /**
+    * Retrieves the route for a request name, adding it if not yet registered
+    * @param requestName the request name
+    * @return the route
+    */
+   Route& route(std::string_view requestName);
+
+   /**
+    * Retrieves the registered route for a request name
+    * @param key the request name (and its precomputed hash)
+    * @return the route, or null if no route is registered
+    */
+   const Route* findRoute(const RouteKey& key) const;
+
+   /**
+    * Retrieves the registered route for a request name
+    * @param requestName the request name
+    * @return the route, or null if no route is registered
+    */
+   const Route* findRoute(std::string_view requestName) const;
+
+   /**
+    * Sets the handler for requests that have no route
+    * @param fallback the fallback handler (not owned)
+    */
+   void setFallback(MessageHandler* fallback);
+
+   /**
+    * Retrieves the number of registered routes
+    * @return the number of routes
+    */
+   std::size_t getNumberRoutes() const;
+
+   // MessageHandler
+   void handleTextMessage(const Message& requestMessage,
+                          Message& responseMessage,
+                          const std::string& requestName,
+                          const std::string& requestPayload,
+                          std::string& responsePayload) override;
+
+   void handleKeyValuesMessage(const Message& requestMessage,
+                               Message& responseMessage,
+                               const std::string& requestName,
+                               const chaudiere::KeyValuePairs& requestPayload,
+                               chaudiere::KeyValuePairs& responsePayload) override;
+
+private:
+   struct Slot {
+      std::uint64_t hash;
+      Route* route;
+   };
+
+   Route* lookup(std::uint64_t hash, std::string_view requestName) const;
+   void insert(std::uint64_t hash, Route* route);
+   void grow();
+   MessageHandler* fallbackFor(const Route* route) const;
+
+   std::deque<Route> m_routes;   // deque: references stay valid as routes are added
+   std::vector<Slot> m_slots;
+   std::size_t m_mask;
+   MessageHandler* m_fallback;
+
+   // disallow copies
+   MessageRouter(const MessageRouter&);
+   MessageRouter& operator=(const MessageRouter&);
+};
+
+}
+
+#endif
+
@@ -6,7 +6,7 @@
 #include "MessageSocketServiceHandler.h"
 #include "SocketRequest.h"
 #include "MessageRequestHandler.h"
-#include "Logger.h"
+#include "Logging.h"
 
 using namespace tonnerre;
 using namespace chaudiere;
@@ -17,25 +17,54 @@ const std::string MessageSocketServiceHandler::handlerName =
 //******************************************************************************
 
 MessageSocketServiceHandler::MessageSocketServiceHandler(MessageHandler* handler) :
-   m_handler(handler) {
-   Logger::logInstanceCreate("MessageSocketServiceHandler");
+   m_handler(handler),
+   m_serverOptions(nullptr),
+   m_admissionController(nullptr),
+   m_metrics(nullptr) {
+   TONNERRE_LOG_INSTANCE_CREATE("MessageSocketServiceHandler");
+}
+
+//******************************************************************************
+
+MessageSocketServiceHandler::MessageSocketServiceHandler(MessageHandler* handler,
+                                                         const ServerOptions* serverOptions) :
+   m_handler(handler),
+   m_serverOptions(serverOptions),
+   m_admissionController(nullptr),
+   m_metrics(nullptr) {
+   TONNERRE_LOG_INSTANCE_CREATE("MessageSocketServiceHandler");
 }
 
 //******************************************************************************
 
 MessageSocketServiceHandler::~MessageSocketServiceHandler() {
-   Logger::logInstanceDestroy("MessageSocketServiceHandler");
+   TONNERRE_LOG_INSTANCE_DESTROY("MessageSocketServiceHandler");
 }
 
 //******************************************************************************
 
 void MessageSocketServiceHandler::serviceSocket(SocketRequest* socketRequest) {
    MessageRequestHandler messageRequestHandler(socketRequest, m_handler);
+   messageRequestHandler.setServerOptions(m_serverOptions);
+   messageRequestHandler.setAdmissionController(m_admissionController);
+   messageRequestHandler.setServerMetrics(m_metrics);
    messageRequestHandler.run();
 }
 
 //******************************************************************************
 
+void MessageSocketServiceHandler::setAdmissionController(AdmissionController* admissionController) {
+   m_admissionController = admissionController;
+}
+
+//******************************************************************************
+
+void MessageSocketServiceHandler::setServerMetrics(ServerMetrics* metrics) {
+   m_metrics = metrics;
+}
+
+//******************************************************************************
+
 const std::string& MessageSocketServiceHandler::getName() const {
    return handlerName;
 }
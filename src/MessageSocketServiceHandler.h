@@ -12,7 +12,10 @@
 
 namespace tonnerre
 {
+   class AdmissionController;
    class MessageHandler;
+   class ServerMetrics;
+   class ServerOptions;
 
 /**
  *
@@ -27,6 +30,16 @@ public:
     */
    MessageSocketServiceHandler(MessageHandler* handler);
 
+   /**
+    *
+    * @param handler
+    * @param serverOptions the options passed on to each request handler (not owned)
+    * @see MessageHandler()
+    * @see ServerOptions()
+    */
+   MessageSocketServiceHandler(MessageHandler* handler,
+                               const ServerOptions* serverOptions);
+
    /**
     * Destructor
     */
@@ -39,6 +52,20 @@ public:
     */
    virtual void serviceSocket(chaudiere::SocketRequest* socketRequest);
 
+   /**
+    * Sets the admission controller passed on to each request handler
+    * @param admissionController the controller (not owned)
+    * @see AdmissionController()
+    */
+   void setAdmissionController(AdmissionController* admissionController);
+
+   /**
+    * Sets the metrics passed on to each request handler
+    * @param metrics the metrics (not owned)
+    * @see ServerMetrics()
+    */
+   void setServerMetrics(ServerMetrics* metrics);
+
    /**
     * Retrieves the name of the handler. This is primarily an aid for debugging.
     * @return the name of the handler
@@ -48,6 +75,9 @@ public:
 private:
    static const std::string handlerName;
    MessageHandler* m_handler;
+   const ServerOptions* m_serverOptions;
+   AdmissionController* m_admissionController;
+   ServerMetrics* m_metrics;
 
 };
 
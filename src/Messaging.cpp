@@ -1,6 +1,7 @@
 // Copyright Paul Dardeau, SwampBits LLC 2014
 // BSD License
 
+#include <random>
 #include <vector>
 #include <stdlib.h>
 
@@ -11,17 +12,23 @@
 #include "MutexLock.h"
 #include "PthreadsThreadingFactory.h"
 #include "StrUtils.h"
+#include "UnixSocket.h"
 
 using namespace std;
 using namespace tonnerre;
 using namespace chaudiere;
 
 static const std::string KEY_HOST        = "host";
+static const std::string KEY_PATH        = "path";
 static const std::string KEY_PERSISTENT  = "persistent";
 static const std::string KEY_PORT        = "port";
 static const std::string KEY_SERVICES    = "services";
 
 static const std::string VALUE_TRUE      = "true";
+
+// how long a service whose segment isn't being served goes before the
+// segment is looked for again
+static const int SHM_RETRY_MILLIS        = 1000;
 static const std::string EMPTY           = "";
 
 
@@ -68,11 +75,14 @@ void Messaging::initialize(const std::string& configFilePath)
 
             KeyValuePairs kvp;
             if (reader.readSection(sectionName, kvp)) {
-               if (kvp.hasKey(KEY_HOST) && kvp.hasKey(KEY_PORT)) {
-                  const string& host = kvp.getValue(KEY_HOST);
-                  const string& portAsString = kvp.getValue(KEY_PORT);
-                  const unsigned short portValue =
-                     (unsigned short) StrUtils::parseInt(portAsString);
+               const bool hasPath = kvp.hasKey(KEY_PATH);
+               if (hasPath || (kvp.hasKey(KEY_HOST) && kvp.hasKey(KEY_PORT))) {
+                  // a Unix domain socket service has its path for a host
+                  // and no port
+                  const string& host =
+                     hasPath ? kvp.getValue(KEY_PATH) : kvp.getValue(KEY_HOST);
+                  const unsigned short portValue = hasPath ? 0 :
+                     (unsigned short) StrUtils::parseInt(kvp.getValue(KEY_PORT));
 
                   ServiceInfo serviceInfo(serviceName, host, portValue);
 
@@ -84,7 +94,11 @@ void Messaging::initialize(const std::string& configFilePath)
                      }
                   }
 
+                  ServiceOptions options;
+                  options.populate(kvp);
+
                   messaging->registerService(serviceName, serviceInfo);
+                  messaging->setOptionsForService(serviceName, options);
                   ++servicesRegistered;
                }
             }
@@ -106,8 +120,40 @@ bool Messaging::isInitialized()
 
 //******************************************************************************
 
+bool Messaging::isTraceSampled(const std::string& serviceName)
+{
+   std::shared_ptr<Messaging> messaging(getMessaging());
+   // (untraced deployments never take the lock)
+   if ((messaging == nullptr) || !messaging->m_hasTraceSampling.load()) {
+      return false;
+   }
+
+   double sampleRate = 0.0;
+   {
+      MutexLock lock(*messaging->m_mutex);
+      const map<string,ServiceOptions>::const_iterator it =
+         messaging->m_mapServiceOptions.find(serviceName);
+      if (it != messaging->m_mapServiceOptions.end()) {
+         sampleRate = (*it).second.getTraceSampleRate();
+      }
+   }
+
+   if (sampleRate <= 0.0) {
+      return false;
+   } else if (sampleRate >= 1.0) {
+      return true;
+   }
+
+   thread_local std::minstd_rand generator(std::random_device{}());
+   std::uniform_real_distribution<double> distribution(0.0, 1.0);
+   return distribution(generator) < sampleRate;
+}
+
+//******************************************************************************
+
 Messaging::Messaging() :
-   m_mutex(nullptr)
+   m_mutex(nullptr),
+   m_hasTraceSampling(false)
 {
    ThreadingFactory* factory = ThreadingFactory::getThreadingFactory();
    if (factory == nullptr) {
@@ -135,6 +181,32 @@ void Messaging::registerService(const std::string& serviceName,
 
 //******************************************************************************
 
+void Messaging::setOptionsForService(const std::string& serviceName,
+                                     const ServiceOptions& options)
+{
+   MutexLock lock(*m_mutex);
+   m_mapServiceOptions[serviceName] = options;
+   if (options.getTraceSampleRate() > 0.0) {
+      m_hasTraceSampling.store(true);
+   }
+}
+
+//******************************************************************************
+
+ServiceOptions Messaging::getOptionsForService(const std::string& serviceName) const
+{
+   MutexLock lock(*m_mutex);
+   const map<string,ServiceOptions>::const_iterator it =
+      m_mapServiceOptions.find(serviceName);
+   if (it != m_mapServiceOptions.end()) {
+      return (*it).second;
+   } else {
+      return ServiceOptions();
+   }
+}
+
+//******************************************************************************
+
 bool Messaging::isServiceRegistered(const std::string& serviceName) const
 {
    MutexLock lock(*m_mutex);
@@ -168,8 +240,7 @@ Socket* Messaging::socketForService(const ServiceInfo& serviceInfo)
       m_mapSocketConnections.erase(it);
       return socket;
    } else {
-      return new Socket(serviceInfo.host(),
-                        serviceInfo.port());
+      return UnixSocket::connectToService(serviceInfo);
    }
 }
 
@@ -184,3 +255,124 @@ void Messaging::returnSocketForService(const ServiceInfo& serviceInfo,
 }
 
 //******************************************************************************
+
+RequestCoalescer& Messaging::getRequestCoalescer()
+{
+   return m_requestCoalescer;
+}
+
+//******************************************************************************
+
+BatchingSender* Messaging::batchingSenderForService(const std::string& serviceName)
+{
+   MutexLock lock(*m_mutex);
+
+   map<string,std::unique_ptr<BatchingSender>>::iterator itSender =
+      m_mapBatchingSenders.find(serviceName);
+   if (itSender != m_mapBatchingSenders.end()) {
+      return (*itSender).second.get();
+   }
+
+   const map<string,ServiceOptions>::const_iterator itOptions =
+      m_mapServiceOptions.find(serviceName);
+   if ((itOptions == m_mapServiceOptions.end()) ||
+       !(*itOptions).second.isAsyncOneWay()) {
+      return nullptr;
+   }
+
+   const map<string,ServiceInfo>::const_iterator itService =
+      m_mapServices.find(serviceName);
+   if (itService == m_mapServices.end()) {
+      return nullptr;
+   }
+
+   BatchingSender* sender =
+      new BatchingSender((*itService).second, (*itOptions).second);
+   m_mapBatchingSenders[serviceName].reset(sender);
+   return sender;
+}
+
+//******************************************************************************
+
+std::shared_ptr<ShmClient> Messaging::shmClientForService(const std::string& serviceName)
+{
+   MutexLock lock(*m_mutex);
+
+   const map<string,ServiceOptions>::const_iterator itOptions =
+      m_mapServiceOptions.find(serviceName);
+   if ((itOptions == m_mapServiceOptions.end()) ||
+       ((*itOptions).second.getTransport() != TransportShm)) {
+      return nullptr;
+   }
+
+   map<string,std::shared_ptr<ShmClient>>::iterator itClient =
+      m_mapShmClients.find(serviceName);
+   if (itClient != m_mapShmClients.end()) {
+      if ((*itClient).second->isServing()) {
+         return (*itClient).second;
+      }
+      // the server went away (or restarted with a new segment)
+      m_mapShmClients.erase(itClient);
+   }
+
+   const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+   const map<string,std::chrono::steady_clock::time_point>::const_iterator itRetry =
+      m_mapShmRetryTimes.find(serviceName);
+   if ((itRetry != m_mapShmRetryTimes.end()) && (now < (*itRetry).second)) {
+      return nullptr;
+   }
+
+   const map<string,ServiceInfo>::const_iterator itService =
+      m_mapServices.find(serviceName);
+   if (itService == m_mapServices.end()) {
+      return nullptr;
+   }
+
+   std::shared_ptr<ShmClient> client(
+      new ShmClient(ShmSegment::nameForPort((*itService).second.port())));
+   if (!client->isServing()) {
+      m_mapShmRetryTimes[serviceName] =
+         now + std::chrono::milliseconds(SHM_RETRY_MILLIS);
+      return nullptr;
+   }
+
+   m_mapShmClients[serviceName] = client;
+   return client;
+}
+
+//******************************************************************************
+
+UdpSender* Messaging::udpSenderForService(const std::string& serviceName)
+{
+   MutexLock lock(*m_mutex);
+
+   map<string,std::unique_ptr<UdpSender>>::iterator itSender =
+      m_mapUdpSenders.find(serviceName);
+   if (itSender != m_mapUdpSenders.end()) {
+      UdpSender* sender = (*itSender).second.get();
+      return sender->isOpen() ? sender : nullptr;
+   }
+
+   const map<string,ServiceOptions>::const_iterator itOptions =
+      m_mapServiceOptions.find(serviceName);
+   if ((itOptions == m_mapServiceOptions.end()) ||
+       ((*itOptions).second.getTransport() != TransportUdp)) {
+      return nullptr;
+   }
+
+   // (a Unix domain socket service has no port to send datagrams to)
+   const map<string,ServiceInfo>::const_iterator itService =
+      m_mapServices.find(serviceName);
+   if ((itService == m_mapServices.end()) ||
+       UnixSocket::isUnixService((*itService).second)) {
+      return nullptr;
+   }
+
+   // a sender that couldn't open its socket is kept, so that the address
+   // isn't resolved again for every message
+   UdpSender* sender = new UdpSender((*itService).second, (*itOptions).second);
+   m_mapUdpSenders[serviceName].reset(sender);
+   return sender->isOpen() ? sender : nullptr;
+}
+
+//******************************************************************************
@@ -4,11 +4,18 @@
 #ifndef TONNERRE_MESSAGING_H
 #define TONNERRE_MESSAGING_H
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <map>
 
+#include "BatchingSender.h"
+#include "RequestCoalescer.h"
 #include "ServiceInfo.h"
+#include "ServiceOptions.h"
+#include "ShmClient.h"
+#include "UdpSender.h"
 #include "Socket.h"
 #include "Mutex.h"
 
@@ -49,6 +56,15 @@ public:
     */
    static bool isInitialized();
 
+   /**
+    * Decides whether the next request to a service is traced, according to
+    * the service's 'trace_sample_rate' (used internally)
+    * @param serviceName the name of the destination service
+    * @return boolean indicating if the request should be traced
+    * @see RequestTrace()
+    */
+   static bool isTraceSampled(const std::string& serviceName);
+
    /**
     * Default constructor
     */
@@ -68,6 +84,23 @@ public:
    void registerService(const std::string& serviceName,
                         const chaudiere::ServiceInfo& serviceInfo);
 
+   /**
+    * Sets the tonnerre-specific options for a registered service
+    * @param serviceName the name of the service
+    * @param options the options for the service
+    * @see ServiceOptions()
+    */
+   void setOptionsForService(const std::string& serviceName,
+                             const ServiceOptions& options);
+
+   /**
+    * Retrieves the tonnerre-specific options for a service
+    * @param serviceName the name of the service
+    * @return the options for the service (defaults if none were set)
+    * @see ServiceOptions()
+    */
+   ServiceOptions getOptionsForService(const std::string& serviceName) const;
+
    /**
     * Determines if the specified service name has been registered
     * @param serviceName the service name whose existence is being evaluated
@@ -88,9 +121,11 @@ public:
    chaudiere::ServiceInfo getInfoForService(const std::string& serviceName) const;
 
    /**
-    * Retrieve a socket connection for the specified service
+    * Retrieve a socket connection for the specified service (a Unix domain
+    * socket if the service is configured with a 'path')
     * @param serviceInfo the service for which a socket conection is desired
-    * @return socket connection
+    * @return socket connection (nullptr if a Unix domain socket couldn't
+    * be connected)
     * @see ServiceInfo()
     * @see Socket()
     */
@@ -106,13 +141,57 @@ public:
    void returnSocketForService(const chaudiere::ServiceInfo& serviceInfo,
                                chaudiere::Socket* socket);
 
+   /**
+    * Retrieves the coalescer that lets identical in-flight requests share
+    * a round trip (used internally)
+    * @return the request coalescer
+    * @see RequestCoalescer()
+    */
+   RequestCoalescer& getRequestCoalescer();
 
+   /**
+    * Retrieves the background sender for one-way messages to a service,
+    * creating it on first use (used internally)
+    * @param serviceName the name of the destination service
+    * @return the sender, or nullptr if the service isn't configured for
+    * asynchronous one-way messages
+    * @see BatchingSender()
+    */
+   BatchingSender* batchingSenderForService(const std::string& serviceName);
+
+   /**
+    * Retrieves the shared memory client for a service, attaching to the
+    * server's segment on first use (used internally)
+    * @param serviceName the name of the destination service
+    * @return the client, or nullptr if the service isn't configured with
+    * 'transport = shm' or its segment isn't being served (in which case
+    * messages go over TCP)
+    * @see ShmClient()
+    */
+   std::shared_ptr<ShmClient> shmClientForService(const std::string& serviceName);
+
+   /**
+    * Retrieves the datagram sender for one-way messages to a service,
+    * creating it on first use (used internally)
+    * @param serviceName the name of the destination service
+    * @return the sender, or nullptr if the service isn't configured with
+    * 'transport = udp' or its address can't be resolved
+    * @see UdpSender()
+    */
+   UdpSender* udpSenderForService(const std::string& serviceName);
 
 private:
    static std::shared_ptr<Messaging> messagingInstance;
    std::map<std::string, chaudiere::ServiceInfo> m_mapServices;
    std::map<std::string, chaudiere::Socket*> m_mapSocketConnections;
+   std::map<std::string, ServiceOptions> m_mapServiceOptions;
+   std::map<std::string, std::unique_ptr<BatchingSender>> m_mapBatchingSenders;
+   std::map<std::string, std::shared_ptr<ShmClient>> m_mapShmClients;
+   std::map<std::string, std::chrono::steady_clock::time_point> m_mapShmRetryTimes;
+   std::map<std::string, std::unique_ptr<UdpSender>> m_mapUdpSenders;
    std::unique_ptr<chaudiere::Mutex> m_mutex;
+   RequestCoalescer m_requestCoalescer;
+   std::atomic<bool> m_hasTraceSampling;
 
    Messaging(const Messaging&);
    Messaging& operator=(const Messaging&);
@@ -1,12 +1,23 @@
 // Copyright Paul Dardeau, SwampBits LLC 2014
 // BSD License
 
+#include <thread>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
 #include "MessagingServer.h"
 #include "MessageHandler.h"
 #include "ServerSocket.h"
 #include "MessageRequestHandler.h"
 #include "MessageSocketServiceHandler.h"
-#include "Logger.h"
+#include "ThreadPoolExecutor.h"
+#include "WorkStealingExecutor.h"
+#include "IoUring.h"
+#include "InProcessRegistry.h"
+#include "UnixSocket.h"
+#include "AsyncLogSink.h"
+#include "Logging.h"
 
 using namespace std;
 using namespace tonnerre;
@@ -21,39 +32,440 @@ MessagingServer::MessagingServer(const std::string& configFilePath,
                                  const std::string& serverServiceName,
                                  MessageHandler* handler) :
    SocketServer(SERVER_NAME, SERVER_VERSION, configFilePath),
-   m_handler(handler),
    m_serviceName(serverServiceName) {
-   Logger::logInstanceCreate("MessagingServer");
+   TONNERRE_LOG_INSTANCE_CREATE("MessagingServer");
+
+   if (handler != nullptr) {
+      m_serviceDispatcher.registerService(m_serviceName, handler);
+   }
+   m_serverOptions.readConfigFile(configFilePath);
+
+   if (m_serverOptions.isAsyncLogging()) {
+      // (process-wide; left running for whatever else logs through it)
+      AsyncLogSink::start();
+   }
+
+   if (m_serverOptions.hasAdmissionControl()) {
+      m_admissionController.reset(new AdmissionController(
+         m_serverOptions.getMaxInFlight(),
+         m_serverOptions.getMaxQueueDepth(),
+         m_serverOptions.getCodelTargetMillis(),
+         m_serverOptions.getCodelIntervalMillis()));
+   }
+
+   if (m_serverOptions.isMetrics()) {
+      m_metrics.reset(new ServerMetrics);
+      if (m_serverOptions.getMetricsDumpIntervalMillis() > 0) {
+         m_metricsDumper.reset(new MetricsDumper(
+            *m_metrics,
+            m_serverOptions.getMetricsDumpPath(),
+            m_serverOptions.getMetricsDumpIntervalMillis()));
+      }
+   }
+
+   if (m_serverOptions.isPriorityScheduling() && !m_serverOptions.isSharded()) {
+      // connections are still read on the usual threads; each request then
+      // waits in its priority class's queue for one of these workers
+      m_priorityExecutor.reset(new PriorityExecutor(
+         m_serverOptions.getWorkerThreads(),
+         m_serverOptions.isWeightedScheduling(),
+         m_serverOptions.getPriorityWeights()));
+   }
+
+   if (m_serverOptions.isWorkStealing()) {
+      m_executor.reset(
+         new WorkStealingExecutor(m_serverOptions.getWorkerThreads()));
+   }
+
+   if (!m_serverOptions.getSocketPath().empty() && !m_executor) {
+      // (a Unix domain socket is accepted here, not by chaudière)
+      m_executor.reset(
+         new ThreadPoolExecutor(m_serverOptions.getWorkerThreads()));
+   }
+
+   if (m_serverOptions.isKeepAlive() && !m_serverOptions.isSharded()) {
+      // (shards hold idle connections in their own event loops)
+      // idle keep-alive connections wait in the monitor rather than holding
+      // a thread; once readable again they are served from our own pool
+      if (!m_executor) {
+         m_executor.reset(
+            new ThreadPoolExecutor(m_serverOptions.getWorkerThreads()));
+      }
+      m_idleMonitor.reset(new IdleConnectionMonitor(
+         m_serverOptions.getKeepAliveIdleTimeoutMillis(),
+         [this](Socket* socket, int requestsServed) {
+            resumeConnection(socket, requestsServed);
+         }));
+   }
 }
 
 //******************************************************************************
 
 MessagingServer::~MessagingServer() {
-   Logger::logInstanceDestroy("MessagingServer");
+   TONNERRE_LOG_INSTANCE_DESTROY("MessagingServer");
+
+   // (first, so that no new in-process calls reach handlers being stopped)
+   for (const auto& serviceName : m_inProcessServices) {
+      InProcessRegistry::unregisterService(serviceName);
+   }
+
+   for (auto& shard : m_shards) {
+      shard->stop();
+   }
+
+   for (auto& ioUringServer : m_ioUringServers) {
+      ioUringServer->stop();
+   }
+
+   if (m_shmServer) {
+      m_shmServer->stop();
+   }
+
+   if (m_udpServer) {
+      m_udpServer->stop();
+   }
+
+   // drain the workers first -- they may still park connections with the
+   // monitor, which then closes whatever is left
+   if (m_priorityExecutor) {
+      m_priorityExecutor->stop();
+   }
+
+   if (m_executor) {
+      m_executor->stop();
+   }
+
+   if (m_idleMonitor) {
+      m_idleMonitor->stop();
+   }
+
+   // (last, so that its final dump includes the requests just drained)
+   if (m_metricsDumper) {
+      m_metricsDumper->stop();
+   }
 }
 
 //******************************************************************************
 
 void MessagingServer::setMessageHandler(MessageHandler* handler) {
-   m_handler = handler;
+   m_serviceDispatcher.registerService(m_serviceName, handler);
+   m_serviceDispatcher.setDefaultHandler(handler);
+}
+
+//******************************************************************************
+
+void MessagingServer::registerService(const std::string& serviceName,
+                                      MessageHandler* handler) {
+   m_serviceDispatcher.registerService(serviceName, handler);
+}
+
+//******************************************************************************
+
+const ServiceDispatcher& MessagingServer::getServiceDispatcher() const {
+   return m_serviceDispatcher;
+}
+
+//******************************************************************************
+
+const ServerOptions& MessagingServer::getServerOptions() const {
+   return m_serverOptions;
+}
+
+//******************************************************************************
+
+const AdmissionController* MessagingServer::getAdmissionController() const {
+   return m_admissionController.get();
+}
+
+//******************************************************************************
+
+const ServerMetrics* MessagingServer::getServerMetrics() const {
+   return m_metrics.get();
+}
+
+//******************************************************************************
+
+int MessagingServer::run() {
+   if (m_serverOptions.isInProcess()) {
+      registerInProcess();
+   }
+
+   if (m_serverOptions.isShm()) {
+      startShm();
+   }
+
+   if (m_serverOptions.isUdp()) {
+      startUdp();
+   }
+
+   if (!m_serverOptions.getSocketPath().empty()) {
+      if (m_serverOptions.isSharded() || m_serverOptions.isIoUring()) {
+         Logger::warning("sharded and io_uring servers listen on TCP only, "
+                         "serving the unix socket from the worker pool");
+      }
+      return runUnixSocket();
+   }
+
+   if (m_serverOptions.isIoUring()) {
+      if (m_serverOptions.isWorkStealing()) {
+         Logger::warning("io_uring isn't combined with the work-stealing pool, "
+                         "using standard socket I/O");
+      } else if (IoUring::isSupported()) {
+         return runIoUring();
+      } else {
+         Logger::warning("io_uring not supported by this kernel, using standard socket I/O");
+      }
+   }
+
+   if (m_serverOptions.isWorkStealing()) {
+      return runWorkStealing();
+   } else if (m_serverOptions.isSharded()) {
+      return runSharded();
+   }
+
+   return SocketServer::run();
+}
+
+//******************************************************************************
+
+int MessagingServer::runWorkStealing() {
+   ServerSocket serverSocket(m_serverOptions.getPort());
+
+   Logger::info("server listening on port " +
+                std::to_string(m_serverOptions.getPort()) +
+                " (work-stealing, " +
+                std::to_string(m_executor->getNumberWorkers()) + " workers)");
+
+   for (;;) {
+      Socket* socket = serverSocket.accept();
+      if (socket == nullptr) {
+         TONNERRE_LOG_ERROR("unable to accept connection");
+         continue;
+      }
+
+      // the accept thread only hands off; the executor's injection queue
+      // keeps it off the workers' deques and free of locks
+      if (!m_executor->execute(handlerForSocket(socket))) {
+         TONNERRE_LOG_WARNING("server stopping, closing accepted connection");
+         break;
+      }
+   }
+
+   return 0;
+}
+
+//******************************************************************************
+
+int MessagingServer::runUnixSocket() {
+   const std::string& socketPath = m_serverOptions.getSocketPath();
+   const int listenFd = UnixSocket::listen(socketPath);
+   if (listenFd < 0) {
+      Logger::critical("unable to listen on unix socket " + socketPath);
+      return 1;
+   }
+
+   Logger::info("server listening on unix socket " + socketPath +
+                " (" + std::to_string(m_executor->getNumberWorkers()) + " workers)");
+
+   for (;;) {
+      const int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+      if (fd < 0) {
+         if (errno != EINTR) {
+            TONNERRE_LOG_ERROR("unable to accept connection");
+         }
+         continue;
+      }
+
+      if (!m_executor->execute(handlerForSocket(new Socket(fd)))) {
+         TONNERRE_LOG_WARNING("server stopping, closing accepted connection");
+         break;
+      }
+   }
+
+   ::close(listenFd);
+   ::unlink(socketPath.c_str());
+   return 0;
+}
+
+//******************************************************************************
+
+int MessagingServer::runSharded() {
+   const int numberShards = m_serverOptions.getShards();
+   const int numberCores = (int) std::thread::hardware_concurrency();
+
+   for (int i = 0; i < numberShards; ++i) {
+      // more shards than cores share cores rather than going unpinned
+      const int cpu = (numberCores > 0) ? (i % numberCores) : -1;
+      m_shards.emplace_back(
+         new ServerShard(m_serverOptions.getPort(), createSocketServiceHandler(), cpu));
+   }
+
+   for (auto& shard : m_shards) {
+      if (!shard->start()) {
+         Logger::critical("unable to start server shard");
+         for (auto& started : m_shards) {
+            started->stop();
+         }
+         return 1;
+      }
+   }
+
+   Logger::info("server listening on port " +
+                std::to_string(m_serverOptions.getPort()) +
+                " (" + std::to_string(numberShards) + " shards)");
+
+   for (auto& shard : m_shards) {
+      shard->waitUntilStopped();
+   }
+
+   return 0;
+}
+
+//******************************************************************************
+
+int MessagingServer::runIoUring() {
+   // one loop per shard when sharded, otherwise a single unpinned loop
+   const bool isSharded = m_serverOptions.isSharded();
+   const int numberLoops = isSharded ? m_serverOptions.getShards() : 1;
+   const int numberCores = (int) std::thread::hardware_concurrency();
+
+   for (int i = 0; i < numberLoops; ++i) {
+      const int cpu = (isSharded && (numberCores > 0)) ? (i % numberCores) : -1;
+      m_ioUringServers.emplace_back(new IoUringServer(m_serverOptions.getPort(),
+                                                      messageHandler(),
+                                                      &m_serverOptions,
+                                                      cpu));
+      m_ioUringServers.back()->setAdmissionController(m_admissionController.get());
+      m_ioUringServers.back()->setServerMetrics(m_metrics.get());
+   }
+
+   for (auto& ioUringServer : m_ioUringServers) {
+      if (!ioUringServer->start()) {
+         Logger::critical("unable to start io_uring server loop");
+         for (auto& started : m_ioUringServers) {
+            started->stop();
+         }
+         return 1;
+      }
+   }
+
+   Logger::info("server listening on port " +
+                std::to_string(m_serverOptions.getPort()) +
+                " (io_uring, " + std::to_string(numberLoops) + " loops)");
+
+   for (auto& ioUringServer : m_ioUringServers) {
+      ioUringServer->waitUntilStopped();
+   }
+
+   return 0;
+}
+
+//******************************************************************************
+
+void MessagingServer::startShm() {
+   m_shmServer.reset(new ShmServer(m_serverOptions.getPort(),
+                                   messageHandler(),
+                                   &m_serverOptions));
+   m_shmServer->setAdmissionController(m_admissionController.get());
+   m_shmServer->setServerMetrics(m_metrics.get());
+
+   if (m_shmServer->start()) {
+      Logger::info("serving shared memory segment " + m_shmServer->getSegmentName());
+   } else {
+      // same-host clients fall back to TCP
+      Logger::warning("unable to serve shared memory segment " +
+                      m_shmServer->getSegmentName());
+      m_shmServer.reset();
+   }
+}
+
+//******************************************************************************
+
+void MessagingServer::startUdp() {
+   m_udpServer.reset(new UdpServer(m_serverOptions.getPort(), messageHandler()));
+   m_udpServer->setAdmissionController(m_admissionController.get());
+   m_udpServer->setServerMetrics(m_metrics.get());
+
+   if (m_udpServer->start()) {
+      Logger::info("receiving datagrams on port " +
+                   std::to_string(m_serverOptions.getPort()));
+   } else {
+      Logger::warning("unable to receive datagrams on port " +
+                      std::to_string(m_serverOptions.getPort()));
+      m_udpServer.reset();
+   }
+}
+
+//******************************************************************************
+
+void MessagingServer::registerInProcess() {
+   m_serviceDispatcher.getServiceNames(m_inProcessServices);
+   for (const auto& serviceName : m_inProcessServices) {
+      InProcessRegistry::registerService(serviceName,
+                                         m_serviceDispatcher.handlerForService(serviceName),
+                                         m_admissionController.get(),
+                                         m_metrics.get());
+   }
 }
 
 //******************************************************************************
 
 RequestHandler* MessagingServer::handlerForSocket(Socket* socket) {
-   return new MessageRequestHandler(socket, m_handler);
+   MessageRequestHandler* handler = new MessageRequestHandler(socket, messageHandler());
+   configureRequestHandler(handler);
+   return handler;
 }
 
 //******************************************************************************
 
 RequestHandler* MessagingServer::handlerForSocketRequest(SocketRequest* socketRequest) {
-   return new MessageRequestHandler(socketRequest, m_handler);
+   MessageRequestHandler* handler =
+      new MessageRequestHandler(socketRequest, messageHandler());
+   configureRequestHandler(handler);
+   return handler;
 }
 
 //******************************************************************************
 
 SocketServiceHandler* MessagingServer::createSocketServiceHandler() {
-   return new MessageSocketServiceHandler(m_handler);
+   MessageSocketServiceHandler* serviceHandler =
+      new MessageSocketServiceHandler(messageHandler(), &m_serverOptions);
+   serviceHandler->setAdmissionController(m_admissionController.get());
+   serviceHandler->setServerMetrics(m_metrics.get());
+   return serviceHandler;
+}
+
+//******************************************************************************
+
+MessageHandler* MessagingServer::messageHandler() {
+   // a server hosting a single service skips the routing hop entirely
+   if (m_serviceDispatcher.getNumberServices() <= 1) {
+      return m_serviceDispatcher.getDefaultHandler();
+   }
+
+   return &m_serviceDispatcher;
+}
+
+//******************************************************************************
+
+void MessagingServer::configureRequestHandler(MessageRequestHandler* handler) {
+   handler->setServerOptions(&m_serverOptions);
+   handler->setIdleConnectionMonitor(m_idleMonitor.get());
+   handler->setAdmissionController(m_admissionController.get());
+   handler->setPriorityExecutor(m_priorityExecutor.get());
+   handler->setServerMetrics(m_metrics.get());
+}
+
+//******************************************************************************
+
+void MessagingServer::resumeConnection(Socket* socket, int requestsServed) {
+   MessageRequestHandler* handler = new MessageRequestHandler(socket, messageHandler());
+   configureRequestHandler(handler);
+   handler->setRequestsServed(requestsServed);
+
+   if (!m_executor->execute(handler)) {
+      TONNERRE_LOG_WARNING("server stopping, closing resumed connection");
+   }
 }
 
 //******************************************************************************
@@ -4,19 +4,36 @@
 #ifndef TONNERRE_MESSAGINGSERVER_H
 #define TONNERRE_MESSAGINGSERVER_H
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "SocketServer.h"
 #include "RequestHandler.h"
 #include "SocketServiceHandler.h"
+#include "ServerOptions.h"
+#include "Executor.h"
+#include "PriorityExecutor.h"
+#include "AdmissionController.h"
+#include "IdleConnectionMonitor.h"
+#include "MetricsDumper.h"
+#include "ServerMetrics.h"
+#include "ServiceDispatcher.h"
+#include "ServerShard.h"
+#include "IoUringServer.h"
+#include "ShmServer.h"
+#include "UdpServer.h"
 
 
 namespace tonnerre
 {
    class MessageHandler;
+   class MessageRequestHandler;
 
 /**
- *
+ * MessagingServer receives messages for one or more services. The service
+ * named at construction is the default; further services can be hosted on
+ * the same listener, event loop and worker pool with registerService().
  */
 class MessagingServer : public chaudiere::SocketServer
 {
@@ -27,7 +44,7 @@ public:
    /**
     * Constructs a new server to receive messages
     * @param configFilePath the path to the configuration (INI) file
-    * @param serviceName the name of the service this server will provide (as defined in configuration file)
+    * @param serviceName the name of the (default) service this server will provide (as defined in configuration file)
     * @param handler the handler to be called when message requests are received
     */
    MessagingServer(const std::string& configFilePath,
@@ -40,11 +57,77 @@ public:
    ~MessagingServer();
 
    /**
-    * Sets the message handler
+    * Sets the message handler for the default service
     * @param handler the handler to use
     */
    void setMessageHandler(MessageHandler* handler);
 
+   /**
+    * Hosts another service on this server. Requests whose header names the
+    * service are given to its handler. Services must be registered before
+    * the server is run.
+    * @param serviceName the name of the service (as clients send to it)
+    * @param handler the handler for the service's requests
+    * @see ServiceDispatcher()
+    */
+   void registerService(const std::string& serviceName, MessageHandler* handler);
+
+   /**
+    * Retrieves the dispatcher that routes requests to each hosted service
+    * @return the service dispatcher
+    */
+   const ServiceDispatcher& getServiceDispatcher() const;
+
+   /**
+    * Retrieves the tonnerre-specific options read from the [server] section
+    * @return the server options
+    * @see ServerOptions()
+    */
+   const ServerOptions& getServerOptions() const;
+
+   /**
+    * Retrieves the controller that sheds requests under load
+    * @return the admission controller, or nullptr if no admission limits
+    * are configured in the [server] section
+    * @see AdmissionController()
+    */
+   const AdmissionController* getAdmissionController() const;
+
+   /**
+    * Retrieves the server's per-request counters and latency histograms
+    * @return the metrics, or nullptr unless 'metrics = true' is set in the
+    * [server] section
+    * @see ServerMetrics()
+    */
+   const ServerMetrics* getServerMetrics() const;
+
+   /**
+    * Runs the server (does not return under normal operation). With
+    * 'threading = workstealing' in the [server] section, connections are
+    * accepted here and served on tonnerre's work-stealing executor; with
+    * 'threading = sharded' they are accepted and served by independent
+    * shards; otherwise chaudière's SocketServer runs them on its own
+    * thread pool. 'io_backend = io_uring' replaces either of the last two
+    * with io_uring event loops when the kernel supports them. With
+    * 'shm = true', same-host clients are also served through a shared
+    * memory segment, and with 'udp = true' one-way messages are also
+    * received as datagrams on the server's port. With 'path' set, the
+    * server listens on that Unix domain socket instead of its port,
+    * serving connections on a pool of 'worker_threads'. Unless
+    * 'in_process = false' is set, requests sent to the server's services
+    * from this same process bypass all of these and go straight to the
+    * handler.
+    * @return exit code for the server process
+    * @see WorkStealingExecutor()
+    * @see ServerShard()
+    * @see IoUringServer()
+    * @see ShmServer()
+    * @see UdpServer()
+    * @see UnixSocket()
+    * @see InProcessRegistry()
+    */
+   int run();
+
    /**
     * Creates a request handler for the socket (used internally)
     * @param socket the socket that will be used by the new handler
@@ -71,8 +154,31 @@ public:
    virtual chaudiere::SocketServiceHandler* createSocketServiceHandler();
 
 private:
-   MessageHandler* m_handler;
+   MessageHandler* messageHandler();
+   int runWorkStealing();
+   int runUnixSocket();
+   int runSharded();
+   int runIoUring();
+   void startShm();
+   void startUdp();
+   void registerInProcess();
+   void configureRequestHandler(MessageRequestHandler* handler);
+   void resumeConnection(chaudiere::Socket* socket, int requestsServed);
+
    std::string m_serviceName;
+   ServiceDispatcher m_serviceDispatcher;
+   ServerOptions m_serverOptions;
+   std::unique_ptr<AdmissionController> m_admissionController;
+   std::unique_ptr<ServerMetrics> m_metrics;
+   std::unique_ptr<MetricsDumper> m_metricsDumper;
+   std::unique_ptr<Executor> m_executor;
+   std::unique_ptr<PriorityExecutor> m_priorityExecutor;
+   std::unique_ptr<IdleConnectionMonitor> m_idleMonitor;
+   std::vector<std::unique_ptr<ServerShard>> m_shards;
+   std::vector<std::unique_ptr<IoUringServer>> m_ioUringServers;
+   std::unique_ptr<ShmServer> m_shmServer;
+   std::unique_ptr<UdpServer> m_udpServer;
+   std::vector<std::string> m_inProcessServices;
 };
 
 }
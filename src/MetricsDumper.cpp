@@ -0,0 +1,103 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+#include "MetricsDumper.h"
+#include "ServerMetrics.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+//******************************************************************************
+
+MetricsDumper::MetricsDumper(const ServerMetrics& metrics,
+                             const std::string& dumpPath,
+                             int intervalMillis) :
+   m_metrics(metrics),
+   m_dumpPath(dumpPath),
+   m_intervalMillis(intervalMillis),
+   m_isRunning(true) {
+   TONNERRE_LOG_INSTANCE_CREATE("MetricsDumper");
+   m_thread = std::thread(&MetricsDumper::run, this);
+}
+
+//******************************************************************************
+
+MetricsDumper::~MetricsDumper() {
+   TONNERRE_LOG_INSTANCE_DESTROY("MetricsDumper");
+   stop();
+}
+
+//******************************************************************************
+
+void MetricsDumper::stop() {
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (!m_isRunning) {
+         return;
+      }
+      m_isRunning = false;
+   }
+
+   m_cond.notify_all();
+
+   if (m_thread.joinable()) {
+      m_thread.join();
+   }
+
+   dump();
+}
+
+//******************************************************************************
+
+bool MetricsDumper::dump() {
+   const std::string text = m_metrics.toPrometheus();
+
+   if (m_dumpPath.empty()) {
+      Logger::info("server metrics:\n" + text);
+      return true;
+   }
+
+   // a scraper must never see a half-written file, so write a temporary
+   // file alongside and rename it over the old one
+   const std::string tempPath = m_dumpPath + ".tmp";
+   {
+      std::ofstream file(tempPath.c_str(), std::ios::out | std::ios::trunc);
+      file << text;
+      if (!file) {
+         Logger::error("unable to write metrics to " + tempPath);
+         return false;
+      }
+   }
+
+   if (std::rename(tempPath.c_str(), m_dumpPath.c_str()) != 0) {
+      Logger::error("unable to replace metrics file " + m_dumpPath);
+      std::remove(tempPath.c_str());
+      return false;
+   }
+
+   return true;
+}
+
+//******************************************************************************
+
+void MetricsDumper::run() {
+   std::unique_lock<std::mutex> lock(m_mutex);
+   for (;;) {
+      if (m_cond.wait_for(lock, std::chrono::milliseconds(m_intervalMillis),
+                          [this] { return !m_isRunning; })) {
+         // stop() writes the final dump
+         return;
+      }
+
+      lock.unlock();
+      dump();
+      lock.lock();
+   }
+}
+
+//******************************************************************************
@@ -0,0 +1,69 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_METRICSDUMPER_H
+#define TONNERRE_METRICSDUMPER_H
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+namespace tonnerre
+{
+   class ServerMetrics;
+
+/**
+ * MetricsDumper periodically writes a server's metrics in Prometheus text
+ * format, either to a file (replaced atomically, as the node exporter's
+ * textfile collector expects) or to the log.
+ */
+class MetricsDumper
+{
+public:
+   /**
+    * Constructs the dumper and starts its thread
+    * @param metrics the metrics to write (not owned)
+    * @param dumpPath the file to write (empty to write to the log)
+    * @param intervalMillis how often to write the metrics
+    * @see ServerMetrics()
+    */
+   MetricsDumper(const ServerMetrics& metrics,
+                 const std::string& dumpPath,
+                 int intervalMillis);
+
+   /**
+    * Destructor (stops the dumper)
+    */
+   ~MetricsDumper();
+
+   /**
+    * Stops the dumper thread after writing the metrics one last time
+    */
+   void stop();
+
+   /**
+    * Writes the metrics now
+    * @return boolean indicating if the metrics were written
+    */
+   bool dump();
+
+private:
+   void run();
+
+   const ServerMetrics& m_metrics;
+   const std::string m_dumpPath;
+   const int m_intervalMillis;
+   std::thread m_thread;
+   std::mutex m_mutex;
+   std::condition_variable m_cond;
+   bool m_isRunning;
+
+   MetricsDumper(const MetricsDumper&);
+   MetricsDumper& operator=(const MetricsDumper&);
+};
+
+}
+
+#endif
@@ -0,0 +1,162 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "PriorityExecutor.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+//******************************************************************************
+
+PriorityExecutor::PriorityExecutor(int numberWorkers,
+                                   bool isWeighted,
+                                   const std::vector<int>& weights) :
+   m_queuedCount(0),
+   m_isWeighted(isWeighted),
+   m_isRunning(true) {
+   TONNERRE_LOG_INSTANCE_CREATE("PriorityExecutor");
+
+   for (int i = 0; i < NUMBER_MESSAGE_PRIORITIES; ++i) {
+      const int weight = (i < (int) weights.size()) ? weights[i] : 1;
+      m_weights[i] = (weight > 0) ? weight : 1;
+      m_credits[i] = m_weights[i];
+   }
+
+   if (numberWorkers < 1) {
+      numberWorkers = 1;
+   }
+
+   for (int i = 0; i < numberWorkers; ++i) {
+      m_workers.emplace_back(&PriorityExecutor::runWorker, this);
+   }
+}
+
+//******************************************************************************
+
+PriorityExecutor::~PriorityExecutor() {
+   TONNERRE_LOG_INSTANCE_DESTROY("PriorityExecutor");
+   stop();
+}
+
+//******************************************************************************
+
+bool PriorityExecutor::execute(Runnable* task) {
+   return execute(task, MessagePriorityNormal);
+}
+
+//******************************************************************************
+
+bool PriorityExecutor::execute(Runnable* task, MessagePriority priority) {
+   if (task == nullptr) {
+      return false;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_isRunning) {
+         m_tasks[priority].push_back(task);
+         ++m_queuedCount;
+         m_cond.notify_one();
+         return true;
+      }
+   }
+
+   delete task;
+   return false;
+}
+
+//******************************************************************************
+
+void PriorityExecutor::stop() {
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (!m_isRunning) {
+         return;
+      }
+      m_isRunning = false;
+      m_cond.notify_all();
+   }
+
+   for (auto& worker : m_workers) {
+      if (worker.joinable()) {
+         worker.join();
+      }
+   }
+}
+
+//******************************************************************************
+
+int PriorityExecutor::getNumberWorkers() const {
+   return (int) m_workers.size();
+}
+
+//******************************************************************************
+
+std::size_t PriorityExecutor::getQueuedCount(MessagePriority priority) const {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   return m_tasks[priority].size();
+}
+
+//******************************************************************************
+
+Runnable* PriorityExecutor::nextTask() {
+   // (called with the mutex held and at least one task queued)
+   if (m_isWeighted) {
+      for (int round = 0; round < 2; ++round) {
+         for (int i = 0; i < NUMBER_MESSAGE_PRIORITIES; ++i) {
+            if (!m_tasks[i].empty() && (m_credits[i] > 0)) {
+               --m_credits[i];
+               Runnable* task = m_tasks[i].front();
+               m_tasks[i].pop_front();
+               return task;
+            }
+         }
+
+         // every class with work has used its turns; start a new round
+         for (int i = 0; i < NUMBER_MESSAGE_PRIORITIES; ++i) {
+            m_credits[i] = m_weights[i];
+         }
+      }
+   }
+
+   for (int i = 0; i < NUMBER_MESSAGE_PRIORITIES; ++i) {
+      if (!m_tasks[i].empty()) {
+         Runnable* task = m_tasks[i].front();
+         m_tasks[i].pop_front();
+         return task;
+      }
+   }
+
+   return nullptr;
+}
+
+//******************************************************************************
+
+void PriorityExecutor::runWorker() {
+   for (;;) {
+      Runnable* task = nullptr;
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         m_cond.wait(lock, [this] { return !m_isRunning || (m_queuedCount > 0); });
+         if (m_queuedCount == 0) {
+            // stopped and fully drained
+            return;
+         }
+         task = nextTask();
+         --m_queuedCount;
+      }
+
+      try {
+         task->run();
+      } catch (const std::exception& e) {
+         TONNERRE_LOG_ERROR("exception caught in executor task: " + std::string(e.what()));
+      } catch (...) {
+         TONNERRE_LOG_ERROR("exception caught in executor task");
+      }
+
+      delete task;
+   }
+}
+
+//******************************************************************************
@@ -0,0 +1,93 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_PRIORITYEXECUTOR_H
+#define TONNERRE_PRIORITYEXECUTOR_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Executor.h"
+#include "Message.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * PriorityExecutor is a fixed-size pool of worker threads with one FIFO
+ * queue per priority class. With strict scheduling a worker always takes
+ * the oldest task of the highest class that has any; with weighted
+ * scheduling each class gets a number of turns per round in proportion to
+ * its weight, so that lower classes can't be starved outright.
+ */
+class PriorityExecutor : public Executor
+{
+public:
+   /**
+    * Constructs the executor and starts its worker threads
+    * @param numberWorkers the number of worker threads (at least 1)
+    * @param isWeighted whether classes take weighted turns instead of
+    * strict precedence
+    * @param weights the turns per round of each class, highest class first
+    * (used only when weighted; missing or non-positive weights count as 1)
+    */
+   PriorityExecutor(int numberWorkers,
+                    bool isWeighted,
+                    const std::vector<int>& weights);
+
+   /**
+    * Destructor (stops the executor if still running)
+    */
+   ~PriorityExecutor();
+
+   /**
+    * Queues a task with normal priority
+    * @param task the task to run (ownership passes to the executor)
+    * @return boolean indicating whether the task was accepted
+    */
+   bool execute(chaudiere::Runnable* task) override;
+
+   /**
+    * Queues a task in the queue of its priority class
+    * @param task the task to run (ownership passes to the executor)
+    * @param priority the task's priority class
+    * @return boolean indicating whether the task was accepted (false once
+    * the executor has been stopped, in which case the task is deleted)
+    */
+   bool execute(chaudiere::Runnable* task, MessagePriority priority);
+
+   void stop() override;
+   int getNumberWorkers() const override;
+
+   /**
+    * Retrieves the number of tasks waiting in a priority class's queue
+    * @param priority the priority class
+    * @return number of queued tasks
+    */
+   std::size_t getQueuedCount(MessagePriority priority) const;
+
+private:
+   void runWorker();
+   chaudiere::Runnable* nextTask();
+
+   std::vector<std::thread> m_workers;
+   std::deque<chaudiere::Runnable*> m_tasks[NUMBER_MESSAGE_PRIORITIES];
+   int m_weights[NUMBER_MESSAGE_PRIORITIES];
+   int m_credits[NUMBER_MESSAGE_PRIORITIES];
+   mutable std::mutex m_mutex;
+   std::condition_variable m_cond;
+   std::size_t m_queuedCount;
+   const bool m_isWeighted;
+   bool m_isRunning;
+
+   PriorityExecutor(const PriorityExecutor&);
+   PriorityExecutor& operator=(const PriorityExecutor&);
+};
+
+}
+
+#endif
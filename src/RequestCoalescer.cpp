@@ -0,0 +1,135 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <functional>
+
+#include "RequestCoalescer.h"
+#include "StrUtils.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+static const std::string KEY_SEPARATOR = "\n";
+
+//******************************************************************************
+
+RequestCoalescer::Call::Call(const std::string& encodedRequest) :
+   m_encodedRequest(encodedRequest),
+   m_numFollowers(0),
+   m_isComplete(false),
+   m_success(false) {
+}
+
+//******************************************************************************
+
+std::string RequestCoalescer::keyFor(const std::string& serviceName,
+                                     const std::string& requestName,
+                                     const std::string& encodedRequest) {
+   // the hash only narrows the search; join() compares the full encoded
+   // request so a collision can never hand out somebody else's response
+   const std::size_t payloadHash = std::hash<std::string>()(encodedRequest);
+
+   std::string key;
+   key.reserve(serviceName.length() + requestName.length() + 24);
+   key += serviceName;
+   key += KEY_SEPARATOR;
+   key += requestName;
+   key += KEY_SEPARATOR;
+   key += StrUtils::size_tToString(payloadHash);
+   return key;
+}
+
+//******************************************************************************
+
+RequestCoalescer::RequestCoalescer() {
+}
+
+//******************************************************************************
+
+RequestCoalescer::~RequestCoalescer() {
+}
+
+//******************************************************************************
+
+std::shared_ptr<RequestCoalescer::Call>
+RequestCoalescer::join(const std::string& key,
+                       const std::string& encodedRequest,
+                       bool& isLeader) {
+   std::lock_guard<std::mutex> lock(m_mutex);
+
+   auto it = m_mapInFlight.find(key);
+   if (it != m_mapInFlight.end()) {
+      std::shared_ptr<Call> call = (*it).second;
+      if (call->m_encodedRequest != encodedRequest) {
+         // hash collision with a different request
+         isLeader = false;
+         return nullptr;
+      }
+
+      std::lock_guard<std::mutex> callLock(call->m_mutex);
+      ++call->m_numFollowers;
+      isLeader = false;
+      return call;
+   }
+
+   std::shared_ptr<Call> call(new Call(encodedRequest));
+   m_mapInFlight[key] = call;
+   isLeader = true;
+   return call;
+}
+
+//******************************************************************************
+
+void RequestCoalescer::complete(const std::string& key,
+                                const std::shared_ptr<Call>& call,
+                                bool success,
+                                const Message& response) {
+   if (call == nullptr) {
+      return;
+   }
+
+   {
+      // retire the call first so that requests arriving from here on start
+      // a fresh round trip instead of receiving a result they didn't wait for
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto it = m_mapInFlight.find(key);
+      if ((it != m_mapInFlight.end()) && ((*it).second == call)) {
+         m_mapInFlight.erase(it);
+      }
+   }
+
+   std::lock_guard<std::mutex> callLock(call->m_mutex);
+   if (call->m_numFollowers > 0) {
+      call->m_response = response;
+   }
+   call->m_success = success;
+   call->m_isComplete = true;
+   call->m_cond.notify_all();
+}
+
+//******************************************************************************
+
+bool RequestCoalescer::wait(const std::shared_ptr<Call>& call,
+                            Message& response) {
+   if (call == nullptr) {
+      return false;
+   }
+
+   std::unique_lock<std::mutex> callLock(call->m_mutex);
+   call->m_cond.wait(callLock, [&call] { return call->m_isComplete; });
+
+   if (call->m_success) {
+      response = call->m_response;
+   }
+
+   return call->m_success;
+}
+
+//******************************************************************************
+
+std::size_t RequestCoalescer::getInFlightCount() const {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   return m_mapInFlight.size();
+}
+
+//******************************************************************************
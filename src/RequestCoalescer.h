@@ -0,0 +1,115 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_REQUESTCOALESCER_H
+#define TONNERRE_REQUESTCOALESCER_H
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Message.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * RequestCoalescer lets identical in-flight requests share a single network
+ * round trip ("singleflight"). The first sender of a request becomes the
+ * leader and performs the send; any identical requests that arrive while the
+ * leader is waiting become followers and receive a copy of the leader's
+ * response instead of opening their own connection.
+ */
+class RequestCoalescer
+{
+public:
+   /**
+    * State shared by the leader and followers of one in-flight request
+    */
+   class Call
+   {
+   public:
+      explicit Call(const std::string& encodedRequest);
+
+      std::string m_encodedRequest;
+      std::mutex m_mutex;
+      std::condition_variable m_cond;
+      Message m_response;
+      int m_numFollowers;
+      bool m_isComplete;
+      bool m_success;
+   };
+
+   /**
+    * Builds the coalescing key for a request
+    * @param serviceName the name of the destination service
+    * @param requestName the name of the message request
+    * @param encodedRequest the flattened request (see Message::toString)
+    * @return key identifying requests that may share a round trip
+    */
+   static std::string keyFor(const std::string& serviceName,
+                             const std::string& requestName,
+                             const std::string& encodedRequest);
+
+   /**
+    * Default constructor
+    */
+   RequestCoalescer();
+
+   /**
+    * Destructor
+    */
+   ~RequestCoalescer();
+
+   /**
+    * Joins (or starts) the in-flight call for the specified key
+    * @param key the coalescing key (see keyFor)
+    * @param encodedRequest the flattened request
+    * @param isLeader set to true if the caller must perform the round trip
+    * @return the shared call, or nullptr if the key is in use by a different
+    * request (hash collision) and the caller should send on its own
+    */
+   std::shared_ptr<Call> join(const std::string& key,
+                              const std::string& encodedRequest,
+                              bool& isLeader);
+
+   /**
+    * Publishes the leader's result to all followers and retires the call
+    * @param key the coalescing key used with join
+    * @param call the call returned by join
+    * @param success whether the round trip succeeded
+    * @param response the response received by the leader
+    */
+   void complete(const std::string& key,
+                 const std::shared_ptr<Call>& call,
+                 bool success,
+                 const Message& response);
+
+   /**
+    * Waits (as a follower) for the leader to complete the call
+    * @param call the call returned by join
+    * @param response populated with a copy of the leader's response
+    * @return boolean indicating whether the leader's round trip succeeded
+    */
+   bool wait(const std::shared_ptr<Call>& call, Message& response);
+
+   /**
+    * Retrieves the number of calls currently in flight
+    * @return number of in-flight calls
+    */
+   std::size_t getInFlightCount() const;
+
+private:
+   std::map<std::string, std::shared_ptr<Call>> m_mapInFlight;
+   mutable std::mutex m_mutex;
+
+   RequestCoalescer(const RequestCoalescer&);
+   RequestCoalescer& operator=(const RequestCoalescer&);
+};
+
+}
+
+#endif
@@ -0,0 +1,213 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <chrono>
+#include <cstdlib>
+
+#include "RequestTrace.h"
+#include "Message.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+static const std::string STAGE_KEYS[RequestTrace::NUMBER_STAGES] = {
+   "trace.client_encode",
+   "trace.client_write",
+   "trace.server_accept",
+   "trace.server_read",
+   "trace.server_parse",
+   "trace.handler_start",
+   "trace.handler_end",
+   "trace.server_write",
+   "trace.client_receive"
+};
+
+// where a message's receipt is noted, whichever side read it
+static const std::string KEY_TRACE_READ  = "trace.read";
+static const std::string KEY_TRACE_PARSE = "trace.parse";
+
+//******************************************************************************
+
+std::int64_t RequestTrace::now() {
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//******************************************************************************
+
+void RequestTrace::stamp(Message& message, Stage stage, std::int64_t nanos) {
+   message.setHeader(STAGE_KEYS[stage], std::to_string(nanos));
+}
+
+//******************************************************************************
+
+std::int64_t RequestTrace::getStamp(const Message& message, Stage stage) {
+   if (!message.hasHeader(STAGE_KEYS[stage])) {
+      return 0;
+   }
+
+   return std::strtoll(message.getHeader(STAGE_KEYS[stage]).c_str(), nullptr, 10);
+}
+
+//******************************************************************************
+
+void RequestTrace::copyStamps(const Message& source, Message& destination) {
+   for (int i = 0; i < NUMBER_STAGES; ++i) {
+      if (source.hasHeader(STAGE_KEYS[i])) {
+         destination.setHeader(STAGE_KEYS[i], source.getHeader(STAGE_KEYS[i]));
+      }
+   }
+}
+
+//******************************************************************************
+
+void RequestTrace::stampReceipt(Message& message,
+                                std::int64_t readNanos,
+                                std::int64_t parseNanos) {
+   message.setHeader(KEY_TRACE_READ, std::to_string(readNanos));
+   message.setHeader(KEY_TRACE_PARSE, std::to_string(parseNanos));
+}
+
+//******************************************************************************
+
+void RequestTrace::stampServerStages(const Message& requestMessage,
+                                     Message& responseMessage,
+                                     std::int64_t acceptNanos,
+                                     std::int64_t handlerStartNanos,
+                                     std::int64_t handlerEndNanos) {
+   responseMessage.setTraced(true);
+   if (acceptNanos != 0) {
+      stamp(responseMessage, StageServerAccept, acceptNanos);
+   }
+
+   if (requestMessage.hasHeader(KEY_TRACE_READ)) {
+      const std::string& readNanos = requestMessage.getHeader(KEY_TRACE_READ);
+      if (acceptNanos == 0) {
+         responseMessage.setHeader(STAGE_KEYS[StageServerAccept], readNanos);
+      }
+      responseMessage.setHeader(STAGE_KEYS[StageServerRead], readNanos);
+      responseMessage.setHeader(STAGE_KEYS[StageServerParse],
+                                requestMessage.getHeader(KEY_TRACE_PARSE));
+   }
+
+   stamp(responseMessage, StageHandlerStart, handlerStartNanos);
+   if (handlerEndNanos != 0) {
+      stamp(responseMessage, StageHandlerEnd, handlerEndNanos);
+   }
+}
+
+//******************************************************************************
+
+void RequestTrace::stampClientStages(Message& responseMessage,
+                                     std::int64_t encodeNanos,
+                                     std::int64_t writeNanos) {
+   stamp(responseMessage, StageClientEncode, encodeNanos);
+   stamp(responseMessage, StageClientWrite, writeNanos);
+
+   if (responseMessage.hasHeader(KEY_TRACE_READ)) {
+      responseMessage.setHeader(STAGE_KEYS[StageClientReceive],
+                                responseMessage.getHeader(KEY_TRACE_READ));
+   }
+}
+
+//******************************************************************************
+
+const std::string& RequestTrace::stageKey(Stage stage) {
+   return STAGE_KEYS[stage];
+}
+
+//******************************************************************************
+
+RequestTrace::RequestTrace(const Message& responseMessage) {
+   TONNERRE_LOG_INSTANCE_CREATE("RequestTrace");
+
+   for (int i = 0; i < NUMBER_STAGES; ++i) {
+      m_stamps[i] = getStamp(responseMessage, (Stage) i);
+   }
+}
+
+//******************************************************************************
+
+RequestTrace::RequestTrace(const RequestTrace& copy) {
+   TONNERRE_LOG_INSTANCE_CREATE("RequestTrace");
+
+   for (int i = 0; i < NUMBER_STAGES; ++i) {
+      m_stamps[i] = copy.m_stamps[i];
+   }
+}
+
+//******************************************************************************
+
+RequestTrace::~RequestTrace() {
+   TONNERRE_LOG_INSTANCE_DESTROY("RequestTrace");
+}
+
+//******************************************************************************
+
+RequestTrace& RequestTrace::operator=(const RequestTrace& copy) {
+   if (this == &copy) {
+      return *this;
+   }
+
+   for (int i = 0; i < NUMBER_STAGES; ++i) {
+      m_stamps[i] = copy.m_stamps[i];
+   }
+
+   return *this;
+}
+
+//******************************************************************************
+
+bool RequestTrace::isComplete() const {
+   for (int i = 0; i < NUMBER_STAGES; ++i) {
+      if (m_stamps[i] == 0) {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+//******************************************************************************
+
+std::int64_t RequestTrace::getMicros(Stage from, Stage to) const {
+   if ((m_stamps[from] == 0) || (m_stamps[to] == 0)) {
+      return 0;
+   }
+
+   return (m_stamps[to] - m_stamps[from]) / 1000;
+}
+
+//******************************************************************************
+
+std::int64_t RequestTrace::getNetworkMicros() const {
+   const std::int64_t clientWait = getMicros(StageClientWrite, StageClientReceive);
+   const std::int64_t serverTime = getMicros(StageServerAccept, StageServerWrite);
+   if ((clientWait == 0) || (serverTime > clientWait)) {
+      return 0;
+   }
+
+   return clientWait - serverTime;
+}
+
+//******************************************************************************
+
+std::int64_t RequestTrace::getTotalMicros() const {
+   return getMicros(StageClientEncode, StageClientReceive);
+}
+
+//******************************************************************************
+
+std::string RequestTrace::toString() const {
+   return "encode=" + std::to_string(getMicros(StageClientEncode, StageClientWrite)) + "us" +
+          " network=" + std::to_string(getNetworkMicros()) + "us" +
+          " read=" + std::to_string(getMicros(StageServerAccept, StageServerRead)) + "us" +
+          " parse=" + std::to_string(getMicros(StageServerRead, StageServerParse)) + "us" +
+          " queue=" + std::to_string(getMicros(StageServerParse, StageHandlerStart)) + "us" +
+          " handler=" + std::to_string(getMicros(StageHandlerStart, StageHandlerEnd)) + "us" +
+          " respond=" + std::to_string(getMicros(StageHandlerEnd, StageServerWrite)) + "us" +
+          " total=" + std::to_string(getTotalMicros()) + "us";
+}
+
+//******************************************************************************
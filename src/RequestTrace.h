@@ -0,0 +1,181 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_REQUESTTRACE_H
+#define TONNERRE_REQUESTTRACE_H
+
+#include <cstdint>
+#include <string>
+
+
+namespace tonnerre
+{
+   class Message;
+
+/**
+ * RequestTrace records monotonic timestamps for the stages a traced request
+ * goes through and reports the latency breakdown. Timestamps travel as
+ * 'trace.<stage>' headers: the server stamps its stages on the response,
+ * and the client adds its own once the response arrives. Client and server
+ * stamps come from different clocks (unless both run on one host), so the
+ * breakdown only ever subtracts stamps taken on the same side.
+ */
+class RequestTrace
+{
+public:
+   enum Stage {
+      StageClientEncode,
+      StageClientWrite,
+      StageServerAccept,
+      StageServerRead,
+      StageServerParse,
+      StageHandlerStart,
+      StageHandlerEnd,
+      StageServerWrite,
+      StageClientReceive
+   };
+
+   static const int NUMBER_STAGES = 9;
+
+   /**
+    * Retrieves the current time of the monotonic clock
+    * @return nanoseconds since an arbitrary (per-host) epoch
+    */
+   static std::int64_t now();
+
+   /**
+    * Records when a stage happened
+    * @param message the message to stamp
+    * @param stage the stage
+    * @param nanos the monotonic time of the stage
+    */
+   static void stamp(Message& message, Stage stage, std::int64_t nanos);
+
+   /**
+    * Retrieves when a stage happened
+    * @param message the stamped message
+    * @param stage the stage
+    * @return the monotonic time of the stage (0 if not stamped)
+    */
+   static std::int64_t getStamp(const Message& message, Stage stage);
+
+   /**
+    * Copies every stage stamp from one message to another
+    * @param source the stamped message
+    * @param destination the message to copy the stamps to
+    */
+   static void copyStamps(const Message& source, Message& destination);
+
+   /**
+    * Records when a traced message was read off the socket and decoded
+    * (used internally)
+    * @param message the message just read
+    * @param readNanos when its last byte was read
+    * @param parseNanos when it was decoded
+    */
+   static void stampReceipt(Message& message,
+                            std::int64_t readNanos,
+                            std::int64_t parseNanos);
+
+   /**
+    * Stamps the server's stages so far on the response to a traced request
+    * and marks the response traced (used internally; the server write stage
+    * is stamped separately, just before the response is encoded)
+    * @param requestMessage the traced request (stamped on receipt)
+    * @param responseMessage the response
+    * @param acceptNanos when the server picked the request's connection up
+    * (0 if the request was read as soon as it arrived, in which case it is
+    * taken to be the read stage)
+    * @param handlerStartNanos when the handler was called
+    * @param handlerEndNanos when the handler returned (0 if not yet known)
+    */
+   static void stampServerStages(const Message& requestMessage,
+                                 Message& responseMessage,
+                                 std::int64_t acceptNanos,
+                                 std::int64_t handlerStartNanos,
+                                 std::int64_t handlerEndNanos);
+
+   /**
+    * Stamps the client's stages on a traced request's response once it has
+    * been read (used internally)
+    * @param responseMessage the response (stamped on receipt)
+    * @param encodeNanos when the request started being encoded
+    * @param writeNanos when the request was written
+    */
+   static void stampClientStages(Message& responseMessage,
+                                 std::int64_t encodeNanos,
+                                 std::int64_t writeNanos);
+
+   /**
+    * Retrieves the header key for a stage
+    * @param stage the stage
+    * @return the key (e.g., 'trace.handler_start')
+    */
+   static const std::string& stageKey(Stage stage);
+
+   /**
+    * Constructs the breakdown of a traced response
+    * @param responseMessage the response received for a traced request
+    */
+   explicit RequestTrace(const Message& responseMessage);
+
+   /**
+    * Copy constructor
+    * @param copy the source of the copy
+    */
+   RequestTrace(const RequestTrace& copy);
+
+   /**
+    * Destructor
+    */
+   ~RequestTrace();
+
+   /**
+    * Copy operator
+    * @param copy the source of the copy
+    * @return reference to the updated instance
+    */
+   RequestTrace& operator=(const RequestTrace& copy);
+
+   /**
+    * Determines if every stage was stamped
+    * @return boolean indicating if the breakdown is complete
+    */
+   bool isComplete() const;
+
+   /**
+    * Retrieves the time between two stages stamped on the same side
+    * @param from the earlier stage
+    * @param to the later stage
+    * @return elapsed microseconds (0 if either stage is missing)
+    */
+   std::int64_t getMicros(Stage from, Stage to) const;
+
+   /**
+    * Retrieves the time spent on the network (and in the kernel) both ways:
+    * the client's wait for the response less the server's time with it
+    * @return network microseconds (0 if stages are missing)
+    */
+   std::int64_t getNetworkMicros() const;
+
+   /**
+    * Retrieves the client-observed latency, from encoding the request to
+    * receiving the response
+    * @return total microseconds (0 if stages are missing)
+    */
+   std::int64_t getTotalMicros() const;
+
+   /**
+    * Formats the breakdown for logging, e.g.
+    * 'encode=4us network=61us read=3us ... total=212us'
+    * @return the breakdown
+    */
+   std::string toString() const;
+
+private:
+   std::int64_t m_stamps[NUMBER_STAGES];
+};
+
+}
+
+#endif
@@ -0,0 +1,213 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <chrono>
+
+#include "Responder.h"
+#include "RequestTrace.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+//******************************************************************************
+
+Responder::Connection::Connection(Socket* socket) :
+   m_socket(socket),
+   m_numExpected(0) {
+}
+
+//******************************************************************************
+
+Responder::Connection::Connection(std::function<bool(const std::string&)> writer) :
+   m_writer(writer),
+   m_numExpected(0) {
+}
+
+//******************************************************************************
+
+Responder::Connection::~Connection() {
+}
+
+//******************************************************************************
+
+bool Responder::Connection::write(const std::string& encodedResponse) {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   if (m_writer) {
+      return m_writer(encodedResponse);
+   }
+   return (m_socket != nullptr) && m_socket->write(encodedResponse);
+}
+
+//******************************************************************************
+
+void Responder::Connection::expectResponse() {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   ++m_numExpected;
+}
+
+//******************************************************************************
+
+bool Responder::Connection::writeExpected(const std::string& encodedResponse) {
+   const bool isWritten = write(encodedResponse);
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+   if (--m_numExpected == 0) {
+      m_writtenCond.notify_all();
+   }
+
+   return isWritten;
+}
+
+//******************************************************************************
+
+bool Responder::Connection::awaitResponses(int timeoutMillis) {
+   std::unique_lock<std::mutex> lock(m_mutex);
+   return m_writtenCond.wait_for(lock, std::chrono::milliseconds(timeoutMillis),
+                                 [this] { return m_numExpected == 0; });
+}
+
+//******************************************************************************
+
+Responder::Completion::Completion() :
+   m_isDone(false) {
+}
+
+//******************************************************************************
+
+const Message& Responder::Completion::wait() {
+   std::unique_lock<std::mutex> lock(m_mutex);
+   m_cond.wait(lock, [this] { return m_isDone; });
+   return m_responseMessage;
+}
+
+//******************************************************************************
+
+void Responder::Completion::signal(const Message& responseMessage) {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   m_responseMessage = responseMessage;
+   m_isDone = true;
+   m_cond.notify_all();
+}
+
+//******************************************************************************
+
+Responder::Responder(std::shared_ptr<Connection> connection,
+                     const Message& requestMessage) :
+   m_connection(connection),
+   m_responseMessage(requestMessage.getRequestName(), requestMessage.getType()),
+   m_isComplete(false),
+   m_isOneWay(requestMessage.isOneWay()) {
+   TONNERRE_LOG_INSTANCE_CREATE("Responder");
+
+   if (!m_isOneWay && (m_connection != nullptr)) {
+      m_connection->expectResponse();
+   }
+}
+
+//******************************************************************************
+
+Responder::Responder(std::shared_ptr<Completion> completion,
+                     const Message& requestMessage) :
+   m_completion(completion),
+   m_responseMessage(requestMessage.getRequestName(), requestMessage.getType()),
+   m_isComplete(false),
+   m_isOneWay(requestMessage.isOneWay()) {
+   TONNERRE_LOG_INSTANCE_CREATE("Responder");
+}
+
+//******************************************************************************
+
+Responder::~Responder() {
+   TONNERRE_LOG_INSTANCE_DESTROY("Responder");
+
+   if (claim()) {
+      if (!m_isOneWay) {
+         TONNERRE_LOG_WARNING("responder for '" + m_responseMessage.getRequestName() +
+                         "' dropped without completing, sending empty response");
+      }
+      deliver();
+   }
+}
+
+//******************************************************************************
+
+Message& Responder::getResponseMessage() {
+   return m_responseMessage;
+}
+
+//******************************************************************************
+
+bool Responder::complete(const std::string& textPayload) {
+   if (!claim()) {
+      return false;
+   }
+
+   m_responseMessage.setTextPayload(textPayload);
+   return deliver();
+}
+
+//******************************************************************************
+
+bool Responder::complete(const KeyValuePairs& kvpPayload) {
+   if (!claim()) {
+      return false;
+   }
+
+   m_responseMessage.setKeyValuesPayload(kvpPayload);
+   return deliver();
+}
+
+//******************************************************************************
+
+bool Responder::complete() {
+   if (!claim()) {
+      return false;
+   }
+
+   return deliver();
+}
+
+//******************************************************************************
+
+bool Responder::isComplete() const {
+   return m_isComplete.load(std::memory_order_acquire);
+}
+
+//******************************************************************************
+
+bool Responder::claim() {
+   // only the first completion (from whichever thread) gets to respond
+   bool expected = false;
+   return m_isComplete.compare_exchange_strong(expected, true,
+                                               std::memory_order_acq_rel);
+}
+
+//******************************************************************************
+
+bool Responder::deliver() {
+   if (m_responseMessage.isTraced()) {
+      const std::int64_t completedNanos = RequestTrace::now();
+      RequestTrace::stamp(m_responseMessage, RequestTrace::StageHandlerEnd, completedNanos);
+      RequestTrace::stamp(m_responseMessage, RequestTrace::StageServerWrite, completedNanos);
+   }
+
+   if (m_completion != nullptr) {
+      m_completion->signal(m_responseMessage);
+      return true;
+   }
+
+   if (m_isOneWay || (m_connection == nullptr)) {
+      // nobody is reading a response
+      return true;
+   }
+
+   if (!m_connection->writeExpected(m_responseMessage.toString())) {
+      TONNERRE_LOG_ERROR("writing async response message to socket failed");
+      return false;
+   }
+
+   return true;
+}
+
+//******************************************************************************
@@ -0,0 +1,187 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_RESPONDER_H
+#define TONNERRE_RESPONDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Message.h"
+#include "KeyValuePairs.h"
+#include "Socket.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * Responder sends the response to one request handled by an
+ * AsyncMessageHandler. It may be completed from any thread, at any time
+ * after the handler has returned; the response is written to the client
+ * when complete() is called. A responder that is destroyed without being
+ * completed sends an empty response so that the client isn't left waiting.
+ */
+class Responder
+{
+public:
+   /**
+    * Connection is the write side of a client connection, shared by the
+    * responders for its requests and by whatever writes its synchronous
+    * responses (used internally). Responses are written whole. The
+    * protocol has no request ids, so the server also waits (see
+    * awaitResponses) for the responses it expects before reading another
+    * request, which keeps them in request order.
+    */
+   class Connection
+   {
+   public:
+      /**
+       * Constructs a connection around a socket
+       * @param socket the socket to write responses to (ownership passes to the connection)
+       */
+      explicit Connection(chaudiere::Socket* socket);
+
+      /**
+       * Constructs a connection that hands responses to a function instead,
+       * e.g. to pass them to the thread that owns the client connection
+       * @param writer called with each encoded response; returns whether it was taken
+       */
+      explicit Connection(std::function<bool(const std::string&)> writer);
+      ~Connection();
+
+      bool write(const std::string& encodedResponse);
+
+      /**
+       * Notes that a responder will write a response later
+       */
+      void expectResponse();
+
+      /**
+       * Writes a response noted with expectResponse (it counts as written
+       * even if the write fails)
+       * @param encodedResponse the encoded response
+       * @return boolean indicating whether the write succeeded
+       */
+      bool writeExpected(const std::string& encodedResponse);
+
+      /**
+       * Waits until every expected response has been written
+       * @param timeoutMillis longest time to wait
+       * @return boolean indicating whether none are still outstanding
+       */
+      bool awaitResponses(int timeoutMillis);
+
+   private:
+      std::unique_ptr<chaudiere::Socket> m_socket;
+      std::function<bool(const std::string&)> m_writer;
+      std::mutex m_mutex;
+      std::condition_variable m_writtenCond;
+      int m_numExpected;
+
+      // disallow copies
+      Connection(const Connection&);
+      Connection& operator=(const Connection&);
+   };
+
+   /**
+    * Completion lets an in-process caller block until a responder is
+    * completed (used internally for synchronous calls to an async handler)
+    */
+   class Completion
+   {
+   public:
+      Completion();
+
+      /**
+       * Waits until the responder completes (or is destroyed)
+       * @return the response message
+       */
+      const Message& wait();
+
+   private:
+      friend class Responder;
+      void signal(const Message& responseMessage);
+
+      std::mutex m_mutex;
+      std::condition_variable m_cond;
+      Message m_responseMessage;
+      bool m_isDone;
+   };
+
+   /**
+    * Constructs a responder that writes its response to a connection (used internally)
+    * @param connection the client connection (null for a one-way message)
+    * @param requestMessage the request being responded to
+    */
+   Responder(std::shared_ptr<Connection> connection,
+             const Message& requestMessage);
+
+   /**
+    * Constructs a responder that hands its response to a local waiter (used internally)
+    * @param completion the completion to signal
+    * @param requestMessage the request being responded to
+    */
+   Responder(std::shared_ptr<Completion> completion,
+             const Message& requestMessage);
+
+   /**
+    * Destructor (sends an empty response if never completed)
+    */
+   ~Responder();
+
+   /**
+    * Retrieves the response message, e.g. to set its payload before calling complete()
+    * @return the response message
+    */
+   Message& getResponseMessage();
+
+   /**
+    * Completes the request with a text payload
+    * @param textPayload the response payload
+    * @return boolean indicating whether the response was sent (false if already completed or the write failed)
+    */
+   bool complete(const std::string& textPayload);
+
+   /**
+    * Completes the request with a key-values payload
+    * @param kvpPayload the response payload
+    * @return boolean indicating whether the response was sent (false if already completed or the write failed)
+    */
+   bool complete(const chaudiere::KeyValuePairs& kvpPayload);
+
+   /**
+    * Completes the request with the response message as it stands
+    * @return boolean indicating whether the response was sent (false if already completed or the write failed)
+    */
+   bool complete();
+
+   /**
+    * Determines if the responder has been completed
+    * @return boolean indicating whether complete() has been called
+    */
+   bool isComplete() const;
+
+private:
+   bool claim();
+   bool deliver();
+
+   std::shared_ptr<Connection> m_connection;
+   std::shared_ptr<Completion> m_completion;
+   Message m_responseMessage;
+   std::atomic<bool> m_isComplete;
+   bool m_isOneWay;
+
+   // disallow copies
+   Responder(const Responder&);
+   Responder& operator=(const Responder&);
+};
+
+}
+
+#endif
+
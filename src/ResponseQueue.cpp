@@ -0,0 +1,69 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "ResponseQueue.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+
+//******************************************************************************
+
+ResponseQueue::ResponseQueue(std::function<void()> wake) :
+   m_wake(wake),
+   m_isClosed(false) {
+   TONNERRE_LOG_INSTANCE_CREATE("ResponseQueue");
+}
+
+//******************************************************************************
+
+ResponseQueue::~ResponseQueue() {
+   TONNERRE_LOG_INSTANCE_DESTROY("ResponseQueue");
+}
+
+//******************************************************************************
+
+std::shared_ptr<Responder::Connection> ResponseQueue::connectionFor(std::uint64_t key) {
+   std::shared_ptr<ResponseQueue> queue(shared_from_this());
+   return std::make_shared<Responder::Connection>(
+      [queue, key](const std::string& encodedResponse) {
+         return queue->post(key, encodedResponse);
+      });
+}
+
+//******************************************************************************
+
+bool ResponseQueue::post(std::uint64_t key, const std::string& encodedResponse) {
+   // the wake is made under the lock so that close() can't return while
+   // one is still in progress
+   std::lock_guard<std::mutex> lock(m_mutex);
+   if (m_isClosed) {
+      return false;
+   }
+
+   // one wake per batch is enough -- the server takes them all at once
+   const bool isWakeNeeded = m_responses.empty();
+   m_responses.push_back(Response(key, encodedResponse));
+   if (isWakeNeeded) {
+      m_wake();
+   }
+
+   return true;
+}
+
+//******************************************************************************
+
+void ResponseQueue::take(std::vector<Response>& responses) {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   responses.swap(m_responses);
+   m_responses.clear();
+}
+
+//******************************************************************************
+
+void ResponseQueue::close() {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   m_isClosed = true;
+   m_responses.clear();
+}
+
+//******************************************************************************
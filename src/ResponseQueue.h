@@ -0,0 +1,85 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_RESPONSEQUEUE_H
+#define TONNERRE_RESPONSEQUEUE_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Responder.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * ResponseQueue carries the responses of async handlers back to a server
+ * that writes responses only from its own thread (the io_uring and shared
+ * memory servers). A responder may complete on any thread; its response is
+ * queued under the key the server gave its connection (see connectionFor),
+ * and the server is woken to collect it. Create instances with std::make_shared, since the
+ * connections handed out keep the queue alive.
+ */
+class ResponseQueue : public std::enable_shared_from_this<ResponseQueue>
+{
+public:
+   typedef std::pair<std::uint64_t, std::string> Response;
+
+   /**
+    * Constructs a queue
+    * @param wake called (from the completing thread) when the queue goes
+    * from empty to holding a response
+    */
+   explicit ResponseQueue(std::function<void()> wake);
+
+   /**
+    * Destructor
+    */
+   ~ResponseQueue();
+
+   /**
+    * Creates the connection that responders for a server connection write to
+    * @param key identifies the server connection when its responses are taken
+    * @return the connection
+    */
+   std::shared_ptr<Responder::Connection> connectionFor(std::uint64_t key);
+
+   /**
+    * Queues an encoded response
+    * @param key the server connection the response belongs to
+    * @param encodedResponse the flattened response
+    * @return boolean indicating whether the response was queued (false once closed)
+    */
+   bool post(std::uint64_t key, const std::string& encodedResponse);
+
+   /**
+    * Takes every queued response (called on the server's thread)
+    * @param responses receives the responses, in the order they were queued
+    */
+   void take(std::vector<Response>& responses);
+
+   /**
+    * Stops taking responses; once this returns the wake function isn't
+    * called again
+    */
+   void close();
+
+private:
+   std::function<void()> m_wake;
+   std::vector<Response> m_responses;
+   std::mutex m_mutex;
+   bool m_isClosed;
+
+   ResponseQueue(const ResponseQueue&);
+   ResponseQueue& operator=(const ResponseQueue&);
+};
+
+}
+
+#endif
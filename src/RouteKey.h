@@ -0,0 +1,72 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_ROUTEKEY_H
+#define TONNERRE_ROUTEKEY_H
+
+#include <cstdint>
+#include <string_view>
+
+
+namespace tonnerre
+{
+
+/**
+ * RouteKey pairs a request name with its hash. Declared constexpr for a
+ * literal name, the hash is computed at compile time:
+ *
+ *    static constexpr RouteKey ROUTE_ECHO("echo");
+ *
+ * The name must outlive the key (a string literal always does).
+ */
+class RouteKey
+{
+public:
+   /**
+    * Hashes a request name (64-bit FNV-1a)
+    * @param name the request name
+    * @return the hash of the name
+    */
+   static constexpr std::uint64_t hashName(std::string_view name) {
+      std::uint64_t hash = 14695981039346656037ULL;
+      for (char c : name) {
+         hash ^= static_cast<unsigned char>(c);
+         hash *= 1099511628211ULL;
+      }
+      return hash;
+   }
+
+   /**
+    * Constructs a key for the request name
+    * @param name the request name
+    */
+   constexpr RouteKey(std::string_view name) :
+      m_name(name),
+      m_hash(hashName(name)) {
+   }
+
+   /**
+    * Retrieves the request name
+    * @return the request name
+    */
+   constexpr std::string_view name() const {
+      return m_name;
+   }
+
+   /**
+    * Retrieves the hash of the request name
+    * @return the hash
+    */
+   constexpr std::uint64_t hash() const {
+      return m_hash;
+   }
+
+private:
+   std::string_view m_name;
+   std::uint64_t m_hash;
+};
+
+}
+
+#endif
+
@@ -0,0 +1,373 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <unordered_map>
+
+#include "ServerMetrics.h"
+#include "AsyncLogSink.h"
+#include "Message.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+const std::string ServerMetrics::STATS_REQUEST_NAME = "__stats";
+const std::string ServerMetrics::OTHER_REQUEST_NAME = "__other";
+const std::size_t ServerMetrics::MAX_REQUEST_NAMES = 128;
+
+// (the thread-local cache in threadMetrics() is keyed by instance id rather
+// than address, since a new instance may reuse a destroyed one's address)
+static std::atomic<std::uint64_t> nextMetricsId(1);
+
+static const double PERCENTILES[] = { 50.0, 90.0, 99.0, 99.9 };
+static const char* PERCENTILE_NAMES[] = { "p50", "p90", "p99", "p999" };
+static const char* QUANTILE_NAMES[] = { "0.5", "0.9", "0.99", "0.999" };
+static const int NUMBER_PERCENTILES = 4;
+
+namespace {
+
+// Each counter has a single writer (its thread), so an increment is a
+// plain load and store rather than a locked read-modify-write; readers on
+// other threads see a recent value.
+void bump(std::atomic<std::uint64_t>& counter, std::uint64_t amount) {
+   counter.store(counter.load(std::memory_order_relaxed) + amount,
+                 std::memory_order_relaxed);
+}
+
+std::uint64_t toMicros(ServerMetrics::Duration duration) {
+   const long long micros =
+      std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+   return (micros > 0) ? (std::uint64_t) micros : 0;
+}
+
+// LatencyHistogram's buckets, kept as single-writer atomics.
+class AtomicHistogram {
+public:
+   AtomicHistogram() :
+      m_buckets(new std::atomic<std::uint64_t>[LatencyHistogram::NUMBER_BUCKETS]()),
+      m_sum(0) {
+   }
+
+   void record(std::uint64_t micros) {
+      bump(m_buckets[LatencyHistogram::bucketIndex(micros)], 1);
+      bump(m_sum, micros);
+   }
+
+   void mergeInto(LatencyHistogram& histogram) const {
+      for (int i = 0; i < LatencyHistogram::NUMBER_BUCKETS; ++i) {
+         const std::uint64_t count = m_buckets[i].load(std::memory_order_relaxed);
+         if (count > 0) {
+            histogram.addToBucket(i, count);
+         }
+      }
+      histogram.addToSum(m_sum.load(std::memory_order_relaxed));
+   }
+
+private:
+   std::unique_ptr<std::atomic<std::uint64_t>[]> m_buckets;
+   std::atomic<std::uint64_t> m_sum;
+};
+
+// Escapes a request name for use as a Prometheus label value.
+std::string labelValue(const std::string& value) {
+   std::string escaped;
+   escaped.reserve(value.length());
+   for (char c : value) {
+      if ((c == '\\') || (c == '"')) {
+         escaped += '\\';
+         escaped += c;
+      } else if (c == '\n') {
+         escaped += "\\n";
+      } else {
+         escaped += c;
+      }
+   }
+   return escaped;
+}
+
+std::string seconds(std::uint64_t micros) {
+   char buffer[32];
+   ::snprintf(buffer, sizeof(buffer), "%.6f", micros / 1000000.0);
+   return buffer;
+}
+
+void appendCounter(std::string& text,
+                   const std::string& name,
+                   const std::string& help,
+                   const std::vector<ServerMetrics::RequestStats>& stats,
+                   std::uint64_t ServerMetrics::RequestStats::*counter) {
+   text += "# HELP " + name + " " + help + "\n";
+   text += "# TYPE " + name + " counter\n";
+   for (const ServerMetrics::RequestStats& requestStats : stats) {
+      text += name + "{request=\"" + labelValue(requestStats.requestName) + "\"} " +
+              std::to_string(requestStats.*counter) + "\n";
+   }
+}
+
+void appendSummary(std::string& text,
+                   const std::string& name,
+                   const std::string& help,
+                   const std::vector<ServerMetrics::RequestStats>& stats,
+                   LatencyHistogram ServerMetrics::RequestStats::*latency) {
+   text += "# HELP " + name + " " + help + "\n";
+   text += "# TYPE " + name + " summary\n";
+   for (const ServerMetrics::RequestStats& requestStats : stats) {
+      const LatencyHistogram& histogram = requestStats.*latency;
+      const std::string label = "request=\"" + labelValue(requestStats.requestName) + "\"";
+      for (int i = 0; i < NUMBER_PERCENTILES; ++i) {
+         text += name + "{" + label + ",quantile=\"" + QUANTILE_NAMES[i] + "\"} " +
+                 seconds(histogram.getValueAtPercentile(PERCENTILES[i])) + "\n";
+      }
+      text += name + "_sum{" + label + "} " + seconds(histogram.getSum()) + "\n";
+      text += name + "_count{" + label + "} " + std::to_string(histogram.getCount()) + "\n";
+   }
+}
+
+void addLatencyPairs(KeyValuePairs& kvp,
+                     const std::string& prefix,
+                     const LatencyHistogram& histogram) {
+   for (int i = 0; i < NUMBER_PERCENTILES; ++i) {
+      kvp.addPair(prefix + PERCENTILE_NAMES[i],
+                  std::to_string(histogram.getValueAtPercentile(PERCENTILES[i])));
+   }
+   kvp.addPair(prefix + "max", std::to_string(histogram.getMax()));
+}
+
+}
+
+struct ServerMetrics::RequestMetrics {
+   std::atomic<std::uint64_t> requests;
+   std::atomic<std::uint64_t> errors;
+   std::atomic<std::uint64_t> bytesIn;
+   std::atomic<std::uint64_t> bytesOut;
+   AtomicHistogram queueLatency;
+   AtomicHistogram handlerLatency;
+   AtomicHistogram totalLatency;
+
+   RequestMetrics() :
+      requests(0),
+      errors(0),
+      bytesIn(0),
+      bytesOut(0) {
+   }
+};
+
+struct ServerMetrics::ThreadMetrics {
+   std::thread::id threadId;
+   // taken by the owning thread only to add a request name, and by readers
+   // while merging; lookups by the owning thread don't need it
+   std::mutex mutex;
+   std::unordered_map<std::string, std::unique_ptr<RequestMetrics>> requests;
+};
+
+//******************************************************************************
+
+bool ServerMetrics::isStatsRequest(const Message& requestMessage) {
+   return requestMessage.getRequestName() == STATS_REQUEST_NAME;
+}
+
+//******************************************************************************
+
+ServerMetrics::ServerMetrics() :
+   m_id(nextMetricsId++) {
+   TONNERRE_LOG_INSTANCE_CREATE("ServerMetrics");
+}
+
+//******************************************************************************
+
+ServerMetrics::~ServerMetrics() {
+   TONNERRE_LOG_INSTANCE_DESTROY("ServerMetrics");
+}
+
+//******************************************************************************
+
+ServerMetrics::ThreadMetrics* ServerMetrics::threadMetrics() {
+   // a thread nearly always records into the same instance, so remembering
+   // the last one keeps the common path free of locks
+   static thread_local std::uint64_t cachedId = 0;
+   static thread_local ThreadMetrics* cachedMetrics = nullptr;
+
+   if (cachedId == m_id) {
+      return cachedMetrics;
+   }
+
+   const std::thread::id threadId = std::this_thread::get_id();
+   ThreadMetrics* metrics = nullptr;
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (auto& candidate : m_threadMetrics) {
+         if (candidate->threadId == threadId) {
+            metrics = candidate.get();
+            break;
+         }
+      }
+
+      if (metrics == nullptr) {
+         m_threadMetrics.emplace_back(new ThreadMetrics);
+         metrics = m_threadMetrics.back().get();
+         metrics->threadId = threadId;
+      }
+   }
+
+   cachedId = m_id;
+   cachedMetrics = metrics;
+   return metrics;
+}
+
+//******************************************************************************
+
+void ServerMetrics::record(const std::string& requestName,
+                           bool isError,
+                           std::size_t bytesIn,
+                           std::size_t bytesOut,
+                           Duration queueLatency,
+                           Duration handlerLatency,
+                           Duration totalLatency) {
+   ThreadMetrics* metrics = threadMetrics();
+
+   RequestMetrics* requestMetrics;
+   auto it = metrics->requests.find(requestName);
+   if (it != metrics->requests.end()) {
+      requestMetrics = it->second.get();
+   } else {
+      requestMetrics = addRequestMetrics(metrics, requestName);
+   }
+
+   bump(requestMetrics->requests, 1);
+   if (isError) {
+      bump(requestMetrics->errors, 1);
+   }
+   bump(requestMetrics->bytesIn, bytesIn);
+   bump(requestMetrics->bytesOut, bytesOut);
+   requestMetrics->queueLatency.record(toMicros(queueLatency));
+   requestMetrics->handlerLatency.record(toMicros(handlerLatency));
+   requestMetrics->totalLatency.record(toMicros(totalLatency));
+}
+
+//******************************************************************************
+
+ServerMetrics::RequestMetrics*
+ServerMetrics::addRequestMetrics(ThreadMetrics* metrics, const std::string& requestName) {
+   // which names get their own metrics is decided once for all threads, so
+   // a name is never split between itself and the overflow
+   bool isOwnName;
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      isOwnName = (m_requestNames.count(requestName) > 0);
+      if (!isOwnName && (m_requestNames.size() < MAX_REQUEST_NAMES)) {
+         m_requestNames.insert(requestName);
+         isOwnName = true;
+      }
+   }
+
+   const std::string& recordedName = isOwnName ? requestName : OTHER_REQUEST_NAME;
+   auto it = metrics->requests.find(recordedName);
+   if (it != metrics->requests.end()) {
+      return it->second.get();
+   }
+
+   RequestMetrics* requestMetrics = new RequestMetrics;
+   std::lock_guard<std::mutex> lock(metrics->mutex);
+   metrics->requests[recordedName].reset(requestMetrics);
+   return requestMetrics;
+}
+
+//******************************************************************************
+
+std::vector<ServerMetrics::RequestStats> ServerMetrics::getRequestStats() const {
+   std::vector<RequestStats> stats;
+   std::unordered_map<std::string, std::size_t> indexByName;
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+   for (const auto& metrics : m_threadMetrics) {
+      std::lock_guard<std::mutex> threadLock(metrics->mutex);
+      for (const auto& entry : metrics->requests) {
+         auto it = indexByName.find(entry.first);
+         if (it == indexByName.end()) {
+            it = indexByName.emplace(entry.first, stats.size()).first;
+            stats.emplace_back();
+            stats.back().requestName = entry.first;
+            stats.back().requests = 0;
+            stats.back().errors = 0;
+            stats.back().bytesIn = 0;
+            stats.back().bytesOut = 0;
+         }
+
+         RequestStats& requestStats = stats[it->second];
+         const RequestMetrics& requestMetrics = *entry.second;
+         requestStats.requests += requestMetrics.requests.load(std::memory_order_relaxed);
+         requestStats.errors += requestMetrics.errors.load(std::memory_order_relaxed);
+         requestStats.bytesIn += requestMetrics.bytesIn.load(std::memory_order_relaxed);
+         requestStats.bytesOut += requestMetrics.bytesOut.load(std::memory_order_relaxed);
+         requestMetrics.queueLatency.mergeInto(requestStats.queueLatency);
+         requestMetrics.handlerLatency.mergeInto(requestStats.handlerLatency);
+         requestMetrics.totalLatency.mergeInto(requestStats.totalLatency);
+      }
+   }
+
+   std::sort(stats.begin(), stats.end(),
+             [](const RequestStats& a, const RequestStats& b) {
+                return a.requestName < b.requestName;
+             });
+   return stats;
+}
+
+//******************************************************************************
+
+std::string ServerMetrics::toPrometheus() const {
+   const std::vector<RequestStats> stats = getRequestStats();
+   std::string text;
+
+   appendCounter(text, "tonnerre_requests_total",
+                 "Requests handled.", stats, &RequestStats::requests);
+   appendCounter(text, "tonnerre_request_errors_total",
+                 "Requests that failed or were shed.", stats, &RequestStats::errors);
+   appendCounter(text, "tonnerre_request_bytes_in_total",
+                 "Bytes of requests read.", stats, &RequestStats::bytesIn);
+   appendCounter(text, "tonnerre_request_bytes_out_total",
+                 "Bytes of responses written.", stats, &RequestStats::bytesOut);
+   appendSummary(text, "tonnerre_request_queue_seconds",
+                 "Time requests waited for a worker.", stats, &RequestStats::queueLatency);
+   appendSummary(text, "tonnerre_request_handler_seconds",
+                 "Time spent in the message handler.", stats, &RequestStats::handlerLatency);
+   appendSummary(text, "tonnerre_request_seconds",
+                 "Time from being queued to the response written.", stats, &RequestStats::totalLatency);
+
+   text += "# HELP tonnerre_log_records_dropped_total Log records dropped by the async log sink.\n";
+   text += "# TYPE tonnerre_log_records_dropped_total counter\n";
+   text += "tonnerre_log_records_dropped_total " +
+           std::to_string(AsyncLogSink::getDroppedRecords()) + "\n";
+
+   return text;
+}
+
+//******************************************************************************
+
+void ServerMetrics::respondToStats(const Message& requestMessage,
+                                   Message& responseMessage) const {
+   if (requestMessage.getType() != MessageTypeKeyValues) {
+      responseMessage.setTextPayload(toPrometheus());
+      return;
+   }
+
+   KeyValuePairs kvp;
+   for (const RequestStats& requestStats : getRequestStats()) {
+      const std::string& name = requestStats.requestName;
+      kvp.addPair(name + ".requests", std::to_string(requestStats.requests));
+      kvp.addPair(name + ".errors", std::to_string(requestStats.errors));
+      kvp.addPair(name + ".bytes_in", std::to_string(requestStats.bytesIn));
+      kvp.addPair(name + ".bytes_out", std::to_string(requestStats.bytesOut));
+      addLatencyPairs(kvp, name + ".queue_us.", requestStats.queueLatency);
+      addLatencyPairs(kvp, name + ".handler_us.", requestStats.handlerLatency);
+      addLatencyPairs(kvp, name + ".total_us.", requestStats.totalLatency);
+   }
+   kvp.addPair("log.records_dropped", std::to_string(AsyncLogSink::getDroppedRecords()));
+
+   responseMessage.setKeyValuesPayload(kvp);
+}
+
+//******************************************************************************
@@ -0,0 +1,146 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_SERVERMETRICS_H
+#define TONNERRE_SERVERMETRICS_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "KeyValuePairs.h"
+#include "LatencyHistogram.h"
+
+
+namespace tonnerre
+{
+   class Message;
+
+/**
+ * ServerMetrics keeps per-request-name counters (requests, errors, bytes in
+ * and out) and latency histograms (queue, handler and total) for a server.
+ * Each thread records into its own set without taking a lock; the sets are
+ * merged when the metrics are read. Names beyond the first
+ * MAX_REQUEST_NAMES are recorded together under OTHER_REQUEST_NAME.
+ */
+class ServerMetrics
+{
+public:
+   /**
+    * The reserved request name that servers answer with their metrics
+    * instead of passing to a handler
+    */
+   static const std::string STATS_REQUEST_NAME;
+
+   /**
+    * The request name that requests are recorded under once
+    * MAX_REQUEST_NAMES distinct names have been seen
+    */
+   static const std::string OTHER_REQUEST_NAME;
+
+   /**
+    * The number of distinct request names that get metrics of their own.
+    * Request names come from clients, so without a limit every new name
+    * would cost each thread another set of histograms.
+    */
+   static const std::size_t MAX_REQUEST_NAMES;
+
+   typedef std::chrono::steady_clock::duration Duration;
+
+   /**
+    * RequestStats is the merged view of one request name's metrics
+    */
+   struct RequestStats {
+      std::string requestName;
+      std::uint64_t requests;
+      std::uint64_t errors;
+      std::uint64_t bytesIn;
+      std::uint64_t bytesOut;
+      LatencyHistogram queueLatency;
+      LatencyHistogram handlerLatency;
+      LatencyHistogram totalLatency;
+   };
+
+   /**
+    * Determines if a request asks for the server's metrics
+    * @param requestMessage the request
+    * @return boolean indicating if the request is a stats request
+    */
+   static bool isStatsRequest(const Message& requestMessage);
+
+   /**
+    * Default constructor
+    */
+   ServerMetrics();
+
+   /**
+    * Destructor
+    */
+   ~ServerMetrics();
+
+   /**
+    * Records one handled request (from any thread)
+    * @param requestName the name of the request
+    * @param isError whether the request failed (handler exception, failed
+    * write or shed)
+    * @param bytesIn size of the request on the wire
+    * @param bytesOut size of the response on the wire
+    * @param queueLatency time spent waiting for a worker
+    * @param handlerLatency time spent in the handler
+    * @param totalLatency time from being queued to the response written
+    */
+   void record(const std::string& requestName,
+               bool isError,
+               std::size_t bytesIn,
+               std::size_t bytesOut,
+               Duration queueLatency,
+               Duration handlerLatency,
+               Duration totalLatency);
+
+   /**
+    * Retrieves the metrics of every request name seen so far, merged across
+    * threads
+    * @return the stats, ordered by request name
+    */
+   std::vector<RequestStats> getRequestStats() const;
+
+   /**
+    * Formats the metrics in the Prometheus text exposition format
+    * @return the metrics as text
+    */
+   std::string toPrometheus() const;
+
+   /**
+    * Populates the response to a stats request: a key/value request gets
+    * flat keys such as 'echo.total_us.p99', a text request gets the
+    * Prometheus text
+    * @param requestMessage the stats request
+    * @param responseMessage the response to populate
+    */
+   void respondToStats(const Message& requestMessage,
+                       Message& responseMessage) const;
+
+private:
+   struct RequestMetrics;
+   struct ThreadMetrics;
+
+   ThreadMetrics* threadMetrics();
+   RequestMetrics* addRequestMetrics(ThreadMetrics* metrics,
+                                     const std::string& requestName);
+
+   std::vector<std::unique_ptr<ThreadMetrics>> m_threadMetrics;
+   std::unordered_set<std::string> m_requestNames;
+   mutable std::mutex m_mutex;
+   const std::uint64_t m_id;
+
+   ServerMetrics(const ServerMetrics&);
+   ServerMetrics& operator=(const ServerMetrics&);
+};
+
+}
+
+#endif
@@ -0,0 +1,642 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <thread>
+
+#include "ServerOptions.h"
+#include "ShmSegment.h"
+#include "IniReader.h"
+#include "StrUtils.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+static const std::string KEY_ASYNC_LOGGING              = "async_logging";
+static const std::string KEY_CODEL_INTERVAL_MS          = "codel_interval_ms";
+static const std::string KEY_CODEL_TARGET_MS            = "codel_target_ms";
+static const std::string KEY_INGESTION                  = "ingestion";
+static const std::string KEY_IN_PROCESS                 = "in_process";
+static const std::string KEY_IO_BACKEND                 = "io_backend";
+static const std::string KEY_KEEP_ALIVE                 = "keep_alive";
+static const std::string KEY_KEEP_ALIVE_IDLE_TIMEOUT_MS = "keep_alive_idle_timeout_ms";
+static const std::string KEY_KEEP_ALIVE_LINGER_MS       = "keep_alive_linger_ms";
+static const std::string KEY_KEEP_ALIVE_MAX_REQUESTS    = "keep_alive_max_requests";
+static const std::string KEY_MAX_IN_FLIGHT              = "max_in_flight";
+static const std::string KEY_MAX_QUEUE_DEPTH            = "max_queue_depth";
+static const std::string KEY_METRICS                    = "metrics";
+static const std::string KEY_METRICS_DUMP_INTERVAL_MS   = "metrics_dump_interval_ms";
+static const std::string KEY_METRICS_DUMP_PATH          = "metrics_dump_path";
+static const std::string KEY_PATH                       = "path";
+static const std::string KEY_PORT                       = "port";
+static const std::string KEY_PRIORITY_PREFIX            = "priority.";
+static const std::string KEY_PRIORITY_WEIGHTS           = "priority_weights";
+static const std::string KEY_SCHEDULING                 = "scheduling";
+static const std::string KEY_SHARDS                     = "shards";
+static const std::string KEY_SHM                        = "shm";
+static const std::string KEY_SHM_CHANNELS               = "shm_channels";
+static const std::string KEY_SHM_RING_BYTES             = "shm_ring_bytes";
+static const std::string KEY_THREADING                  = "threading";
+static const std::string KEY_UDP                        = "udp";
+static const std::string KEY_WORKER_THREADS             = "worker_threads";
+
+static const std::string VALUE_TRUE                     = "true";
+
+static const int DEFAULT_WORKER_THREADS                 = 4;
+
+// turns per round for high, normal and low priority under weighted scheduling
+static const int DEFAULT_PRIORITY_WEIGHTS[NUMBER_MESSAGE_PRIORITIES] = { 8, 4, 1 };
+
+const std::string ServerOptions::SECTION_SERVER               = "server";
+const int ServerOptions::DEFAULT_KEEP_ALIVE_IDLE_TIMEOUT_MILLIS = 30000;
+const int ServerOptions::DEFAULT_KEEP_ALIVE_LINGER_MILLIS       = 1;
+const int ServerOptions::DEFAULT_PORT                           = 9000;
+const int ServerOptions::DEFAULT_CODEL_INTERVAL_MILLIS          = 100;
+const std::string ServerOptions::THREADING_WORK_STEALING        = "workstealing";
+const std::string ServerOptions::THREADING_SHARDED              = "sharded";
+const std::string ServerOptions::IO_BACKEND_IO_URING            = "io_uring";
+const std::string ServerOptions::SCHEDULING_STRICT              = "strict";
+const std::string ServerOptions::SCHEDULING_WEIGHTED            = "weighted";
+
+//******************************************************************************
+
+ServerOptions::ServerOptions() :
+   m_priorityWeights(DEFAULT_PRIORITY_WEIGHTS,
+                     DEFAULT_PRIORITY_WEIGHTS + NUMBER_MESSAGE_PRIORITIES),
+   m_port(DEFAULT_PORT),
+   m_shards(DEFAULT_WORKER_THREADS),
+   m_maxInFlight(0),
+   m_maxQueueDepth(0),
+   m_codelTargetMillis(0),
+   m_codelIntervalMillis(DEFAULT_CODEL_INTERVAL_MILLIS),
+   m_metricsDumpIntervalMillis(0),
+   m_keepAliveIdleTimeoutMillis(DEFAULT_KEEP_ALIVE_IDLE_TIMEOUT_MILLIS),
+   m_keepAliveMaxRequests(0),
+   m_keepAliveLingerMillis(DEFAULT_KEEP_ALIVE_LINGER_MILLIS),
+   m_workerThreads(DEFAULT_WORKER_THREADS),
+   m_shmChannels(ShmSegment::DEFAULT_NUMBER_CHANNELS),
+   m_shmRingBytes(ShmSegment::DEFAULT_RING_BYTES),
+   m_asyncLogging(false),
+   m_inProcess(true),
+   m_ingestionMode(false),
+   m_keepAlive(false),
+   m_metrics(false),
+   m_shm(false),
+   m_udp(false) {
+   const unsigned int numberCores = std::thread::hardware_concurrency();
+   if (numberCores > 0) {
+      m_workerThreads = (int) numberCores;
+      m_shards = (int) numberCores;
+   }
+}
+
+//******************************************************************************
+
+void ServerOptions::populate(const KeyValuePairs& kvp) {
+   if (kvp.hasKey(KEY_CODEL_INTERVAL_MS)) {
+      const int interval = StrUtils::parseInt(kvp.getValue(KEY_CODEL_INTERVAL_MS));
+      if (interval > 0) {
+         m_codelIntervalMillis = interval;
+      }
+   }
+
+   if (kvp.hasKey(KEY_CODEL_TARGET_MS)) {
+      const int target = StrUtils::parseInt(kvp.getValue(KEY_CODEL_TARGET_MS));
+      if (target >= 0) {
+         m_codelTargetMillis = target;
+      }
+   }
+
+   if (kvp.hasKey(KEY_INGESTION)) {
+      m_ingestionMode = (kvp.getValue(KEY_INGESTION) == VALUE_TRUE);
+   }
+
+   if (kvp.hasKey(KEY_IN_PROCESS)) {
+      m_inProcess = (kvp.getValue(KEY_IN_PROCESS) == VALUE_TRUE);
+   }
+
+   if (kvp.hasKey(KEY_IO_BACKEND)) {
+      m_ioBackend = kvp.getValue(KEY_IO_BACKEND);
+   }
+
+   if (kvp.hasKey(KEY_KEEP_ALIVE)) {
+      m_keepAlive = (kvp.getValue(KEY_KEEP_ALIVE) == VALUE_TRUE);
+   }
+
+   if (kvp.hasKey(KEY_KEEP_ALIVE_IDLE_TIMEOUT_MS)) {
+      const int idleTimeout =
+         StrUtils::parseInt(kvp.getValue(KEY_KEEP_ALIVE_IDLE_TIMEOUT_MS));
+      if (idleTimeout > 0) {
+         m_keepAliveIdleTimeoutMillis = idleTimeout;
+      }
+   }
+
+   if (kvp.hasKey(KEY_KEEP_ALIVE_LINGER_MS)) {
+      const int linger =
+         StrUtils::parseInt(kvp.getValue(KEY_KEEP_ALIVE_LINGER_MS));
+      if (linger >= 0) {
+         m_keepAliveLingerMillis = linger;
+      }
+   }
+
+   if (kvp.hasKey(KEY_KEEP_ALIVE_MAX_REQUESTS)) {
+      const int maxRequests =
+         StrUtils::parseInt(kvp.getValue(KEY_KEEP_ALIVE_MAX_REQUESTS));
+      if (maxRequests >= 0) {
+         m_keepAliveMaxRequests = maxRequests;
+      }
+   }
+
+   if (kvp.hasKey(KEY_MAX_IN_FLIGHT)) {
+      const int maxInFlight = StrUtils::parseInt(kvp.getValue(KEY_MAX_IN_FLIGHT));
+      if (maxInFlight >= 0) {
+         m_maxInFlight = maxInFlight;
+      }
+   }
+
+   if (kvp.hasKey(KEY_MAX_QUEUE_DEPTH)) {
+      const int maxQueueDepth = StrUtils::parseInt(kvp.getValue(KEY_MAX_QUEUE_DEPTH));
+      if (maxQueueDepth >= 0) {
+         m_maxQueueDepth = maxQueueDepth;
+      }
+   }
+
+   if (kvp.hasKey(KEY_METRICS)) {
+      m_metrics = (kvp.getValue(KEY_METRICS) == VALUE_TRUE);
+   }
+
+   if (kvp.hasKey(KEY_ASYNC_LOGGING)) {
+      m_asyncLogging = (kvp.getValue(KEY_ASYNC_LOGGING) == VALUE_TRUE);
+   }
+
+   if (kvp.hasKey(KEY_METRICS_DUMP_INTERVAL_MS)) {
+      const int dumpInterval =
+         StrUtils::parseInt(kvp.getValue(KEY_METRICS_DUMP_INTERVAL_MS));
+      if (dumpInterval >= 0) {
+         m_metricsDumpIntervalMillis = dumpInterval;
+      }
+   }
+
+   if (kvp.hasKey(KEY_METRICS_DUMP_PATH)) {
+      m_metricsDumpPath = kvp.getValue(KEY_METRICS_DUMP_PATH);
+   }
+
+   if (kvp.hasKey(KEY_PATH)) {
+      m_socketPath = kvp.getValue(KEY_PATH);
+   }
+
+   if (kvp.hasKey(KEY_PORT)) {
+      const int port = StrUtils::parseInt(kvp.getValue(KEY_PORT));
+      if (port > 0) {
+         m_port = port;
+      }
+   }
+
+   if (kvp.hasKey(KEY_PRIORITY_WEIGHTS)) {
+      std::vector<int> weights;
+      for (const std::string& weight :
+           StrUtils::split(kvp.getValue(KEY_PRIORITY_WEIGHTS), ",")) {
+         weights.push_back(StrUtils::parseInt(weight));
+      }
+      if (weights.size() == NUMBER_MESSAGE_PRIORITIES) {
+         m_priorityWeights = weights;
+      }
+   }
+
+   // default priorities per request name, e.g. 'priority.healthCheck = high'
+   std::vector<std::string> keys;
+   kvp.getKeys(keys);
+   for (const std::string& key : keys) {
+      if (StrUtils::startsWith(key, KEY_PRIORITY_PREFIX)) {
+         MessagePriority priority;
+         if (Message::parsePriority(kvp.getValue(key), priority)) {
+            m_requestPriorities[key.substr(KEY_PRIORITY_PREFIX.length())] = priority;
+         }
+      }
+   }
+
+   if (kvp.hasKey(KEY_SCHEDULING)) {
+      m_scheduling = kvp.getValue(KEY_SCHEDULING);
+   }
+
+   if (kvp.hasKey(KEY_SHARDS)) {
+      const int shards = StrUtils::parseInt(kvp.getValue(KEY_SHARDS));
+      if (shards > 0) {
+         m_shards = shards;
+      }
+   }
+
+   if (kvp.hasKey(KEY_SHM)) {
+      m_shm = (kvp.getValue(KEY_SHM) == VALUE_TRUE);
+   }
+
+   if (kvp.hasKey(KEY_SHM_CHANNELS)) {
+      const int channels = StrUtils::parseInt(kvp.getValue(KEY_SHM_CHANNELS));
+      if (channels > 0) {
+         m_shmChannels = channels;
+      }
+   }
+
+   if (kvp.hasKey(KEY_SHM_RING_BYTES)) {
+      const int ringBytes = StrUtils::parseInt(kvp.getValue(KEY_SHM_RING_BYTES));
+      if (ringBytes > 0) {
+         m_shmRingBytes = ringBytes;
+      }
+   }
+
+   if (kvp.hasKey(KEY_THREADING)) {
+      m_threading = kvp.getValue(KEY_THREADING);
+   }
+
+   if (kvp.hasKey(KEY_UDP)) {
+      m_udp = (kvp.getValue(KEY_UDP) == VALUE_TRUE);
+   }
+
+   if (kvp.hasKey(KEY_WORKER_THREADS)) {
+      const int workerThreads =
+         StrUtils::parseInt(kvp.getValue(KEY_WORKER_THREADS));
+      if (workerThreads > 0) {
+         m_workerThreads = workerThreads;
+      }
+   }
+}
+
+//******************************************************************************
+
+// throws BasicException
+void ServerOptions::readConfigFile(const std::string& configFilePath) {
+   IniReader reader(configFilePath);
+   if (reader.hasSection(SECTION_SERVER)) {
+      KeyValuePairs kvp;
+      if (reader.readSection(SECTION_SERVER, kvp)) {
+         populate(kvp);
+      }
+   }
+}
+
+//******************************************************************************
+
+bool ServerOptions::isIngestionMode() const {
+   return m_ingestionMode;
+}
+
+//******************************************************************************
+
+void ServerOptions::setIngestionMode(bool ingestionMode) {
+   m_ingestionMode = ingestionMode;
+}
+
+//******************************************************************************
+
+bool ServerOptions::isKeepAlive() const {
+   return m_keepAlive;
+}
+
+//******************************************************************************
+
+void ServerOptions::setKeepAlive(bool keepAlive) {
+   m_keepAlive = keepAlive;
+}
+
+//******************************************************************************
+
+int ServerOptions::getKeepAliveIdleTimeoutMillis() const {
+   return m_keepAliveIdleTimeoutMillis;
+}
+
+//******************************************************************************
+
+void ServerOptions::setKeepAliveIdleTimeoutMillis(int idleTimeoutMillis) {
+   m_keepAliveIdleTimeoutMillis = idleTimeoutMillis;
+}
+
+//******************************************************************************
+
+int ServerOptions::getKeepAliveMaxRequests() const {
+   return m_keepAliveMaxRequests;
+}
+
+//******************************************************************************
+
+void ServerOptions::setKeepAliveMaxRequests(int maxRequests) {
+   m_keepAliveMaxRequests = maxRequests;
+}
+
+//******************************************************************************
+
+int ServerOptions::getKeepAliveLingerMillis() const {
+   return m_keepAliveLingerMillis;
+}
+
+//******************************************************************************
+
+void ServerOptions::setKeepAliveLingerMillis(int lingerMillis) {
+   m_keepAliveLingerMillis = lingerMillis;
+}
+
+//******************************************************************************
+
+int ServerOptions::getWorkerThreads() const {
+   return m_workerThreads;
+}
+
+//******************************************************************************
+
+void ServerOptions::setWorkerThreads(int workerThreads) {
+   m_workerThreads = workerThreads;
+}
+
+//******************************************************************************
+
+int ServerOptions::getPort() const {
+   return m_port;
+}
+
+//******************************************************************************
+
+void ServerOptions::setPort(int port) {
+   m_port = port;
+}
+
+//******************************************************************************
+
+const std::string& ServerOptions::getSocketPath() const {
+   return m_socketPath;
+}
+
+//******************************************************************************
+
+void ServerOptions::setSocketPath(const std::string& socketPath) {
+   m_socketPath = socketPath;
+}
+
+//******************************************************************************
+
+bool ServerOptions::isInProcess() const {
+   return m_inProcess;
+}
+
+//******************************************************************************
+
+void ServerOptions::setInProcess(bool inProcess) {
+   m_inProcess = inProcess;
+}
+
+//******************************************************************************
+
+const std::string& ServerOptions::getThreading() const {
+   return m_threading;
+}
+
+//******************************************************************************
+
+void ServerOptions::setThreading(const std::string& threading) {
+   m_threading = threading;
+}
+
+//******************************************************************************
+
+bool ServerOptions::isWorkStealing() const {
+   return m_threading == THREADING_WORK_STEALING;
+}
+
+//******************************************************************************
+
+bool ServerOptions::isSharded() const {
+   return m_threading == THREADING_SHARDED;
+}
+
+//******************************************************************************
+
+int ServerOptions::getShards() const {
+   return m_shards;
+}
+
+//******************************************************************************
+
+void ServerOptions::setShards(int shards) {
+   m_shards = shards;
+}
+
+//******************************************************************************
+
+const std::string& ServerOptions::getIoBackend() const {
+   return m_ioBackend;
+}
+
+//******************************************************************************
+
+void ServerOptions::setIoBackend(const std::string& ioBackend) {
+   m_ioBackend = ioBackend;
+}
+
+//******************************************************************************
+
+bool ServerOptions::isIoUring() const {
+   return m_ioBackend == IO_BACKEND_IO_URING;
+}
+
+//******************************************************************************
+
+int ServerOptions::getMaxInFlight() const {
+   return m_maxInFlight;
+}
+
+//******************************************************************************
+
+void ServerOptions::setMaxInFlight(int maxInFlight) {
+   m_maxInFlight = maxInFlight;
+}
+
+//******************************************************************************
+
+int ServerOptions::getMaxQueueDepth() const {
+   return m_maxQueueDepth;
+}
+
+//******************************************************************************
+
+void ServerOptions::setMaxQueueDepth(int maxQueueDepth) {
+   m_maxQueueDepth = maxQueueDepth;
+}
+
+//******************************************************************************
+
+int ServerOptions::getCodelTargetMillis() const {
+   return m_codelTargetMillis;
+}
+
+//******************************************************************************
+
+void ServerOptions::setCodelTargetMillis(int targetMillis) {
+   m_codelTargetMillis = targetMillis;
+}
+
+//******************************************************************************
+
+int ServerOptions::getCodelIntervalMillis() const {
+   return m_codelIntervalMillis;
+}
+
+//******************************************************************************
+
+void ServerOptions::setCodelIntervalMillis(int intervalMillis) {
+   m_codelIntervalMillis = intervalMillis;
+}
+
+//******************************************************************************
+
+bool ServerOptions::hasAdmissionControl() const {
+   return (m_maxInFlight > 0) || (m_maxQueueDepth > 0) || (m_codelTargetMillis > 0);
+}
+
+//******************************************************************************
+
+const std::string& ServerOptions::getScheduling() const {
+   return m_scheduling;
+}
+
+//******************************************************************************
+
+void ServerOptions::setScheduling(const std::string& scheduling) {
+   m_scheduling = scheduling;
+}
+
+//******************************************************************************
+
+bool ServerOptions::isPriorityScheduling() const {
+   return (m_scheduling == SCHEDULING_STRICT) || (m_scheduling == SCHEDULING_WEIGHTED);
+}
+
+//******************************************************************************
+
+bool ServerOptions::isWeightedScheduling() const {
+   return m_scheduling == SCHEDULING_WEIGHTED;
+}
+
+//******************************************************************************
+
+const std::vector<int>& ServerOptions::getPriorityWeights() const {
+   return m_priorityWeights;
+}
+
+//******************************************************************************
+
+void ServerOptions::setPriorityWeights(const std::vector<int>& weights) {
+   m_priorityWeights = weights;
+}
+
+//******************************************************************************
+
+MessagePriority ServerOptions::getRequestPriority(const std::string& requestName) const {
+   auto it = m_requestPriorities.find(requestName);
+   if (it != m_requestPriorities.end()) {
+      return it->second;
+   }
+
+   return MessagePriorityNormal;
+}
+
+//******************************************************************************
+
+void ServerOptions::setRequestPriority(const std::string& requestName,
+                                       MessagePriority priority) {
+   m_requestPriorities[requestName] = priority;
+}
+
+//******************************************************************************
+
+bool ServerOptions::isMetrics() const {
+   return m_metrics;
+}
+
+//******************************************************************************
+
+void ServerOptions::setMetrics(bool metrics) {
+   m_metrics = metrics;
+}
+
+//******************************************************************************
+
+int ServerOptions::getMetricsDumpIntervalMillis() const {
+   return m_metricsDumpIntervalMillis;
+}
+
+//******************************************************************************
+
+void ServerOptions::setMetricsDumpIntervalMillis(int dumpIntervalMillis) {
+   m_metricsDumpIntervalMillis = dumpIntervalMillis;
+}
+
+//******************************************************************************
+
+const std::string& ServerOptions::getMetricsDumpPath() const {
+   return m_metricsDumpPath;
+}
+
+//******************************************************************************
+
+void ServerOptions::setMetricsDumpPath(const std::string& dumpPath) {
+   m_metricsDumpPath = dumpPath;
+}
+
+//******************************************************************************
+
+bool ServerOptions::isAsyncLogging() const {
+   return m_asyncLogging;
+}
+
+//******************************************************************************
+
+void ServerOptions::setAsyncLogging(bool asyncLogging) {
+   m_asyncLogging = asyncLogging;
+}
+
+//******************************************************************************
+
+bool ServerOptions::isShm() const {
+   return m_shm;
+}
+
+//******************************************************************************
+
+void ServerOptions::setShm(bool shm) {
+   m_shm = shm;
+}
+
+//******************************************************************************
+
+std::uint32_t ServerOptions::getShmChannels() const {
+   return m_shmChannels;
+}
+
+//******************************************************************************
+
+void ServerOptions::setShmChannels(std::uint32_t channels) {
+   m_shmChannels = channels;
+}
+
+//******************************************************************************
+
+std::uint32_t ServerOptions::getShmRingBytes() const {
+   return m_shmRingBytes;
+}
+
+//******************************************************************************
+
+void ServerOptions::setShmRingBytes(std::uint32_t ringBytes) {
+   m_shmRingBytes = ringBytes;
+}
+
+//******************************************************************************
+
+bool ServerOptions::isUdp() const {
+   return m_udp;
+}
+
+//******************************************************************************
+
+void ServerOptions::setUdp(bool udp) {
+   m_udp = udp;
+}
+
+//******************************************************************************
@@ -0,0 +1,490 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_SERVEROPTIONS_H
+#define TONNERRE_SERVEROPTIONS_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "KeyValuePairs.h"
+#include "Message.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * ServerOptions holds the tonnerre-specific settings of the [server]
+ * configuration section (the values chaudière's SocketServer doesn't
+ * interpret itself, plus the port and threading values that tonnerre needs
+ * when it runs its own accept loop).
+ */
+class ServerOptions
+{
+public:
+   static const std::string SECTION_SERVER;
+   static const int DEFAULT_KEEP_ALIVE_IDLE_TIMEOUT_MILLIS;
+   static const int DEFAULT_KEEP_ALIVE_LINGER_MILLIS;
+   static const int DEFAULT_PORT;
+   static const int DEFAULT_CODEL_INTERVAL_MILLIS;
+   static const std::string THREADING_WORK_STEALING;
+   static const std::string THREADING_SHARDED;
+   static const std::string IO_BACKEND_IO_URING;
+   static const std::string SCHEDULING_STRICT;
+   static const std::string SCHEDULING_WEIGHTED;
+
+   /**
+    * Default constructor
+    */
+   ServerOptions();
+
+   /**
+    * Populates the options from the [server] configuration section
+    * @param kvp the key/value pairs read from the [server] section
+    * @see KeyValuePairs()
+    */
+   void populate(const chaudiere::KeyValuePairs& kvp);
+
+   /**
+    * Reads the [server] section of a configuration file (if present)
+    * @param configFilePath the path to the configuration (INI) file
+    */
+   void readConfigFile(const std::string& configFilePath);
+
+   /**
+    * Determines if the server runs in ingestion mode, where one-way messages
+    * get no response and a connection may carry a stream of them
+    * @return boolean indicating if ingestion mode is enabled
+    */
+   bool isIngestionMode() const;
+
+   /**
+    * Sets whether the server runs in ingestion mode
+    * @param ingestionMode whether ingestion mode is enabled
+    */
+   void setIngestionMode(bool ingestionMode);
+
+   /**
+    * Determines if connections are kept open and serviced as a loop over
+    * messages (for clients using persistent connections)
+    * @return boolean indicating if keep-alive is enabled
+    */
+   bool isKeepAlive() const;
+
+   /**
+    * Sets whether connections are kept open between messages
+    * @param keepAlive whether keep-alive is enabled
+    */
+   void setKeepAlive(bool keepAlive);
+
+   /**
+    * Retrieves how long a kept-alive connection may sit idle before the
+    * server closes it
+    * @return idle timeout in milliseconds
+    */
+   int getKeepAliveIdleTimeoutMillis() const;
+
+   /**
+    * Sets how long a kept-alive connection may sit idle
+    * @param idleTimeoutMillis idle timeout in milliseconds
+    */
+   void setKeepAliveIdleTimeoutMillis(int idleTimeoutMillis);
+
+   /**
+    * Retrieves the number of requests after which the server closes a
+    * kept-alive connection
+    * @return maximum requests per connection (0 means no limit)
+    */
+   int getKeepAliveMaxRequests() const;
+
+   /**
+    * Sets the number of requests after which a connection is closed
+    * @param maxRequests maximum requests per connection (0 means no limit)
+    */
+   void setKeepAliveMaxRequests(int maxRequests);
+
+   /**
+    * Retrieves how long a worker waits for the next message on a connection
+    * before handing the connection back to an event loop
+    * @return linger time in milliseconds
+    */
+   int getKeepAliveLingerMillis() const;
+
+   /**
+    * Sets how long a worker waits for the next message before handing the
+    * connection back to an event loop
+    * @param lingerMillis linger time in milliseconds
+    */
+   void setKeepAliveLingerMillis(int lingerMillis);
+
+   /**
+    * Retrieves the number of worker threads for tonnerre's own executor
+    * @return number of worker threads
+    */
+   int getWorkerThreads() const;
+
+   /**
+    * Sets the number of worker threads for tonnerre's own executor
+    * @param workerThreads number of worker threads
+    */
+   void setWorkerThreads(int workerThreads);
+
+   /**
+    * Retrieves the port the server listens on
+    * @return the listening port
+    */
+   int getPort() const;
+
+   /**
+    * Sets the port the server listens on
+    * @param port the listening port
+    */
+   void setPort(int port);
+
+   /**
+    * Retrieves the Unix domain socket the server listens on instead of
+    * its port
+    * @return the socket path (empty to listen on the port)
+    * @see UnixSocket()
+    */
+   const std::string& getSocketPath() const;
+
+   /**
+    * Sets the Unix domain socket the server listens on instead of its port
+    * @param socketPath the socket path (empty to listen on the port)
+    */
+   void setSocketPath(const std::string& socketPath);
+
+   /**
+    * Determines if requests sent to the server's services from within its
+    * own process are handed straight to their handlers
+    * @return boolean indicating if in-process dispatch is enabled (the
+    * default)
+    * @see InProcessRegistry()
+    */
+   bool isInProcess() const;
+
+   /**
+    * Sets whether same-process requests are handed straight to handlers
+    * @param inProcess whether in-process dispatch is enabled
+    */
+   void setInProcess(bool inProcess);
+
+   /**
+    * Retrieves the threading model named in the configuration
+    * @return the threading model (e.g., 'pthreads' or 'workstealing')
+    */
+   const std::string& getThreading() const;
+
+   /**
+    * Sets the threading model
+    * @param threading the threading model
+    */
+   void setThreading(const std::string& threading);
+
+   /**
+    * Determines if requests are dispatched on tonnerre's work-stealing
+    * executor rather than on chaudière's thread pool
+    * @return boolean indicating if the work-stealing executor is used
+    * @see WorkStealingExecutor()
+    */
+   bool isWorkStealing() const;
+
+   /**
+    * Determines if the server runs as independent SO_REUSEPORT shards, each
+    * accepting and serving its own connections on its own core
+    * @return boolean indicating if the server is sharded
+    * @see ServerShard()
+    */
+   bool isSharded() const;
+
+   /**
+    * Retrieves the number of shards for a sharded server
+    * @return number of shards
+    */
+   int getShards() const;
+
+   /**
+    * Sets the number of shards for a sharded server
+    * @param shards number of shards
+    */
+   void setShards(int shards);
+
+   /**
+    * Retrieves the I/O backend named in the configuration
+    * @return the I/O backend (empty for the standard socket path)
+    */
+   const std::string& getIoBackend() const;
+
+   /**
+    * Sets the I/O backend
+    * @param ioBackend the I/O backend (e.g., 'io_uring')
+    */
+   void setIoBackend(const std::string& ioBackend);
+
+   /**
+    * Determines if the io_uring backend was requested (it's only used when
+    * the kernel supports it)
+    * @return boolean indicating if io_uring was requested
+    * @see IoUringServer()
+    */
+   bool isIoUring() const;
+
+   /**
+    * Retrieves the maximum number of requests handled at once before new
+    * ones are shed
+    * @return maximum in-flight requests (0 means no limit)
+    */
+   int getMaxInFlight() const;
+
+   /**
+    * Sets the maximum number of requests handled at once
+    * @param maxInFlight maximum in-flight requests (0 means no limit)
+    */
+   void setMaxInFlight(int maxInFlight);
+
+   /**
+    * Retrieves the maximum number of connections waiting for a worker
+    * before new ones are shed
+    * @return maximum queue depth (0 means no limit)
+    */
+   int getMaxQueueDepth() const;
+
+   /**
+    * Sets the maximum number of connections waiting for a worker
+    * @param maxQueueDepth maximum queue depth (0 means no limit)
+    */
+   void setMaxQueueDepth(int maxQueueDepth);
+
+   /**
+    * Retrieves the queueing delay above which a standing queue starts
+    * shedding requests (CoDel target)
+    * @return target delay in milliseconds (0 disables delay-based shedding)
+    */
+   int getCodelTargetMillis() const;
+
+   /**
+    * Sets the CoDel target queueing delay
+    * @param targetMillis target delay in milliseconds (0 disables it)
+    */
+   void setCodelTargetMillis(int targetMillis);
+
+   /**
+    * Retrieves the interval over which the queueing delay is judged
+    * @return interval in milliseconds
+    */
+   int getCodelIntervalMillis() const;
+
+   /**
+    * Sets the interval over which the queueing delay is judged
+    * @param intervalMillis interval in milliseconds
+    */
+   void setCodelIntervalMillis(int intervalMillis);
+
+   /**
+    * Determines if any admission control limit is configured
+    * @return boolean indicating if requests may be shed under load
+    * @see AdmissionController()
+    */
+   bool hasAdmissionControl() const;
+
+   /**
+    * Retrieves the priority scheduling policy named in the configuration
+    * @return the policy ('strict' or 'weighted'; empty when requests are
+    * served in arrival order)
+    */
+   const std::string& getScheduling() const;
+
+   /**
+    * Sets the priority scheduling policy
+    * @param scheduling the policy ('strict', 'weighted' or empty)
+    */
+   void setScheduling(const std::string& scheduling);
+
+   /**
+    * Determines if requests are queued by priority class before being
+    * handled
+    * @return boolean indicating if priority scheduling is enabled
+    * @see PriorityExecutor()
+    */
+   bool isPriorityScheduling() const;
+
+   /**
+    * Determines if priority classes take weighted turns rather than strict
+    * precedence
+    * @return boolean indicating if scheduling is weighted
+    */
+   bool isWeightedScheduling() const;
+
+   /**
+    * Retrieves the turns per round of each priority class for weighted
+    * scheduling (highest class first)
+    * @return the weights
+    */
+   const std::vector<int>& getPriorityWeights() const;
+
+   /**
+    * Sets the turns per round of each priority class
+    * @param weights the weights (highest class first)
+    */
+   void setPriorityWeights(const std::vector<int>& weights);
+
+   /**
+    * Retrieves the priority given to requests with the specified name that
+    * don't carry a priority of their own
+    * @param requestName the name of the request
+    * @return the configured priority (MessagePriorityNormal by default)
+    */
+   MessagePriority getRequestPriority(const std::string& requestName) const;
+
+   /**
+    * Sets the default priority for requests with the specified name
+    * @param requestName the name of the request
+    * @param priority the priority
+    */
+   void setRequestPriority(const std::string& requestName,
+                           MessagePriority priority);
+
+   /**
+    * Determines if the server keeps per-request counters and latency
+    * histograms (and answers the reserved '__stats' request)
+    * @return boolean indicating if metrics are enabled
+    * @see ServerMetrics()
+    */
+   bool isMetrics() const;
+
+   /**
+    * Sets whether the server keeps metrics
+    * @param metrics whether metrics are enabled
+    */
+   void setMetrics(bool metrics);
+
+   /**
+    * Retrieves how often the metrics are written out in Prometheus text
+    * format
+    * @return dump interval in milliseconds (0 means never)
+    */
+   int getMetricsDumpIntervalMillis() const;
+
+   /**
+    * Sets how often the metrics are written out
+    * @param dumpIntervalMillis dump interval in milliseconds (0 means never)
+    */
+   void setMetricsDumpIntervalMillis(int dumpIntervalMillis);
+
+   /**
+    * Retrieves the file the metrics are written to
+    * @return the dump file path (empty to write them to the log)
+    */
+   const std::string& getMetricsDumpPath() const;
+
+   /**
+    * Sets the file the metrics are written to
+    * @param dumpPath the dump file path (empty to write them to the log)
+    */
+   void setMetricsDumpPath(const std::string& dumpPath);
+
+   /**
+    * Determines if the server logs through the AsyncLogSink, so that
+    * errors logged while handling requests don't wait on the Logger
+    * @return boolean indicating if asynchronous logging is enabled
+    * @see AsyncLogSink()
+    */
+   bool isAsyncLogging() const;
+
+   /**
+    * Sets whether the server logs through the AsyncLogSink
+    * @param asyncLogging whether asynchronous logging is enabled
+    */
+   void setAsyncLogging(bool asyncLogging);
+
+   /**
+    * Determines if the server also serves same-host clients through a
+    * shared memory segment (named for the server's port)
+    * @return boolean indicating if the shared memory transport is enabled
+    * @see ShmServer()
+    */
+   bool isShm() const;
+
+   /**
+    * Sets whether the server serves a shared memory segment
+    * @param shm whether the shared memory transport is enabled
+    */
+   void setShm(bool shm);
+
+   /**
+    * Retrieves the number of channels in the shared memory segment (the
+    * most client threads that can have a request in flight at once)
+    * @return number of channels
+    */
+   std::uint32_t getShmChannels() const;
+
+   /**
+    * Sets the number of channels in the shared memory segment
+    * @param channels number of channels
+    */
+   void setShmChannels(std::uint32_t channels);
+
+   /**
+    * Retrieves the size of each of a channel's two rings (the largest
+    * message carried is a few bytes smaller; larger ones go over TCP)
+    * @return ring size in bytes
+    */
+   std::uint32_t getShmRingBytes() const;
+
+   /**
+    * Sets the size of each of a channel's rings
+    * @param ringBytes ring size in bytes (rounded up to a power of 2)
+    */
+   void setShmRingBytes(std::uint32_t ringBytes);
+
+   /**
+    * Determines if the server also receives one-way messages sent as
+    * datagrams on its port
+    * @return boolean indicating if the UDP transport is enabled
+    * @see UdpServer()
+    */
+   bool isUdp() const;
+
+   /**
+    * Sets whether the server receives datagrams on its port
+    * @param udp whether the UDP transport is enabled
+    */
+   void setUdp(bool udp);
+
+private:
+   std::unordered_map<std::string, MessagePriority> m_requestPriorities;
+   std::vector<int> m_priorityWeights;
+   std::string m_scheduling;
+   std::string m_ioBackend;
+   std::string m_metricsDumpPath;
+   std::string m_socketPath;
+   std::string m_threading;
+   int m_port;
+   int m_shards;
+   int m_maxInFlight;
+   int m_maxQueueDepth;
+   int m_codelTargetMillis;
+   int m_codelIntervalMillis;
+   int m_metricsDumpIntervalMillis;
+   int m_keepAliveIdleTimeoutMillis;
+   int m_keepAliveMaxRequests;
+   int m_keepAliveLingerMillis;
+   int m_workerThreads;
+   std::uint32_t m_shmChannels;
+   std::uint32_t m_shmRingBytes;
+   bool m_asyncLogging;
+   bool m_inProcess;
+   bool m_ingestionMode;
+   bool m_keepAlive;
+   bool m_metrics;
+   bool m_shm;
+   bool m_udp;
+};
+
+}
+
+#endif
@@ -0,0 +1,307 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "ServerShard.h"
+#include "Socket.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+static const int LISTEN_BACKLOG = SOMAXCONN;
+
+//******************************************************************************
+
+ServerShard::ServerShard(int port, SocketServiceHandler* serviceHandler, int cpu) :
+   m_serviceHandler(serviceHandler),
+   m_acceptCount(0),
+   m_connectionCount(0),
+   m_isRunning(false),
+   m_port(port),
+   m_cpu(cpu),
+   m_listenFd(-1),
+   m_isStopped(true) {
+   TONNERRE_LOG_INSTANCE_CREATE("ServerShard");
+
+   m_wakePipe[0] = -1;
+   m_wakePipe[1] = -1;
+}
+
+//******************************************************************************
+
+ServerShard::~ServerShard() {
+   TONNERRE_LOG_INSTANCE_DESTROY("ServerShard");
+   stop();
+   delete m_serviceHandler;
+}
+
+//******************************************************************************
+
+bool ServerShard::start() {
+   if (m_isRunning.load()) {
+      return false;
+   }
+
+   m_listenFd = openReusePortListener(m_port);
+   if (m_listenFd == -1) {
+      return false;
+   }
+
+   // accepts are driven by poll, so never block in accept()
+   ::fcntl(m_listenFd, F_SETFL, ::fcntl(m_listenFd, F_GETFL) | O_NONBLOCK);
+
+   if (::pipe(m_wakePipe) != 0) {
+      Logger::error("unable to create wake pipe for server shard");
+      ::close(m_listenFd);
+      m_listenFd = -1;
+      return false;
+   }
+   ::fcntl(m_wakePipe[0], F_SETFL, O_NONBLOCK);
+   ::fcntl(m_wakePipe[1], F_SETFL, O_NONBLOCK);
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_isStopped = false;
+   }
+
+   m_isRunning.store(true);
+   m_thread = std::thread(&ServerShard::run, this);
+   return true;
+}
+
+//******************************************************************************
+
+void ServerShard::stop() {
+   if (!m_isRunning.exchange(false)) {
+      return;
+   }
+
+   const char wakeByte = 0;
+   if (::write(m_wakePipe[1], &wakeByte, 1) < 0) {
+      // pipe full -- the shard is already being woken
+   }
+
+   if (m_thread.joinable()) {
+      m_thread.join();
+   }
+
+   ::close(m_wakePipe[0]);
+   ::close(m_wakePipe[1]);
+   m_wakePipe[0] = -1;
+   m_wakePipe[1] = -1;
+}
+
+//******************************************************************************
+
+void ServerShard::waitUntilStopped() {
+   std::unique_lock<std::mutex> lock(m_mutex);
+   m_stoppedCond.wait(lock, [this] { return m_isStopped; });
+}
+
+//******************************************************************************
+
+std::uint64_t ServerShard::getAcceptCount() const {
+   return m_acceptCount.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+std::size_t ServerShard::getConnectionCount() const {
+   return m_connectionCount.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+int ServerShard::openReusePortListener(int port) {
+   const int listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+   if (listenFd < 0) {
+      Logger::error("unable to create listening socket");
+      return -1;
+   }
+
+   // every shard binds the same port; SO_REUSEPORT has the kernel hash
+   // each new connection to one of the listeners
+   const int on = 1;
+   ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+   if (::setsockopt(listenFd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0) {
+      Logger::error("unable to set SO_REUSEPORT on listening socket");
+      ::close(listenFd);
+      return -1;
+   }
+
+   struct sockaddr_in addr;
+   addr.sin_family = AF_INET;
+   addr.sin_addr.s_addr = htonl(INADDR_ANY);
+   addr.sin_port = htons((unsigned short) port);
+
+   if ((::bind(listenFd, (struct sockaddr*) &addr, sizeof(addr)) != 0) ||
+       (::listen(listenFd, LISTEN_BACKLOG) != 0)) {
+      Logger::error("unable to listen on port " + std::to_string(port));
+      ::close(listenFd);
+      return -1;
+   }
+
+   return listenFd;
+}
+
+//******************************************************************************
+
+void ServerShard::run() {
+   pinThreadToCpu(m_cpu);
+
+   std::vector<struct pollfd> pollFds;
+
+   while (m_isRunning.load(std::memory_order_acquire)) {
+      pollFds.clear();
+
+      struct pollfd pfd;
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+
+      pfd.fd = m_wakePipe[0];
+      pollFds.push_back(pfd);
+      pfd.fd = m_listenFd;
+      pollFds.push_back(pfd);
+      for (SocketRequest* request : m_connections) {
+         pfd.fd = request->getSocketFD();
+         pollFds.push_back(pfd);
+      }
+
+      const int rc = ::poll(pollFds.data(), pollFds.size(), -1);
+      if (rc < 0) {
+         if (errno == EINTR) {
+            continue;
+         }
+         TONNERRE_LOG_ERROR("poll failed in server shard");
+         break;
+      }
+
+      if (pollFds[0].revents != 0) {
+         char drain[64];
+         while (::read(m_wakePipe[0], drain, sizeof(drain)) > 0) {
+         }
+         continue;
+      }
+
+      // requests run right here on the shard's thread (each connection
+      // hands it back after a few messages, so a busy one can't hold it);
+      // connections that are done are dropped from the set as we go
+      std::size_t kept = 0;
+      for (std::size_t i = 0; i < m_connections.size(); ++i) {
+         SocketRequest* request = m_connections[i];
+         if ((pollFds[i + 2].revents == 0) || serviceConnection(request)) {
+            m_connections[kept++] = request;
+         } else {
+            delete request;
+         }
+      }
+      m_connections.resize(kept);
+
+      if (pollFds[1].revents != 0) {
+         acceptConnections();
+      }
+
+      m_connectionCount.store(m_connections.size(), std::memory_order_relaxed);
+   }
+
+   closeConnections();
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+   m_isStopped = true;
+   m_stoppedCond.notify_all();
+}
+
+//******************************************************************************
+
+void ServerShard::pinThreadToCpu(int cpu) {
+#if defined(__linux__)
+   if (cpu >= 0) {
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      CPU_SET(cpu, &cpuSet);
+      if (::pthread_setaffinity_np(::pthread_self(), sizeof(cpuSet), &cpuSet) != 0) {
+         Logger::warning("unable to pin thread to cpu " + std::to_string(cpu));
+      }
+   }
+#else
+   (void) cpu;
+#endif
+}
+
+//******************************************************************************
+
+void ServerShard::acceptConnections() {
+   for (;;) {
+      const int fd = ::accept(m_listenFd, nullptr, nullptr);
+      if (fd < 0) {
+         if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+            TONNERRE_LOG_ERROR("unable to accept connection in server shard");
+         }
+         return;
+      }
+
+      // the listener is non-blocking but the request handlers read their
+      // messages with blocking reads
+      ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+
+      Socket* socket = new Socket(fd);
+      socket->setTcpNoDelay(true);
+      m_connections.push_back(new SocketRequest(socket, m_serviceHandler));
+      m_acceptCount.fetch_add(1, std::memory_order_relaxed);
+   }
+}
+
+//******************************************************************************
+
+bool ServerShard::serviceConnection(SocketRequest* request) {
+   // readable also covers the peer closing its end
+   char peekByte;
+   const ssize_t peeked =
+      ::recv(request->getSocketFD(), &peekByte, 1, MSG_PEEK | MSG_DONTWAIT);
+   if (peeked == 0) {
+      return false;
+   } else if (peeked < 0) {
+      return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+   }
+
+   try {
+      request->run();
+   } catch (const std::exception& e) {
+      TONNERRE_LOG_ERROR("exception caught in server shard: " + std::string(e.what()));
+      return false;
+   } catch (...) {
+      TONNERRE_LOG_ERROR("exception caught in server shard");
+      return false;
+   }
+
+   // the handler closes the socket itself once a connection is finished
+   // (e.g., when keep_alive_max_requests is reached)
+   return request->getSocket()->isOpen();
+}
+
+//******************************************************************************
+
+void ServerShard::closeConnections() {
+   for (SocketRequest* request : m_connections) {
+      delete request;
+   }
+   m_connections.clear();
+   m_connectionCount.store(0, std::memory_order_relaxed);
+
+   if (m_listenFd != -1) {
+      ::close(m_listenFd);
+      m_listenFd = -1;
+   }
+}
+
+//******************************************************************************
@@ -0,0 +1,117 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_SERVERSHARD_H
+#define TONNERRE_SERVERSHARD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SocketRequest.h"
+#include "SocketServiceHandler.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * ServerShard is one slice of a sharded server: its own listening socket
+ * (bound with SO_REUSEPORT, so the kernel spreads incoming connections
+ * across the shards' listeners) and a single thread, pinned to one core,
+ * that accepts on it, polls its connections, and runs their requests
+ * inline. A connection stays with the shard that accepted it for its whole
+ * life and no queue is shared between shards. Each time a connection is
+ * serviced it gets a handful of messages at most (see
+ * MessageRequestHandler), so a client that keeps sending can't starve the
+ * shard's other connections.
+ */
+class ServerShard
+{
+public:
+   /**
+    * Opens a listening socket bound with SO_REUSEPORT (used internally)
+    * @param port the port to listen on
+    * @return the listening socket's descriptor, or -1 on failure
+    */
+   static int openReusePortListener(int port);
+
+   /**
+    * Pins the calling thread to one core (Linux only; used internally)
+    * @param cpu the core to pin to (-1 for no pinning)
+    */
+   static void pinThreadToCpu(int cpu);
+
+   /**
+    * Constructs a shard (the listener is not opened until start())
+    * @param port the port to listen on (shared by all shards)
+    * @param serviceHandler the handler that services each readable
+    * connection (ownership passes to the shard)
+    * @param cpu the core to pin the shard's thread to (-1 for no pinning)
+    * @see MessageSocketServiceHandler()
+    */
+   ServerShard(int port, chaudiere::SocketServiceHandler* serviceHandler, int cpu);
+
+   /**
+    * Destructor (stops the shard and closes its connections)
+    */
+   ~ServerShard();
+
+   /**
+    * Opens the shard's listener and starts its thread
+    * @return boolean indicating whether the shard is listening
+    */
+   bool start();
+
+   /**
+    * Stops the shard's thread and closes its listener and connections
+    */
+   void stop();
+
+   /**
+    * Blocks until the shard's thread has stopped
+    */
+   void waitUntilStopped();
+
+   /**
+    * Retrieves the number of connections accepted by this shard
+    * @return number of accepted connections
+    */
+   std::uint64_t getAcceptCount() const;
+
+   /**
+    * Retrieves the number of connections currently open on this shard
+    * @return number of open connections
+    */
+   std::size_t getConnectionCount() const;
+
+private:
+   void run();
+   void acceptConnections();
+   bool serviceConnection(chaudiere::SocketRequest* request);
+   void closeConnections();
+
+   std::vector<chaudiere::SocketRequest*> m_connections;
+   chaudiere::SocketServiceHandler* m_serviceHandler;
+   std::thread m_thread;
+   std::mutex m_mutex;
+   std::condition_variable m_stoppedCond;
+   std::atomic<std::uint64_t> m_acceptCount;
+   std::atomic<std::size_t> m_connectionCount;
+   std::atomic<bool> m_isRunning;
+   const int m_port;
+   const int m_cpu;
+   int m_listenFd;
+   int m_wakePipe[2];
+   bool m_isStopped;
+
+   ServerShard(const ServerShard&);
+   ServerShard& operator=(const ServerShard&);
+};
+
+}
+
+#endif
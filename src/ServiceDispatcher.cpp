@@ -0,0 +1,137 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "ServiceDispatcher.h"
+#include "Message.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+//******************************************************************************
+
+ServiceDispatcher::ServiceDispatcher() :
+   m_defaultHandler(nullptr) {
+   TONNERRE_LOG_INSTANCE_CREATE("ServiceDispatcher");
+}
+
+//******************************************************************************
+
+ServiceDispatcher::~ServiceDispatcher() {
+   TONNERRE_LOG_INSTANCE_DESTROY("ServiceDispatcher");
+}
+
+//******************************************************************************
+
+void ServiceDispatcher::registerService(const std::string& serviceName,
+                                        MessageHandler* handler) {
+   if (handler == nullptr) {
+      m_mapServiceHandlers.erase(serviceName);
+      return;
+   }
+
+   m_mapServiceHandlers[serviceName] = handler;
+
+   if (m_defaultHandler == nullptr) {
+      m_defaultHandler = handler;
+   }
+}
+
+//******************************************************************************
+
+void ServiceDispatcher::setDefaultHandler(MessageHandler* handler) {
+   m_defaultHandler = handler;
+}
+
+//******************************************************************************
+
+MessageHandler* ServiceDispatcher::getDefaultHandler() const {
+   return m_defaultHandler;
+}
+
+//******************************************************************************
+
+MessageHandler* ServiceDispatcher::handlerForService(const std::string& serviceName) const {
+   if (!serviceName.empty()) {
+      auto it = m_mapServiceHandlers.find(serviceName);
+      if (it != m_mapServiceHandlers.end()) {
+         return it->second;
+      }
+   }
+
+   return m_defaultHandler;
+}
+
+//******************************************************************************
+
+bool ServiceDispatcher::hasService(const std::string& serviceName) const {
+   return m_mapServiceHandlers.find(serviceName) != m_mapServiceHandlers.end();
+}
+
+//******************************************************************************
+
+std::size_t ServiceDispatcher::getNumberServices() const {
+   return m_mapServiceHandlers.size();
+}
+
+//******************************************************************************
+
+void ServiceDispatcher::getServiceNames(std::vector<std::string>& serviceNames) const {
+   for (const auto& entry : m_mapServiceHandlers) {
+      serviceNames.push_back(entry.first);
+   }
+}
+
+//******************************************************************************
+
+MessageHandler* ServiceDispatcher::handlerForRequest(const Message& requestMessage) const {
+   MessageHandler* handler = handlerForService(requestMessage.getServiceName());
+   if (handler == nullptr) {
+      TONNERRE_LOG_ERROR("no handler for service '" +
+                    requestMessage.getServiceName() + "'");
+   }
+   return handler;
+}
+
+//******************************************************************************
+
+void ServiceDispatcher::handleTextMessage(const Message& requestMessage,
+                                          Message& responseMessage,
+                                          const std::string& requestName,
+                                          const std::string& requestPayload,
+                                          std::string& responsePayload) {
+   MessageHandler* handler = handlerForRequest(requestMessage);
+   if (handler != nullptr) {
+      handler->handleTextMessage(requestMessage,
+                                 responseMessage,
+                                 requestName,
+                                 requestPayload,
+                                 responsePayload);
+   }
+}
+
+//******************************************************************************
+
+void ServiceDispatcher::handleKeyValuesMessage(const Message& requestMessage,
+                                               Message& responseMessage,
+                                               const std::string& requestName,
+                                               const KeyValuePairs& requestPayload,
+                                               KeyValuePairs& responsePayload) {
+   MessageHandler* handler = handlerForRequest(requestMessage);
+   if (handler != nullptr) {
+      handler->handleKeyValuesMessage(requestMessage,
+                                      responseMessage,
+                                      requestName,
+                                      requestPayload,
+                                      responsePayload);
+   }
+}
+
+//******************************************************************************
+
+AsyncMessageHandler* ServiceDispatcher::asyncHandlerFor(const Message& requestMessage) {
+   MessageHandler* handler = handlerForService(requestMessage.getServiceName());
+   return (handler != nullptr) ? handler->asyncHandlerFor(requestMessage) : nullptr;
+}
+
+//******************************************************************************
@@ -0,0 +1,116 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_SERVICEDISPATCHER_H
+#define TONNERRE_SERVICEDISPATCHER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MessageHandler.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * ServiceDispatcher is the MessageHandler a MessagingServer hosting more
+ * than one service hands its requests to. Each request is forwarded to the
+ * handler registered for the service named in its header (set by the
+ * client's send); requests with no service name, or one that isn't
+ * registered, go to the default handler.
+ *
+ * Services must be registered before the server starts running -- lookups
+ * on the request path are not synchronized with registration.
+ */
+class ServiceDispatcher : public MessageHandler
+{
+public:
+   /**
+    * Default constructor
+    */
+   ServiceDispatcher();
+
+   /**
+    * Destructor
+    */
+   ~ServiceDispatcher();
+
+   /**
+    * Registers the handler for a service (replacing any existing one). The
+    * first handler registered also becomes the default handler unless one
+    * has been set explicitly.
+    * @param serviceName the name of the service
+    * @param handler the handler for the service's requests (not owned)
+    */
+   void registerService(const std::string& serviceName, MessageHandler* handler);
+
+   /**
+    * Sets the handler for requests that don't name a registered service
+    * @param handler the default handler (not owned)
+    */
+   void setDefaultHandler(MessageHandler* handler);
+
+   /**
+    * Retrieves the handler for requests that don't name a registered service
+    * @return the default handler (may be null)
+    */
+   MessageHandler* getDefaultHandler() const;
+
+   /**
+    * Retrieves the handler that a request for the service would be given to
+    * @param serviceName the name of the service
+    * @return the service's handler, or the default handler if the service isn't registered
+    */
+   MessageHandler* handlerForService(const std::string& serviceName) const;
+
+   /**
+    * Determines if a handler has been registered for the service
+    * @param serviceName the name of the service
+    * @return boolean indicating whether the service is registered
+    */
+   bool hasService(const std::string& serviceName) const;
+
+   /**
+    * Retrieves the number of registered services
+    * @return the number of services
+    */
+   std::size_t getNumberServices() const;
+
+   /**
+    * Retrieves the names of the registered services
+    * @param serviceNames the vector to populate with the names
+    */
+   void getServiceNames(std::vector<std::string>& serviceNames) const;
+
+   // MessageHandler
+   void handleTextMessage(const Message& requestMessage,
+                          Message& responseMessage,
+                          const std::string& requestName,
+                          const std::string& requestPayload,
+                          std::string& responsePayload) override;
+
+   void handleKeyValuesMessage(const Message& requestMessage,
+                               Message& responseMessage,
+                               const std::string& requestName,
+                               const chaudiere::KeyValuePairs& requestPayload,
+                               chaudiere::KeyValuePairs& responsePayload) override;
+
+   AsyncMessageHandler* asyncHandlerFor(const Message& requestMessage) override;
+
+private:
+   MessageHandler* handlerForRequest(const Message& requestMessage) const;
+
+   std::unordered_map<std::string, MessageHandler*> m_mapServiceHandlers;
+   MessageHandler* m_defaultHandler;
+
+   // disallow copies
+   ServiceDispatcher(const ServiceDispatcher&);
+   ServiceDispatcher& operator=(const ServiceDispatcher&);
+};
+
+}
+
+#endif
+
@@ -0,0 +1,194 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <stdlib.h>
+
+#include "ServiceOptions.h"
+#include "Logger.h"
+#include "StrUtils.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+static const std::string KEY_ASYNC               = "async";
+static const std::string KEY_ASYNC_BACKPRESSURE  = "async_backpressure";
+static const std::string KEY_ASYNC_BATCH_BYTES   = "async_batch_bytes";
+static const std::string KEY_ASYNC_LINGER_MS     = "async_linger_ms";
+static const std::string KEY_ASYNC_QUEUE_SIZE    = "async_queue_size";
+static const std::string KEY_TRACE_SAMPLE_RATE   = "trace_sample_rate";
+static const std::string KEY_TRANSPORT           = "transport";
+
+static const std::string VALUE_BLOCK             = "block";
+static const std::string VALUE_DROP_OLDEST       = "drop_oldest";
+static const std::string VALUE_FAIL              = "fail";
+static const std::string VALUE_SHM               = "shm";
+static const std::string VALUE_TCP               = "tcp";
+static const std::string VALUE_TRUE              = "true";
+static const std::string VALUE_UDP               = "udp";
+
+const std::size_t ServiceOptions::DEFAULT_ASYNC_QUEUE_SIZE   = 8192;
+const std::size_t ServiceOptions::DEFAULT_ASYNC_BATCH_BYTES  = 65536;
+const int ServiceOptions::DEFAULT_ASYNC_LINGER_MILLIS        = 5;
+
+//******************************************************************************
+
+ServiceOptions::ServiceOptions() :
+   m_asyncQueueSize(DEFAULT_ASYNC_QUEUE_SIZE),
+   m_asyncBatchBytes(DEFAULT_ASYNC_BATCH_BYTES),
+   m_asyncLingerMillis(DEFAULT_ASYNC_LINGER_MILLIS),
+   m_asyncBackpressure(BackpressureBlock),
+   m_traceSampleRate(0.0),
+   m_transport(TransportTcp),
+   m_asyncOneWay(false) {
+}
+
+//******************************************************************************
+
+void ServiceOptions::populate(const KeyValuePairs& kvp) {
+   if (kvp.hasKey(KEY_ASYNC)) {
+      m_asyncOneWay = (kvp.getValue(KEY_ASYNC) == VALUE_TRUE);
+   }
+
+   if (kvp.hasKey(KEY_ASYNC_QUEUE_SIZE)) {
+      const int queueSize = StrUtils::parseInt(kvp.getValue(KEY_ASYNC_QUEUE_SIZE));
+      if (queueSize > 0) {
+         m_asyncQueueSize = queueSize;
+      }
+   }
+
+   if (kvp.hasKey(KEY_ASYNC_BATCH_BYTES)) {
+      const int batchBytes = StrUtils::parseInt(kvp.getValue(KEY_ASYNC_BATCH_BYTES));
+      if (batchBytes > 0) {
+         m_asyncBatchBytes = batchBytes;
+      }
+   }
+
+   if (kvp.hasKey(KEY_ASYNC_LINGER_MS)) {
+      const int lingerMillis = StrUtils::parseInt(kvp.getValue(KEY_ASYNC_LINGER_MS));
+      if (lingerMillis >= 0) {
+         m_asyncLingerMillis = lingerMillis;
+      }
+   }
+
+   if (kvp.hasKey(KEY_ASYNC_BACKPRESSURE)) {
+      const std::string& policy = kvp.getValue(KEY_ASYNC_BACKPRESSURE);
+      if (policy == VALUE_BLOCK) {
+         m_asyncBackpressure = BackpressureBlock;
+      } else if (policy == VALUE_DROP_OLDEST) {
+         m_asyncBackpressure = BackpressureDropOldest;
+      } else if (policy == VALUE_FAIL) {
+         m_asyncBackpressure = BackpressureFail;
+      } else {
+         Logger::warning("unrecognized async_backpressure value: " + policy);
+      }
+   }
+
+   if (kvp.hasKey(KEY_TRACE_SAMPLE_RATE)) {
+      setTraceSampleRate(::strtod(kvp.getValue(KEY_TRACE_SAMPLE_RATE).c_str(), nullptr));
+   }
+
+   if (kvp.hasKey(KEY_TRANSPORT)) {
+      const std::string& transport = kvp.getValue(KEY_TRANSPORT);
+      if (transport == VALUE_TCP) {
+         m_transport = TransportTcp;
+      } else if (transport == VALUE_SHM) {
+         m_transport = TransportShm;
+      } else if (transport == VALUE_UDP) {
+         m_transport = TransportUdp;
+      } else {
+         Logger::warning("unrecognized transport value: " + transport);
+      }
+   }
+}
+
+//******************************************************************************
+
+bool ServiceOptions::isAsyncOneWay() const {
+   return m_asyncOneWay;
+}
+
+//******************************************************************************
+
+void ServiceOptions::setAsyncOneWay(bool asyncOneWay) {
+   m_asyncOneWay = asyncOneWay;
+}
+
+//******************************************************************************
+
+std::size_t ServiceOptions::getAsyncQueueSize() const {
+   return m_asyncQueueSize;
+}
+
+//******************************************************************************
+
+void ServiceOptions::setAsyncQueueSize(std::size_t queueSize) {
+   m_asyncQueueSize = queueSize;
+}
+
+//******************************************************************************
+
+std::size_t ServiceOptions::getAsyncBatchBytes() const {
+   return m_asyncBatchBytes;
+}
+
+//******************************************************************************
+
+void ServiceOptions::setAsyncBatchBytes(std::size_t batchBytes) {
+   m_asyncBatchBytes = batchBytes;
+}
+
+//******************************************************************************
+
+int ServiceOptions::getAsyncLingerMillis() const {
+   return m_asyncLingerMillis;
+}
+
+//******************************************************************************
+
+void ServiceOptions::setAsyncLingerMillis(int lingerMillis) {
+   m_asyncLingerMillis = lingerMillis;
+}
+
+//******************************************************************************
+
+BackpressurePolicy ServiceOptions::getAsyncBackpressure() const {
+   return m_asyncBackpressure;
+}
+
+//******************************************************************************
+
+void ServiceOptions::setAsyncBackpressure(BackpressurePolicy policy) {
+   m_asyncBackpressure = policy;
+}
+
+//******************************************************************************
+
+double ServiceOptions::getTraceSampleRate() const {
+   return m_traceSampleRate;
+}
+
+//******************************************************************************
+
+void ServiceOptions::setTraceSampleRate(double sampleRate) {
+   if (sampleRate < 0.0) {
+      m_traceSampleRate = 0.0;
+   } else if (sampleRate > 1.0) {
+      m_traceSampleRate = 1.0;
+   } else {
+      m_traceSampleRate = sampleRate;
+   }
+}
+
+//******************************************************************************
+
+Transport ServiceOptions::getTransport() const {
+   return m_transport;
+}
+
+//******************************************************************************
+
+void ServiceOptions::setTransport(Transport transport) {
+   m_transport = transport;
+}
+
+//******************************************************************************
@@ -0,0 +1,156 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_SERVICEOPTIONS_H
+#define TONNERRE_SERVICEOPTIONS_H
+
+#include <cstddef>
+#include <string>
+
+#include "KeyValuePairs.h"
+
+
+namespace tonnerre
+{
+
+enum BackpressurePolicy {
+   BackpressureBlock,
+   BackpressureDropOldest,
+   BackpressureFail
+};
+
+enum Transport {
+   TransportTcp,
+   TransportShm,
+   TransportUdp
+};
+
+/**
+ * ServiceOptions holds the tonnerre-specific settings of a service's
+ * configuration section (everything beyond the host/port/persistent values
+ * carried by ServiceInfo).
+ */
+class ServiceOptions
+{
+public:
+   static const std::size_t DEFAULT_ASYNC_QUEUE_SIZE;
+   static const std::size_t DEFAULT_ASYNC_BATCH_BYTES;
+   static const int DEFAULT_ASYNC_LINGER_MILLIS;
+
+   /**
+    * Default constructor
+    */
+   ServiceOptions();
+
+   /**
+    * Populates the options from a service's configuration section
+    * @param kvp the key/value pairs read from the service's section
+    * @see KeyValuePairs()
+    */
+   void populate(const chaudiere::KeyValuePairs& kvp);
+
+   /**
+    * Determines if one-way messages are handed off to a background sender
+    * (which needs the service's server to run with ingestion or keep-alive
+    * enabled)
+    * @return boolean indicating if one-way sends are asynchronous
+    */
+   bool isAsyncOneWay() const;
+
+   /**
+    * Sets whether one-way messages are handed off to a background sender
+    * @param asyncOneWay whether one-way sends should be asynchronous
+    */
+   void setAsyncOneWay(bool asyncOneWay);
+
+   /**
+    * Retrieves the maximum number of one-way messages queued for the sender
+    * @return capacity of the one-way message queue
+    */
+   std::size_t getAsyncQueueSize() const;
+
+   /**
+    * Sets the maximum number of one-way messages queued for the sender
+    * @param queueSize capacity of the one-way message queue
+    */
+   void setAsyncQueueSize(std::size_t queueSize);
+
+   /**
+    * Retrieves the number of bytes that triggers an immediate batch write
+    * @return batch size in bytes
+    */
+   std::size_t getAsyncBatchBytes() const;
+
+   /**
+    * Sets the number of bytes that triggers an immediate batch write
+    * @param batchBytes batch size in bytes
+    */
+   void setAsyncBatchBytes(std::size_t batchBytes);
+
+   /**
+    * Retrieves how long a partial batch may wait for more messages
+    * @return linger time in milliseconds
+    */
+   int getAsyncLingerMillis() const;
+
+   /**
+    * Sets how long a partial batch may wait for more messages
+    * @param lingerMillis linger time in milliseconds
+    */
+   void setAsyncLingerMillis(int lingerMillis);
+
+   /**
+    * Retrieves what happens to a one-way send when the queue is full
+    * @return the backpressure policy
+    */
+   BackpressurePolicy getAsyncBackpressure() const;
+
+   /**
+    * Sets what happens to a one-way send when the queue is full
+    * @param policy the backpressure policy
+    */
+   void setAsyncBackpressure(BackpressurePolicy policy);
+
+   /**
+    * Retrieves the fraction of requests to the service that are traced
+    * @return sample rate between 0 (none) and 1 (every request)
+    * @see RequestTrace()
+    */
+   double getTraceSampleRate() const;
+
+   /**
+    * Sets the fraction of requests to the service that are traced
+    * @param sampleRate sample rate between 0 (none) and 1 (every request)
+    */
+   void setTraceSampleRate(double sampleRate);
+
+   /**
+    * Retrieves how messages reach the service
+    * @return the transport (TransportShm for a server on the same host
+    * serving a shared memory segment; TCP is used whenever that segment
+    * isn't available. TransportUdp sends one-way messages that fit in a
+    * datagram as datagrams, and everything else over TCP)
+    * @see ShmClient()
+    * @see UdpSender()
+    */
+   Transport getTransport() const;
+
+   /**
+    * Sets how messages reach the service
+    * @param transport the transport
+    */
+   void setTransport(Transport transport);
+
+private:
+   std::size_t m_asyncQueueSize;
+   std::size_t m_asyncBatchBytes;
+   int m_asyncLingerMillis;
+   BackpressurePolicy m_asyncBackpressure;
+   double m_traceSampleRate;
+   Transport m_transport;
+   bool m_asyncOneWay;
+};
+
+}
+
+#endif
@@ -0,0 +1,240 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <thread>
+#include <unistd.h>
+
+#include "ShmClient.h"
+#include "Message.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+// how many times a waiting side looks again before sleeping on the futex
+static const int SPIN_ITERATIONS  = 200;
+
+// how long a sleep lasts before the server is checked on
+static const int WAIT_MILLIS      = 100;
+
+//******************************************************************************
+
+ShmClient::ShmClient(const std::string& segmentName) :
+   m_isBroken(false),
+   m_pid((std::int32_t) ::getpid()) {
+   TONNERRE_LOG_INSTANCE_CREATE("ShmClient");
+
+   m_segment.attach(segmentName);
+}
+
+//******************************************************************************
+
+ShmClient::~ShmClient() {
+   TONNERRE_LOG_INSTANCE_DESTROY("ShmClient");
+
+   if (m_segment.isMapped()) {
+      for (std::uint32_t index : m_claimedChannels) {
+         releaseChannel(index);
+      }
+   }
+}
+
+//******************************************************************************
+
+bool ShmClient::isServing() const {
+   return m_segment.isMapped() && !m_isBroken.load() &&
+          (m_segment.header()->isServing.load() != 0);
+}
+
+//******************************************************************************
+
+std::size_t ShmClient::getMaxFrameLength() const {
+   return m_segment.isMapped() ? m_segment.getMaxFrameLength() : 0;
+}
+
+//******************************************************************************
+
+bool ShmClient::call(const std::string& requestFrame,
+                     std::string& responseFrame,
+                     bool& isSent) {
+   isSent = false;
+   std::uint32_t index = 0;
+   if (!isServing() || !claimChannel(index)) {
+      return false;
+   }
+
+   isSent = push(index, requestFrame);
+   if (!isSent || !awaitResponse(index, responseFrame)) {
+      // whatever is left in the channel is the server's to clean up
+      std::lock_guard<std::mutex> lock(m_mutex);
+      releaseChannel(index);
+      return false;
+   }
+
+   returnChannel(index);
+   return true;
+}
+
+//******************************************************************************
+
+bool ShmClient::sendOneWay(const std::string& requestFrame) {
+   std::uint32_t index = 0;
+   if (!isServing() || !claimChannel(index)) {
+      return false;
+   }
+
+   const bool isSent = push(index, requestFrame);
+   returnChannel(index);
+   return isSent;
+}
+
+//******************************************************************************
+
+bool ShmClient::claimChannel(std::uint32_t& index) {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   if (!m_idleChannels.empty()) {
+      index = m_idleChannels.back();
+      m_idleChannels.pop_back();
+      return true;
+   }
+
+   const std::uint32_t numberChannels = m_segment.getNumberChannels();
+   for (std::uint32_t i = 0; i < numberChannels; ++i) {
+      ShmSegment::Channel* channel = m_segment.channel(i);
+      std::uint32_t expected = ShmSegment::ChannelFree;
+      if (channel->state.compare_exchange_strong(expected, ShmSegment::ChannelInUse)) {
+         channel->ownerPid.store(m_pid);
+         m_claimedChannels.push_back(i);
+         index = i;
+         return true;
+      }
+   }
+
+   TONNERRE_LOG_WARNING("no free shared memory channels");
+   return false;
+}
+
+//******************************************************************************
+
+void ShmClient::returnChannel(std::uint32_t index) {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   m_idleChannels.push_back(index);
+}
+
+//******************************************************************************
+
+void ShmClient::releaseChannel(std::uint32_t index) {
+   // (called with the mutex held, or from the destructor)
+   for (std::size_t i = 0; i < m_claimedChannels.size(); ++i) {
+      if (m_claimedChannels[i] == index) {
+         m_claimedChannels.erase(m_claimedChannels.begin() + i);
+         break;
+      }
+   }
+
+   // the server may have released the channel already (and another client
+   // claimed it since), so only a channel this process still holds is
+   // handed back
+   ShmSegment::Channel* channel = m_segment.channel(index);
+   std::uint32_t expected = ShmSegment::ChannelInUse;
+   if ((channel->ownerPid.load() != m_pid) ||
+       !channel->state.compare_exchange_strong(expected, ShmSegment::ChannelReleased)) {
+      return;
+   }
+
+   ShmSegment::Header* header = m_segment.header();
+   ShmSegment::notify(&header->doorbell, &header->serverSleeping);
+}
+
+//******************************************************************************
+
+bool ShmClient::push(std::uint32_t index, const std::string& requestFrame) {
+   if (requestFrame.length() > m_segment.getMaxFrameLength()) {
+      return false;
+   }
+
+   ShmSegment::Header* header = m_segment.header();
+   ShmRing ring = m_segment.requestRing(index);
+
+   // (only one-way requests can fill the ring; the server is draining it)
+   for (int attempts = 1; !ring.push(requestFrame); ++attempts) {
+      if (((attempts % SPIN_ITERATIONS) == 0) && !isServerAlive()) {
+         return false;
+      }
+      std::this_thread::yield();
+   }
+
+   ShmSegment::notify(&header->doorbell, &header->serverSleeping);
+   return true;
+}
+
+//******************************************************************************
+
+bool ShmClient::awaitResponse(std::uint32_t index, std::string& responseFrame) {
+   if (!awaitFrame(index, responseFrame)) {
+      return false;
+   } else if (!responseFrame.empty()) {
+      return true;
+   }
+
+   // an empty frame announces a response too large for the ring; it
+   // follows in pieces, and its own length says when it's all here
+   std::string piece;
+   for (;;) {
+      if (!awaitFrame(index, piece)) {
+         return false;
+      }
+
+      responseFrame += piece;
+      const std::size_t length = Message::frameLength(responseFrame);
+      if (length == std::string::npos) {
+         TONNERRE_LOG_ERROR("malformed response received over shared memory");
+         return false;
+      } else if ((length > 0) && (responseFrame.length() >= length)) {
+         return true;
+      }
+   }
+}
+
+//******************************************************************************
+
+bool ShmClient::awaitFrame(std::uint32_t index, std::string& frame) {
+   ShmSegment::Channel* channel = m_segment.channel(index);
+   ShmRing ring = m_segment.responseRing(index);
+
+   for (int spins = 0; ; ++spins) {
+      const std::uint32_t seen = channel->responseSignal.load();
+      if (ring.pop(frame)) {
+         return true;
+      }
+
+      if (spins < SPIN_ITERATIONS) {
+         std::this_thread::yield();
+         continue;
+      }
+
+      ShmSegment::await(&channel->responseSignal, &channel->clientSleeping,
+                        seen, WAIT_MILLIS);
+
+      // a quiet wait means a slow handler -- or a server that has gone
+      if ((channel->responseSignal.load() == seen) &&
+          ((channel->state.load() != ShmSegment::ChannelInUse) || !isServerAlive())) {
+         return ring.pop(frame);
+      }
+   }
+}
+
+//******************************************************************************
+
+bool ShmClient::isServerAlive() const {
+   const ShmSegment::Header* header = m_segment.header();
+   if ((header->isServing.load() == 0) ||
+       !ShmSegment::isProcessAlive(header->serverPid.load())) {
+      m_isBroken.store(true);
+      return false;
+   }
+
+   return true;
+}
+
+//******************************************************************************
@@ -0,0 +1,102 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_SHMCLIENT_H
+#define TONNERRE_SHMCLIENT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ShmSegment.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * ShmClient sends encoded messages to a server on the same host through
+ * the server's shared memory segment (services configured with
+ * 'transport = shm'). Each calling thread borrows one of the channels the
+ * client has claimed, so a channel only ever has one request in flight;
+ * channels are claimed as concurrent callers need them and given back to
+ * the server when the client is destroyed (or, should the process die,
+ * reclaimed by the server).
+ * @see ShmSegment()
+ * @see ShmServer()
+ */
+class ShmClient
+{
+public:
+   /**
+    * Attaches to a server's segment
+    * @param segmentName the name of the segment
+    * @see ShmSegment::nameForPort()
+    */
+   explicit ShmClient(const std::string& segmentName);
+
+   /**
+    * Destructor (releases the client's channels)
+    */
+   ~ShmClient();
+
+   /**
+    * Determines if the segment is attached and its server is still serving
+    * it
+    * @return boolean indicating if requests can be sent
+    */
+   bool isServing() const;
+
+   /**
+    * Retrieves the largest encoded message that can be sent
+    * @return the largest frame length (0 if not attached)
+    */
+   std::size_t getMaxFrameLength() const;
+
+   /**
+    * Sends a request and waits for its response
+    * @param requestFrame the encoded request
+    * @param responseFrame set to the encoded response
+    * @param isSent set to indicate if the request reached the segment (if
+    * not -- no channel was free, or the server had stopped -- it can safely
+    * be sent another way)
+    * @return boolean indicating if a response was received
+    */
+   bool call(const std::string& requestFrame,
+             std::string& responseFrame,
+             bool& isSent);
+
+   /**
+    * Sends a one-way request (the server doesn't respond)
+    * @param requestFrame the encoded request
+    * @return boolean indicating if the request was handed to the server
+    * (if not, it can safely be sent another way)
+    */
+   bool sendOneWay(const std::string& requestFrame);
+
+private:
+   bool claimChannel(std::uint32_t& index);
+   void returnChannel(std::uint32_t index);
+   void releaseChannel(std::uint32_t index);
+   bool push(std::uint32_t index, const std::string& requestFrame);
+   bool awaitResponse(std::uint32_t index, std::string& responseFrame);
+   bool awaitFrame(std::uint32_t index, std::string& frame);
+   bool isServerAlive() const;
+
+   ShmSegment m_segment;
+   std::vector<std::uint32_t> m_idleChannels;
+   std::vector<std::uint32_t> m_claimedChannels;
+   std::mutex m_mutex;
+   mutable std::atomic<bool> m_isBroken;
+   std::int32_t m_pid;
+
+   ShmClient(const ShmClient&);
+   ShmClient& operator=(const ShmClient&);
+};
+
+}
+
+#endif
@@ -0,0 +1,105 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <algorithm>
+#include <cstring>
+
+#include "ShmRing.h"
+
+using namespace tonnerre;
+
+static const std::size_t LENGTH_PREFIX_BYTES = sizeof(std::uint32_t);
+
+//******************************************************************************
+
+std::size_t ShmRing::maxFrameLength(std::uint32_t capacity) {
+   return capacity - LENGTH_PREFIX_BYTES;
+}
+
+//******************************************************************************
+
+ShmRing::ShmRing(std::atomic<std::uint64_t>* head,
+                 std::atomic<std::uint64_t>* tail,
+                 char* buffer,
+                 std::uint32_t capacity) :
+   m_head(head),
+   m_tail(tail),
+   m_buffer(buffer),
+   m_capacity(capacity) {
+}
+
+//******************************************************************************
+
+bool ShmRing::push(const std::string& frame) {
+   const std::size_t recordLength = LENGTH_PREFIX_BYTES + frame.length();
+   const std::uint64_t tail = m_tail->load(std::memory_order_relaxed);
+   const std::uint64_t head = m_head->load(std::memory_order_acquire);
+   if (recordLength > m_capacity - (tail - head)) {
+      return false;
+   }
+
+   const std::uint32_t frameLength = (std::uint32_t) frame.length();
+   copyIn(tail, (const char*) &frameLength, LENGTH_PREFIX_BYTES);
+   copyIn(tail + LENGTH_PREFIX_BYTES, frame.data(), frame.length());
+   m_tail->store(tail + recordLength, std::memory_order_release);
+   return true;
+}
+
+//******************************************************************************
+
+bool ShmRing::pop(std::string& frame) {
+   const std::uint64_t head = m_head->load(std::memory_order_relaxed);
+   const std::uint64_t tail = m_tail->load(std::memory_order_acquire);
+   if (head == tail) {
+      return false;
+   }
+
+   std::uint32_t frameLength = 0;
+   copyOut(head, (char*) &frameLength, LENGTH_PREFIX_BYTES);
+
+   // the other side is another process; a length it couldn't have pushed
+   // means the ring is corrupt, so nothing in it can be trusted
+   if ((frameLength > maxFrameLength(m_capacity)) ||
+       (LENGTH_PREFIX_BYTES + frameLength > tail - head)) {
+      m_head->store(tail, std::memory_order_release);
+      return false;
+   }
+
+   frame.resize(frameLength);
+   copyOut(head + LENGTH_PREFIX_BYTES, &frame[0], frameLength);
+   m_head->store(head + LENGTH_PREFIX_BYTES + frameLength, std::memory_order_release);
+   return true;
+}
+
+//******************************************************************************
+
+bool ShmRing::isEmpty() const {
+   return m_head->load(std::memory_order_acquire) ==
+          m_tail->load(std::memory_order_acquire);
+}
+
+//******************************************************************************
+
+void ShmRing::clear() {
+   m_head->store(m_tail->load(std::memory_order_acquire), std::memory_order_release);
+}
+
+//******************************************************************************
+
+void ShmRing::copyIn(std::uint64_t position, const char* bytes, std::size_t length) {
+   const std::size_t offset = position & (m_capacity - 1);
+   const std::size_t firstPart = std::min(length, (std::size_t) m_capacity - offset);
+   std::memcpy(m_buffer + offset, bytes, firstPart);
+   std::memcpy(m_buffer, bytes + firstPart, length - firstPart);
+}
+
+//******************************************************************************
+
+void ShmRing::copyOut(std::uint64_t position, char* bytes, std::size_t length) const {
+   const std::size_t offset = position & (m_capacity - 1);
+   const std::size_t firstPart = std::min(length, (std::size_t) m_capacity - offset);
+   std::memcpy(bytes, m_buffer + offset, firstPart);
+   std::memcpy(bytes + firstPart, m_buffer, length - firstPart);
+}
+
+//******************************************************************************
@@ -0,0 +1,85 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_SHMRING_H
+#define TONNERRE_SHMRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace tonnerre
+{
+
+/**
+ * ShmRing is a view of a single-producer, single-consumer ring of
+ * length-prefixed frames whose positions and bytes live in shared memory
+ * (so the producer and consumer may be in different processes). The
+ * positions only ever increase; a frame may wrap around the end of the
+ * buffer. The ring owns nothing -- ShmSegment lays the memory out.
+ * @see ShmSegment()
+ */
+class ShmRing
+{
+public:
+   /**
+    * Retrieves the largest frame a ring can hold
+    * @param capacity the size of the ring's buffer in bytes
+    * @return the largest frame length
+    */
+   static std::size_t maxFrameLength(std::uint32_t capacity);
+
+   /**
+    * Constructs a view of a ring
+    * @param head the consumer's position
+    * @param tail the producer's position
+    * @param buffer the ring's bytes
+    * @param capacity the size of the buffer (a power of 2)
+    */
+   ShmRing(std::atomic<std::uint64_t>* head,
+           std::atomic<std::uint64_t>* tail,
+           char* buffer,
+           std::uint32_t capacity);
+
+   /**
+    * Appends a frame (producer only)
+    * @param frame the frame to append
+    * @return boolean indicating if the frame was appended (false if there
+    * isn't room for it now)
+    */
+   bool push(const std::string& frame);
+
+   /**
+    * Removes the oldest frame (consumer only)
+    * @param frame set to the frame
+    * @return boolean indicating if there was a frame (false, with the ring
+    * emptied, if its length is more than the ring holds)
+    */
+   bool pop(std::string& frame);
+
+   /**
+    * Determines if the ring holds no frames
+    * @return boolean indicating if the ring is empty
+    */
+   bool isEmpty() const;
+
+   /**
+    * Discards every frame (only when neither side is using the ring)
+    */
+   void clear();
+
+private:
+   void copyIn(std::uint64_t position, const char* bytes, std::size_t length);
+   void copyOut(std::uint64_t position, char* bytes, std::size_t length) const;
+
+   std::atomic<std::uint64_t>* m_head;
+   std::atomic<std::uint64_t>* m_tail;
+   char* m_buffer;
+   std::uint32_t m_capacity;
+};
+
+}
+
+#endif
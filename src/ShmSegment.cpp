@@ -0,0 +1,292 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include <chrono>
+#include <new>
+#include <thread>
+
+#include "ShmSegment.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+static const std::uint32_t SEGMENT_MAGIC   = 0x544e5253;  // 'TNRS'
+static const std::uint32_t SEGMENT_VERSION = 1;
+static const std::uint32_t MIN_RING_BYTES  = 4096;
+static const std::string SEGMENT_PREFIX    = "/tonnerre-";
+
+static const int REQUEST_RING              = 0;
+static const int RESPONSE_RING             = 1;
+
+const std::uint32_t ShmSegment::DEFAULT_NUMBER_CHANNELS = 64;
+const std::uint32_t ShmSegment::DEFAULT_RING_BYTES      = 65536;
+
+//******************************************************************************
+
+std::string ShmSegment::nameForPort(int port) {
+   return SEGMENT_PREFIX + std::to_string(port);
+}
+
+//******************************************************************************
+
+void ShmSegment::futexWait(std::atomic<std::uint32_t>* word,
+                           std::uint32_t expected,
+                           int timeoutMillis) {
+#if defined(__linux__)
+   // (not FUTEX_PRIVATE_FLAG -- the word is shared between processes)
+   struct timespec timeout;
+   timeout.tv_sec = timeoutMillis / 1000;
+   timeout.tv_nsec = (timeoutMillis % 1000) * 1000000L;
+   ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word),
+             FUTEX_WAIT, expected, &timeout, nullptr, 0);
+#else
+   if (word->load() == expected) {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+   }
+#endif
+}
+
+//******************************************************************************
+
+void ShmSegment::futexWake(std::atomic<std::uint32_t>* word) {
+#if defined(__linux__)
+   ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word),
+             FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+#else
+   (void) word;
+#endif
+}
+
+//******************************************************************************
+
+void ShmSegment::notify(std::atomic<std::uint32_t>* signal,
+                        std::atomic<std::uint32_t>* sleeping) {
+   // the bump and the check pair with await()'s store and re-check, so a
+   // waiter either sees the new value or is seen to be sleeping
+   signal->fetch_add(1);
+   if (sleeping->load() != 0) {
+      futexWake(signal);
+   }
+}
+
+//******************************************************************************
+
+void ShmSegment::await(std::atomic<std::uint32_t>* signal,
+                       std::atomic<std::uint32_t>* sleeping,
+                       std::uint32_t seen,
+                       int timeoutMillis) {
+   sleeping->store(1);
+   if (signal->load() == seen) {
+      futexWait(signal, seen, timeoutMillis);
+   }
+   sleeping->store(0);
+}
+
+//******************************************************************************
+
+bool ShmSegment::isProcessAlive(std::int32_t pid) {
+   return (pid > 0) && ((::kill(pid, 0) == 0) || (errno == EPERM));
+}
+
+//******************************************************************************
+
+ShmSegment::ShmSegment() :
+   m_base(nullptr),
+   m_length(0),
+   m_channelBytes(0),
+   m_isOwner(false) {
+   TONNERRE_LOG_INSTANCE_CREATE("ShmSegment");
+}
+
+//******************************************************************************
+
+ShmSegment::~ShmSegment() {
+   TONNERRE_LOG_INSTANCE_DESTROY("ShmSegment");
+
+   unlink();
+
+   if (m_base != nullptr) {
+      ::munmap(m_base, m_length);
+   }
+}
+
+//******************************************************************************
+
+bool ShmSegment::create(const std::string& name,
+                        std::uint32_t numberChannels,
+                        std::uint32_t ringBytes) {
+   std::uint32_t capacity = MIN_RING_BYTES;
+   while (capacity < ringBytes) {
+      capacity <<= 1;
+   }
+
+   // a segment left behind by a server that didn't stop cleanly is replaced
+   ::shm_unlink(name.c_str());
+
+   const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+   if (fd < 0) {
+      TONNERRE_LOG_ERROR("unable to create shared memory segment " + name);
+      return false;
+   }
+
+   const std::size_t channelBytes = sizeof(Channel) + 2 * (std::size_t) capacity;
+   const std::size_t length = sizeof(Header) + numberChannels * channelBytes;
+   if ((::ftruncate(fd, (off_t) length) != 0) || !map(fd, length)) {
+      TONNERRE_LOG_ERROR("unable to size shared memory segment " + name);
+      ::close(fd);
+      ::shm_unlink(name.c_str());
+      return false;
+   }
+   ::close(fd);
+
+   m_name = name;
+   m_isOwner = true;
+   m_channelBytes = channelBytes;
+
+   // (the pages are zero-filled, which is every counter's starting value)
+   Header* segmentHeader = new (m_base) Header;
+   segmentHeader->version = SEGMENT_VERSION;
+   segmentHeader->numberChannels = numberChannels;
+   segmentHeader->ringBytes = capacity;
+   for (std::uint32_t i = 0; i < numberChannels; ++i) {
+      new (m_base + sizeof(Header) + i * channelBytes) Channel;
+   }
+   segmentHeader->serverPid.store((std::int32_t) ::getpid());
+
+   // written last: a client that sees the magic sees a complete layout
+   std::atomic_thread_fence(std::memory_order_release);
+   segmentHeader->magic = SEGMENT_MAGIC;
+
+   return true;
+}
+
+//******************************************************************************
+
+bool ShmSegment::attach(const std::string& name) {
+   const int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+   if (fd < 0) {
+      return false;
+   }
+
+   struct stat info;
+   if ((::fstat(fd, &info) != 0) || (info.st_size < (off_t) sizeof(Header)) ||
+       !map(fd, (std::size_t) info.st_size)) {
+      ::close(fd);
+      return false;
+   }
+   ::close(fd);
+
+   const Header* segmentHeader = header();
+   std::atomic_thread_fence(std::memory_order_acquire);
+   const std::size_t channelBytes =
+      sizeof(Channel) + 2 * (std::size_t) segmentHeader->ringBytes;
+   if ((segmentHeader->magic != SEGMENT_MAGIC) ||
+       (segmentHeader->version != SEGMENT_VERSION) ||
+       (sizeof(Header) + segmentHeader->numberChannels * channelBytes > m_length)) {
+      TONNERRE_LOG_WARNING("incompatible shared memory segment " + name);
+      ::munmap(m_base, m_length);
+      m_base = nullptr;
+      m_length = 0;
+      return false;
+   }
+
+   m_name = name;
+   m_channelBytes = channelBytes;
+   return true;
+}
+
+//******************************************************************************
+
+void ShmSegment::unlink() {
+   if (m_isOwner) {
+      ::shm_unlink(m_name.c_str());
+      m_isOwner = false;
+   }
+}
+
+//******************************************************************************
+
+bool ShmSegment::isMapped() const {
+   return m_base != nullptr;
+}
+
+//******************************************************************************
+
+ShmSegment::Header* ShmSegment::header() const {
+   return reinterpret_cast<Header*>(m_base);
+}
+
+//******************************************************************************
+
+ShmSegment::Channel* ShmSegment::channel(std::uint32_t index) const {
+   return reinterpret_cast<Channel*>(m_base + sizeof(Header) + index * m_channelBytes);
+}
+
+//******************************************************************************
+
+ShmRing ShmSegment::requestRing(std::uint32_t index) const {
+   Channel* segmentChannel = channel(index);
+   return ShmRing(&segmentChannel->requestHead,
+                  &segmentChannel->requestTail,
+                  ringBuffer(index, REQUEST_RING),
+                  header()->ringBytes);
+}
+
+//******************************************************************************
+
+ShmRing ShmSegment::responseRing(std::uint32_t index) const {
+   Channel* segmentChannel = channel(index);
+   return ShmRing(&segmentChannel->responseHead,
+                  &segmentChannel->responseTail,
+                  ringBuffer(index, RESPONSE_RING),
+                  header()->ringBytes);
+}
+
+//******************************************************************************
+
+std::uint32_t ShmSegment::getNumberChannels() const {
+   return header()->numberChannels;
+}
+
+//******************************************************************************
+
+std::size_t ShmSegment::getMaxFrameLength() const {
+   return ShmRing::maxFrameLength(header()->ringBytes);
+}
+
+//******************************************************************************
+
+bool ShmSegment::map(int fd, std::size_t length) {
+   void* base = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (base == MAP_FAILED) {
+      return false;
+   }
+
+   m_base = static_cast<char*>(base);
+   m_length = length;
+   return true;
+}
+
+//******************************************************************************
+
+char* ShmSegment::ringBuffer(std::uint32_t index, int ring) const {
+   return reinterpret_cast<char*>(channel(index)) + sizeof(Channel) +
+          ring * (std::size_t) header()->ringBytes;
+}
+
+//******************************************************************************
@@ -0,0 +1,213 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_SHMSEGMENT_H
+#define TONNERRE_SHMSEGMENT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "ShmRing.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * ShmSegment maps the POSIX shared memory segment that a messaging server
+ * serves same-host clients from. The segment is divided into channels; a
+ * client claims a channel and owns it until it exits, so each channel's
+ * request ring has a single producer (the client) and its response ring a
+ * single consumer (the client), with the server's thread on the other side
+ * of both. Clients ring a shared doorbell after each request and the
+ * server rings the channel's own signal after each response; either side
+ * sleeps on a futex only after spinning briefly.
+ * @see ShmRing()
+ * @see ShmServer()
+ * @see ShmClient()
+ */
+class ShmSegment
+{
+public:
+   enum ChannelState {
+      ChannelFree,
+      ChannelInUse,
+      ChannelReleased
+   };
+
+   struct alignas(64) Header {
+      std::uint32_t magic;
+      std::uint32_t version;
+      std::uint32_t numberChannels;
+      std::uint32_t ringBytes;
+      std::atomic<std::uint32_t> isServing;
+      std::atomic<std::int32_t> serverPid;
+      alignas(64) std::atomic<std::uint32_t> doorbell;
+      std::atomic<std::uint32_t> serverSleeping;
+   };
+
+   struct alignas(64) Channel {
+      std::atomic<std::uint32_t> state;
+      std::atomic<std::int32_t> ownerPid;
+      alignas(64) std::atomic<std::uint64_t> requestHead;
+      alignas(64) std::atomic<std::uint64_t> requestTail;
+      alignas(64) std::atomic<std::uint64_t> responseHead;
+      alignas(64) std::atomic<std::uint64_t> responseTail;
+      alignas(64) std::atomic<std::uint32_t> responseSignal;
+      std::atomic<std::uint32_t> clientSleeping;
+   };
+
+   static const std::uint32_t DEFAULT_NUMBER_CHANNELS;
+   static const std::uint32_t DEFAULT_RING_BYTES;
+
+   /**
+    * Retrieves the name of the segment served alongside a port
+    * @param port the port the server listens on
+    * @return the segment name (e.g., '/tonnerre-9000')
+    */
+   static std::string nameForPort(int port);
+
+   /**
+    * Waits for a shared futex word to change from an expected value
+    * @param word the futex word
+    * @param expected the value the word is expected to hold
+    * @param timeoutMillis the longest to wait
+    */
+   static void futexWait(std::atomic<std::uint32_t>* word,
+                         std::uint32_t expected,
+                         int timeoutMillis);
+
+   /**
+    * Wakes every process waiting on a shared futex word
+    * @param word the futex word
+    */
+   static void futexWake(std::atomic<std::uint32_t>* word);
+
+   /**
+    * Signals the other side after publishing to a ring: bumps the signal
+    * word and wakes the other side only if it has gone to sleep
+    * @param signal the signal word
+    * @param sleeping the other side's sleeping flag
+    */
+   static void notify(std::atomic<std::uint32_t>* signal,
+                      std::atomic<std::uint32_t>* sleeping);
+
+   /**
+    * Sleeps until the signal word moves on from the value seen before the
+    * ring was last found empty (or the timeout passes)
+    * @param signal the signal word
+    * @param sleeping this side's sleeping flag
+    * @param seen the signal value read before checking the ring
+    * @param timeoutMillis the longest to sleep
+    */
+   static void await(std::atomic<std::uint32_t>* signal,
+                     std::atomic<std::uint32_t>* sleeping,
+                     std::uint32_t seen,
+                     int timeoutMillis);
+
+   /**
+    * Determines if a process is still running
+    * @param pid the process id
+    * @return boolean indicating if the process exists
+    */
+   static bool isProcessAlive(std::int32_t pid);
+
+   /**
+    * Constructs an unmapped segment
+    */
+   ShmSegment();
+
+   /**
+    * Destructor (unmaps the segment, and removes it if it was created here)
+    */
+   ~ShmSegment();
+
+   /**
+    * Creates (replacing any left behind by an earlier server) and maps a
+    * segment
+    * @param name the segment name
+    * @param numberChannels the number of channels
+    * @param ringBytes the size of each ring (rounded up to a power of 2)
+    * @return boolean indicating if the segment was created
+    */
+   bool create(const std::string& name,
+               std::uint32_t numberChannels,
+               std::uint32_t ringBytes);
+
+   /**
+    * Maps an existing segment
+    * @param name the segment name
+    * @return boolean indicating if the segment was found and is valid
+    */
+   bool attach(const std::string& name);
+
+   /**
+    * Removes the segment's name so that no further clients can attach
+    * (only for a segment created here)
+    */
+   void unlink();
+
+   /**
+    * Determines if a segment is mapped
+    * @return boolean indicating if the segment is mapped
+    */
+   bool isMapped() const;
+
+   /**
+    * Retrieves the segment's header
+    * @return the header
+    */
+   Header* header() const;
+
+   /**
+    * Retrieves one of the segment's channels
+    * @param index the channel's index
+    * @return the channel
+    */
+   Channel* channel(std::uint32_t index) const;
+
+   /**
+    * Retrieves the ring carrying a channel's requests to the server
+    * @param index the channel's index
+    * @return the request ring
+    */
+   ShmRing requestRing(std::uint32_t index) const;
+
+   /**
+    * Retrieves the ring carrying a channel's responses to the client
+    * @param index the channel's index
+    * @return the response ring
+    */
+   ShmRing responseRing(std::uint32_t index) const;
+
+   /**
+    * Retrieves the number of channels
+    * @return the number of channels
+    */
+   std::uint32_t getNumberChannels() const;
+
+   /**
+    * Retrieves the largest frame a ring can carry
+    * @return the largest frame length
+    */
+   std::size_t getMaxFrameLength() const;
+
+private:
+   bool map(int fd, std::size_t length);
+   char* ringBuffer(std::uint32_t index, int ring) const;
+
+   std::string m_name;
+   char* m_base;
+   std::size_t m_length;
+   std::size_t m_channelBytes;
+   bool m_isOwner;
+
+   ShmSegment(const ShmSegment&);
+   ShmSegment& operator=(const ShmSegment&);
+};
+
+}
+
+#endif
@@ -0,0 +1,341 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <chrono>
+
+#include "ShmServer.h"
+#include "Message.h"
+#include "MessageRequestHandler.h"
+#include "ResponseQueue.h"
+#include "ServerOptions.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+// how many empty passes over the channels before sleeping on the doorbell
+static const int SPIN_ITERATIONS        = 200;
+
+// how often channels are checked for owners that died holding them
+static const int REAP_INTERVAL_MILLIS   = 1000;
+
+//******************************************************************************
+
+ShmServer::ShmServer(int port,
+                     MessageHandler* handler,
+                     const ServerOptions* serverOptions) :
+   m_segmentName(ShmSegment::nameForPort(port)),
+   m_handler(handler),
+   m_serverOptions(serverOptions),
+   m_admissionController(nullptr),
+   m_metrics(nullptr),
+   m_requestCount(0),
+   m_isRunning(false) {
+   TONNERRE_LOG_INSTANCE_CREATE("ShmServer");
+}
+
+//******************************************************************************
+
+ShmServer::~ShmServer() {
+   TONNERRE_LOG_INSTANCE_DESTROY("ShmServer");
+
+   stop();
+}
+
+//******************************************************************************
+
+void ShmServer::setAdmissionController(AdmissionController* admissionController) {
+   m_admissionController = admissionController;
+}
+
+//******************************************************************************
+
+void ShmServer::setServerMetrics(ServerMetrics* metrics) {
+   m_metrics = metrics;
+}
+
+//******************************************************************************
+
+bool ShmServer::start() {
+   const std::uint32_t numberChannels = (m_serverOptions != nullptr) ?
+      m_serverOptions->getShmChannels() : ShmSegment::DEFAULT_NUMBER_CHANNELS;
+   const std::uint32_t ringBytes = (m_serverOptions != nullptr) ?
+      m_serverOptions->getShmRingBytes() : ShmSegment::DEFAULT_RING_BYTES;
+
+   if (!m_segment.create(m_segmentName, numberChannels, ringBytes)) {
+      return false;
+   }
+
+   // only this server's thread pushes to a channel's response ring, so
+   // async handlers' responses are handed back to it through the doorbell
+   ShmSegment::Header* segmentHeader = m_segment.header();
+   m_responses = std::make_shared<ResponseQueue>([segmentHeader] {
+      ShmSegment::notify(&segmentHeader->doorbell, &segmentHeader->serverSleeping);
+   });
+   m_channelGenerations.assign(m_segment.getNumberChannels(), 0);
+   m_responderConnections.assign(m_segment.getNumberChannels(),
+                                 std::shared_ptr<Responder::Connection>());
+   m_unsentResponses.assign(m_segment.getNumberChannels(), std::string());
+
+   m_isRunning.store(true);
+   m_segment.header()->isServing.store(1);
+   m_thread = std::thread(&ShmServer::run, this);
+   return true;
+}
+
+//******************************************************************************
+
+void ShmServer::stop() {
+   if (!m_thread.joinable()) {
+      return;
+   }
+
+   ShmSegment::Header* header = m_segment.header();
+   m_responses->close();
+   m_isRunning.store(false);
+   header->isServing.store(0);
+   ShmSegment::futexWake(&header->doorbell);
+   m_thread.join();
+
+   // clients waiting on a response check on the server once woken
+   for (std::uint32_t i = 0; i < m_segment.getNumberChannels(); ++i) {
+      ShmSegment::Channel* channel = m_segment.channel(i);
+      ShmSegment::notify(&channel->responseSignal, &channel->clientSleeping);
+   }
+
+   m_segment.unlink();
+}
+
+//******************************************************************************
+
+const std::string& ShmServer::getSegmentName() const {
+   return m_segmentName;
+}
+
+//******************************************************************************
+
+std::uint64_t ShmServer::getRequestCount() const {
+   return m_requestCount.load();
+}
+
+//******************************************************************************
+
+void ShmServer::run() {
+   typedef std::chrono::steady_clock Clock;
+
+   ShmSegment::Header* header = m_segment.header();
+   const std::uint32_t numberChannels = m_segment.getNumberChannels();
+   Clock::time_point reapedAt = Clock::now();
+   int idlePasses = 0;
+
+   while (m_isRunning.load()) {
+      // read before the pass, so a request pushed during it keeps us awake
+      const std::uint32_t seen = header->doorbell.load();
+
+      bool isBusy = deliverResponses();
+      for (std::uint32_t i = 0; i < numberChannels; ++i) {
+         if (serviceChannel(i)) {
+            isBusy = true;
+         }
+      }
+
+      if (isBusy) {
+         idlePasses = 0;
+         continue;
+      }
+
+      if (++idlePasses < SPIN_ITERATIONS) {
+         std::this_thread::yield();
+         continue;
+      }
+
+      idlePasses = 0;
+      ShmSegment::await(&header->doorbell, &header->serverSleeping,
+                        seen, REAP_INTERVAL_MILLIS);
+
+      if (Clock::now() - reapedAt >= std::chrono::milliseconds(REAP_INTERVAL_MILLIS)) {
+         reapChannels();
+         reapedAt = Clock::now();
+      }
+   }
+}
+
+//******************************************************************************
+
+bool ShmServer::serviceChannel(std::uint32_t index) {
+   ShmSegment::Channel* channel = m_segment.channel(index);
+   const std::uint32_t state = channel->state.load();
+
+   if (state == ShmSegment::ChannelReleased) {
+      // whatever the client left behind goes with it
+      m_segment.requestRing(index).clear();
+      m_segment.responseRing(index).clear();
+      ++m_channelGenerations[index];
+      m_responderConnections[index].reset();
+      m_unsentResponses[index].clear();
+      channel->ownerPid.store(0);
+      channel->state.store(ShmSegment::ChannelFree);
+      return false;
+   } else if (state != ShmSegment::ChannelInUse) {
+      return false;
+   }
+
+   ShmRing ring = m_segment.requestRing(index);
+   std::string requestFrame;
+   bool isHandled = flushResponse(index);
+
+   while (ring.pop(requestFrame)) {
+      isHandled = true;
+      if (!handleRequest(index, requestFrame)) {
+         releaseChannel(index);
+         break;
+      }
+   }
+
+   return isHandled;
+}
+
+//******************************************************************************
+
+bool ShmServer::handleRequest(std::uint32_t index, const std::string& requestFrame) {
+   Message requestMessage;
+   if (!requestMessage.reconstituteFromFrame(requestFrame) ||
+       requestMessage.getRequestName().empty()) {
+      TONNERRE_LOG_ERROR("unable to reconstruct request message");
+      return false;
+   }
+
+   m_requestCount.fetch_add(1, std::memory_order_relaxed);
+
+   Message responseMessage(requestMessage.getRequestName(),
+                           requestMessage.getType());
+
+   // a one-way sender never pops a response, so none is pushed (in or out
+   // of ingestion mode)
+   MessageRequestHandler::ResponseWriter writeResponse;
+   std::shared_ptr<Responder::Connection> asyncConnection;
+   if (!requestMessage.isOneWay()) {
+      writeResponse = [this, index](const std::string& response) {
+         pushResponse(index, response);
+         return true;
+      };
+      asyncConnection = responderConnection(index);
+   }
+
+   return MessageRequestHandler::serveRequest(m_handler, m_admissionController, m_metrics,
+                                              requestMessage, requestFrame.length(),
+                                              responseMessage, writeResponse,
+                                              asyncConnection) !=
+      MessageRequestHandler::RequestUnanswered;
+}
+
+//******************************************************************************
+
+void ShmServer::pushResponse(std::uint32_t index, const std::string& response) {
+   // the handler has already run, so a response too large for the ring
+   // can't be turned away: an empty frame tells the client it's coming in
+   // pieces, which are pushed as the client makes room for them (a channel
+   // has one call in flight, so nothing else is waiting to be pushed)
+   if (response.length() > m_segment.getMaxFrameLength()) {
+      m_segment.responseRing(index).push(std::string());
+   }
+
+   m_unsentResponses[index] += response;
+   flushResponse(index);
+}
+
+//******************************************************************************
+
+bool ShmServer::flushResponse(std::uint32_t index) {
+   std::string& unsent = m_unsentResponses[index];
+   if (unsent.empty()) {
+      return false;
+   }
+
+   ShmRing ring = m_segment.responseRing(index);
+   const std::size_t maxFrameLength = m_segment.getMaxFrameLength();
+   std::size_t offset = 0;
+
+   while (offset < unsent.length()) {
+      // (pieces of half the ring let the client pop one while the next
+      // goes in)
+      const std::size_t remaining = unsent.length() - offset;
+      const std::size_t pieceLength =
+         (remaining <= maxFrameLength) ? remaining : maxFrameLength / 2;
+      if (!ring.push(unsent.substr(offset, pieceLength))) {
+         break;
+      }
+      offset += pieceLength;
+   }
+
+   if (offset == 0) {
+      return false;
+   }
+
+   unsent.erase(0, offset);
+   ShmSegment::Channel* channel = m_segment.channel(index);
+   ShmSegment::notify(&channel->responseSignal, &channel->clientSleeping);
+   return true;
+}
+
+//******************************************************************************
+
+std::shared_ptr<Responder::Connection> ShmServer::responderConnection(std::uint32_t index) {
+   // the key carries the channel's generation, so a response that outlives
+   // its client is recognized and dropped
+   std::shared_ptr<Responder::Connection>& connection = m_responderConnections[index];
+   if (connection == nullptr) {
+      const std::uint64_t key =
+         ((std::uint64_t) m_channelGenerations[index] << 32) | index;
+      connection = m_responses->connectionFor(key);
+   }
+
+   return connection;
+}
+
+//******************************************************************************
+
+bool ShmServer::deliverResponses() {
+   std::vector<ResponseQueue::Response> responses;
+   m_responses->take(responses);
+
+   for (const ResponseQueue::Response& response : responses) {
+      const std::uint32_t index = (std::uint32_t) (response.first & 0xffffffff);
+      const std::uint32_t generation = (std::uint32_t) (response.first >> 32);
+      if ((m_channelGenerations[index] != generation) ||
+          (m_segment.channel(index)->state.load() != ShmSegment::ChannelInUse)) {
+         // the client went away while its request was outstanding
+         continue;
+      }
+
+      pushResponse(index, response.second);
+   }
+
+   return !responses.empty();
+}
+
+//******************************************************************************
+
+void ShmServer::releaseChannel(std::uint32_t index) {
+   // the client can't be answered; its pending call fails
+   ShmSegment::Channel* channel = m_segment.channel(index);
+   channel->state.store(ShmSegment::ChannelReleased);
+   ShmSegment::notify(&channel->responseSignal, &channel->clientSleeping);
+}
+
+//******************************************************************************
+
+void ShmServer::reapChannels() {
+   const std::uint32_t numberChannels = m_segment.getNumberChannels();
+   for (std::uint32_t i = 0; i < numberChannels; ++i) {
+      ShmSegment::Channel* channel = m_segment.channel(i);
+      const std::int32_t ownerPid = channel->ownerPid.load();
+      if ((channel->state.load() == ShmSegment::ChannelInUse) &&
+          (ownerPid != 0) && !ShmSegment::isProcessAlive(ownerPid)) {
+         channel->state.store(ShmSegment::ChannelReleased);
+         serviceChannel(i);
+      }
+   }
+}
+
+//******************************************************************************
@@ -0,0 +1,133 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_SHMSERVER_H
+#define TONNERRE_SHMSERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Responder.h"
+#include "ShmSegment.h"
+
+
+namespace tonnerre
+{
+   class AdmissionController;
+   class MessageHandler;
+   class ResponseQueue;
+   class ServerMetrics;
+   class ServerOptions;
+
+/**
+ * ShmServer serves a messaging server's same-host clients through a shared
+ * memory segment ('shm = true' in the [server] section), alongside the
+ * usual listener. A single thread polls the segment's channels, handles
+ * each request on that thread as soon as it is popped, and pushes the
+ * response back on the request's channel (in pieces, if it's larger than
+ * the ring). An async handler's response is handed back to the same
+ * thread to push once its responder completes, so the thread never waits
+ * on one. The thread spins briefly when the channels go quiet and then
+ * sleeps on the segment's doorbell.
+ * @see ShmSegment()
+ * @see ShmClient()
+ */
+class ShmServer
+{
+public:
+   /**
+    * Constructs a server (nothing is created until start())
+    * @param port the port the messaging server listens on (names the
+    * segment)
+    * @param handler the handler for requests
+    * @param serverOptions the server options (not owned; must outlive the
+    * server)
+    */
+   ShmServer(int port,
+             MessageHandler* handler,
+             const ServerOptions* serverOptions);
+
+   /**
+    * Destructor (stops the server and removes its segment)
+    */
+   ~ShmServer();
+
+   /**
+    * Sets the admission controller consulted before each request is
+    * dispatched (call before start())
+    * @param admissionController the controller (not owned)
+    * @see AdmissionController()
+    */
+   void setAdmissionController(AdmissionController* admissionController);
+
+   /**
+    * Sets the metrics that each request is recorded in (call before
+    * start())
+    * @param metrics the metrics (not owned)
+    * @see ServerMetrics()
+    */
+   void setServerMetrics(ServerMetrics* metrics);
+
+   /**
+    * Creates the segment and starts serving it
+    * @return boolean indicating whether the server is running
+    */
+   bool start();
+
+   /**
+    * Stops serving and removes the segment (clients waiting on a response
+    * see the server go and fail their calls)
+    */
+   void stop();
+
+   /**
+    * Retrieves the name of the segment
+    * @return the segment name
+    */
+   const std::string& getSegmentName() const;
+
+   /**
+    * Retrieves the number of requests handled
+    * @return number of requests
+    */
+   std::uint64_t getRequestCount() const;
+
+private:
+   void run();
+   bool serviceChannel(std::uint32_t index);
+   bool handleRequest(std::uint32_t index, const std::string& requestFrame);
+   void pushResponse(std::uint32_t index, const std::string& response);
+   bool flushResponse(std::uint32_t index);
+   std::shared_ptr<Responder::Connection> responderConnection(std::uint32_t index);
+   bool deliverResponses();
+   void releaseChannel(std::uint32_t index);
+   void reapChannels();
+
+   ShmSegment m_segment;
+   std::string m_segmentName;
+   MessageHandler* m_handler;
+   const ServerOptions* m_serverOptions;
+   AdmissionController* m_admissionController;
+   ServerMetrics* m_metrics;
+   std::shared_ptr<ResponseQueue> m_responses;
+   // per channel, bumped each time the channel is freed, so that a response
+   // completed after its client has gone isn't pushed to the next one
+   std::vector<std::uint32_t> m_channelGenerations;
+   std::vector<std::shared_ptr<Responder::Connection>> m_responderConnections;
+   // per channel, what's left of a response too large for the ring
+   std::vector<std::string> m_unsentResponses;
+   std::thread m_thread;
+   std::atomic<std::uint64_t> m_requestCount;
+   std::atomic<bool> m_isRunning;
+
+   ShmServer(const ShmServer&);
+   ShmServer& operator=(const ShmServer&);
+};
+
+}
+
+#endif
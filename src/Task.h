@@ -0,0 +1,230 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TASK_H
+#define TONNERRE_TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+
+namespace tonnerre
+{
+
+   template <typename T> class Task;
+
+   namespace detail
+   {
+
+/**
+ * TaskPromiseBase holds what Task promises share: the coroutine awaiting
+ * the task (resumed by symmetric transfer when the task finishes) and any
+ * exception the task's body let escape.
+ */
+class TaskPromiseBase
+{
+public:
+   struct FinalAwaiter
+   {
+      bool await_ready() const noexcept {
+         return false;
+      }
+
+      template <typename Promise>
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+         std::coroutine_handle<> continuation = handle.promise().getContinuation();
+         return continuation ? continuation : std::noop_coroutine();
+      }
+
+      void await_resume() const noexcept {
+      }
+   };
+
+   std::suspend_always initial_suspend() const noexcept {
+      return {};
+   }
+
+   FinalAwaiter final_suspend() const noexcept {
+      return {};
+   }
+
+   void unhandled_exception() noexcept {
+      m_exception = std::current_exception();
+   }
+
+   void setContinuation(std::coroutine_handle<> continuation) noexcept {
+      m_continuation = continuation;
+   }
+
+   std::coroutine_handle<> getContinuation() const noexcept {
+      return m_continuation;
+   }
+
+   void rethrowIfFailed() const {
+      if (m_exception) {
+         std::rethrow_exception(m_exception);
+      }
+   }
+
+private:
+   std::coroutine_handle<> m_continuation;
+   std::exception_ptr m_exception;
+};
+
+   }
+
+/**
+ * Task is the return type of tonnerre coroutines. A task doesn't start
+ * until it's awaited (co_await task), at which point the awaiting coroutine
+ * is suspended until the task co_returns its value; the value (or the
+ * exception the task threw) is what the co_await expression yields.
+ *
+ * @code
+ * Task<std::string> lookup(Message request) {
+ *    Message response;
+ *    if (co_await AsyncClient::send(request, "stooge_info_service", response)) {
+ *       co_return response.getTextPayload();
+ *    }
+ *    co_return "";
+ * }
+ * @endcode
+ */
+template <typename T>
+class Task
+{
+public:
+   class promise_type : public detail::TaskPromiseBase
+   {
+   public:
+      Task get_return_object() noexcept {
+         return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+      }
+
+      template <typename U>
+      void return_value(U&& value) {
+         m_value.emplace(std::forward<U>(value));
+      }
+
+      T takeValue() {
+         rethrowIfFailed();
+         return std::move(*m_value);
+      }
+
+   private:
+      std::optional<T> m_value;
+   };
+
+   Task(Task&& other) noexcept :
+      m_handle(std::exchange(other.m_handle, nullptr)) {
+   }
+
+   Task& operator=(Task&& other) noexcept {
+      if (this != &other) {
+         if (m_handle) {
+            m_handle.destroy();
+         }
+         m_handle = std::exchange(other.m_handle, nullptr);
+      }
+      return *this;
+   }
+
+   ~Task() {
+      if (m_handle) {
+         m_handle.destroy();
+      }
+   }
+
+   bool await_ready() const noexcept {
+      return !m_handle || m_handle.done();
+   }
+
+   std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+      m_handle.promise().setContinuation(awaiting);
+      return m_handle;
+   }
+
+   T await_resume() {
+      return m_handle.promise().takeValue();
+   }
+
+private:
+   explicit Task(std::coroutine_handle<promise_type> handle) noexcept :
+      m_handle(handle) {
+   }
+
+   std::coroutine_handle<promise_type> m_handle;
+
+   // disallow copies
+   Task(const Task&) = delete;
+   Task& operator=(const Task&) = delete;
+};
+
+/**
+ * Task<void> is a task that produces no value (co_return;)
+ */
+template <>
+class Task<void>
+{
+public:
+   class promise_type : public detail::TaskPromiseBase
+   {
+   public:
+      Task get_return_object() noexcept {
+         return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+      }
+
+      void return_void() noexcept {
+      }
+   };
+
+   Task(Task&& other) noexcept :
+      m_handle(std::exchange(other.m_handle, nullptr)) {
+   }
+
+   Task& operator=(Task&& other) noexcept {
+      if (this != &other) {
+         if (m_handle) {
+            m_handle.destroy();
+         }
+         m_handle = std::exchange(other.m_handle, nullptr);
+      }
+      return *this;
+   }
+
+   ~Task() {
+      if (m_handle) {
+         m_handle.destroy();
+      }
+   }
+
+   bool await_ready() const noexcept {
+      return !m_handle || m_handle.done();
+   }
+
+   std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+      m_handle.promise().setContinuation(awaiting);
+      return m_handle;
+   }
+
+   void await_resume() {
+      m_handle.promise().rethrowIfFailed();
+   }
+
+private:
+   explicit Task(std::coroutine_handle<promise_type> handle) noexcept :
+      m_handle(handle) {
+   }
+
+   std::coroutine_handle<promise_type> m_handle;
+
+   // disallow copies
+   Task(const Task&) = delete;
+   Task& operator=(const Task&) = delete;
+};
+
+}
+
+#endif
+
@@ -0,0 +1,105 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "ThreadPoolExecutor.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+//******************************************************************************
+
+ThreadPoolExecutor::ThreadPoolExecutor(int numberWorkers) :
+   m_isRunning(true) {
+   TONNERRE_LOG_INSTANCE_CREATE("ThreadPoolExecutor");
+
+   if (numberWorkers < 1) {
+      numberWorkers = 1;
+   }
+
+   for (int i = 0; i < numberWorkers; ++i) {
+      m_workers.emplace_back(&ThreadPoolExecutor::runWorker, this);
+   }
+}
+
+//******************************************************************************
+
+ThreadPoolExecutor::~ThreadPoolExecutor() {
+   TONNERRE_LOG_INSTANCE_DESTROY("ThreadPoolExecutor");
+   stop();
+}
+
+//******************************************************************************
+
+bool ThreadPoolExecutor::execute(Runnable* task) {
+   if (task == nullptr) {
+      return false;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_isRunning) {
+         m_tasks.push_back(task);
+         m_cond.notify_one();
+         return true;
+      }
+   }
+
+   delete task;
+   return false;
+}
+
+//******************************************************************************
+
+void ThreadPoolExecutor::stop() {
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (!m_isRunning) {
+         return;
+      }
+      m_isRunning = false;
+      m_cond.notify_all();
+   }
+
+   for (auto& worker : m_workers) {
+      if (worker.joinable()) {
+         worker.join();
+      }
+   }
+}
+
+//******************************************************************************
+
+int ThreadPoolExecutor::getNumberWorkers() const {
+   return (int) m_workers.size();
+}
+
+//******************************************************************************
+
+void ThreadPoolExecutor::runWorker() {
+   for (;;) {
+      Runnable* task = nullptr;
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         m_cond.wait(lock, [this] { return !m_isRunning || !m_tasks.empty(); });
+         if (m_tasks.empty()) {
+            // stopped and fully drained
+            return;
+         }
+         task = m_tasks.front();
+         m_tasks.pop_front();
+      }
+
+      try {
+         task->run();
+      } catch (const std::exception& e) {
+         TONNERRE_LOG_ERROR("exception caught in executor task: " + std::string(e.what()));
+      } catch (...) {
+         TONNERRE_LOG_ERROR("exception caught in executor task");
+      }
+
+      delete task;
+   }
+}
+
+//******************************************************************************
@@ -0,0 +1,56 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_THREADPOOLEXECUTOR_H
+#define TONNERRE_THREADPOOLEXECUTOR_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Executor.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * ThreadPoolExecutor is a fixed-size pool of worker threads sharing one
+ * FIFO task queue.
+ */
+class ThreadPoolExecutor : public Executor
+{
+public:
+   /**
+    * Constructs the executor and starts its worker threads
+    * @param numberWorkers the number of worker threads (at least 1)
+    */
+   explicit ThreadPoolExecutor(int numberWorkers);
+
+   /**
+    * Destructor (stops the executor if still running)
+    */
+   ~ThreadPoolExecutor();
+
+   bool execute(chaudiere::Runnable* task) override;
+   void stop() override;
+   int getNumberWorkers() const override;
+
+private:
+   void runWorker();
+
+   std::vector<std::thread> m_workers;
+   std::deque<chaudiere::Runnable*> m_tasks;
+   std::mutex m_mutex;
+   std::condition_variable m_cond;
+   bool m_isRunning;
+
+   ThreadPoolExecutor(const ThreadPoolExecutor&);
+   ThreadPoolExecutor& operator=(const ThreadPoolExecutor&);
+};
+
+}
+
+#endif
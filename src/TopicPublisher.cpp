@@ -0,0 +1,287 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "TopicPublisher.h"
+#include "TopicSubscriber.h"
+#include "Message.h"
+#include "KeyValuePairs.h"
+#include "StrUtils.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+static const std::string KEY_HOST        = "host";
+static const std::string KEY_PORT        = "port";
+static const std::string KEY_STATUS      = "status";
+static const std::string KEY_TOPIC       = "topic";
+
+static const std::string VALUE_ERROR     = "error";
+static const std::string VALUE_OK        = "ok";
+
+static const std::string SUBSCRIBER      = "subscriber";
+
+const std::string TopicPublisher::SUBSCRIBE_REQUEST_NAME   = "__subscribe";
+const std::string TopicPublisher::UNSUBSCRIBE_REQUEST_NAME = "__unsubscribe";
+
+//******************************************************************************
+
+static bool sendSubscriptionRequest(const std::string& requestName,
+                                    const std::string& publisherService,
+                                    const std::string& topic,
+                                    const ServiceInfo& subscriberInfo) {
+   KeyValuePairs kvp;
+   kvp.addPair(KEY_TOPIC, topic);
+   kvp.addPair(KEY_HOST, subscriberInfo.host());
+   kvp.addPair(KEY_PORT, std::to_string(subscriberInfo.port()));
+
+   Message request(requestName, MessageTypeKeyValues);
+   request.setKeyValuesPayload(kvp);
+
+   Message response;
+   if (!request.send(publisherService, response)) {
+      return false;
+   }
+
+   const KeyValuePairs& responsePayload = response.getKeyValuesPayload();
+   return responsePayload.hasKey(KEY_STATUS) &&
+          (responsePayload.getValue(KEY_STATUS) == VALUE_OK);
+}
+
+//******************************************************************************
+
+bool TopicPublisher::requestSubscription(const std::string& publisherService,
+                                         const std::string& topic,
+                                         const ServiceInfo& subscriberInfo) {
+   return sendSubscriptionRequest(SUBSCRIBE_REQUEST_NAME, publisherService,
+                                  topic, subscriberInfo);
+}
+
+//******************************************************************************
+
+bool TopicPublisher::requestUnsubscription(const std::string& publisherService,
+                                           const std::string& topic,
+                                           const ServiceInfo& subscriberInfo) {
+   return sendSubscriptionRequest(UNSUBSCRIBE_REQUEST_NAME, publisherService,
+                                  topic, subscriberInfo);
+}
+
+//******************************************************************************
+
+TopicPublisher::TopicPublisher() {
+   TONNERRE_LOG_INSTANCE_CREATE("TopicPublisher");
+
+   // a subscriber that falls behind loses its oldest messages rather than
+   // holding up the publisher
+   m_subscriberOptions.setAsyncBackpressure(BackpressureDropOldest);
+}
+
+//******************************************************************************
+
+TopicPublisher::TopicPublisher(const ServiceOptions& subscriberOptions) :
+   m_subscriberOptions(subscriberOptions) {
+   TONNERRE_LOG_INSTANCE_CREATE("TopicPublisher");
+}
+
+//******************************************************************************
+
+TopicPublisher::~TopicPublisher() {
+   TONNERRE_LOG_INSTANCE_DESTROY("TopicPublisher");
+
+   std::unordered_map<std::string, Subscription> subscriptions;
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_topics.clear();
+      subscriptions.swap(m_subscriptions);
+   }
+
+   for (auto& subscription : subscriptions) {
+      subscription.second.subscriber->stop();
+   }
+}
+
+//******************************************************************************
+
+void TopicPublisher::subscribe(const std::string& topic,
+                               const ServiceInfo& subscriberInfo) {
+   const std::string subscriberId = subscriberInfo.getUniqueIdentifier();
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+
+   // a service subscribed to several topics keeps one connection
+   std::shared_ptr<TopicSubscriber> subscriber;
+   auto itSubscription = m_subscriptions.find(subscriberId);
+   const bool isSubscribed = (itSubscription != m_subscriptions.end());
+   if (isSubscribed) {
+      subscriber = (*itSubscription).second.subscriber;
+   } else {
+      subscriber.reset(new TopicSubscriber(subscriberInfo, m_subscriberOptions));
+   }
+
+   std::shared_ptr<Subscribers> subscribers(new Subscribers);
+   auto itTopic = m_topics.find(topic);
+   if (itTopic != m_topics.end()) {
+      for (const auto& existing : *(*itTopic).second) {
+         if (existing == subscriber) {
+            return;
+         }
+      }
+      *subscribers = *(*itTopic).second;
+   }
+
+   subscribers->push_back(subscriber);
+   m_topics[topic] = subscribers;
+
+   if (isSubscribed) {
+      ++(*itSubscription).second.numberTopics;
+   } else {
+      Subscription& subscription = m_subscriptions[subscriberId];
+      subscription.subscriber = subscriber;
+      subscription.numberTopics = 1;
+   }
+}
+
+//******************************************************************************
+
+bool TopicPublisher::unsubscribe(const std::string& topic,
+                                 const ServiceInfo& subscriberInfo) {
+   const std::string subscriberId = subscriberInfo.getUniqueIdentifier();
+   std::shared_ptr<TopicSubscriber> unsubscribed;
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      auto itSubscription = m_subscriptions.find(subscriberId);
+      auto itTopic = m_topics.find(topic);
+      if ((itSubscription == m_subscriptions.end()) || (itTopic == m_topics.end())) {
+         return false;
+      }
+
+      const std::shared_ptr<TopicSubscriber>& subscriber =
+         (*itSubscription).second.subscriber;
+      std::shared_ptr<Subscribers> subscribers(new Subscribers);
+      for (const auto& existing : *(*itTopic).second) {
+         if (existing != subscriber) {
+            subscribers->push_back(existing);
+         }
+      }
+
+      if (subscribers->size() == (*itTopic).second->size()) {
+         return false;
+      }
+
+      if (subscribers->empty()) {
+         m_topics.erase(itTopic);
+      } else {
+         (*itTopic).second = subscribers;
+      }
+
+      if (--(*itSubscription).second.numberTopics == 0) {
+         unsubscribed = subscriber;
+         m_subscriptions.erase(itSubscription);
+      }
+   }
+
+   // (outside the lock: stopping waits for the subscriber's queue to drain)
+   if (unsubscribed != nullptr) {
+      unsubscribed->stop();
+   }
+
+   return true;
+}
+
+//******************************************************************************
+
+std::size_t TopicPublisher::publish(const std::string& topic, Message& message) {
+   std::shared_ptr<const Subscribers> subscribers;
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto it = m_topics.find(topic);
+      if (it == m_topics.end()) {
+         return 0;
+      }
+      subscribers = (*it).second;
+   }
+
+   // encoded once; every subscriber's queue shares the one buffer
+   message.setOneWay(true);
+   const std::shared_ptr<const std::string> encodedMessage(
+      new std::string(message.encodeForService(topic)));
+
+   std::size_t numberQueued = 0;
+   for (const auto& subscriber : *subscribers) {
+      if (subscriber->enqueue(encodedMessage)) {
+         ++numberQueued;
+      }
+   }
+
+   return numberQueued;
+}
+
+//******************************************************************************
+
+std::size_t TopicPublisher::getSubscriberCount(const std::string& topic) const {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   auto it = m_topics.find(topic);
+   return (it != m_topics.end()) ? (*it).second->size() : 0;
+}
+
+//******************************************************************************
+
+std::shared_ptr<TopicSubscriber>
+TopicPublisher::getSubscriber(const ServiceInfo& subscriberInfo) const {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   auto it = m_subscriptions.find(subscriberInfo.getUniqueIdentifier());
+   return (it != m_subscriptions.end()) ? (*it).second.subscriber : nullptr;
+}
+
+//******************************************************************************
+
+void TopicPublisher::handleTextMessage(const Message& requestMessage,
+                                       Message& responseMessage,
+                                       const std::string& requestName,
+                                       const std::string& requestPayload,
+                                       std::string& responsePayload) {
+   (void) requestMessage;
+   (void) responseMessage;
+   (void) requestPayload;
+   TONNERRE_LOG_ERROR("unsupported publisher request '" + requestName + "'");
+   responsePayload = VALUE_ERROR;
+}
+
+//******************************************************************************
+
+void TopicPublisher::handleKeyValuesMessage(const Message& requestMessage,
+                                            Message& responseMessage,
+                                            const std::string& requestName,
+                                            const KeyValuePairs& requestPayload,
+                                            KeyValuePairs& responsePayload) {
+   (void) requestMessage;
+   (void) responseMessage;
+
+   const bool isSubscribe = (requestName == SUBSCRIBE_REQUEST_NAME);
+   if ((!isSubscribe && (requestName != UNSUBSCRIBE_REQUEST_NAME)) ||
+       !requestPayload.hasKey(KEY_TOPIC) ||
+       !requestPayload.hasKey(KEY_HOST) ||
+       !requestPayload.hasKey(KEY_PORT)) {
+      TONNERRE_LOG_ERROR("unsupported publisher request '" + requestName + "'");
+      responsePayload.addPair(KEY_STATUS, VALUE_ERROR);
+      return;
+   }
+
+   const ServiceInfo subscriberInfo(SUBSCRIBER,
+      requestPayload.getValue(KEY_HOST),
+      (unsigned short) StrUtils::parseInt(requestPayload.getValue(KEY_PORT)));
+   const std::string& topic = requestPayload.getValue(KEY_TOPIC);
+
+   bool isDone = true;
+   if (isSubscribe) {
+      subscribe(topic, subscriberInfo);
+   } else {
+      isDone = unsubscribe(topic, subscriberInfo);
+   }
+
+   responsePayload.addPair(KEY_STATUS, isDone ? VALUE_OK : VALUE_ERROR);
+}
+
+//******************************************************************************
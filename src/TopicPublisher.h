@@ -0,0 +1,168 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TOPICPUBLISHER_H
+#define TONNERRE_TOPICPUBLISHER_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MessageHandler.h"
+#include "ServiceInfo.h"
+#include "ServiceOptions.h"
+
+
+namespace tonnerre
+{
+   class Message;
+   class TopicSubscriber;
+
+/**
+ * TopicPublisher fans messages out to the services subscribed to a topic.
+ * A publish encodes the message once, as a one-way message addressed to
+ * the topic, and queues that same immutable buffer for every subscriber;
+ * each subscriber has its own connection, writer thread and bounded queue
+ * (see TopicSubscriber), so a slow one doesn't hold up the rest.
+ *
+ * Subscriptions can be made directly, or by subscribing services over the
+ * network: the publisher is a MessageHandler that answers the
+ * SUBSCRIBE_REQUEST_NAME and UNSUBSCRIBE_REQUEST_NAME requests sent by
+ * requestSubscription() and requestUnsubscription(), so the publishing
+ * process hosts it as a service. Published messages arrive at a
+ * subscriber's handler as ordinary one-way messages whose service name
+ * (Message::getServiceName) is the topic; a server hosting several
+ * services routes them by registering a handler under the topic's name.
+ * @see TopicSubscriber()
+ */
+class TopicPublisher : public MessageHandler
+{
+public:
+   static const std::string SUBSCRIBE_REQUEST_NAME;
+   static const std::string UNSUBSCRIBE_REQUEST_NAME;
+
+   /**
+    * Asks a publishing service to send a topic's messages to a service
+    * @param publisherService the name of the publishing service
+    * @param topic the topic
+    * @param subscriberInfo where the subscribing service listens (a port
+    * of 0 names a Unix domain socket path as the host)
+    * @return boolean indicating if the publisher accepted the subscription
+    */
+   static bool requestSubscription(const std::string& publisherService,
+                                   const std::string& topic,
+                                   const chaudiere::ServiceInfo& subscriberInfo);
+
+   /**
+    * Asks a publishing service to stop sending a topic's messages to a
+    * service
+    * @param publisherService the name of the publishing service
+    * @param topic the topic
+    * @param subscriberInfo where the subscribing service listens
+    * @return boolean indicating if the subscription was removed
+    */
+   static bool requestUnsubscription(const std::string& publisherService,
+                                     const std::string& topic,
+                                     const chaudiere::ServiceInfo& subscriberInfo);
+
+   /**
+    * Constructs a publisher whose subscribers each get a queue of
+    * ServiceOptions::DEFAULT_ASYNC_QUEUE_SIZE messages that drops its
+    * oldest message when full
+    */
+   TopicPublisher();
+
+   /**
+    * Constructs a publisher
+    * @param subscriberOptions 'async_queue_size' and 'async_backpressure'
+    * set each subscriber's queue size and overflow policy
+    * @see ServiceOptions()
+    */
+   explicit TopicPublisher(const ServiceOptions& subscriberOptions);
+
+   /**
+    * Destructor. Writes whatever is queued for each subscriber before
+    * returning.
+    */
+   ~TopicPublisher();
+
+   /**
+    * Subscribes a service to a topic (subscribing again has no effect)
+    * @param topic the topic
+    * @param subscriberInfo where the subscribing service listens
+    */
+   void subscribe(const std::string& topic,
+                  const chaudiere::ServiceInfo& subscriberInfo);
+
+   /**
+    * Unsubscribes a service from a topic; once it has no topics left its
+    * connection is closed after its queue is written
+    * @param topic the topic
+    * @param subscriberInfo where the subscribing service listens
+    * @return boolean indicating if the service was subscribed
+    */
+   bool unsubscribe(const std::string& topic,
+                    const chaudiere::ServiceInfo& subscriberInfo);
+
+   /**
+    * Publishes a message to every subscriber of a topic
+    * @param topic the topic
+    * @param message the message (marked one-way and addressed to the topic)
+    * @return the number of subscribers the message was queued for
+    */
+   std::size_t publish(const std::string& topic, Message& message);
+
+   /**
+    * Retrieves the number of services subscribed to a topic
+    * @param topic the topic
+    * @return number of subscribers
+    */
+   std::size_t getSubscriberCount(const std::string& topic) const;
+
+   /**
+    * Retrieves the connection to a subscribing service, e.g. to read its
+    * counters
+    * @param subscriberInfo where the subscribing service listens
+    * @return the subscriber, or nullptr if it has no subscriptions
+    * @see TopicSubscriber()
+    */
+   std::shared_ptr<TopicSubscriber> getSubscriber(const chaudiere::ServiceInfo& subscriberInfo) const;
+
+   // MessageHandler
+   void handleTextMessage(const Message& requestMessage,
+                          Message& responseMessage,
+                          const std::string& requestName,
+                          const std::string& requestPayload,
+                          std::string& responsePayload) override;
+
+   void handleKeyValuesMessage(const Message& requestMessage,
+                               Message& responseMessage,
+                               const std::string& requestName,
+                               const chaudiere::KeyValuePairs& requestPayload,
+                               chaudiere::KeyValuePairs& responsePayload) override;
+
+private:
+   typedef std::vector<std::shared_ptr<TopicSubscriber>> Subscribers;
+
+   struct Subscription {
+      std::shared_ptr<TopicSubscriber> subscriber;
+      int numberTopics;
+   };
+
+   ServiceOptions m_subscriberOptions;
+   mutable std::mutex m_mutex;
+   // each topic's subscribers are replaced rather than modified, so a
+   // publish only holds the lock long enough to take a reference
+   std::unordered_map<std::string, std::shared_ptr<const Subscribers>> m_topics;
+   std::unordered_map<std::string, Subscription> m_subscriptions;
+
+   TopicPublisher(const TopicPublisher&);
+   TopicPublisher& operator=(const TopicPublisher&);
+};
+
+}
+
+#endif
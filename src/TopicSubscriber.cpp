@@ -0,0 +1,165 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+
+#include "TopicSubscriber.h"
+#include "UnixSocket.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+// most queued messages gathered into one write
+static const std::size_t MAX_MESSAGES_PER_WRITE = 64;
+
+// how long a write may wait on a subscriber that isn't reading before its
+// connection is given up on
+static const int WRITE_TIMEOUT_MILLIS          = 5000;
+
+//******************************************************************************
+
+TopicSubscriber::TopicSubscriber(const ServiceInfo& subscriberInfo,
+                                 const ServiceOptions& options) :
+   AsyncQueueWriter<Buffer>(options.getAsyncQueueSize(),
+                            options.getAsyncBackpressure()),
+   m_subscriberInfo(subscriberInfo) {
+   TONNERRE_LOG_INSTANCE_CREATE("TopicSubscriber");
+   start();
+}
+
+//******************************************************************************
+
+TopicSubscriber::~TopicSubscriber() {
+   TONNERRE_LOG_INSTANCE_DESTROY("TopicSubscriber");
+   stop();
+}
+
+//******************************************************************************
+
+const ServiceInfo& TopicSubscriber::getSubscriberInfo() const {
+   return m_subscriberInfo;
+}
+
+//******************************************************************************
+
+int TopicSubscriber::writeQueued(bool) {
+   Buffer batch[MAX_MESSAGES_PER_WRITE];
+
+   // whatever queued up while the last batch was written goes out together
+   std::size_t numberMessages = 0;
+   while ((numberMessages < MAX_MESSAGES_PER_WRITE) &&
+          dequeue(batch[numberMessages])) {
+      ++numberMessages;
+   }
+
+   if (numberMessages == 0) {
+      return NO_DEADLINE;
+   }
+
+   writeBatch(batch, numberMessages);
+   return 0;
+}
+
+//******************************************************************************
+
+void TopicSubscriber::writeBatch(Buffer* batch, std::size_t numberMessages) {
+   std::size_t numberWritten = 0;   // messages written in full
+   std::size_t offset = 0;          // bytes written of the next one
+
+   // one reconnect attempt per batch: a connection the subscriber has since
+   // closed shows up as a failed write
+   for (int attempt = 0; (attempt < 2) && (numberWritten < numberMessages); ++attempt) {
+      if ((m_socket == nullptr) && !connect()) {
+         break;
+      }
+
+      const int fd = m_socket->getFileDescriptor();
+      bool isFailed = false;
+
+      while (!isFailed && (numberWritten < numberMessages)) {
+         struct iovec iovecs[MAX_MESSAGES_PER_WRITE];
+         std::size_t numberIovecs = 0;
+         for (std::size_t i = numberWritten; i < numberMessages; ++i) {
+            const std::size_t skip = (i == numberWritten) ? offset : 0;
+            iovecs[numberIovecs].iov_base = const_cast<char*>(batch[i]->data() + skip);
+            iovecs[numberIovecs].iov_len = batch[i]->length() - skip;
+            ++numberIovecs;
+         }
+
+         struct msghdr header;
+         ::memset(&header, 0, sizeof(header));
+         header.msg_iov = iovecs;
+         header.msg_iovlen = numberIovecs;
+
+         const ssize_t rc = ::sendmsg(fd, &header, MSG_NOSIGNAL);
+         if (rc < 0) {
+            if (errno != EINTR) {
+               isFailed = true;
+            }
+            continue;
+         }
+
+         std::size_t bytesWritten = (std::size_t) rc;
+         while ((bytesWritten > 0) && (numberWritten < numberMessages)) {
+            const std::size_t remaining = batch[numberWritten]->length() - offset;
+            if (bytesWritten >= remaining) {
+               bytesWritten -= remaining;
+               ++numberWritten;
+               offset = 0;
+            } else {
+               offset += bytesWritten;
+               bytesWritten = 0;
+            }
+         }
+      }
+
+      if (!isFailed) {
+         // a subscriber that isn't in ingestion mode still answers
+         // one-way messages
+         discardResponses(fd);
+         break;
+      }
+
+      m_socket.reset();
+      if (offset > 0) {
+         // a new connection has to start on a message boundary, so the
+         // rest of a partly written message is lost
+         countFailed(1);
+         ++numberWritten;
+         offset = 0;
+      }
+   }
+
+   if (numberWritten < numberMessages) {
+      TONNERRE_LOG_ERROR("unable to write published messages to subscriber");
+      countFailed(numberMessages - numberWritten);
+   }
+
+   countSent(numberWritten);
+}
+
+//******************************************************************************
+
+bool TopicSubscriber::connect() {
+   m_socket.reset(UnixSocket::connectToService(m_subscriberInfo));
+   if ((m_socket == nullptr) || !m_socket->isConnected()) {
+      m_socket.reset();
+      TONNERRE_LOG_ERROR("unable to connect to subscriber");
+      return false;
+   }
+
+   struct timeval timeout;
+   timeout.tv_sec = WRITE_TIMEOUT_MILLIS / 1000;
+   timeout.tv_usec = (WRITE_TIMEOUT_MILLIS % 1000) * 1000;
+   ::setsockopt(m_socket->getFileDescriptor(), SOL_SOCKET, SO_SNDTIMEO,
+                &timeout, sizeof(timeout));
+   return true;
+}
+
+//******************************************************************************
@@ -0,0 +1,81 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TOPICSUBSCRIBER_H
+#define TONNERRE_TOPICSUBSCRIBER_H
+
+#include <memory>
+#include <string>
+
+#include "AsyncWriter.h"
+#include "ServiceOptions.h"
+#include "ServiceInfo.h"
+#include "Socket.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * TopicSubscriber is a publisher's connection to one subscriber. Published
+ * messages are queued as shared, already-encoded buffers (the same buffer
+ * for every subscriber), and a background thread writes whatever has
+ * queued up with a single gathering write, so no subscriber's copy of a
+ * message is ever made. Each subscriber has its own bounded queue, so one
+ * that falls behind only affects itself: once its queue is full the
+ * backpressure policy either drops its oldest message, rejects the new
+ * one, or (BackpressureBlock) holds up the publisher. A subscriber that
+ * stops reading altogether has its writes time out and its connection
+ * replaced.
+ *
+ * All messages travel over one persistent connection, so the subscribing
+ * server must keep servicing a connection after the first message (as it
+ * does in ingestion mode or with keep-alive).
+ * @see TopicPublisher()
+ * @see AsyncQueueWriter()
+ */
+class TopicSubscriber :
+   public AsyncQueueWriter<std::shared_ptr<const std::string>>
+{
+public:
+   /**
+    * Constructs a subscriber connection and starts its writer thread (the
+    * connection is made when the first message is written)
+    * @param subscriberInfo the subscribing service
+    * @param options 'async_queue_size' and 'async_backpressure' are used
+    * @see ServiceInfo()
+    * @see ServiceOptions()
+    */
+   TopicSubscriber(const chaudiere::ServiceInfo& subscriberInfo,
+                   const ServiceOptions& options);
+
+   /**
+    * Destructor. Writes whatever is still queued before returning.
+    */
+   ~TopicSubscriber();
+
+   /**
+    * Retrieves the subscribing service
+    * @return the service's information
+    */
+   const chaudiere::ServiceInfo& getSubscriberInfo() const;
+
+protected:
+   int writeQueued(bool isStopping) override;
+
+private:
+   typedef std::shared_ptr<const std::string> Buffer;
+
+   void writeBatch(Buffer* batch, std::size_t numberMessages);
+   bool connect();
+
+   chaudiere::ServiceInfo m_subscriberInfo;
+   std::unique_ptr<chaudiere::Socket> m_socket;
+
+   TopicSubscriber(const TopicSubscriber&);
+   TopicSubscriber& operator=(const TopicSubscriber&);
+};
+
+}
+
+#endif
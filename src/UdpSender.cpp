@@ -0,0 +1,155 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <errno.h>
+#include <netdb.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "UdpSender.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+// most datagrams handed to the kernel in one sendmmsg call
+static const unsigned int MAX_DATAGRAMS_PER_SEND = 64;
+
+//******************************************************************************
+
+UdpSender::UdpSender(const ServiceInfo& serviceInfo,
+                     const ServiceOptions& options) :
+   // the sender never blocks: telemetry that can't keep up is dropped
+   AsyncQueueWriter<std::string>(options.getAsyncQueueSize(), BackpressureFail),
+   m_batchCount(0),
+   m_socketFD(-1) {
+   TONNERRE_LOG_INSTANCE_CREATE("UdpSender");
+
+   struct addrinfo hints;
+   ::memset(&hints, 0, sizeof(hints));
+   hints.ai_family = AF_UNSPEC;
+   hints.ai_socktype = SOCK_DGRAM;
+   hints.ai_flags = AI_NUMERICSERV;
+
+   struct addrinfo* addresses = nullptr;
+   const std::string port = std::to_string(serviceInfo.port());
+   if (::getaddrinfo(serviceInfo.host().c_str(), port.c_str(), &hints, &addresses) != 0) {
+      TONNERRE_LOG_ERROR("unable to resolve address of udp service");
+      return;
+   }
+
+   // connecting fixes the destination, so datagrams don't each carry it
+   for (struct addrinfo* address = addresses; address != nullptr; address = address->ai_next) {
+      const int fd = ::socket(address->ai_family,
+                              address->ai_socktype | SOCK_CLOEXEC,
+                              address->ai_protocol);
+      if (fd < 0) {
+         continue;
+      }
+      if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+         m_socketFD = fd;
+         break;
+      }
+      ::close(fd);
+   }
+   ::freeaddrinfo(addresses);
+
+   if (m_socketFD < 0) {
+      TONNERRE_LOG_ERROR("unable to open udp socket for service");
+      return;
+   }
+
+   start();
+}
+
+//******************************************************************************
+
+UdpSender::~UdpSender() {
+   TONNERRE_LOG_INSTANCE_DESTROY("UdpSender");
+   stop();
+
+   if (m_socketFD >= 0) {
+      ::close(m_socketFD);
+   }
+}
+
+//******************************************************************************
+
+bool UdpSender::isOpen() const {
+   return m_socketFD >= 0;
+}
+
+//******************************************************************************
+
+bool UdpSender::enqueue(const std::string& encodedMessage) {
+   if (encodedMessage.length() > MAX_DATAGRAM_BYTES) {
+      return false;
+   }
+
+   return AsyncQueueWriter<std::string>::enqueue(encodedMessage);
+}
+
+//******************************************************************************
+
+int UdpSender::writeQueued(bool) {
+   std::string batch[MAX_DATAGRAMS_PER_SEND];
+
+   // whatever queued up while the last batch was sent goes out together
+   unsigned int numberMessages = 0;
+   while ((numberMessages < MAX_DATAGRAMS_PER_SEND) &&
+          dequeue(batch[numberMessages])) {
+      ++numberMessages;
+   }
+
+   if (numberMessages == 0) {
+      return NO_DEADLINE;
+   }
+
+   sendBatch(batch, numberMessages);
+   return 0;
+}
+
+//******************************************************************************
+
+void UdpSender::sendBatch(std::string* messages, unsigned int numberMessages) {
+   struct iovec iovecs[MAX_DATAGRAMS_PER_SEND];
+   struct mmsghdr headers[MAX_DATAGRAMS_PER_SEND];
+   ::memset(headers, 0, sizeof(headers));
+
+   for (unsigned int i = 0; i < numberMessages; ++i) {
+      iovecs[i].iov_base = const_cast<char*>(messages[i].data());
+      iovecs[i].iov_len = messages[i].length();
+      headers[i].msg_hdr.msg_iov = &iovecs[i];
+      headers[i].msg_hdr.msg_iovlen = 1;
+   }
+
+   m_batchCount.fetch_add(1, std::memory_order_relaxed);
+
+   unsigned int numberSent = 0;
+   while (numberSent < numberMessages) {
+      const int rc = ::sendmmsg(m_socketFD, headers + numberSent,
+                                numberMessages - numberSent, 0);
+      if (rc > 0) {
+         numberSent += rc;
+         countSent(rc);
+      } else if ((rc < 0) && (errno == EINTR)) {
+         continue;
+      } else {
+         // the error belongs to the first unsent datagram (e.g., a refusal
+         // reported for an earlier one); skip it and carry on with the rest
+         ++numberSent;
+         countFailed(1);
+      }
+   }
+}
+
+//******************************************************************************
+
+std::uint64_t UdpSender::getBatchCount() const {
+   return m_batchCount.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
@@ -0,0 +1,90 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_UDPSENDER_H
+#define TONNERRE_UDPSENDER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "AsyncWriter.h"
+#include "ServiceOptions.h"
+#include "ServiceInfo.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * UdpSender delivers one-way messages for a single service ('transport =
+ * udp') as datagrams, one message per datagram. Callers only enqueue the
+ * flattened message; a background thread drains whatever has queued up
+ * and hands it to the kernel with a single sendmmsg call, so a burst of
+ * messages costs one system call rather than one each. Nothing is
+ * connected or acknowledged: a datagram the network or a busy server
+ * drops is simply lost, which is the trade telemetry-style services make
+ * for not holding any connection state.
+ * @see UdpServer()
+ * @see AsyncQueueWriter()
+ */
+class UdpSender : public AsyncQueueWriter<std::string>
+{
+public:
+   // largest message sent as a datagram (larger ones go over TCP; servers
+   // size their receive buffers to match)
+   static const std::size_t MAX_DATAGRAM_BYTES = 8192;
+
+   /**
+    * Constructs a sender and starts its background thread
+    * @param serviceInfo the destination service
+    * @param options the service's settings ('async_queue_size' bounds the
+    * messages waiting to be sent)
+    * @see ServiceInfo()
+    * @see ServiceOptions()
+    */
+   UdpSender(const chaudiere::ServiceInfo& serviceInfo,
+             const ServiceOptions& options);
+
+   /**
+    * Destructor. Sends whatever is still queued before returning.
+    */
+   ~UdpSender();
+
+   /**
+    * Determines if the service's address was resolved and a socket opened
+    * @return boolean indicating if messages can be sent
+    */
+   bool isOpen() const;
+
+   /**
+    * Queues a flattened one-way message to be sent as a datagram
+    * @param encodedMessage the flattened message (see Message::toString)
+    * @return boolean indicating whether the message was queued (false if
+    * it's larger than MAX_DATAGRAM_BYTES, the queue is full, or after stop)
+    */
+   bool enqueue(const std::string& encodedMessage);
+
+   /**
+    * Retrieves the number of sendmmsg calls made
+    * @return count of batches
+    */
+   std::uint64_t getBatchCount() const;
+
+protected:
+   int writeQueued(bool isStopping) override;
+
+private:
+   void sendBatch(std::string* messages, unsigned int numberMessages);
+
+   std::atomic<std::uint64_t> m_batchCount;
+   int m_socketFD;
+
+   UdpSender(const UdpSender&);
+   UdpSender& operator=(const UdpSender&);
+};
+
+}
+
+#endif
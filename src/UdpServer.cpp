@@ -0,0 +1,217 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "UdpServer.h"
+#include "UdpSender.h"
+#include "Message.h"
+#include "MessageRequestHandler.h"
+#include "ServerMetrics.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+// datagrams received per recvmmsg call (and buffers in the ring)
+static const unsigned int RECEIVE_BATCH        = 64;
+
+// asked of the kernel so that bursts aren't dropped while handlers run
+// (silently capped at net.core.rmem_max)
+static const int RECEIVE_BUFFER_BYTES          = 4 * 1024 * 1024;
+
+// how often a receiving thread with nothing to do checks for stop()
+static const int RECEIVE_TIMEOUT_MILLIS        = 100;
+
+//******************************************************************************
+
+UdpServer::UdpServer(int port, MessageHandler* handler) :
+   m_handler(handler),
+   m_admissionController(nullptr),
+   m_metrics(nullptr),
+   m_requestCount(0),
+   m_droppedCount(0),
+   m_isRunning(false),
+   m_port(port),
+   m_socketFD(-1) {
+   TONNERRE_LOG_INSTANCE_CREATE("UdpServer");
+}
+
+//******************************************************************************
+
+UdpServer::~UdpServer() {
+   TONNERRE_LOG_INSTANCE_DESTROY("UdpServer");
+
+   stop();
+}
+
+//******************************************************************************
+
+void UdpServer::setAdmissionController(AdmissionController* admissionController) {
+   m_admissionController = admissionController;
+}
+
+//******************************************************************************
+
+void UdpServer::setServerMetrics(ServerMetrics* metrics) {
+   m_metrics = metrics;
+}
+
+//******************************************************************************
+
+bool UdpServer::start() {
+   // a dual-stack socket receives from IPv4 and IPv6 senders alike
+   int fd = ::socket(AF_INET6, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+   if (fd >= 0) {
+      const int v6Only = 0;
+      ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &v6Only, sizeof(v6Only));
+
+      struct sockaddr_in6 address;
+      ::memset(&address, 0, sizeof(address));
+      address.sin6_family = AF_INET6;
+      address.sin6_addr = in6addr_any;
+      address.sin6_port = htons((unsigned short) m_port);
+      if (::bind(fd, (struct sockaddr*) &address, sizeof(address)) != 0) {
+         ::close(fd);
+         fd = -1;
+      }
+   }
+
+   if (fd < 0) {
+      fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+      if (fd < 0) {
+         return false;
+      }
+
+      struct sockaddr_in address;
+      ::memset(&address, 0, sizeof(address));
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_ANY);
+      address.sin_port = htons((unsigned short) m_port);
+      if (::bind(fd, (struct sockaddr*) &address, sizeof(address)) != 0) {
+         ::close(fd);
+         return false;
+      }
+   }
+
+   ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF,
+                &RECEIVE_BUFFER_BYTES, sizeof(RECEIVE_BUFFER_BYTES));
+
+   struct timeval timeout;
+   timeout.tv_sec = 0;
+   timeout.tv_usec = RECEIVE_TIMEOUT_MILLIS * 1000;
+   ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+   m_socketFD = fd;
+   m_isRunning.store(true);
+   m_thread = std::thread(&UdpServer::run, this);
+   return true;
+}
+
+//******************************************************************************
+
+void UdpServer::stop() {
+   if (!m_thread.joinable()) {
+      return;
+   }
+
+   m_isRunning.store(false);
+   m_thread.join();
+
+   ::close(m_socketFD);
+   m_socketFD = -1;
+}
+
+//******************************************************************************
+
+std::uint64_t UdpServer::getRequestCount() const {
+   return m_requestCount.load();
+}
+
+//******************************************************************************
+
+std::uint64_t UdpServer::getDroppedCount() const {
+   return m_droppedCount.load();
+}
+
+//******************************************************************************
+
+void UdpServer::run() {
+   // one slot per datagram, a byte larger than any sender uses so that an
+   // oversized datagram shows up as truncated rather than as a short one
+   const std::size_t slotBytes = UdpSender::MAX_DATAGRAM_BYTES + 1;
+   std::vector<char> buffers(RECEIVE_BATCH * slotBytes);
+   struct iovec iovecs[RECEIVE_BATCH];
+   struct mmsghdr headers[RECEIVE_BATCH];
+
+   while (m_isRunning.load()) {
+      ::memset(headers, 0, sizeof(headers));
+      for (unsigned int i = 0; i < RECEIVE_BATCH; ++i) {
+         iovecs[i].iov_base = &buffers[i * slotBytes];
+         iovecs[i].iov_len = slotBytes;
+         headers[i].msg_hdr.msg_iov = &iovecs[i];
+         headers[i].msg_hdr.msg_iovlen = 1;
+      }
+
+      // blocks (up to the receive timeout) for the first datagram only,
+      // then takes whatever else has already arrived
+      const int received = ::recvmmsg(m_socketFD, headers, RECEIVE_BATCH,
+                                      MSG_WAITFORONE, nullptr);
+      if (received < 0) {
+         if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+            TONNERRE_LOG_ERROR("udp receive failed");
+         }
+         continue;
+      }
+
+      for (int i = 0; i < received; ++i) {
+         if ((headers[i].msg_hdr.msg_flags & MSG_TRUNC) ||
+             (headers[i].msg_len > UdpSender::MAX_DATAGRAM_BYTES)) {
+            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+            continue;
+         }
+         handleDatagram(&buffers[i * slotBytes], headers[i].msg_len);
+      }
+   }
+}
+
+//******************************************************************************
+
+void UdpServer::handleDatagram(const char* datagram, std::size_t length) {
+   Message requestMessage;
+   if (!requestMessage.reconstituteFromFrame(std::string(datagram, length)) ||
+       requestMessage.getRequestName().empty()) {
+      m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+      return;
+   }
+
+   // stats are only served where there's a connection to answer on
+   if (ServerMetrics::isStatsRequest(requestMessage)) {
+      m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+      return;
+   }
+
+   // (the response is built for the handler's sake and then discarded)
+   Message responseMessage(requestMessage.getRequestName(),
+                           requestMessage.getType());
+   const MessageRequestHandler::RequestDisposition disposition =
+      MessageRequestHandler::serveRequest(m_handler, m_admissionController, m_metrics,
+                                          requestMessage, length, responseMessage,
+                                          MessageRequestHandler::ResponseWriter(),
+                                          nullptr);
+   if (disposition == MessageRequestHandler::RequestShed) {
+      m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+   } else {
+      m_requestCount.fetch_add(1, std::memory_order_relaxed);
+   }
+}
+
+//******************************************************************************
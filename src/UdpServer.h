@@ -0,0 +1,103 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_UDPSERVER_H
+#define TONNERRE_UDPSERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+
+namespace tonnerre
+{
+   class AdmissionController;
+   class MessageHandler;
+   class ServerMetrics;
+
+/**
+ * UdpServer receives one-way messages sent as datagrams ('udp = true' in
+ * the [server] section) on the messaging server's port, alongside the
+ * usual listener. A single thread receives with recvmmsg into a ring of
+ * preallocated buffers, so a burst of datagrams costs one system call, and
+ * hands each message to the handler on that thread. There is no
+ * connection state and nothing is ever answered: datagrams that are
+ * truncated, malformed, or shed by admission control are counted and
+ * dropped.
+ * @see UdpSender()
+ */
+class UdpServer
+{
+public:
+   /**
+    * Constructs a server (nothing is bound until start())
+    * @param port the UDP port to receive on
+    * @param handler the handler for messages
+    */
+   UdpServer(int port, MessageHandler* handler);
+
+   /**
+    * Destructor (stops the server)
+    */
+   ~UdpServer();
+
+   /**
+    * Sets the admission controller consulted before each message is
+    * dispatched (call before start())
+    * @param admissionController the controller (not owned)
+    * @see AdmissionController()
+    */
+   void setAdmissionController(AdmissionController* admissionController);
+
+   /**
+    * Sets the metrics that each message is recorded in (call before
+    * start())
+    * @param metrics the metrics (not owned)
+    * @see ServerMetrics()
+    */
+   void setServerMetrics(ServerMetrics* metrics);
+
+   /**
+    * Binds the port and starts receiving
+    * @return boolean indicating whether the server is running
+    */
+   bool start();
+
+   /**
+    * Stops receiving and closes the socket
+    */
+   void stop();
+
+   /**
+    * Retrieves the number of messages handed to the handler
+    * @return number of messages
+    */
+   std::uint64_t getRequestCount() const;
+
+   /**
+    * Retrieves the number of datagrams dropped without being handled
+    * @return number of datagrams dropped
+    */
+   std::uint64_t getDroppedCount() const;
+
+private:
+   void run();
+   void handleDatagram(const char* datagram, std::size_t length);
+
+   MessageHandler* m_handler;
+   AdmissionController* m_admissionController;
+   ServerMetrics* m_metrics;
+   std::thread m_thread;
+   std::atomic<std::uint64_t> m_requestCount;
+   std::atomic<std::uint64_t> m_droppedCount;
+   std::atomic<bool> m_isRunning;
+   int m_port;
+   int m_socketFD;
+
+   UdpServer(const UdpServer&);
+   UdpServer& operator=(const UdpServer&);
+};
+
+}
+
+#endif
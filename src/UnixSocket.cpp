@@ -0,0 +1,126 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "UnixSocket.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+static const int LISTEN_BACKLOG = 128;
+
+//******************************************************************************
+
+static bool socketAddress(const std::string& path, struct sockaddr_un& address) {
+   ::memset(&address, 0, sizeof(address));
+   address.sun_family = AF_UNIX;
+   if (path.empty() || (path.length() >= sizeof(address.sun_path))) {
+      TONNERRE_LOG_ERROR("invalid unix socket path: " + path);
+      return false;
+   }
+
+   ::memcpy(address.sun_path, path.c_str(), path.length());
+   return true;
+}
+
+//******************************************************************************
+
+bool UnixSocket::isUnixService(const ServiceInfo& serviceInfo) {
+   return (serviceInfo.port() == 0) && !serviceInfo.host().empty();
+}
+
+//******************************************************************************
+
+Socket* UnixSocket::connectToService(const ServiceInfo& serviceInfo) {
+   if (isUnixService(serviceInfo)) {
+      return connect(serviceInfo.host());
+   }
+
+   return new Socket(serviceInfo.host(), serviceInfo.port());
+}
+
+//******************************************************************************
+
+Socket* UnixSocket::connect(const std::string& path) {
+   struct sockaddr_un address;
+   if (!socketAddress(path, address)) {
+      return nullptr;
+   }
+
+   const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+   if (fd < 0) {
+      return nullptr;
+   }
+
+   if (::connect(fd, (struct sockaddr*) &address, sizeof(address)) != 0) {
+      ::close(fd);
+      return nullptr;
+   }
+
+   return new Socket(fd);
+}
+
+//******************************************************************************
+
+int UnixSocket::startConnect(const std::string& path, bool& isPending) {
+   isPending = false;
+
+   struct sockaddr_un address;
+   if (!socketAddress(path, address)) {
+      return -1;
+   }
+
+   const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+   if (fd < 0) {
+      return -1;
+   }
+
+   if (::connect(fd, (struct sockaddr*) &address, sizeof(address)) == 0) {
+      return fd;
+   } else if (errno == EINPROGRESS) {
+      isPending = true;
+      return fd;
+   }
+
+   ::close(fd);
+   return -1;
+}
+
+//******************************************************************************
+
+int UnixSocket::listen(const std::string& path) {
+   struct sockaddr_un address;
+   if (!socketAddress(path, address)) {
+      return -1;
+   }
+
+   // a socket file outlives its server; anything else at the path is left
+   // alone (and the bind fails)
+   struct stat info;
+   if ((::lstat(path.c_str(), &info) == 0) && S_ISSOCK(info.st_mode)) {
+      ::unlink(path.c_str());
+   }
+
+   const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+   if (fd < 0) {
+      return -1;
+   }
+
+   if ((::bind(fd, (struct sockaddr*) &address, sizeof(address)) != 0) ||
+       (::listen(fd, LISTEN_BACKLOG) != 0)) {
+      TONNERRE_LOG_ERROR("unable to listen on unix socket " + path);
+      ::close(fd);
+      return -1;
+   }
+
+   return fd;
+}
+
+//******************************************************************************
@@ -0,0 +1,68 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_UNIXSOCKET_H
+#define TONNERRE_UNIXSOCKET_H
+
+#include <string>
+
+#include "ServiceInfo.h"
+#include "Socket.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * UnixSocket connects to and listens on AF_UNIX stream sockets, for
+ * services on the same host that are configured with a 'path' rather than
+ * a host and port. Such a service is registered with the path as its host
+ * and a port of 0. Connections carry the same message frames as TCP ones
+ * and are wrapped in an ordinary chaudière Socket.
+ */
+class UnixSocket
+{
+public:
+   /**
+    * Determines if a service is reached through a Unix domain socket
+    * @param serviceInfo the service
+    * @return boolean indicating if the service's host is a socket path
+    * @see ServiceInfo()
+    */
+   static bool isUnixService(const chaudiere::ServiceInfo& serviceInfo);
+
+   /**
+    * Connects to a service, over a Unix domain socket or TCP as configured
+    * @param serviceInfo the service
+    * @return the connected socket, or nullptr if the connection failed
+    */
+   static chaudiere::Socket* connectToService(const chaudiere::ServiceInfo& serviceInfo);
+
+   /**
+    * Connects to a Unix domain socket
+    * @param path the socket's path
+    * @return the connected socket, or nullptr if the connection failed
+    */
+   static chaudiere::Socket* connect(const std::string& path);
+
+   /**
+    * Starts a non-blocking connect to a Unix domain socket (for callers
+    * that poll for completion, such as AsyncClient)
+    * @param path the socket's path
+    * @param isPending set to true if the connect is still in progress
+    * @return the non-blocking file descriptor, or -1 if the connect failed
+    */
+   static int startConnect(const std::string& path, bool& isPending);
+
+   /**
+    * Listens on a Unix domain socket, replacing any socket file left at
+    * the path by an earlier server
+    * @param path the socket's path
+    * @return the listening file descriptor, or -1 on failure
+    */
+   static int listen(const std::string& path);
+};
+
+}
+
+#endif
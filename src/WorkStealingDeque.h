@@ -0,0 +1,157 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_WORKSTEALINGDEQUE_H
+#define TONNERRE_WORKSTEALINGDEQUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+
+namespace tonnerre
+{
+
+/**
+ * WorkStealingDeque is a fixed-capacity Chase-Lev deque. Its owning thread
+ * pushes and pops at the bottom (LIFO, so recently queued work runs while
+ * still warm in cache); any other thread may steal from the top (FIFO).
+ * Only the owner's pop ever races with steals, and only for the last entry.
+ * T must be trivially copyable (it is used with task pointers).
+ */
+template <typename T>
+class WorkStealingDeque
+{
+public:
+   /**
+    * Constructs a deque
+    * @param capacity the maximum number of entries (rounded up to a power of 2)
+    */
+   explicit WorkStealingDeque(std::size_t capacity) :
+      m_capacity(roundUpToPowerOfTwo(capacity)),
+      m_mask(m_capacity - 1),
+      m_items(new std::atomic<T>[m_capacity]),
+      m_top(0),
+      m_bottom(0) {
+   }
+
+   /**
+    * Adds an entry at the bottom (owning thread only)
+    * @param item the entry to add
+    * @return boolean indicating whether the entry was added (false if full)
+    */
+   bool push(T item) {
+      const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+      const std::int64_t top = m_top.load(std::memory_order_acquire);
+      if (bottom - top >= (std::int64_t) m_capacity) {
+         return false;
+      }
+
+      m_items[bottom & m_mask].store(item, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+      return true;
+   }
+
+   /**
+    * Removes the most recently pushed entry (owning thread only)
+    * @param item receives the entry
+    * @return boolean indicating whether an entry was removed
+    */
+   bool pop(T& item) {
+      const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+      m_bottom.store(bottom, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      std::int64_t top = m_top.load(std::memory_order_relaxed);
+
+      if (top > bottom) {
+         // empty
+         m_bottom.store(bottom + 1, std::memory_order_relaxed);
+         return false;
+      }
+
+      item = m_items[bottom & m_mask].load(std::memory_order_relaxed);
+      if (top == bottom) {
+         // last entry -- a thief may be taking it at the same time
+         const bool won =
+            m_top.compare_exchange_strong(top, top + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed);
+         m_bottom.store(bottom + 1, std::memory_order_relaxed);
+         return won;
+      }
+
+      return true;
+   }
+
+   /**
+    * Removes the oldest entry (any thread)
+    * @param item receives the entry
+    * @return boolean indicating whether an entry was removed (false if the
+    * deque was empty or another thread took the entry first)
+    */
+   bool steal(T& item) {
+      std::int64_t top = m_top.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+      if (top >= bottom) {
+         return false;
+      }
+
+      item = m_items[top & m_mask].load(std::memory_order_relaxed);
+      return m_top.compare_exchange_strong(top, top + 1,
+                                           std::memory_order_seq_cst,
+                                           std::memory_order_relaxed);
+   }
+
+   /**
+    * Retrieves the number of entries (a snapshot when other threads are active)
+    * @return number of entries
+    */
+   std::size_t sizeApprox() const {
+      const std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+      const std::int64_t top = m_top.load(std::memory_order_acquire);
+      return (bottom > top) ? (std::size_t) (bottom - top) : 0;
+   }
+
+   /**
+    * Determines whether the deque is empty (a snapshot when other threads are active)
+    * @return boolean indicating whether the deque is empty
+    */
+   bool empty() const {
+      return sizeApprox() == 0;
+   }
+
+   /**
+    * Retrieves the capacity of the deque
+    * @return the maximum number of entries
+    */
+   std::size_t capacity() const {
+      return m_capacity;
+   }
+
+private:
+   static std::size_t roundUpToPowerOfTwo(std::size_t value) {
+      std::size_t result = 2;
+      while (result < value) {
+         result <<= 1;
+      }
+      return result;
+   }
+
+   const std::size_t m_capacity;
+   const std::size_t m_mask;
+   std::unique_ptr<std::atomic<T>[]> m_items;
+   // top is written by thieves, bottom only by the owner; keep them apart
+   alignas(64) std::atomic<std::int64_t> m_top;
+   alignas(64) std::atomic<std::int64_t> m_bottom;
+
+   WorkStealingDeque(const WorkStealingDeque&);
+   WorkStealingDeque& operator=(const WorkStealingDeque&);
+};
+
+}
+
+#endif
@@ -0,0 +1,244 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <chrono>
+
+#include "WorkStealingExecutor.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+const std::size_t WorkStealingExecutor::DEFAULT_DEQUE_CAPACITY     = 1024;
+const std::size_t WorkStealingExecutor::DEFAULT_INJECTION_CAPACITY = 16384;
+
+// spins through the queues this many times before going to sleep
+static const int IDLE_SPINS_BEFORE_SLEEP   = 64;
+
+// upper bound on a sleep, as a backstop for a missed wake-up
+static const int IDLE_SLEEP_MS             = 100;
+
+// the worker (if any) that the current thread is, so that tasks queued
+// from within a task go to that worker's own deque
+static thread_local const WorkStealingExecutor* currentExecutor = nullptr;
+static thread_local std::size_t currentWorkerIndex = 0;
+
+//******************************************************************************
+
+WorkStealingExecutor::WorkStealingExecutor(int numberWorkers,
+                                           std::size_t dequeCapacity,
+                                           std::size_t injectionCapacity) :
+   m_injectionQueue(injectionCapacity),
+   m_numberSleeping(0),
+   m_isRunning(true),
+   m_stealCount(0) {
+   TONNERRE_LOG_INSTANCE_CREATE("WorkStealingExecutor");
+
+   if (numberWorkers < 1) {
+      numberWorkers = 1;
+   }
+
+   // every deque exists before any worker can go looking for a victim
+   for (int i = 0; i < numberWorkers; ++i) {
+      m_workers.emplace_back(new Worker(dequeCapacity));
+   }
+
+   for (std::size_t i = 0; i < m_workers.size(); ++i) {
+      m_workers[i]->thread = std::thread(&WorkStealingExecutor::runWorker, this, i);
+   }
+}
+
+//******************************************************************************
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+   TONNERRE_LOG_INSTANCE_DESTROY("WorkStealingExecutor");
+   stop();
+}
+
+//******************************************************************************
+
+bool WorkStealingExecutor::execute(Runnable* task) {
+   if (task == nullptr) {
+      return false;
+   }
+
+   if (currentExecutor == this) {
+      // a worker queueing follow-on work; it stays on this worker's deque
+      // unless the deque is full
+      if (m_workers[currentWorkerIndex]->deque.push(task)) {
+         wakeWorker();
+         return true;
+      }
+   } else if (!m_isRunning.load(std::memory_order_acquire)) {
+      delete task;
+      return false;
+   }
+
+   // a full injection queue means the workers are far behind; hold the
+   // submitter back rather than dropping a connection
+   while (!m_injectionQueue.tryPush(task)) {
+      if (!m_isRunning.load(std::memory_order_acquire)) {
+         delete task;
+         return false;
+      }
+      std::this_thread::yield();
+   }
+
+   wakeWorker();
+   return true;
+}
+
+//******************************************************************************
+
+void WorkStealingExecutor::stop() {
+   {
+      std::lock_guard<std::mutex> lock(m_sleepMutex);
+      if (!m_isRunning.load(std::memory_order_acquire)) {
+         return;
+      }
+      m_isRunning.store(false, std::memory_order_release);
+      m_sleepCond.notify_all();
+   }
+
+   for (auto& worker : m_workers) {
+      if (worker->thread.joinable()) {
+         worker->thread.join();
+      }
+   }
+
+   // a submitter racing with stop() may have slipped one in after the
+   // workers left
+   Runnable* task = nullptr;
+   while (m_injectionQueue.tryPop(task)) {
+      runTask(task);
+   }
+}
+
+//******************************************************************************
+
+int WorkStealingExecutor::getNumberWorkers() const {
+   return (int) m_workers.size();
+}
+
+//******************************************************************************
+
+std::uint64_t WorkStealingExecutor::getStealCount() const {
+   return m_stealCount.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
+
+void WorkStealingExecutor::runWorker(std::size_t index) {
+   currentExecutor = this;
+   currentWorkerIndex = index;
+
+   int idleSpins = 0;
+
+   for (;;) {
+      Runnable* task = nullptr;
+      if (findTask(index, task)) {
+         idleSpins = 0;
+         runTask(task);
+         continue;
+      }
+
+      if (++idleSpins < IDLE_SPINS_BEFORE_SLEEP) {
+         std::this_thread::yield();
+         continue;
+      }
+      idleSpins = 0;
+
+      std::unique_lock<std::mutex> lock(m_sleepMutex);
+      m_numberSleeping.fetch_add(1, std::memory_order_relaxed);
+      // pairs with the fence in wakeWorker() so that either we see the new
+      // task before sleeping or the submitter sees us sleeping and wakes us
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const bool hasWork = hasQueuedTasks();
+      if (!hasWork && m_isRunning.load(std::memory_order_acquire)) {
+         m_sleepCond.wait_for(lock, std::chrono::milliseconds(IDLE_SLEEP_MS));
+      }
+      m_numberSleeping.fetch_sub(1, std::memory_order_relaxed);
+
+      if (!hasWork && !m_isRunning.load(std::memory_order_acquire) &&
+          !hasQueuedTasks()) {
+         // stopped and fully drained
+         break;
+      }
+   }
+
+   currentExecutor = nullptr;
+}
+
+//******************************************************************************
+
+bool WorkStealingExecutor::findTask(std::size_t index, Runnable*& task) {
+   if (m_workers[index]->deque.pop(task)) {
+      return true;
+   }
+
+   if (m_injectionQueue.tryPop(task)) {
+      return true;
+   }
+
+   // start each round of stealing at a different victim so that idle
+   // workers don't all converge on the same deque
+   static thread_local std::uint32_t randomState =
+      (std::uint32_t) (index * 2654435761u) | 1u;
+   randomState ^= randomState << 13;
+   randomState ^= randomState >> 17;
+   randomState ^= randomState << 5;
+
+   const std::size_t numberWorkers = m_workers.size();
+   const std::size_t start = randomState % numberWorkers;
+   for (std::size_t i = 0; i < numberWorkers; ++i) {
+      const std::size_t victim = (start + i) % numberWorkers;
+      if (victim != index && m_workers[victim]->deque.steal(task)) {
+         m_stealCount.fetch_add(1, std::memory_order_relaxed);
+         return true;
+      }
+   }
+
+   return false;
+}
+
+//******************************************************************************
+
+bool WorkStealingExecutor::hasQueuedTasks() const {
+   if (!m_injectionQueue.empty()) {
+      return true;
+   }
+
+   for (const auto& worker : m_workers) {
+      if (!worker->deque.empty()) {
+         return true;
+      }
+   }
+
+   return false;
+}
+
+//******************************************************************************
+
+void WorkStealingExecutor::wakeWorker() {
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if (m_numberSleeping.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> lock(m_sleepMutex);
+      m_sleepCond.notify_one();
+   }
+}
+
+//******************************************************************************
+
+void WorkStealingExecutor::runTask(Runnable* task) {
+   try {
+      task->run();
+   } catch (const std::exception& e) {
+      TONNERRE_LOG_ERROR("exception caught in executor task: " + std::string(e.what()));
+   } catch (...) {
+      TONNERRE_LOG_ERROR("exception caught in executor task");
+   }
+
+   delete task;
+}
+
+//******************************************************************************
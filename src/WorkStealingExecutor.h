@@ -0,0 +1,93 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_WORKSTEALINGEXECUTOR_H
+#define TONNERRE_WORKSTEALINGEXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Executor.h"
+#include "BoundedQueue.h"
+#include "WorkStealingDeque.h"
+
+
+namespace tonnerre
+{
+
+/**
+ * WorkStealingExecutor gives each worker thread its own deque instead of
+ * one shared, locked queue. Tasks submitted from outside the pool (the
+ * accept loop, the idle connection monitor) go through a lock-free
+ * injection queue; tasks submitted by a task go to the submitting worker's
+ * own deque. A worker with nothing to do steals from the others before it
+ * sleeps, so no lock is taken on the path of a busy server.
+ */
+class WorkStealingExecutor : public Executor
+{
+public:
+   static const std::size_t DEFAULT_DEQUE_CAPACITY;
+   static const std::size_t DEFAULT_INJECTION_CAPACITY;
+
+   /**
+    * Constructs the executor and starts its worker threads
+    * @param numberWorkers the number of worker threads (at least 1)
+    * @param dequeCapacity the capacity of each worker's deque
+    * @param injectionCapacity the capacity of the shared injection queue
+    */
+   explicit WorkStealingExecutor(int numberWorkers,
+                                 std::size_t dequeCapacity=DEFAULT_DEQUE_CAPACITY,
+                                 std::size_t injectionCapacity=DEFAULT_INJECTION_CAPACITY);
+
+   /**
+    * Destructor (stops the executor if still running)
+    */
+   ~WorkStealingExecutor();
+
+   bool execute(chaudiere::Runnable* task) override;
+   void stop() override;
+   int getNumberWorkers() const override;
+
+   /**
+    * Retrieves the number of tasks that workers have taken from each other
+    * @return number of successful steals
+    */
+   std::uint64_t getStealCount() const;
+
+private:
+   struct Worker {
+      explicit Worker(std::size_t dequeCapacity) :
+         deque(dequeCapacity) {
+      }
+
+      WorkStealingDeque<chaudiere::Runnable*> deque;
+      std::thread thread;
+   };
+
+   void runWorker(std::size_t index);
+   bool findTask(std::size_t index, chaudiere::Runnable*& task);
+   bool hasQueuedTasks() const;
+   void wakeWorker();
+   static void runTask(chaudiere::Runnable* task);
+
+   std::vector<std::unique_ptr<Worker>> m_workers;
+   BoundedQueue<chaudiere::Runnable*> m_injectionQueue;
+   std::mutex m_sleepMutex;
+   std::condition_variable m_sleepCond;
+   std::atomic<int> m_numberSleeping;
+   std::atomic<bool> m_isRunning;
+   std::atomic<std::uint64_t> m_stealCount;
+
+   WorkStealingExecutor(const WorkStealingExecutor&);
+   WorkStealingExecutor& operator=(const WorkStealingExecutor&);
+};
+
+}
+
+#endif
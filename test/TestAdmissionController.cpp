@@ -0,0 +1,121 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <chrono>
+
+#include "TestAdmissionController.h"
+#include "AdmissionController.h"
+
+using namespace tonnerre;
+
+typedef AdmissionController::Clock Clock;
+
+//******************************************************************************
+
+TestAdmissionController::TestAdmissionController() :
+   poivre::TestSuite("TestAdmissionController") {
+}
+
+//******************************************************************************
+
+void TestAdmissionController::runTests() {
+   testUnlimited();
+   testMaxInFlight();
+   testMaxQueueDepth();
+   testCodel();
+}
+
+//******************************************************************************
+
+void TestAdmissionController::testUnlimited() {
+   TEST_CASE("testUnlimited");
+
+   AdmissionController controller(0, 0, 0, 100);
+   for (int i = 0; i < 1000; ++i) {
+      require(controller.enqueue(), "queue should be unlimited");
+      require(controller.admit(std::chrono::seconds(10)), "requests should be admitted without limits");
+   }
+
+   require(controller.getInFlight() == 1000, "every admitted request should be in flight");
+   require(controller.getQueueDepth() == 1000, "every enqueued connection should be counted");
+   require(controller.getShedCount() == 0, "nothing should be shed");
+}
+
+//******************************************************************************
+
+void TestAdmissionController::testMaxInFlight() {
+   TEST_CASE("testMaxInFlight");
+
+   AdmissionController controller(2, 0, 0, 100);
+   require(controller.admit(Clock::duration::zero()), "first request should be admitted");
+   require(controller.admit(Clock::duration::zero()), "second request should be admitted");
+   requireFalse(controller.admit(Clock::duration::zero()), "third request should be shed");
+   require(controller.getInFlight() == 2, "shed request should not count as in flight");
+   require(controller.getShedCount() == 1, "shed request should be counted");
+
+   controller.release();
+   require(controller.admit(Clock::duration::zero()), "released slot should be reusable");
+}
+
+//******************************************************************************
+
+void TestAdmissionController::testMaxQueueDepth() {
+   TEST_CASE("testMaxQueueDepth");
+
+   AdmissionController controller(0, 2, 0, 100);
+   require(controller.enqueue(), "first connection should be queued");
+   require(controller.enqueue(), "second connection should be queued");
+   requireFalse(controller.enqueue(), "third connection should be turned away");
+   require(controller.getQueueDepth() == 2, "turned away connection should not be counted");
+   require(controller.getShedCount() == 1, "turned away connection should count as shed");
+
+   controller.dequeue();
+   require(controller.enqueue(), "dequeue should make room");
+}
+
+//******************************************************************************
+
+void TestAdmissionController::testCodel() {
+   TEST_CASE("testCodel");
+
+   const std::chrono::milliseconds target(5);
+   const std::chrono::milliseconds interval(100);
+   AdmissionController controller(0, 0, (int) target.count(), (int) interval.count());
+
+   Clock::time_point now = Clock::now();
+
+   // a short burst of long waits doesn't shed: the interval also saw a
+   // short wait
+   require(controller.admit(std::chrono::milliseconds(1), now), "short wait should be admitted");
+   require(controller.admit(std::chrono::milliseconds(50), now), "burst should be admitted");
+   controller.release();
+   controller.release();
+
+   now += interval;
+   require(controller.admit(std::chrono::milliseconds(50), now), "interval with a short wait is not a standing queue");
+   controller.release();
+   requireFalse(controller.isQueueStanding(), "queue should not be standing after a burst");
+
+   // a whole interval above target means the queue is standing
+   for (int i = 0; i < 5; ++i) {
+      now += std::chrono::milliseconds(10);
+      controller.admit(std::chrono::milliseconds(20), now);
+      controller.release();
+   }
+
+   now += interval;
+   requireFalse(controller.admit(std::chrono::milliseconds(50), now), "long wait should be shed while the queue stands");
+   require(controller.isQueueStanding(), "queue should be standing");
+   require(controller.admit(std::chrono::milliseconds(8), now), "wait under twice the target should still be admitted");
+   controller.release();
+
+   // the shortest wait of the next interval is back under target
+   now += std::chrono::milliseconds(10);
+   require(controller.admit(std::chrono::milliseconds(1), now), "short wait should be admitted");
+   controller.release();
+   now += interval;
+   require(controller.admit(std::chrono::milliseconds(50), now), "queue should stop shedding once it drains");
+   requireFalse(controller.isQueueStanding(), "queue should no longer be standing");
+}
+
+//******************************************************************************
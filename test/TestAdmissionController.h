@@ -0,0 +1,30 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTADMISSIONCONTROLLER_H
+#define TONNERRE_TESTADMISSIONCONTROLLER_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestAdmissionController : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testUnlimited();
+   void testMaxInFlight();
+   void testMaxQueueDepth();
+   void testCodel();
+
+public:
+   TestAdmissionController();
+
+};
+
+}
+
+#endif
+
@@ -0,0 +1,187 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TestAsyncLogSink.h"
+#include "AsyncLogSink.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+// (long enough that only flush() drains during a test)
+static const int NO_DRAIN_MILLIS = 60000;
+
+namespace {
+
+struct CapturedLog {
+   std::mutex mutex;
+   std::vector<std::pair<LogLevel, std::string>> messages;
+
+   AsyncLogSink::Writer writer() {
+      return [this](LogLevel level, const std::string& message) {
+         std::lock_guard<std::mutex> lock(mutex);
+         messages.push_back(std::make_pair(level, message));
+      };
+   }
+
+   std::size_t size() {
+      std::lock_guard<std::mutex> lock(mutex);
+      return messages.size();
+   }
+};
+
+}
+
+//******************************************************************************
+
+TestAsyncLogSink::TestAsyncLogSink() :
+   poivre::TestSuite("TestAsyncLogSink") {
+}
+
+//******************************************************************************
+
+void TestAsyncLogSink::runTests() {
+   testAppendAndFlush();
+   testDropsWhenFull();
+   testTruncatesLongMessages();
+   testDrainThread();
+   testManyThreads();
+   testStartStop();
+}
+
+//******************************************************************************
+
+void TestAsyncLogSink::testAppendAndFlush() {
+   TEST_CASE("testAppendAndFlush");
+
+   CapturedLog captured;
+   AsyncLogSink sink(16, captured.writer(), NO_DRAIN_MILLIS);
+
+   require(sink.append(Error, "unable to write to socket"), "append should queue the message");
+   require(sink.append(Warning, "no route for text request 'x'"), "append should queue the message");
+   require(captured.size() == 0, "messages should wait for the drain");
+
+   sink.flush();
+   require(captured.size() == 2, "flush should write the queued messages");
+   require(captured.messages[0].first == Error, "the level should be kept");
+   requireStringEquals("unable to write to socket", captured.messages[0].second,
+                       "messages should be written in order");
+   requireStringEquals("no route for text request 'x'", captured.messages[1].second,
+                       "messages should be written in order");
+   require(sink.getDropped() == 0, "nothing should be dropped");
+}
+
+//******************************************************************************
+
+void TestAsyncLogSink::testDropsWhenFull() {
+   TEST_CASE("testDropsWhenFull");
+
+   CapturedLog captured;
+   AsyncLogSink sink(4, captured.writer(), NO_DRAIN_MILLIS);
+
+   int queued = 0;
+   for (int i = 0; i < 10; ++i) {
+      if (sink.append(Error, "bad frame " + std::to_string(i))) {
+         ++queued;
+      }
+   }
+   require(queued == 4, "a full ring should refuse records");
+   require(sink.getDropped() == 6, "refused records should be counted");
+
+   sink.flush();
+   require(captured.size() == 5, "the queued records and a drop report should be written");
+   requireStringEquals("bad frame 3", captured.messages[3].second,
+                       "the oldest records should be kept");
+   require(captured.messages[4].first == Warning, "drops should be reported as a warning");
+   require(captured.messages[4].second.find("dropped 6") != std::string::npos,
+           "the report should give the number dropped");
+
+   require(sink.append(Error, "bad frame 10"), "a drained ring should take records again");
+   sink.flush();
+   require(captured.size() == 6, "drops already reported should not be reported again");
+}
+
+//******************************************************************************
+
+void TestAsyncLogSink::testTruncatesLongMessages() {
+   TEST_CASE("testTruncatesLongMessages");
+
+   CapturedLog captured;
+   AsyncLogSink sink(4, captured.writer(), NO_DRAIN_MILLIS);
+
+   sink.append(Error, std::string(1000, 'x'));
+   sink.flush();
+   require(captured.size() == 1, "the message should be written");
+   require(captured.messages[0].second.length() == AsyncLogSink::MAX_MESSAGE_LENGTH,
+           "a long message should be truncated to a record");
+}
+
+//******************************************************************************
+
+void TestAsyncLogSink::testDrainThread() {
+   TEST_CASE("testDrainThread");
+
+   CapturedLog captured;
+   {
+      AsyncLogSink sink(16, captured.writer(), 1);
+      sink.append(Error, "first");
+
+      for (int i = 0; (i < 1000) && (captured.size() == 0); ++i) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      require(captured.size() == 1, "the drain thread should write the message");
+
+      sink.append(Error, "second");
+   }
+
+   require(captured.size() == 2, "destroying the sink should write what's left");
+}
+
+//******************************************************************************
+
+void TestAsyncLogSink::testManyThreads() {
+   TEST_CASE("testManyThreads");
+
+   CapturedLog captured;
+   AsyncLogSink sink(256, captured.writer(), 1);
+
+   std::vector<std::thread> threads;
+   for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&sink, t]() {
+         for (int i = 0; i < 200; ++i) {
+            sink.append(Error, "thread " + std::to_string(t));
+         }
+      });
+   }
+
+   for (auto& thread : threads) {
+      thread.join();
+   }
+
+   sink.flush();
+   require(captured.size() == 800, "each thread's messages should all be written");
+   require(sink.getDropped() == 0, "rings that aren't full should drop nothing");
+}
+
+//******************************************************************************
+
+void TestAsyncLogSink::testStartStop() {
+   TEST_CASE("testStartStop");
+
+   requireFalse(AsyncLogSink::isRunning(), "the process-wide sink should not run by default");
+
+   AsyncLogSink::start();
+   require(AsyncLogSink::isRunning(), "start should run the process-wide sink");
+   AsyncLogSink::log(Info, "logged through the sink");
+   require(AsyncLogSink::getDroppedRecords() == 0, "nothing should be dropped");
+
+   AsyncLogSink::stop();
+   requireFalse(AsyncLogSink::isRunning(), "stop should stop the process-wide sink");
+}
+
+//******************************************************************************
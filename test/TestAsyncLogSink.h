@@ -0,0 +1,31 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTASYNCLOGSINK_H
+#define TONNERRE_TESTASYNCLOGSINK_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestAsyncLogSink : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testAppendAndFlush();
+   void testDropsWhenFull();
+   void testTruncatesLongMessages();
+   void testDrainThread();
+   void testManyThreads();
+   void testStartStop();
+
+public:
+   TestAsyncLogSink();
+
+};
+
+}
+
+#endif
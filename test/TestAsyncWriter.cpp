@@ -0,0 +1,176 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "TestAsyncWriter.h"
+#include "AsyncWriter.h"
+
+using namespace tonnerre;
+
+namespace {
+
+// records what it writes; while held, its thread waits before dequeueing
+// so that the queue can be filled
+class RecordingWriter : public AsyncQueueWriter<int> {
+public:
+   RecordingWriter(std::size_t capacity, BackpressurePolicy backpressure) :
+      AsyncQueueWriter<int>(capacity, backpressure),
+      m_isHeld(true) {
+      start();
+   }
+
+   ~RecordingWriter() {
+      release();
+      stop();
+   }
+
+   void release() {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_isHeld = false;
+      m_cond.notify_all();
+   }
+
+   std::vector<int> written() {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_written;
+   }
+
+protected:
+   int writeQueued(bool) override {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cond.wait(lock, [this] { return !m_isHeld; });
+
+      int value;
+      std::uint64_t numberWritten = 0;
+      while (dequeue(value)) {
+         m_written.push_back(value);
+         ++numberWritten;
+      }
+
+      countSent(numberWritten);
+      return (numberWritten > 0) ? 0 : NO_DEADLINE;
+   }
+
+private:
+   std::mutex m_mutex;
+   std::condition_variable m_cond;
+   std::vector<int> m_written;
+   bool m_isHeld;
+};
+
+}
+
+//******************************************************************************
+
+TestAsyncWriter::TestAsyncWriter() :
+   poivre::TestSuite("TestAsyncWriter") {
+}
+
+//******************************************************************************
+
+void TestAsyncWriter::runTests() {
+   testWritesInOrder();
+   testBackpressureFail();
+   testBackpressureDropOldest();
+   testBackpressureBlock();
+   testEnqueueAfterStop();
+}
+
+//******************************************************************************
+
+void TestAsyncWriter::testWritesInOrder() {
+   TEST_CASE("testWritesInOrder");
+
+   RecordingWriter writer(16, BackpressureBlock);
+   writer.release();
+   for (int i = 0; i < 5; ++i) {
+      require(writer.enqueue(i), "enqueue should succeed");
+   }
+   writer.stop();
+
+   const std::vector<int> written = writer.written();
+   require(written.size() == 5, "stop should write everything queued");
+   for (int i = 0; i < 5; ++i) {
+      require(written[i] == i, "messages should be written in order");
+   }
+   require(writer.getSentCount() == 5, "sent count");
+   require(writer.getDroppedCount() == 0, "nothing dropped");
+}
+
+//******************************************************************************
+
+void TestAsyncWriter::testBackpressureFail() {
+   TEST_CASE("testBackpressureFail");
+
+   RecordingWriter writer(2, BackpressureFail);
+   require(writer.enqueue(1), "enqueue 1");
+   require(writer.enqueue(2), "enqueue 2");
+   requireFalse(writer.enqueue(3), "enqueue into a full queue should fail");
+   require(writer.getDroppedCount() == 1, "rejected message should be counted");
+
+   writer.release();
+   writer.stop();
+   const std::vector<int> written = writer.written();
+   require(written.size() == 2, "queued messages should be written");
+   require((written[0] == 1) && (written[1] == 2), "the new message is the one rejected");
+}
+
+//******************************************************************************
+
+void TestAsyncWriter::testBackpressureDropOldest() {
+   TEST_CASE("testBackpressureDropOldest");
+
+   RecordingWriter writer(2, BackpressureDropOldest);
+   require(writer.enqueue(1), "enqueue 1");
+   require(writer.enqueue(2), "enqueue 2");
+   require(writer.enqueue(3), "enqueue into a full queue should make room");
+   require(writer.getDroppedCount() == 1, "discarded message should be counted");
+
+   writer.release();
+   writer.stop();
+   const std::vector<int> written = writer.written();
+   require(written.size() == 2, "queued messages should be written");
+   require((written[0] == 2) && (written[1] == 3), "the oldest message is the one discarded");
+}
+
+//******************************************************************************
+
+void TestAsyncWriter::testBackpressureBlock() {
+   TEST_CASE("testBackpressureBlock");
+
+   RecordingWriter writer(2, BackpressureBlock);
+   require(writer.enqueue(1), "enqueue 1");
+   require(writer.enqueue(2), "enqueue 2");
+
+   std::thread releaser([&writer]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      writer.release();
+   });
+
+   require(writer.enqueue(3), "enqueue into a full queue should wait for room");
+   releaser.join();
+   writer.stop();
+
+   require(writer.getDroppedCount() == 0, "nothing dropped");
+   require(writer.written().size() == 3, "every message should be written");
+}
+
+//******************************************************************************
+
+void TestAsyncWriter::testEnqueueAfterStop() {
+   TEST_CASE("testEnqueueAfterStop");
+
+   RecordingWriter writer(4, BackpressureBlock);
+   writer.release();
+   writer.stop();
+   requireFalse(writer.enqueue(1), "enqueue after stop should fail");
+   require(writer.written().empty(), "nothing written");
+}
+
+//******************************************************************************
+
@@ -0,0 +1,31 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTASYNCWRITER_H
+#define TONNERRE_TESTASYNCWRITER_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestAsyncWriter : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testWritesInOrder();
+   void testBackpressureFail();
+   void testBackpressureDropOldest();
+   void testBackpressureBlock();
+   void testEnqueueAfterStop();
+
+public:
+   TestAsyncWriter();
+
+};
+
+}
+
+#endif
+
@@ -0,0 +1,117 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <memory>
+
+#include "TestBatchingSender.h"
+#include "BatchingSender.h"
+#include "Message.h"
+#include "ServerSocket.h"
+#include "ServiceInfo.h"
+#include "ServiceOptions.h"
+#include "Socket.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+//******************************************************************************
+
+TestBatchingSender::TestBatchingSender() :
+   poivre::TestSuite("TestBatchingSender") {
+}
+
+//******************************************************************************
+
+void TestBatchingSender::runTests() {
+   testEnqueueDelivers();
+   testBatching();
+   testEnqueueAfterStop();
+}
+
+//******************************************************************************
+
+void TestBatchingSender::testEnqueueDelivers() {
+   TEST_CASE("testEnqueueDelivers");
+
+   const int port = 34720;
+   ServerSocket serverListener(port);
+
+   ServiceInfo serviceInfo("asyncService", "127.0.0.1", (unsigned short) port);
+   ServiceOptions options;
+   options.setAsyncOneWay(true);
+   options.setAsyncLingerMillis(1);
+
+   BatchingSender sender(serviceInfo, options);
+
+   for (int i = 0; i < 3; ++i) {
+      Message message("event", MessageTypeText);
+      message.setTextPayload("event-" + std::to_string(i));
+      require(sender.enqueue(message.toString()), "enqueue should succeed");
+   }
+
+   std::unique_ptr<Socket> accepted(serverListener.accept());
+   require(accepted != nullptr, "sender should connect to the service");
+
+   for (int i = 0; i < 3; ++i) {
+      Message received;
+      require(received.reconstitute(accepted.get()), "server should read each queued message");
+      requireStringEquals("event-" + std::to_string(i), received.getTextPayload(), "messages should arrive in order");
+   }
+
+   sender.stop();
+   require(sender.getSentCount() == 3, "all messages should be counted as sent");
+   require(sender.getDroppedCount() == 0, "no messages should be dropped");
+}
+
+//******************************************************************************
+
+void TestBatchingSender::testBatching() {
+   TEST_CASE("testBatching");
+
+   const int port = 34721;
+   ServerSocket serverListener(port);
+
+   ServiceInfo serviceInfo("asyncService", "127.0.0.1", (unsigned short) port);
+   ServiceOptions options;
+   options.setAsyncOneWay(true);
+   options.setAsyncLingerMillis(200);
+
+   const int numMessages = 20;
+   BatchingSender sender(serviceInfo, options);
+   for (int i = 0; i < numMessages; ++i) {
+      Message message("metric", MessageTypeText);
+      message.setTextPayload("value");
+      sender.enqueue(message.toString());
+   }
+
+   // stop() flushes the partial batch without waiting out the linger time
+   sender.stop();
+
+   std::unique_ptr<Socket> accepted(serverListener.accept());
+   int received = 0;
+   for (int i = 0; i < numMessages; ++i) {
+      Message message;
+      if (message.reconstitute(accepted.get())) {
+         ++received;
+      }
+   }
+
+   require(received == numMessages, "every message should be delivered");
+   require(sender.getBatchCount() < (std::uint64_t) numMessages, "messages should be coalesced into fewer writes");
+}
+
+//******************************************************************************
+
+void TestBatchingSender::testEnqueueAfterStop() {
+   TEST_CASE("testEnqueueAfterStop");
+
+   ServiceInfo serviceInfo("asyncService", "127.0.0.1", 34722);
+   ServiceOptions options;
+   BatchingSender sender(serviceInfo, options);
+   sender.stop();
+
+   Message message("late", MessageTypeText);
+   requireFalse(sender.enqueue(message.toString()), "enqueue after stop should fail");
+}
+
+//******************************************************************************
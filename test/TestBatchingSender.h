@@ -0,0 +1,29 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTBATCHINGSENDER_H
+#define TONNERRE_TESTBATCHINGSENDER_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestBatchingSender : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testEnqueueDelivers();
+   void testBatching();
+   void testEnqueueAfterStop();
+
+public:
+   TestBatchingSender();
+
+};
+
+}
+
+#endif
+
@@ -0,0 +1,139 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TestBoundedQueue.h"
+#include "BoundedQueue.h"
+
+using namespace tonnerre;
+
+//******************************************************************************
+
+TestBoundedQueue::TestBoundedQueue() :
+   poivre::TestSuite("TestBoundedQueue") {
+}
+
+//******************************************************************************
+
+void TestBoundedQueue::runTests() {
+   testCapacity();
+   testPushPop();
+   testFull();
+   testEmpty();
+   testConcurrentProducers();
+}
+
+//******************************************************************************
+
+void TestBoundedQueue::testCapacity() {
+   TEST_CASE("testCapacity");
+
+   BoundedQueue<int> queue(5);
+   require(queue.capacity() == 8, "capacity should be rounded up to a power of 2");
+
+   BoundedQueue<int> tiny(0);
+   require(tiny.capacity() == 2, "capacity should be at least 2");
+}
+
+//******************************************************************************
+
+void TestBoundedQueue::testPushPop() {
+   TEST_CASE("testPushPop");
+
+   BoundedQueue<std::string> queue(4);
+   std::string first("first");
+   std::string second("second");
+   require(queue.tryPush(first), "push into empty queue should succeed");
+   require(queue.tryPush(second), "second push should succeed");
+
+   std::string popped;
+   require(queue.tryPop(popped), "pop should succeed");
+   requireStringEquals("first", popped, "entries should come out in FIFO order");
+   require(queue.tryPop(popped), "second pop should succeed");
+   requireStringEquals("second", popped, "second entry");
+   requireFalse(queue.tryPop(popped), "pop from empty queue should fail");
+}
+
+//******************************************************************************
+
+void TestBoundedQueue::testFull() {
+   TEST_CASE("testFull");
+
+   BoundedQueue<std::string> queue(2);
+   std::string a("a");
+   std::string b("b");
+   std::string c("c");
+   require(queue.tryPush(a), "push 1");
+   require(queue.tryPush(b), "push 2");
+   requireFalse(queue.tryPush(c), "push into full queue should fail");
+   requireStringEquals("c", c, "a failed push should leave the item untouched");
+
+   std::string popped;
+   require(queue.tryPop(popped), "pop from full queue");
+   require(queue.tryPush(c), "push should succeed once there's room");
+}
+
+//******************************************************************************
+
+void TestBoundedQueue::testEmpty() {
+   TEST_CASE("testEmpty");
+
+   BoundedQueue<int> queue(4);
+   require(queue.empty(), "new queue should be empty");
+   int value = 7;
+   queue.tryPush(value);
+   requireFalse(queue.empty(), "queue with an entry should not be empty");
+   require(queue.sizeApprox() == 1, "size should be 1");
+}
+
+//******************************************************************************
+
+void TestBoundedQueue::testConcurrentProducers() {
+   TEST_CASE("testConcurrentProducers");
+
+   const int numProducers = 4;
+   const int perProducer = 10000;
+   BoundedQueue<int> queue(1024);
+
+   std::vector<std::thread> producers;
+   for (int p = 0; p < numProducers; ++p) {
+      producers.emplace_back([&queue, p, perProducer]() {
+         for (int i = 0; i < perProducer; ++i) {
+            int value = (p * perProducer) + i;
+            while (!queue.tryPush(value)) {
+               std::this_thread::yield();
+            }
+         }
+      });
+   }
+
+   std::vector<int> lastSeen(numProducers, -1);
+   bool inOrder = true;
+   int received = 0;
+   while (received < numProducers * perProducer) {
+      int value;
+      if (queue.tryPop(value)) {
+         const int producer = value / perProducer;
+         if (value <= lastSeen[producer]) {
+            inOrder = false;
+         }
+         lastSeen[producer] = value;
+         ++received;
+      } else {
+         std::this_thread::yield();
+      }
+   }
+
+   for (auto& producer : producers) {
+      producer.join();
+   }
+
+   require(received == numProducers * perProducer, "every pushed entry should be popped exactly once");
+   require(inOrder, "entries from one producer should keep their order");
+   require(queue.empty(), "queue should be empty after draining");
+}
+
+//******************************************************************************
@@ -0,0 +1,31 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTBOUNDEDQUEUE_H
+#define TONNERRE_TESTBOUNDEDQUEUE_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestBoundedQueue : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testCapacity();
+   void testPushPop();
+   void testFull();
+   void testEmpty();
+   void testConcurrentProducers();
+
+public:
+   TestBoundedQueue();
+
+};
+
+}
+
+#endif
+
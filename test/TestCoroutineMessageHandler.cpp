@@ -0,0 +1,257 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "TestCoroutineMessageHandler.h"
+#include "CoroutineMessageHandler.h"
+#include "CoroutineReactor.h"
+#include "AsyncClient.h"
+#include "MessageRequestHandler.h"
+#include "Messaging.h"
+#include "Message.h"
+#include "KeyValuePairs.h"
+#include "ServerSocket.h"
+#include "ServiceInfo.h"
+#include "Socket.h"
+#include "UnixSocket.h"
+#include "LoopbackConnection.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+namespace {
+
+Task<int> addLater(int a, int b) {
+   co_await sleepFor(std::chrono::milliseconds(1));
+   co_return a + b;
+}
+
+Task<void> doNothingLater() {
+   co_await sleepFor(std::chrono::milliseconds(1));
+}
+
+// Awaits nested tasks (one returning a value, one returning nothing).
+class NestedTaskHandler : public tonnerre::CoroutineMessageHandler {
+public:
+   Task<std::string> handleTextMessageCoroutine(Message requestMessage) override {
+      co_await doNothingLater();
+      const int sum = co_await addLater(2, 3);
+      co_return requestMessage.getTextPayload() + std::to_string(sum);
+   }
+
+   Task<KeyValuePairs> handleKeyValuesMessageCoroutine(Message requestMessage) override {
+      KeyValuePairs kvp(requestMessage.getKeyValuesPayload());
+      kvp.addPair("sum", std::to_string(co_await addLater(20, 22)));
+      co_return kvp;
+   }
+};
+
+// Sleeps before responding.
+class SleepingHandler : public tonnerre::CoroutineMessageHandler {
+public:
+   explicit SleepingHandler(int sleepMillis) :
+      m_sleepMillis(sleepMillis) {
+   }
+
+   Task<std::string> handleTextMessageCoroutine(Message requestMessage) override {
+      co_await sleepFor(std::chrono::milliseconds(m_sleepMillis));
+      co_return "slept: " + requestMessage.getTextPayload();
+   }
+
+private:
+   int m_sleepMillis;
+};
+
+// Throws after suspending.
+class ThrowingHandler : public tonnerre::CoroutineMessageHandler {
+public:
+   Task<std::string> handleTextMessageCoroutine(Message) override {
+      co_await sleepFor(std::chrono::milliseconds(1));
+      throw std::runtime_error("coroutine handler failure");
+   }
+};
+
+// Forwards the request payload to a downstream service.
+class ForwardingHandler : public tonnerre::CoroutineMessageHandler {
+public:
+   Task<std::string> handleTextMessageCoroutine(Message requestMessage) override {
+      Message downstreamRequest("lookup", MessageTypeText);
+      downstreamRequest.setTextPayload(requestMessage.getTextPayload());
+
+      Message downstreamResponse;
+      if (co_await AsyncClient::send(downstreamRequest, "downstream", downstreamResponse)) {
+         co_return "forwarded " + downstreamResponse.getTextPayload();
+      }
+      co_return "downstream call failed";
+   }
+};
+
+std::string dispatchText(MessageHandler& handler, const std::string& payload) {
+   Message request("coroutineTest", MessageTypeText);
+   request.setTextPayload(payload);
+   Message response("coroutineTest", MessageTypeText);
+   MessageRequestHandler::dispatch(&handler, request, response);
+   return response.getTextPayload();
+}
+
+}
+
+//******************************************************************************
+
+TestCoroutineMessageHandler::TestCoroutineMessageHandler() :
+   poivre::TestSuite("TestCoroutineMessageHandler") {
+}
+
+//******************************************************************************
+
+void TestCoroutineMessageHandler::runTests() {
+   testNestedTasks();
+   testSleepFor();
+   testException();
+   testDownstreamCall();
+   testDownstreamUnixSocket();
+   testRunCoroutine();
+}
+
+//******************************************************************************
+
+void TestCoroutineMessageHandler::testNestedTasks() {
+   TEST_CASE("testNestedTasks");
+
+   NestedTaskHandler handler;
+   requireStringEquals("sum=5", dispatchText(handler, "sum="), "text coroutine should see nested task results");
+
+   Message request("coroutineTest", MessageTypeKeyValues);
+   KeyValuePairs kvp;
+   kvp.addPair("k", "v");
+   request.setKeyValuesPayload(kvp);
+   Message response("coroutineTest", MessageTypeKeyValues);
+   MessageRequestHandler::dispatch(&handler, request, response);
+   requireStringEquals("v", response.getKeyValuesPayload().getValue("k"), "key-values coroutine should see the request payload");
+   requireStringEquals("42", response.getKeyValuesPayload().getValue("sum"), "key-values coroutine should see nested task results");
+}
+
+//******************************************************************************
+
+void TestCoroutineMessageHandler::testSleepFor() {
+   TEST_CASE("testSleepFor");
+
+   SleepingHandler handler(30);
+   const auto start = std::chrono::steady_clock::now();
+   requireStringEquals("slept: zzz", dispatchText(handler, "zzz"), "coroutine should resume after sleeping");
+   const auto elapsed = std::chrono::steady_clock::now() - start;
+   require(elapsed >= std::chrono::milliseconds(30), "coroutine should not resume before the delay");
+}
+
+//******************************************************************************
+
+void TestCoroutineMessageHandler::testException() {
+   TEST_CASE("testException");
+
+   ThrowingHandler handler;
+   requireStringEquals("", dispatchText(handler, "x"), "a throwing coroutine should produce an empty response");
+}
+
+//******************************************************************************
+
+void TestCoroutineMessageHandler::testDownstreamCall() {
+   TEST_CASE("testDownstreamCall");
+
+   const int downstreamPort = 34737;
+   Messaging* messaging = new Messaging();
+   messaging->registerService("downstream", ServiceInfo("downstream", "127.0.0.1", downstreamPort));
+   Messaging::setMessaging(messaging);
+
+   // a minimal downstream service answering one request
+   ServerSocket listener(downstreamPort);
+   std::thread downstream([&listener]() {
+      Socket* socket = listener.accept();
+      Message request;
+      if (socket != nullptr && request.reconstitute(socket)) {
+         Message response(request.getRequestName(), MessageTypeText);
+         response.setTextPayload("[" + request.getTextPayload() + "] via " + request.getServiceName());
+         socket->write(response.toString());
+      }
+      delete socket;
+   });
+
+   ForwardingHandler handler;
+   const std::string response = dispatchText(handler, "payload");
+   downstream.join();
+
+   requireStringEquals("forwarded [payload] via downstream", response, "coroutine should await the downstream response");
+
+   Messaging::setMessaging(nullptr);
+}
+
+//******************************************************************************
+
+void TestCoroutineMessageHandler::testDownstreamUnixSocket() {
+   TEST_CASE("testDownstreamUnixSocket");
+
+   const std::string path = "/tmp/tonnerre-test-" + std::to_string(::getpid()) + "-downstream.sock";
+   const int listenFd = UnixSocket::listen(path);
+   require(listenFd >= 0, "listen should succeed");
+
+   Messaging* messaging = new Messaging();
+   messaging->registerService("downstream", ServiceInfo("downstream", path, 0));
+   Messaging::setMessaging(messaging);
+
+   std::thread downstream([listenFd]() {
+      const int fd = ::accept(listenFd, nullptr, nullptr);
+      if (fd >= 0) {
+         Socket socket(fd);
+         Message request;
+         if (request.reconstitute(&socket)) {
+            Message response(request.getRequestName(), MessageTypeText);
+            response.setTextPayload("[" + request.getTextPayload() + "] via unix socket");
+            socket.write(response.toString());
+         }
+      }
+   });
+
+   ForwardingHandler handler;
+   const std::string response = dispatchText(handler, "payload");
+   ::shutdown(listenFd, SHUT_RDWR); // (wakes the accept if nothing connected)
+   downstream.join();
+
+   requireStringEquals("forwarded [payload] via unix socket", response, "coroutine should reach a path= service over its unix socket");
+
+   Messaging::setMessaging(nullptr);
+   ::close(listenFd);
+   ::unlink(path.c_str());
+}
+
+//******************************************************************************
+
+void TestCoroutineMessageHandler::testRunCoroutine() {
+   TEST_CASE("testRunCoroutine");
+
+   tonnerre_test::LoopbackConnection conn(34738);
+
+   Message request("coroutineTest", MessageTypeText);
+   request.setTextPayload("request");
+   require(conn.clientSocket->write(request.toString()), "writing request should succeed");
+
+   SleepingHandler sleepingHandler(20);
+   Socket* serverSocket = conn.serverSideSocket;
+   conn.serverSideSocket = nullptr; // ownership transferred to the handler below
+
+   {
+      MessageRequestHandler handler(serverSocket, &sleepingHandler);
+      handler.run();
+   }
+
+   // the handler returned while the coroutine was still asleep; the
+   // response is written when it resumes on the reactor
+   Message response;
+   require(response.reconstitute(conn.clientSocket), "client should receive the coroutine's response");
+   requireStringEquals("slept: request", response.getTextPayload(), "response should carry the co_returned payload");
+}
+
+//******************************************************************************
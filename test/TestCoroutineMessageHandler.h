@@ -0,0 +1,32 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTCOROUTINEMESSAGEHANDLER_H
+#define TONNERRE_TESTCOROUTINEMESSAGEHANDLER_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestCoroutineMessageHandler : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testNestedTasks();
+   void testSleepFor();
+   void testException();
+   void testDownstreamCall();
+   void testDownstreamUnixSocket();
+   void testRunCoroutine();
+
+public:
+   TestCoroutineMessageHandler();
+
+};
+
+}
+
+#endif
+
@@ -0,0 +1,168 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "TestIdleConnectionMonitor.h"
+#include "IdleConnectionMonitor.h"
+#include "LoopbackConnection.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+namespace {
+
+// Records the connection handed back by the monitor (and takes ownership
+// of it, as a real resume callback would).
+struct ResumeRecorder {
+   std::mutex mutex;
+   std::condition_variable cond;
+   chaudiere::Socket* socket;
+   int requestsServed;
+
+   ResumeRecorder() :
+      socket(nullptr),
+      requestsServed(0) {
+   }
+
+   ~ResumeRecorder() {
+      delete socket;
+   }
+
+   void onResume(chaudiere::Socket* resumed, int served) {
+      std::lock_guard<std::mutex> lock(mutex);
+      socket = resumed;
+      requestsServed = served;
+      cond.notify_all();
+   }
+
+   bool waitForResume(int timeoutMillis) {
+      std::unique_lock<std::mutex> lock(mutex);
+      return cond.wait_for(lock, std::chrono::milliseconds(timeoutMillis),
+                           [this] { return socket != nullptr; });
+   }
+};
+
+bool waitForParkedCount(const IdleConnectionMonitor& monitor,
+                        std::size_t count,
+                        int timeoutMillis) {
+   const auto deadline = std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(timeoutMillis);
+   while (monitor.getParkedCount() != count) {
+      if (std::chrono::steady_clock::now() >= deadline) {
+         return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+   }
+   return true;
+}
+
+}
+
+//******************************************************************************
+
+TestIdleConnectionMonitor::TestIdleConnectionMonitor() :
+   poivre::TestSuite("TestIdleConnectionMonitor") {
+}
+
+//******************************************************************************
+
+void TestIdleConnectionMonitor::runTests() {
+   testResumeWhenReadable();
+   testIdleTimeout();
+   testPeerClose();
+   testParkAfterStop();
+}
+
+//******************************************************************************
+
+void TestIdleConnectionMonitor::testResumeWhenReadable() {
+   TEST_CASE("testResumeWhenReadable");
+
+   const int port = 34725;
+   tonnerre_test::LoopbackConnection conn(port);
+
+   ResumeRecorder recorder;
+   IdleConnectionMonitor monitor(5000,
+      [&recorder](Socket* socket, int served) { recorder.onResume(socket, served); });
+
+   Socket* serverSocket = conn.serverSideSocket;
+   conn.serverSideSocket = nullptr; // ownership transferred to the monitor below
+   require(monitor.park(serverSocket, 3), "running monitor should accept a connection");
+   require(monitor.getParkedCount() == 1, "parked connection should be counted");
+
+   require(conn.clientSocket->write("x"), "client write should succeed");
+   require(recorder.waitForResume(2000), "connection should be resumed once readable");
+   require(recorder.socket == serverSocket, "resumed socket should be the parked one");
+   require(recorder.requestsServed == 3, "requests served should be carried through");
+   require(monitor.getParkedCount() == 0, "resumed connection should no longer be parked");
+}
+
+//******************************************************************************
+
+void TestIdleConnectionMonitor::testIdleTimeout() {
+   TEST_CASE("testIdleTimeout");
+
+   const int port = 34726;
+   tonnerre_test::LoopbackConnection conn(port);
+
+   ResumeRecorder recorder;
+   IdleConnectionMonitor monitor(50,
+      [&recorder](Socket* socket, int served) { recorder.onResume(socket, served); });
+
+   Socket* serverSocket = conn.serverSideSocket;
+   conn.serverSideSocket = nullptr; // ownership transferred to the monitor below
+   monitor.park(serverSocket, 1);
+
+   require(waitForParkedCount(monitor, 0, 2000), "idle connection should be dropped after the timeout");
+
+   char byte;
+   require(::recv(conn.clientSocket->getFileDescriptor(), &byte, 1, 0) == 0,
+           "client should see the connection closed");
+   require(recorder.socket == nullptr, "idle connection should not be resumed");
+}
+
+//******************************************************************************
+
+void TestIdleConnectionMonitor::testPeerClose() {
+   TEST_CASE("testPeerClose");
+
+   const int port = 34727;
+   tonnerre_test::LoopbackConnection conn(port);
+
+   ResumeRecorder recorder;
+   IdleConnectionMonitor monitor(5000,
+      [&recorder](Socket* socket, int served) { recorder.onResume(socket, served); });
+
+   Socket* serverSocket = conn.serverSideSocket;
+   conn.serverSideSocket = nullptr; // ownership transferred to the monitor below
+   monitor.park(serverSocket, 1);
+
+   delete conn.clientSocket;
+   conn.clientSocket = nullptr;
+
+   require(waitForParkedCount(monitor, 0, 2000), "connection closed by the peer should be dropped");
+   require(recorder.socket == nullptr, "closed connection should not be resumed");
+}
+
+//******************************************************************************
+
+void TestIdleConnectionMonitor::testParkAfterStop() {
+   TEST_CASE("testParkAfterStop");
+
+   const int port = 34728;
+   tonnerre_test::LoopbackConnection conn(port);
+
+   IdleConnectionMonitor monitor(5000, [](Socket* socket, int) { delete socket; });
+   monitor.stop();
+
+   requireFalse(monitor.park(conn.serverSideSocket, 1), "stopped monitor should not accept connections");
+   requireFalse(monitor.park(nullptr, 1), "null socket should be rejected");
+}
+
+//******************************************************************************
@@ -0,0 +1,30 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTIDLECONNECTIONMONITOR_H
+#define TONNERRE_TESTIDLECONNECTIONMONITOR_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestIdleConnectionMonitor : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testResumeWhenReadable();
+   void testIdleTimeout();
+   void testPeerClose();
+   void testParkAfterStop();
+
+public:
+   TestIdleConnectionMonitor();
+
+};
+
+}
+
+#endif
+
@@ -0,0 +1,291 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include "TestInProcessRegistry.h"
+#include "InProcessRegistry.h"
+#include "AdmissionController.h"
+#include "AsyncMessageHandler.h"
+#include "MessageHandler.h"
+#include "Message.h"
+#include "Messaging.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+namespace {
+
+// Echoes the request payload back as the response payload, counting the
+// requests it sees (and optionally holding each one for a while).
+class CountingEchoHandler : public tonnerre::MessageHandler {
+public:
+   CountingEchoHandler() : m_count(0), m_holdMillis(0) {}
+
+   void handleTextMessage(const Message& requestMessage,
+                          Message&,
+                          const std::string&,
+                          const std::string& requestPayload,
+                          std::string& responsePayload) override {
+      if (m_holdMillis > 0) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(m_holdMillis));
+      }
+      m_serviceName = requestMessage.getServiceName();
+      m_count.fetch_add(1);
+      responsePayload = requestPayload;
+   }
+
+   void handleKeyValuesMessage(const Message&,
+                               Message&,
+                               const std::string&,
+                               const chaudiere::KeyValuePairs& requestPayload,
+                               chaudiere::KeyValuePairs& responsePayload) override {
+      m_count.fetch_add(1);
+      responsePayload = requestPayload;
+   }
+
+   int getCount() const {
+      return m_count.load();
+   }
+
+   const std::string& getServiceName() const {
+      return m_serviceName;
+   }
+
+   void setHoldMillis(int holdMillis) {
+      m_holdMillis = holdMillis;
+   }
+
+private:
+   std::atomic<int> m_count;
+   int m_holdMillis;
+   std::string m_serviceName;
+};
+
+class ThrowingHandler : public tonnerre::MessageHandler {
+public:
+   void handleTextMessage(const Message&,
+                          Message&,
+                          const std::string&,
+                          const std::string&,
+                          std::string&) override {
+      throw std::runtime_error("handler failure");
+   }
+
+   void handleKeyValuesMessage(const Message&,
+                               Message&,
+                               const std::string&,
+                               const chaudiere::KeyValuePairs&,
+                               chaudiere::KeyValuePairs&) override {
+      throw std::runtime_error("handler failure");
+   }
+};
+
+class NeverCalledAsyncHandler : public tonnerre::AsyncMessageHandler {
+public:
+   NeverCalledAsyncHandler() : m_count(0) {}
+
+   void handleTextMessageAsync(const Message&,
+                               const std::string&,
+                               const std::string&,
+                               std::shared_ptr<Responder>) override {
+      ++m_count;
+   }
+
+   void handleKeyValuesMessageAsync(const Message&,
+                                    const std::string&,
+                                    const chaudiere::KeyValuePairs&,
+                                    std::shared_ptr<Responder>) override {
+      ++m_count;
+   }
+
+   int getCount() const {
+      return m_count;
+   }
+
+private:
+   int m_count;
+};
+
+}
+
+//******************************************************************************
+
+TestInProcessRegistry::TestInProcessRegistry() :
+   poivre::TestSuite("TestInProcessRegistry") {
+}
+
+//******************************************************************************
+
+void TestInProcessRegistry::runTests() {
+   testCall();
+   testOneWay();
+   testUnregisteredService();
+   testHandlerException();
+   testAsyncHandler();
+   testOverloaded();
+   testUnregisterWaitsForCalls();
+}
+
+//******************************************************************************
+
+void TestInProcessRegistry::testCall() {
+   TEST_CASE("testCall");
+
+   // no Messaging is configured, so only the registry can answer
+   Messaging::setMessaging(nullptr);
+
+   CountingEchoHandler handler;
+   InProcessRegistry::registerService("localEcho", &handler, nullptr, nullptr);
+   require(InProcessRegistry::hasService("localEcho"), "service should be registered");
+
+   Message request("echo", MessageTypeText);
+   request.setTextPayload("in process");
+   Message response;
+   require(request.send("localEcho", response), "send should be handled in-process");
+   requireStringEquals("in process", response.getTextPayload(), "response should echo the request");
+   requireStringEquals("echo", response.getRequestName(), "response should carry the request name");
+   require(!response.isOverloaded(), "response should not be overloaded");
+   requireStringEquals("localEcho", handler.getServiceName(), "handler should see the service name");
+   require(handler.getCount() == 1, "handler should be called once");
+
+   InProcessRegistry::unregisterService("localEcho");
+   require(!InProcessRegistry::hasService("localEcho"), "service should be unregistered");
+}
+
+//******************************************************************************
+
+void TestInProcessRegistry::testOneWay() {
+   TEST_CASE("testOneWay");
+
+   Messaging::setMessaging(nullptr);
+
+   CountingEchoHandler handler;
+   InProcessRegistry::registerService("localEvents", &handler, nullptr, nullptr);
+
+   Message event("event", MessageTypeText);
+   event.setTextPayload("fire and forget");
+   require(event.send("localEvents"), "one-way send should be handled in-process");
+   require(event.isOneWay(), "message should be marked one-way");
+   require(handler.getCount() == 1, "handler should be called before send returns");
+
+   InProcessRegistry::unregisterService("localEvents");
+}
+
+//******************************************************************************
+
+void TestInProcessRegistry::testUnregisteredService() {
+   TEST_CASE("testUnregisteredService");
+
+   Messaging::setMessaging(nullptr);
+
+   require(!InProcessRegistry::hasService("nowhere"), "service should not be registered");
+
+   Message request("echo", MessageTypeText);
+   Message response;
+   require(!InProcessRegistry::call("nowhere", request, response), "call should fall through");
+   require(!request.send("nowhere", response), "send should fail with nothing to send to");
+
+   // unregistering an unknown service is harmless
+   InProcessRegistry::unregisterService("nowhere");
+}
+
+//******************************************************************************
+
+void TestInProcessRegistry::testHandlerException() {
+   TEST_CASE("testHandlerException");
+
+   ThrowingHandler handler;
+   InProcessRegistry::registerService("localThrows", &handler, nullptr, nullptr);
+
+   Message request("explode", MessageTypeText);
+   request.setTextPayload("boom");
+   Message response;
+   require(InProcessRegistry::call("localThrows", request, response),
+           "a failed request should still be answered");
+   requireStringEquals("", response.getTextPayload(), "response should be empty");
+
+   InProcessRegistry::unregisterService("localThrows");
+}
+
+//******************************************************************************
+
+void TestInProcessRegistry::testAsyncHandler() {
+   TEST_CASE("testAsyncHandler");
+
+   NeverCalledAsyncHandler handler;
+   InProcessRegistry::registerService("localAsync", &handler, nullptr, nullptr);
+
+   Message request("later", MessageTypeText);
+   Message response;
+   require(!InProcessRegistry::call("localAsync", request, response),
+           "requests for asynchronous handlers should go over the network");
+   require(handler.getCount() == 0, "handler should not be called");
+
+   InProcessRegistry::unregisterService("localAsync");
+}
+
+//******************************************************************************
+
+void TestInProcessRegistry::testOverloaded() {
+   TEST_CASE("testOverloaded");
+
+   CountingEchoHandler handler;
+   handler.setHoldMillis(200);
+   AdmissionController admissionController(1, 0, 0, 0);
+   InProcessRegistry::registerService("localBusy", &handler, &admissionController, nullptr);
+
+   std::thread first([]() {
+      Message request("slow", MessageTypeText);
+      Message response;
+      InProcessRegistry::call("localBusy", request, response);
+   });
+
+   // wait for the first request to occupy the only slot
+   for (int i = 0; (i < 100) && (admissionController.getInFlight() == 0); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+   }
+
+   Message request("shed", MessageTypeText);
+   Message response;
+   require(InProcessRegistry::call("localBusy", request, response), "shed request should be answered");
+   require(response.isOverloaded(), "response should be overloaded");
+
+   first.join();
+   require(handler.getCount() == 1, "only the admitted request should be handled");
+
+   InProcessRegistry::unregisterService("localBusy");
+}
+
+//******************************************************************************
+
+void TestInProcessRegistry::testUnregisterWaitsForCalls() {
+   TEST_CASE("testUnregisterWaitsForCalls");
+
+   CountingEchoHandler handler;
+   handler.setHoldMillis(200);
+   InProcessRegistry::registerService("localDraining", &handler, nullptr, nullptr);
+
+   std::atomic<bool> isStarted(false);
+   std::thread caller([&isStarted]() {
+      Message request("slow", MessageTypeText);
+      Message response;
+      isStarted.store(true);
+      InProcessRegistry::call("localDraining", request, response);
+   });
+
+   while (!isStarted.load()) {
+      std::this_thread::yield();
+   }
+   std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+   InProcessRegistry::unregisterService("localDraining");
+   require(handler.getCount() == 1, "unregister should wait for the call in flight");
+
+   caller.join();
+}
+
+//******************************************************************************
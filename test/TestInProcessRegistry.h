@@ -0,0 +1,32 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTINPROCESSREGISTRY_H
+#define TONNERRE_TESTINPROCESSREGISTRY_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestInProcessRegistry : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testCall();
+   void testOneWay();
+   void testUnregisteredService();
+   void testHandlerException();
+   void testAsyncHandler();
+   void testOverloaded();
+   void testUnregisterWaitsForCalls();
+
+public:
+   TestInProcessRegistry();
+
+};
+
+}
+
+#endif
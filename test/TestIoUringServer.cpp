@@ -0,0 +1,312 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "TestIoUringServer.h"
+#include "IoUringServer.h"
+#include "IoUring.h"
+#include "AsyncMessageHandler.h"
+#include "MessageHandler.h"
+#include "Message.h"
+#include "ServerOptions.h"
+#include "Socket.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+namespace {
+
+// Echoes the request payload back as the response payload.
+class EchoMessageHandler : public tonnerre::MessageHandler {
+public:
+   void handleTextMessage(const Message&,
+                          Message&,
+                          const std::string&,
+                          const std::string& requestPayload,
+                          std::string& responsePayload) override {
+      responsePayload = requestPayload;
+   }
+
+   void handleKeyValuesMessage(const Message&,
+                               Message&,
+                               const std::string&,
+                               const chaudiere::KeyValuePairs& requestPayload,
+                               chaudiere::KeyValuePairs& responsePayload) override {
+      responsePayload = requestPayload;
+   }
+};
+
+// Holds the responder for 'hold' requests until released; completes the
+// rest at once.
+class HoldingAsyncHandler : public tonnerre::AsyncMessageHandler {
+public:
+   void handleTextMessageAsync(const Message&,
+                               const std::string& requestName,
+                               const std::string& requestPayload,
+                               std::shared_ptr<Responder> responder) override {
+      if (requestName == "hold") {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_held = responder;
+      } else {
+         responder->complete(requestPayload);
+      }
+   }
+
+   void handleKeyValuesMessageAsync(const Message&,
+                                    const std::string&,
+                                    const chaudiere::KeyValuePairs& requestPayload,
+                                    std::shared_ptr<Responder> responder) override {
+      responder->complete(requestPayload);
+   }
+
+   bool release(const std::string& payload) {
+      std::shared_ptr<Responder> held;
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         held.swap(m_held);
+      }
+      return (held != nullptr) && held->complete(payload);
+   }
+
+private:
+   std::mutex m_mutex;
+   std::shared_ptr<Responder> m_held;
+};
+
+}
+
+//******************************************************************************
+
+TestIoUringServer::TestIoUringServer() :
+   poivre::TestSuite("TestIoUringServer") {
+}
+
+//******************************************************************************
+
+void TestIoUringServer::runTests() {
+   // kernels without io_uring (or with it disabled) take the standard path,
+   // which the other suites cover
+   if (!IoUring::isSupported()) {
+      testStartStop();
+      return;
+   }
+
+   testStartStop();
+   testServeRequests();
+   testPipelinedRequests();
+   testMaxRequests();
+   testAsyncHandler();
+   testAsyncResponseOrder();
+}
+
+//******************************************************************************
+
+void TestIoUringServer::testStartStop() {
+   TEST_CASE("testStartStop");
+
+   EchoMessageHandler echoHandler;
+   ServerOptions options;
+   IoUringServer server(34742, &echoHandler, &options, -1);
+
+   if (!IoUring::isSupported()) {
+      requireFalse(server.start(), "start should fail without io_uring support");
+      return;
+   }
+
+   require(server.start(), "server should start");
+   requireFalse(server.start(), "a running server can't be started again");
+   server.stop();
+   server.waitUntilStopped();
+   require(server.getConnectionCount() == 0, "stopped server should have no connections");
+}
+
+//******************************************************************************
+
+void TestIoUringServer::testServeRequests() {
+   TEST_CASE("testServeRequests");
+
+   const int port = 34743;
+   EchoMessageHandler echoHandler;
+   ServerOptions options;
+   options.setKeepAlive(true);
+   IoUringServer server(port, &echoHandler, &options, -1);
+   require(server.start(), "server should start");
+
+   Socket client("127.0.0.1", port);
+
+   // larger than one receive buffer, so it arrives in pieces
+   const std::string largePayload(20000, 'x');
+
+   for (int i = 0; i < 3; ++i) {
+      Message request("uringTest", MessageTypeText);
+      const std::string payload = (i == 1) ? largePayload : "request " + std::to_string(i);
+      request.setTextPayload(payload);
+      require(client.write(request.toString()), "writing request should succeed");
+
+      Message response;
+      require(response.reconstitute(&client), "client should receive a response per request");
+      require(payload == response.getTextPayload(), "response should echo the request");
+   }
+
+   require(server.getAcceptCount() == 1, "one connection should have been accepted");
+
+   client.close();
+   server.stop();
+}
+
+//******************************************************************************
+
+void TestIoUringServer::testPipelinedRequests() {
+   TEST_CASE("testPipelinedRequests");
+
+   const int port = 34744;
+   EchoMessageHandler echoHandler;
+   ServerOptions options;
+   options.setKeepAlive(true);
+   IoUringServer server(port, &echoHandler, &options, -1);
+   require(server.start(), "server should start");
+
+   Socket client("127.0.0.1", port);
+
+   std::string requests;
+   for (int i = 0; i < 5; ++i) {
+      Message request("pipelined", MessageTypeText);
+      request.setTextPayload(std::to_string(i));
+      requests += request.toString();
+   }
+   require(client.write(requests), "writing requests should succeed");
+
+   for (int i = 0; i < 5; ++i) {
+      Message response;
+      require(response.reconstitute(&client), "client should receive every response");
+      requireStringEquals(std::to_string(i), response.getTextPayload(), "responses should arrive in request order");
+   }
+
+   client.close();
+   server.stop();
+}
+
+//******************************************************************************
+
+void TestIoUringServer::testMaxRequests() {
+   TEST_CASE("testMaxRequests");
+
+   const int port = 34745;
+   EchoMessageHandler echoHandler;
+   ServerOptions options;
+   options.setKeepAlive(true);
+   options.setKeepAliveMaxRequests(2);
+   IoUringServer server(port, &echoHandler, &options, -1);
+   require(server.start(), "server should start");
+
+   Socket client("127.0.0.1", port);
+   for (int i = 0; i < 2; ++i) {
+      Message request("limited", MessageTypeText);
+      request.setTextPayload("x");
+      require(client.write(request.toString()), "writing request should succeed");
+
+      Message response;
+      require(response.reconstitute(&client), "client should receive responses up to the maximum");
+   }
+
+   char byte;
+   require(::recv(client.getFileDescriptor(), &byte, 1, 0) <= 0, "server should close the connection after the maximum");
+
+   server.stop();
+}
+
+//******************************************************************************
+
+void TestIoUringServer::testAsyncHandler() {
+   TEST_CASE("testAsyncHandler");
+
+   const int port = 34766;
+   HoldingAsyncHandler asyncHandler;
+   ServerOptions options;
+   options.setKeepAlive(true);
+   IoUringServer server(port, &asyncHandler, &options, -1);
+   require(server.start(), "server should start");
+
+   Socket heldClient("127.0.0.1", port);
+   Message heldRequest("hold", MessageTypeText);
+   heldRequest.setTextPayload("held");
+   require(heldClient.write(heldRequest.toString()), "writing request should succeed");
+
+   // the loop goes on serving while a responder is outstanding
+   Socket client("127.0.0.1", port);
+   Message request("echo", MessageTypeText);
+   request.setTextPayload("not held up");
+   require(client.write(request.toString()), "writing request should succeed");
+
+   Message response;
+   require(response.reconstitute(&client), "an outstanding responder shouldn't stall the loop");
+   requireStringEquals("not held up", response.getTextPayload(), "response should carry the completed payload");
+
+   // completed from this thread, not the loop's
+   require(asyncHandler.release("released"), "held responder should complete");
+
+   Message heldResponse;
+   require(heldResponse.reconstitute(&heldClient), "held response should be sent once completed");
+   requireStringEquals("released", heldResponse.getTextPayload(), "held response should carry the completed payload");
+
+   client.close();
+   heldClient.close();
+   server.stop();
+}
+
+//******************************************************************************
+
+void TestIoUringServer::testAsyncResponseOrder() {
+   TEST_CASE("testAsyncResponseOrder");
+
+   const int port = 34770;
+   HoldingAsyncHandler asyncHandler;
+   ServerOptions options;
+   options.setKeepAlive(true);
+   IoUringServer server(port, &asyncHandler, &options, -1);
+   require(server.start(), "server should start");
+
+   // a held request pipelined ahead of one that completes at once
+   Socket client("127.0.0.1", port);
+   Message heldRequest("hold", MessageTypeText);
+   heldRequest.setTextPayload("held");
+   Message request("echo", MessageTypeText);
+   request.setTextPayload("second");
+   require(client.write(heldRequest.toString() + request.toString()), "writing requests should succeed");
+
+   struct pollfd pfd;
+   pfd.fd = client.getFileDescriptor();
+   pfd.events = POLLIN;
+   pfd.revents = 0;
+   require(::poll(&pfd, 1, 100) == 0, "the later response should wait for the held one");
+
+   bool isReleased = false;
+   for (int i = 0; (i < 200) && !isReleased; ++i) {
+      isReleased = asyncHandler.release("first");
+      if (!isReleased) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+   }
+   require(isReleased, "held responder should complete");
+
+   // the protocol has no request ids, so the order is all a client has
+   Message firstResponse;
+   require(firstResponse.reconstitute(&client), "client should receive the held response");
+   requireStringEquals("first", firstResponse.getTextPayload(), "the held response should come first");
+   Message secondResponse;
+   require(secondResponse.reconstitute(&client), "client should receive the later response");
+   requireStringEquals("second", secondResponse.getTextPayload(), "the later response should come second");
+
+   client.close();
+   server.stop();
+}
+
+//******************************************************************************
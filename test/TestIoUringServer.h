@@ -0,0 +1,32 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTIOURINGSERVER_H
+#define TONNERRE_TESTIOURINGSERVER_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestIoUringServer : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testStartStop();
+   void testServeRequests();
+   void testPipelinedRequests();
+   void testMaxRequests();
+   void testAsyncHandler();
+   void testAsyncResponseOrder();
+
+public:
+   TestIoUringServer();
+
+};
+
+}
+
+#endif
+
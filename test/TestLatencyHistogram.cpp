@@ -0,0 +1,121 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "TestLatencyHistogram.h"
+#include "LatencyHistogram.h"
+
+using namespace tonnerre;
+
+//******************************************************************************
+
+TestLatencyHistogram::TestLatencyHistogram() :
+   poivre::TestSuite("TestLatencyHistogram") {
+}
+
+//******************************************************************************
+
+void TestLatencyHistogram::runTests() {
+   testBuckets();
+   testEmpty();
+   testPercentiles();
+   testMerge();
+}
+
+//******************************************************************************
+
+void TestLatencyHistogram::testBuckets() {
+   TEST_CASE("testBuckets");
+
+   require(LatencyHistogram::bucketIndex(0) == 0, "zero should have its own bucket");
+   require(LatencyHistogram::bucketIndex(31) == 31, "small values should be exact");
+   require(LatencyHistogram::bucketUpperBound(31) == 31, "small buckets should hold one value");
+
+   // every value must land in a bucket whose bounds contain it, and the
+   // bucket must be no wider than about 6% of the value
+   int previousIndex = -1;
+   for (std::uint64_t value = 1; value < (1ULL << 36); value += value / 7 + 1) {
+      const int index = LatencyHistogram::bucketIndex(value);
+      require(index >= previousIndex, "bucket index should not decrease with value");
+      require(index < LatencyHistogram::NUMBER_BUCKETS, "bucket index should be in range");
+      const std::uint64_t upperBound = LatencyHistogram::bucketUpperBound(index);
+      require(upperBound >= value, "bucket upper bound should cover the value");
+      require(upperBound - value <= value / 16, "bucket should be narrow relative to its values");
+      if (index > 0) {
+         require(LatencyHistogram::bucketUpperBound(index - 1) < value,
+                 "previous bucket should end below the value");
+      }
+      previousIndex = index;
+   }
+
+   require(LatencyHistogram::bucketIndex(~0ULL) == LatencyHistogram::NUMBER_BUCKETS - 1,
+           "huge values should land in the last bucket");
+}
+
+//******************************************************************************
+
+void TestLatencyHistogram::testEmpty() {
+   TEST_CASE("testEmpty");
+
+   LatencyHistogram histogram;
+   require(histogram.getCount() == 0, "new histogram should be empty");
+   require(histogram.getMax() == 0, "empty histogram should have no max");
+   require(histogram.getValueAtPercentile(99.0) == 0, "empty histogram should have no percentiles");
+   require(histogram.getMean() == 0.0, "empty histogram should have no mean");
+}
+
+//******************************************************************************
+
+void TestLatencyHistogram::testPercentiles() {
+   TEST_CASE("testPercentiles");
+
+   LatencyHistogram histogram;
+   for (std::uint64_t micros = 1; micros <= 1000; ++micros) {
+      histogram.record(micros);
+   }
+
+   require(histogram.getCount() == 1000, "count should reflect the values recorded");
+   require(histogram.getSum() == 500500, "sum should reflect the values recorded");
+   require(histogram.getMean() == 500.5, "mean should reflect the values recorded");
+
+   const std::uint64_t p50 = histogram.getValueAtPercentile(50.0);
+   require((p50 >= 500) && (p50 <= 500 + 500 / 16), "p50 should be within bucket precision");
+   const std::uint64_t p99 = histogram.getValueAtPercentile(99.0);
+   require((p99 >= 990) && (p99 <= 990 + 990 / 16), "p99 should be within bucket precision");
+   const std::uint64_t max = histogram.getMax();
+   require((max >= 1000) && (max <= 1000 + 1000 / 16), "max should be within bucket precision");
+   require(histogram.getValueAtPercentile(100.0) == max, "p100 should be the max");
+}
+
+//******************************************************************************
+
+void TestLatencyHistogram::testMerge() {
+   TEST_CASE("testMerge");
+
+   LatencyHistogram fast;
+   LatencyHistogram slow;
+   for (int i = 0; i < 90; ++i) {
+      fast.record(10);
+   }
+   for (int i = 0; i < 10; ++i) {
+      slow.record(5000);
+   }
+
+   LatencyHistogram merged(fast);
+   merged.merge(slow);
+   require(merged.getCount() == 100, "merged count should be the sum of the counts");
+   require(merged.getValueAtPercentile(50.0) == 10, "merged median should come from the fast values");
+   require(merged.getValueAtPercentile(95.0) >= 5000, "merged tail should come from the slow values");
+   require(fast.getCount() == 90, "merging should not change the copied histogram");
+
+   LatencyHistogram rebuilt;
+   rebuilt.addToBucket(LatencyHistogram::bucketIndex(5000), 10);
+   rebuilt.addToSum(50000);
+   require(rebuilt.getCount() == 10, "bucket counts should add to the count");
+   require(rebuilt.getMean() == 5000.0, "added sum should give the mean");
+   require(rebuilt.getBucketCount(LatencyHistogram::bucketIndex(5000)) == 10,
+           "getBucketCount should return the bucket's count");
+   require(rebuilt.getBucketCount(LatencyHistogram::NUMBER_BUCKETS) == 0,
+           "out of range buckets should be empty");
+}
+
+//******************************************************************************
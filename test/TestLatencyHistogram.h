@@ -0,0 +1,29 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTLATENCYHISTOGRAM_H
+#define TONNERRE_TESTLATENCYHISTOGRAM_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestLatencyHistogram : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testBuckets();
+   void testEmpty();
+   void testPercentiles();
+   void testMerge();
+
+public:
+   TestLatencyHistogram();
+
+};
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "TestLogRateLimiter.h"
+#include "LogRateLimiter.h"
+#include "Logging.h"
+
+using namespace tonnerre;
+
+static int messagesBuilt = 0;
+
+//******************************************************************************
+
+static std::string buildMessage() {
+   ++messagesBuilt;
+   return "request failed";
+}
+
+//******************************************************************************
+
+TestLogRateLimiter::TestLogRateLimiter() :
+   poivre::TestSuite("TestLogRateLimiter") {
+}
+
+//******************************************************************************
+
+void TestLogRateLimiter::runTests() {
+   testAllowAt();
+   testAnnotate();
+   testLogErrorIsLazy();
+}
+
+//******************************************************************************
+
+void TestLogRateLimiter::testAllowAt() {
+   TEST_CASE("testAllowAt");
+
+   LogRateLimiter limiter(3);
+   int allowed = 0;
+   for (int i = 0; i < 5; ++i) {
+      if (limiter.allowAt(100)) {
+         ++allowed;
+      }
+   }
+   require(allowed == 3, "only the limit should be allowed within a second");
+   require(limiter.getSuppressed() == 2, "the rest should be counted as suppressed");
+
+   require(limiter.allowAt(101), "a new second should allow messages again");
+   require(limiter.allowAt(101), "a new second should reset the count");
+}
+
+//******************************************************************************
+
+void TestLogRateLimiter::testAnnotate() {
+   TEST_CASE("testAnnotate");
+
+   LogRateLimiter limiter(1);
+   requireStringEquals("unable to write", limiter.annotate("unable to write"),
+                       "nothing suppressed should leave the message alone");
+
+   limiter.allowAt(7);
+   limiter.allowAt(7);
+   limiter.allowAt(7);
+   requireStringEquals("unable to write (2 similar messages suppressed)",
+                       limiter.annotate("unable to write"),
+                       "annotate should report the suppressed count");
+   require(limiter.getSuppressed() == 0, "annotate should reset the suppressed count");
+}
+
+//******************************************************************************
+
+void TestLogRateLimiter::testLogErrorIsLazy() {
+   TEST_CASE("testLogErrorIsLazy");
+
+   messagesBuilt = 0;
+   for (int i = 0; i < 100; ++i) {
+      TONNERRE_LOG_ERROR(buildMessage());
+   }
+
+   // (the loop runs well within one second, or at worst spans two)
+   require(messagesBuilt >= LogRateLimiter::DEFAULT_MESSAGES_PER_SECOND,
+           "messages under the limit should be written");
+   require(messagesBuilt <= 2 * LogRateLimiter::DEFAULT_MESSAGES_PER_SECOND,
+           "suppressed messages should not be built");
+}
+
+//******************************************************************************
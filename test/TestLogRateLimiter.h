@@ -0,0 +1,28 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTLOGRATELIMITER_H
+#define TONNERRE_TESTLOGRATELIMITER_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestLogRateLimiter : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testAllowAt();
+   void testAnnotate();
+   void testLogErrorIsLazy();
+
+public:
+   TestLogRateLimiter();
+
+};
+
+}
+
+#endif
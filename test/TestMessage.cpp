@@ -25,8 +25,13 @@ void TestMessage::runTests() {
    testCopyConstructor();
    testSend();
    testSendWithMessage();
+   testSetCoalescing();
    testAssignmentOperator();
    testReconstitute();
+   testSetOneWay();
+   testSetOverloaded();
+   testSetTraced();
+   testSetPriority();
    testSetType();
    testGetType();
    testGetRequestName();
@@ -104,6 +109,25 @@ void TestMessage::testSendWithMessage() {
 
 //******************************************************************************
 
+void TestMessage::testSetCoalescing() {
+   TEST_CASE("testSetCoalescing");
+
+   Message message("readRequest", MessageTypeText);
+   requireFalse(message.isCoalescing(), "coalescing should be off by default");
+
+   message.setCoalescing(true);
+   require(message.isCoalescing(), "isCoalescing should reflect setCoalescing");
+
+   Message copy(message);
+   require(copy.isCoalescing(), "copy should preserve coalescing opt-in");
+
+   const std::string withCoalescing = message.toString();
+   message.setCoalescing(false);
+   requireStringEquals(message.toString(), withCoalescing, "coalescing is client-side only and should not change the wire format");
+}
+
+//******************************************************************************
+
 void TestMessage::testAssignmentOperator() {
    TEST_CASE("testAssignmentOperator");
 
@@ -131,6 +155,99 @@ void TestMessage::testReconstitute() {
 
 //******************************************************************************
 
+void TestMessage::testSetOneWay() {
+   TEST_CASE("testSetOneWay");
+
+   Message message("fireAndForget", MessageTypeText);
+   requireFalse(message.isOneWay(), "messages should not be one-way by default");
+
+   message.setOneWay(true);
+   require(message.isOneWay(), "isOneWay should reflect setOneWay");
+
+   tonnerre_test::LoopbackConnection conn(34704);
+   require(conn.clientSocket->write(message.toString()), "writing message should succeed");
+
+   Message received;
+   require(received.reconstitute(conn.serverSideSocket), "reconstitute should succeed");
+   require(received.isOneWay(), "one-way flag should survive the round trip");
+}
+
+//******************************************************************************
+
+void TestMessage::testSetOverloaded() {
+   TEST_CASE("testSetOverloaded");
+
+   Message message("busy", MessageTypeText);
+   requireFalse(message.isOverloaded(), "messages should not be overloaded by default");
+
+   message.setOverloaded(true);
+   require(message.isOverloaded(), "isOverloaded should reflect setOverloaded");
+
+   Message received;
+   require(received.reconstituteFromFrame(message.toString()), "reconstitute should succeed");
+   require(received.isOverloaded(), "overloaded flag should survive the round trip");
+
+   message.setOverloaded(false);
+   requireFalse(message.isOverloaded(), "setOverloaded(false) should clear the flag");
+}
+
+//******************************************************************************
+
+void TestMessage::testSetTraced() {
+   TEST_CASE("testSetTraced");
+
+   Message message("lookup", MessageTypeText);
+   requireFalse(message.isTraced(), "messages should not be traced by default");
+
+   message.setTraced(true);
+   require(message.isTraced(), "isTraced should reflect setTraced");
+
+   Message received;
+   require(received.reconstituteFromFrame(message.toString()), "reconstitute should succeed");
+   require(received.isTraced(), "traced flag should survive the round trip");
+
+   message.setTraced(false);
+   requireFalse(message.isTraced(), "setTraced(false) should clear the flag");
+
+   Message untraced;
+   require(untraced.reconstituteFromFrame(message.toString()), "reconstitute should succeed");
+   requireFalse(untraced.hasHeader("trace.read"), "untraced messages should not be stamped on receipt");
+}
+
+//******************************************************************************
+
+void TestMessage::testSetPriority() {
+   TEST_CASE("testSetPriority");
+
+   Message message("bulkExport", MessageTypeText);
+   requireFalse(message.hasPriority(), "messages should carry no priority by default");
+   require(message.getPriority() == MessagePriorityNormal, "default priority should be normal");
+
+   message.setPriority(MessagePriorityLow);
+   require(message.hasPriority(), "hasPriority should reflect setPriority");
+   require(message.getPriority() == MessagePriorityLow, "getPriority should reflect setPriority");
+
+   Message received;
+   const std::string frame(message.toString());
+   require(received.reconstituteFromFrame(frame), "reconstitute should succeed");
+   require(received.getPriority() == MessagePriorityLow, "priority should survive the round trip");
+   require(message.getWireLength() == 0, "locally built messages should have no wire length");
+   require(received.getWireLength() == frame.length(), "wire length should be the frame's length");
+
+   // the header may also be set by name
+   Message tagged("healthCheck", MessageTypeText);
+   tagged.setHeader("priority", "high");
+   require(tagged.getPriority() == MessagePriorityHigh, "priority header should be honoured");
+
+   MessagePriority priority = MessagePriorityNormal;
+   require(Message::parsePriority("low", priority), "known names should parse");
+   require(priority == MessagePriorityLow, "parsed priority should match the name");
+   requireFalse(Message::parsePriority("urgent", priority), "unknown names should not parse");
+   requireStringEquals("high", Message::priorityName(MessagePriorityHigh), "priority names should round trip");
+}
+
+//******************************************************************************
+
 void TestMessage::testSetType() {
    TEST_CASE("testSetType");
 
@@ -206,10 +323,20 @@ void TestMessage::testSetTextPayload() {
 //******************************************************************************
 
 void TestMessage::testGetServiceName() {
-   //TEST_CASE("testGetServiceName");
-   //TODO: implement testGetServiceName (m_serviceName currently has no
-   // setter and is never populated other than by copy/assignment - only
-   // meaningful once a setter or reconstitute()-based population exists)
+   TEST_CASE("testGetServiceName");
+
+   Message message("whoAmI", MessageTypeText);
+   require(message.getServiceName().empty(), "service name should be empty before sending");
+
+   // stands in for the header send() writes
+   message.setHeader("service", "echo_service");
+
+   tonnerre_test::LoopbackConnection conn(34729);
+   require(conn.clientSocket->write(message.toString()), "writing message should succeed");
+
+   Message received;
+   require(received.reconstitute(conn.serverSideSocket), "reconstitute should succeed");
+   requireStringEquals("echo_service", received.getServiceName(), "service name should be read from the header");
 }
 
 //******************************************************************************
@@ -19,8 +19,13 @@ protected:
    void testCopyConstructor();
    void testSend();
    void testSendWithMessage();
+   void testSetCoalescing();
    void testAssignmentOperator();
    void testReconstitute();
+   void testSetOneWay();
+   void testSetOverloaded();
+   void testSetTraced();
+   void testSetPriority();
    void testSetType();
    void testGetType();
    void testGetRequestName();
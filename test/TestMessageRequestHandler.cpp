@@ -1,6 +1,14 @@
 // Copyright Paul Dardeau, SwampBits LLC 2014
 // BSD License
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <sys/types.h>
+#include <sys/socket.h>
+
 #include "TestMessageRequestHandler.h"
 #include "MessageRequestHandler.h"
 #include "MessageHandler.h"
@@ -9,6 +17,13 @@
 #include "SocketRequest.h"
 #include "SocketServiceHandler.h"
 #include "LoopbackConnection.h"
+#include "ServerOptions.h"
+#include "IdleConnectionMonitor.h"
+#include "AdmissionController.h"
+#include "AsyncMessageHandler.h"
+#include "PriorityExecutor.h"
+#include "RequestTrace.h"
+#include "ServerMetrics.h"
 
 using namespace tonnerre;
 using namespace chaudiere;
@@ -36,6 +51,172 @@ public:
    }
 };
 
+// Counts the messages it's given, for the ingestion-mode test.
+class CountingMessageHandler : public tonnerre::MessageHandler {
+public:
+   CountingMessageHandler() : m_count(0) {}
+
+   void handleTextMessage(const Message&,
+                          Message&,
+                          const std::string&,
+                          const std::string&,
+                          std::string& responsePayload) override {
+      ++m_count;
+      responsePayload = "should never be written";
+   }
+
+   void handleKeyValuesMessage(const Message&,
+                               Message&,
+                               const std::string&,
+                               const chaudiere::KeyValuePairs&,
+                               chaudiere::KeyValuePairs&) override {
+      ++m_count;
+   }
+
+   int m_count;
+};
+
+// Throws from every handler method, for testDispatch.
+class ThrowingMessageHandler : public tonnerre::MessageHandler {
+public:
+   void handleTextMessage(const Message&,
+                          Message&,
+                          const std::string&,
+                          const std::string&,
+                          std::string& responsePayload) override {
+      responsePayload = "partial";
+      throw std::runtime_error("handler failure");
+   }
+
+   void handleKeyValuesMessage(const Message&,
+                               Message&,
+                               const std::string&,
+                               const chaudiere::KeyValuePairs&,
+                               chaudiere::KeyValuePairs&) override {
+      throw std::runtime_error("handler failure");
+   }
+};
+
+// Keeps each responder to complete later, as a handler waiting on another
+// service would.
+class DeferringMessageHandler : public tonnerre::AsyncMessageHandler {
+public:
+   void handleTextMessageAsync(const Message&,
+                               const std::string&,
+                               const std::string& requestPayload,
+                               std::shared_ptr<Responder> responder) override {
+      m_payload = requestPayload;
+      m_responder = responder;
+   }
+
+   void handleKeyValuesMessageAsync(const Message&,
+                                    const std::string&,
+                                    const chaudiere::KeyValuePairs&,
+                                    std::shared_ptr<Responder> responder) override {
+      m_responder = responder;
+   }
+
+   std::string m_payload;
+   std::shared_ptr<Responder> m_responder;
+};
+
+// Completes each request from a thread of its own.
+class ThreadCompletingMessageHandler : public tonnerre::AsyncMessageHandler {
+public:
+   void handleTextMessageAsync(const Message&,
+                               const std::string&,
+                               const std::string& requestPayload,
+                               std::shared_ptr<Responder> responder) override {
+      m_thread = std::thread([responder, requestPayload]() {
+         responder->complete("completed: " + requestPayload);
+      });
+   }
+
+   void handleKeyValuesMessageAsync(const Message&,
+                                    const std::string&,
+                                    const chaudiere::KeyValuePairs&,
+                                    std::shared_ptr<Responder> responder) override {
+      m_thread = std::thread([responder]() {
+         responder->complete();
+      });
+   }
+
+   std::thread m_thread;
+};
+
+// Answers 'slow' requests asynchronously, from a thread that waits a
+// while first, and echoes everything else synchronously.
+class SlowAsyncMessageHandler : public tonnerre::AsyncMessageHandler {
+public:
+   ~SlowAsyncMessageHandler() {
+      if (m_thread.joinable()) {
+         m_thread.join();
+      }
+   }
+
+   AsyncMessageHandler* asyncHandlerFor(const Message& requestMessage) override {
+      return (requestMessage.getRequestName() == "slow") ? this : nullptr;
+   }
+
+   void handleTextMessage(const Message&,
+                          Message&,
+                          const std::string&,
+                          const std::string& requestPayload,
+                          std::string& responsePayload) override {
+      responsePayload = requestPayload;
+   }
+
+   void handleTextMessageAsync(const Message&,
+                               const std::string&,
+                               const std::string& requestPayload,
+                               std::shared_ptr<Responder> responder) override {
+      m_thread = std::thread([responder, requestPayload]() {
+         std::this_thread::sleep_for(std::chrono::milliseconds(50));
+         responder->complete(requestPayload);
+      });
+   }
+
+   void handleKeyValuesMessageAsync(const Message&,
+                                    const std::string&,
+                                    const chaudiere::KeyValuePairs&,
+                                    std::shared_ptr<Responder> responder) override {
+      responder->complete();
+   }
+
+   std::thread m_thread;
+};
+
+// Writes the given number of echo requests on the client socket.
+bool writeEchoRequests(chaudiere::Socket* clientSocket, int count) {
+   std::string requests;
+   for (int i = 0; i < count; ++i) {
+      Message request("echoTest", MessageTypeText);
+      request.setTextPayload("request " + std::to_string(i));
+      requests += request.toString();
+   }
+   return clientSocket->write(requests);
+}
+
+// Holds an executor worker until released.
+class GateTask : public chaudiere::Runnable {
+public:
+   GateTask(std::mutex& mutex, std::condition_variable& cond, bool& isReleased) :
+      m_mutex(mutex),
+      m_cond(cond),
+      m_isReleased(isReleased) {
+   }
+
+   void run() override {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cond.wait(lock, [this] { return m_isReleased; });
+   }
+
+private:
+   std::mutex& m_mutex;
+   std::condition_variable& m_cond;
+   bool& m_isReleased;
+};
+
 // Unused by these tests directly, but required to construct a SocketRequest.
 class NoOpSocketServiceHandler : public chaudiere::SocketServiceHandler {
 public:
@@ -62,6 +243,18 @@ void TestMessageRequestHandler::runTests() {
    testConstructorWithSocket();
    testConstructorWithSocketRequest();
    testRun();
+   testRunIngestion();
+   testRunKeepAlive();
+   testRunKeepAliveMaxRequests();
+   testRunKeepAliveParksIdle();
+   testRunShedsOverload();
+   testRunSchedulesByPriority();
+   testRunRecordsMetrics();
+   testRunTracesRequest();
+   testDispatch();
+   testRunAsync();
+   testRunAsyncKeepsOrder();
+   testDispatchAsyncHandler();
 }
 
 //******************************************************************************
@@ -136,3 +329,482 @@ void TestMessageRequestHandler::testRun() {
 }
 
 //******************************************************************************
+
+void TestMessageRequestHandler::testRunIngestion() {
+   TEST_CASE("testRunIngestion");
+
+   const int port = 34708;
+   tonnerre_test::LoopbackConnection conn(port);
+
+   std::string stream;
+   for (int i = 0; i < 3; ++i) {
+      Message event("event", MessageTypeText);
+      event.setOneWay(true);
+      event.setTextPayload("event payload");
+      stream += event.toString();
+   }
+
+   // the whole stream goes out in one write, then the sender closes its
+   // side to end the stream
+   require(conn.clientSocket->write(stream), "writing message stream should succeed");
+   ::shutdown(conn.clientSocket->getFileDescriptor(), SHUT_WR);
+
+   ServerOptions options;
+   options.setIngestionMode(true);
+
+   CountingMessageHandler countingHandler;
+   Socket* serverSocket = conn.serverSideSocket;
+   conn.serverSideSocket = nullptr; // ownership transferred to the handler below
+
+   {
+      MessageRequestHandler handler(serverSocket, &countingHandler);
+      handler.setServerOptions(&options);
+      handler.run();
+   }
+
+   require(countingHandler.m_count == 3, "every one-way message in the stream should be dispatched");
+
+   char responseByte;
+   require(::recv(conn.clientSocket->getFileDescriptor(), &responseByte, 1, 0) == 0,
+           "no response should be written for one-way messages in ingestion mode");
+}
+
+//******************************************************************************
+
+void TestMessageRequestHandler::testRunKeepAlive() {
+   TEST_CASE("testRunKeepAlive");
+
+   const int port = 34709;
+   tonnerre_test::LoopbackConnection conn(port);
+
+   // two requests back to back on the same connection, then the client is done
+   require(writeEchoRequests(conn.clientSocket, 2), "writing requests should succeed");
+   ::shutdown(conn.clientSocket->getFileDescriptor(), SHUT_WR);
+
+   ServerOptions options;
+   options.setKeepAlive(true);
+
+   EchoMessageHandler echoHandler;
+   Socket* serverSocket = conn.serverSideSocket;
+   conn.serverSideSocket = nullptr; // ownership transferred to the handler below
+
+   {
+      MessageRequestHandler handler(serverSocket, &echoHandler);
+      handler.setServerOptions(&options);
+      handler.run();
+      require(handler.getRequestsServed() == 2, "both requests should be served on one connection");
+   }
+
+   for (int i = 0; i < 2; ++i) {
+      Message response;
+      require(response.reconstitute(conn.clientSocket), "client should receive a response per request");
+      requireStringEquals("request " + std::to_string(i), response.getTextPayload(), "responses should come back in order");
+   }
+}
+
+//******************************************************************************
+
+void TestMessageRequestHandler::testRunKeepAliveMaxRequests() {
+   TEST_CASE("testRunKeepAliveMaxRequests");
+
+   const int port = 34718;
+   tonnerre_test::LoopbackConnection conn(port);
+
+   require(writeEchoRequests(conn.clientSocket, 3), "writing requests should succeed");
+
+   ServerOptions options;
+   options.setKeepAlive(true);
+   options.setKeepAliveMaxRequests(2);
+
+   EchoMessageHandler echoHandler;
+   Socket* serverSocket = conn.serverSideSocket;
+   conn.serverSideSocket = nullptr; // ownership transferred to the handler below
+
+   {
+      MessageRequestHandler handler(serverSocket, &echoHandler);
+      handler.setServerOptions(&options);
+      handler.run();
+      require(handler.getRequestsServed() == 2, "no more than the maximum requests should be served");
+   }
+
+   for (int i = 0; i < 2; ++i) {
+      Message response;
+      require(response.reconstitute(conn.clientSocket), "client should receive responses up to the maximum");
+   }
+
+   // the third request was never read, so the close may arrive as a reset
+   char responseByte;
+   require(::recv(conn.clientSocket->getFileDescriptor(), &responseByte, 1, 0) <= 0,
+           "connection should be closed once the maximum is reached");
+}
+
+//******************************************************************************
+
+void TestMessageRequestHandler::testRunKeepAliveParksIdle() {
+   TEST_CASE("testRunKeepAliveParksIdle");
+
+   const int port = 34719;
+   tonnerre_test::LoopbackConnection conn(port);
+
+   require(writeEchoRequests(conn.clientSocket, 1), "writing request should succeed");
+
+   ServerOptions options;
+   options.setKeepAlive(true);
+
+   std::mutex mutex;
+   std::condition_variable cond;
+   Socket* resumedSocket = nullptr;
+   int resumedServed = 0;
+
+   IdleConnectionMonitor monitor(5000,
+      [&](Socket* socket, int requestsServed) {
+         std::lock_guard<std::mutex> lock(mutex);
+         resumedSocket = socket;
+         resumedServed = requestsServed;
+         cond.notify_all();
+      });
+
+   EchoMessageHandler echoHandler;
+   Socket* serverSocket = conn.serverSideSocket;
+   conn.serverSideSocket = nullptr; // ownership transferred to the handler below
+
+   {
+      MessageRequestHandler handler(serverSocket, &echoHandler);
+      handler.setServerOptions(&options);
+      handler.setIdleConnectionMonitor(&monitor);
+      handler.run();
+   }
+
+   // the handler has gone (closing its socket), but the connection lives on
+   // in the monitor
+   require(monitor.getParkedCount() == 1, "idle connection should be parked with the monitor");
+
+   Message response;
+   require(response.reconstitute(conn.clientSocket), "client should receive the first response");
+
+   require(writeEchoRequests(conn.clientSocket, 1), "second request on the parked connection should succeed");
+   {
+      std::unique_lock<std::mutex> lock(mutex);
+      require(cond.wait_for(lock, std::chrono::seconds(2), [&] { return resumedSocket != nullptr; }),
+              "parked connection should be resumed when the next request arrives");
+   }
+   require(resumedServed == 1, "requests already served should be carried to the resumed handler");
+
+   {
+      MessageRequestHandler handler(resumedSocket, &echoHandler);
+      handler.setServerOptions(&options);
+      handler.setRequestsServed(resumedServed);
+      options.setKeepAliveMaxRequests(2);
+      handler.run();
+      require(handler.getRequestsServed() == 2, "resumed handler should serve the next request");
+   }
+
+   require(response.reconstitute(conn.clientSocket), "client should receive the response on the resumed connection");
+}
+
+//******************************************************************************
+
+void TestMessageRequestHandler::testRunShedsOverload() {
+   TEST_CASE("testRunShedsOverload");
+
+   const int port = 34746;
+   tonnerre_test::LoopbackConnection conn(port);
+
+   require(writeEchoRequests(conn.clientSocket, 2), "writing requests should succeed");
+   ::shutdown(conn.clientSocket->getFileDescriptor(), SHUT_WR);
+
+   ServerOptions options;
+   options.setKeepAlive(true);
+
+   // the queue is already full and so is the single in-flight slot
+   AdmissionController controller(1, 1, 0, 100);
+   require(controller.enqueue(), "filling the queue should succeed");
+   require(controller.admit(std::chrono::steady_clock::duration::zero()), "filling the in-flight slot should succeed");
+
+   CountingMessageHandler countingHandler;
+   Socket* serverSocket = conn.serverSideSocket;
+   conn.serverSideSocket = nullptr; // ownership transferred to the handler below
+
+   {
+      MessageRequestHandler handler(serverSocket, &countingHandler);
+      handler.setServerOptions(&options);
+      handler.setAdmissionController(&controller);
+      require(controller.getQueueDepth() == 1, "handler over the queue depth should not be counted");
+      handler.run();
+   }
+
+   Message first;
+   require(first.reconstitute(conn.clientSocket), "client should receive a response to the first request");
+   require(first.isOverloaded(), "first request should be shed for the queue depth");
+   requireStringEquals("echoTest", first.getRequestName(), "shed response should name the request");
+
+   Message second;
+   require(second.reconstitute(conn.clientSocket), "client should receive a response to the second request");
+   require(second.isOverloaded(), "second request should be shed for the in-flight limit");
+
+   require(countingHandler.m_count == 0, "shed requests should never reach the handler");
+   require(controller.getShedCount() == 2, "shed requests should be counted");
+   require(controller.getInFlight() == 1, "shed requests should not stay in flight");
+}
+
+//******************************************************************************
+
+void TestMessageRequestHandler::testRunSchedulesByPriority() {
+   TEST_CASE("testRunSchedulesByPriority");
+
+   const int port = 34747;
+   tonnerre_test::LoopbackConnection conn(port);
+
+   require(writeEchoRequests(conn.clientSocket, 2), "writing requests should succeed");
+   ::shutdown(conn.clientSocket->getFileDescriptor(), SHUT_WR);
+
+   ServerOptions options;
+   options.setKeepAlive(true);
+   options.setRequestPriority("echoTest", MessagePriorityHigh);
+
+   std::mutex mutex;
+   std::condition_variable cond;
+   bool isReleased = false;
+
+   // the only worker is busy, so a scheduled request has to wait its turn
+   PriorityExecutor executor(1, false, std::vector<int>());
+   executor.execute(new GateTask(mutex, cond, isReleased), MessagePriorityLow);
+
+   EchoMessageHandler echoHandler;
+   Socket* serverSocket = conn.serverSideSocket;
+   conn.serverSideSocket = nullptr; // ownership transferred to the handler below
+
+   {
+      MessageRequestHandler handler(serverSocket, &echoHandler);
+      handler.setServerOptions(&options);
+      handler.setPriorityExecutor(&executor);
+      handler.run();
+   }
+
+   require(executor.getQueuedCount(MessagePriorityHigh) == 1, "request should be queued with its configured priority");
+
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      isReleased = true;
+   }
+   cond.notify_all();
+
+   // the scheduled handler keeps the connection and schedules the next one
+   Message first;
+   require(first.reconstitute(conn.clientSocket), "client should receive a response to the first request");
+   requireStringEquals("request 0", first.getTextPayload(), "first response should echo the first request");
+
+   Message second;
+   require(second.reconstitute(conn.clientSocket), "client should receive a response to the second request");
+   requireStringEquals("request 1", second.getTextPayload(), "second response should echo the second request");
+
+   executor.stop();
+}
+
+//******************************************************************************
+
+void TestMessageRequestHandler::testRunRecordsMetrics() {
+   TEST_CASE("testRunRecordsMetrics");
+
+   const int port = 34748;
+   tonnerre_test::LoopbackConnection conn(port);
+
+   require(writeEchoRequests(conn.clientSocket, 2), "writing requests should succeed");
+   Message statsRequest(ServerMetrics::STATS_REQUEST_NAME, MessageTypeKeyValues);
+   require(conn.clientSocket->write(statsRequest.toString()), "writing stats request should succeed");
+   ::shutdown(conn.clientSocket->getFileDescriptor(), SHUT_WR);
+
+   ServerOptions options;
+   options.setKeepAlive(true);
+
+   ServerMetrics metrics;
+   CountingMessageHandler countingHandler;
+   Socket* serverSocket = conn.serverSideSocket;
+   conn.serverSideSocket = nullptr; // ownership transferred to the handler below
+
+   {
+      MessageRequestHandler handler(serverSocket, &countingHandler);
+      handler.setServerOptions(&options);
+      handler.setServerMetrics(&metrics);
+      handler.run();
+   }
+
+   Message first;
+   require(first.reconstitute(conn.clientSocket), "client should receive a response to the first request");
+   Message second;
+   require(second.reconstitute(conn.clientSocket), "client should receive a response to the second request");
+
+   Message stats;
+   require(stats.reconstitute(conn.clientSocket), "client should receive a response to the stats request");
+   requireStringEquals("2", stats.getKeyValuesPayload().getValue("echoTest.requests"),
+                       "stats response should report the requests served before it");
+
+   require(countingHandler.m_count == 2, "stats request should not reach the handler");
+
+   const std::vector<ServerMetrics::RequestStats> requestStats = metrics.getRequestStats();
+   require(requestStats.size() == 1, "stats requests should not be recorded themselves");
+   require(requestStats[0].errors == 0, "successful requests should not count as errors");
+   require(requestStats[0].bytesIn > 0, "request bytes should be recorded");
+   require(requestStats[0].bytesOut > 0, "response bytes should be recorded");
+   require(requestStats[0].totalLatency.getCount() == 2, "each request's latency should be recorded");
+}
+
+//******************************************************************************
+
+void TestMessageRequestHandler::testRunTracesRequest() {
+   TEST_CASE("testRunTracesRequest");
+
+   const int port = 34749;
+   tonnerre_test::LoopbackConnection conn(port);
+
+   Message request("echoTest", MessageTypeText);
+   request.setTextPayload("traced");
+   request.setTraced(true);
+
+   const std::int64_t encodeNanos = RequestTrace::now();
+   const std::string encodedRequest(request.toString());
+   const std::int64_t writeNanos = RequestTrace::now();
+   require(conn.clientSocket->write(encodedRequest), "writing request to client socket should succeed");
+
+   EchoMessageHandler echoHandler;
+   Socket* serverSocket = conn.serverSideSocket;
+   conn.serverSideSocket = nullptr; // ownership transferred to the handler below
+
+   {
+      MessageRequestHandler handler(serverSocket, &echoHandler);
+      handler.run();
+   }
+
+   Message response;
+   require(response.reconstitute(conn.clientSocket), "client should receive a response");
+   require(response.isTraced(), "response to a traced request should be traced");
+   requireStringEquals("traced", response.getTextPayload(), "tracing should not alter the payload");
+
+   RequestTrace::stampClientStages(response, encodeNanos, writeNanos);
+   const RequestTrace trace(response);
+   require(trace.isComplete(), "every stage should be stamped");
+
+   for (int i = RequestTrace::StageServerAccept; i < RequestTrace::StageServerWrite; ++i) {
+      require(RequestTrace::getStamp(response, (RequestTrace::Stage) i) <=
+              RequestTrace::getStamp(response, (RequestTrace::Stage) (i + 1)),
+              "server stages should be stamped in order");
+   }
+
+   // (client and server share a clock here)
+   require(RequestTrace::getStamp(response, RequestTrace::StageClientReceive) >=
+           RequestTrace::getStamp(response, RequestTrace::StageServerWrite),
+           "response should be received after it was written");
+
+}
+
+void TestMessageRequestHandler::testDispatch() {
+   TEST_CASE("testDispatch");
+
+   EchoMessageHandler echoHandler;
+   Message request("echoTest", MessageTypeText);
+   request.setTextPayload("dispatched");
+   Message response("echoTest", MessageTypeText);
+   require(MessageRequestHandler::dispatch(&echoHandler, request, response),
+           "dispatch should report a handler completing");
+   requireStringEquals("dispatched", response.getTextPayload(), "dispatch should populate the response payload");
+
+   ThrowingMessageHandler throwingHandler;
+   Message failedResponse("echoTest", MessageTypeText);
+   requireFalse(MessageRequestHandler::dispatch(&throwingHandler, request, failedResponse),
+                "dispatch should report a handler exception");
+   require(failedResponse.getTextPayload().empty(), "a handler exception should leave the response payload empty");
+}
+
+//******************************************************************************
+
+void TestMessageRequestHandler::testRunAsync() {
+   TEST_CASE("testRunAsync");
+
+   const int port = 34735;
+   tonnerre_test::LoopbackConnection conn(port);
+
+   require(writeEchoRequests(conn.clientSocket, 1), "writing request should succeed");
+
+   DeferringMessageHandler deferringHandler;
+   Socket* serverSocket = conn.serverSideSocket;
+   conn.serverSideSocket = nullptr; // ownership transferred to the handler below
+
+   {
+      MessageRequestHandler handler(serverSocket, &deferringHandler);
+      handler.run();
+   }
+
+   // the handler (and its socket) are gone before the response is written
+   require(deferringHandler.m_responder != nullptr, "async handler should have been given a responder");
+
+   std::shared_ptr<Responder> responder = deferringHandler.m_responder;
+   deferringHandler.m_responder.reset();
+   const std::string payload = deferringHandler.m_payload;
+   std::thread completer([responder, payload]() {
+      responder->complete(payload);
+   });
+   completer.join();
+
+   Message response;
+   require(response.reconstitute(conn.clientSocket), "client should receive the deferred response");
+   requireStringEquals("request 0", response.getTextPayload(), "deferred response should carry the completed payload");
+}
+
+//******************************************************************************
+
+void TestMessageRequestHandler::testRunAsyncKeepsOrder() {
+   TEST_CASE("testRunAsyncKeepsOrder");
+
+   const int port = 34769;
+   tonnerre_test::LoopbackConnection conn(port);
+
+   // a slow async request pipelined ahead of a quick synchronous one
+   Message slowRequest("slow", MessageTypeText);
+   slowRequest.setTextPayload("first");
+   Message quickRequest("quick", MessageTypeText);
+   quickRequest.setTextPayload("second");
+   require(conn.clientSocket->write(slowRequest.toString() + quickRequest.toString()),
+           "writing requests should succeed");
+   ::shutdown(conn.clientSocket->getFileDescriptor(), SHUT_WR);
+
+   ServerOptions options;
+   options.setKeepAlive(true);
+
+   SlowAsyncMessageHandler slowHandler;
+   Socket* serverSocket = conn.serverSideSocket;
+   conn.serverSideSocket = nullptr; // ownership transferred to the handler below
+
+   {
+      MessageRequestHandler handler(serverSocket, &slowHandler);
+      handler.setServerOptions(&options);
+      handler.run();
+      require(handler.getRequestsServed() == 2, "both requests should be served on one connection");
+   }
+
+   // the protocol has no request ids, so the order is all a client has
+   Message firstResponse;
+   require(firstResponse.reconstitute(conn.clientSocket), "client should receive the async response");
+   requireStringEquals("first", firstResponse.getTextPayload(), "the async response should come first");
+   Message secondResponse;
+   require(secondResponse.reconstitute(conn.clientSocket), "client should receive the sync response");
+   requireStringEquals("second", secondResponse.getTextPayload(), "the sync response should come second");
+}
+
+//******************************************************************************
+
+void TestMessageRequestHandler::testDispatchAsyncHandler() {
+   TEST_CASE("testDispatchAsyncHandler");
+
+   ThreadCompletingMessageHandler completingHandler;
+
+   Message request("deferred", MessageTypeText);
+   request.setTextPayload("payload");
+   Message response("deferred", MessageTypeText);
+
+   MessageRequestHandler::dispatch(&completingHandler, request, response);
+   completingHandler.m_thread.join();
+
+   requireStringEquals("completed: payload", response.getTextPayload(), "synchronous dispatch should wait for the responder");
+}
+
+//******************************************************************************
@@ -17,6 +17,18 @@ protected:
    void testConstructorWithSocket();
    void testConstructorWithSocketRequest();
    void testRun();
+   void testRunIngestion();
+   void testRunKeepAlive();
+   void testRunKeepAliveMaxRequests();
+   void testRunKeepAliveParksIdle();
+   void testRunShedsOverload();
+   void testRunSchedulesByPriority();
+   void testRunRecordsMetrics();
+   void testRunTracesRequest();
+   void testDispatch();
+   void testRunAsync();
+   void testRunAsyncKeepsOrder();
+   void testDispatchAsyncHandler();
 
 public:
    TestMessageRequestHandler();
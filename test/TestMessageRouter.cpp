@@ -0,0 +1,225 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <string>
+#include <vector>
+
+#include "TestMessageRouter.h"
+#include "MessageRouter.h"
+#include "MessageRequestHandler.h"
+#include "Message.h"
+#include "KeyValuePairs.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+namespace {
+
+constexpr RouteKey ROUTE_ECHO("echo");
+
+// the hash of a literal route name is available at compile time
+static_assert(ROUTE_ECHO.hash() == RouteKey::hashName("echo"),
+              "route key hash should be computed at compile time");
+
+// Answers every request with a fixed reply and counts its calls.
+class FixedReplyMessageHandler : public tonnerre::MessageHandler {
+public:
+   explicit FixedReplyMessageHandler(const std::string& reply) :
+      m_reply(reply),
+      m_count(0) {
+   }
+
+   void handleTextMessage(const Message&,
+                          Message&,
+                          const std::string&,
+                          const std::string&,
+                          std::string& responsePayload) override {
+      ++m_count;
+      responsePayload = m_reply;
+   }
+
+   void handleKeyValuesMessage(const Message&,
+                               Message&,
+                               const std::string&,
+                               const chaudiere::KeyValuePairs&,
+                               chaudiere::KeyValuePairs& responsePayload) override {
+      ++m_count;
+      responsePayload.addPair("reply", m_reply);
+   }
+
+   std::string m_reply;
+   int m_count;
+};
+
+std::string dispatchText(MessageRouter& router,
+                         const std::string& requestName,
+                         const std::string& payload) {
+   Message request(requestName, MessageTypeText);
+   request.setTextPayload(payload);
+   Message response(requestName, MessageTypeText);
+   MessageRequestHandler::dispatch(&router, request, response);
+   return response.getTextPayload();
+}
+
+}
+
+//******************************************************************************
+
+TestMessageRouter::TestMessageRouter() :
+   poivre::TestSuite("TestMessageRouter") {
+}
+
+//******************************************************************************
+
+void TestMessageRouter::runTests() {
+   testRouteKey();
+   testRoute();
+   testManyRoutes();
+   testFallback();
+   testRouteFallback();
+   testHooks();
+}
+
+//******************************************************************************
+
+void TestMessageRouter::testRouteKey() {
+   TEST_CASE("testRouteKey");
+
+   const std::string name("echo");
+   RouteKey runtimeKey(name);
+   require(runtimeKey.hash() == ROUTE_ECHO.hash(), "runtime and compile-time hashes should agree");
+   require(runtimeKey.name() == ROUTE_ECHO.name(), "key should carry the request name");
+   require(RouteKey::hashName("echo") != RouteKey::hashName("ohce"), "different names should hash differently");
+}
+
+//******************************************************************************
+
+void TestMessageRouter::testRoute() {
+   TEST_CASE("testRoute");
+
+   MessageRouter router;
+   router.route(ROUTE_ECHO)
+      .onText([](const Message&, Message&, const std::string& requestPayload, std::string& responsePayload) {
+         responsePayload = requestPayload;
+      })
+      .onKeyValues([](const Message&, Message&, const KeyValuePairs& requestPayload, KeyValuePairs& responsePayload) {
+         responsePayload = requestPayload;
+      });
+
+   require(router.getNumberRoutes() == 1, "one route should be registered");
+   require(&router.route(ROUTE_ECHO) == router.findRoute("echo"), "registering the same name again should return the existing route");
+   require(router.getNumberRoutes() == 1, "re-registering should not add a route");
+   require(router.findRoute("missing") == nullptr, "unregistered name should have no route");
+
+   requireStringEquals("hello", dispatchText(router, "echo", "hello"), "text request should reach its route");
+
+   Message request("echo", MessageTypeKeyValues);
+   KeyValuePairs kvp;
+   kvp.addPair("k", "v");
+   request.setKeyValuesPayload(kvp);
+   Message response("echo", MessageTypeKeyValues);
+   MessageRequestHandler::dispatch(&router, request, response);
+   requireStringEquals("v", response.getKeyValuesPayload().getValue("k"), "key-values request should reach its route");
+}
+
+//******************************************************************************
+
+void TestMessageRouter::testManyRoutes() {
+   TEST_CASE("testManyRoutes");
+
+   MessageRouter router;
+   const int numberRoutes = 200;
+   for (int i = 0; i < numberRoutes; ++i) {
+      const std::string name = "request" + std::to_string(i);
+      router.route(name).onText([name](const Message&, Message&, const std::string&, std::string& responsePayload) {
+         responsePayload = name;
+      });
+   }
+
+   require(router.getNumberRoutes() == (std::size_t) numberRoutes, "every route should be registered");
+
+   bool allRouted = true;
+   for (int i = 0; i < numberRoutes; ++i) {
+      const std::string name = "request" + std::to_string(i);
+      if (dispatchText(router, name, "") != name) {
+         allRouted = false;
+      }
+   }
+   require(allRouted, "every request should reach its own route after the table grows");
+}
+
+//******************************************************************************
+
+void TestMessageRouter::testFallback() {
+   TEST_CASE("testFallback");
+
+   FixedReplyMessageHandler fallback("fallback");
+
+   MessageRouter router;
+   router.route(ROUTE_ECHO).onText([](const Message&, Message&, const std::string& requestPayload, std::string& responsePayload) {
+      responsePayload = requestPayload;
+   });
+
+   requireStringEquals("", dispatchText(router, "unknown", "x"), "unrouted request without a fallback should get no payload");
+
+   router.setFallback(&fallback);
+   requireStringEquals("fallback", dispatchText(router, "unknown", "x"), "unrouted request should go to the fallback");
+   requireStringEquals("x", dispatchText(router, "echo", "x"), "routed request should not go to the fallback");
+   require(fallback.m_count == 1, "fallback should only see the unrouted request");
+}
+
+//******************************************************************************
+
+void TestMessageRouter::testRouteFallback() {
+   TEST_CASE("testRouteFallback");
+
+   FixedReplyMessageHandler routerFallback("router");
+   FixedReplyMessageHandler routeFallback("route");
+
+   MessageRouter router;
+   router.setFallback(&routerFallback);
+   router.route("kvpOnly").onKeyValues([](const Message&, Message&, const KeyValuePairs&, KeyValuePairs&) {
+   });
+   router.route("kvpOnlyWithFallback")
+      .onKeyValues([](const Message&, Message&, const KeyValuePairs&, KeyValuePairs&) {
+      })
+      .fallback(&routeFallback);
+
+   requireStringEquals("router", dispatchText(router, "kvpOnly", ""), "unhandled payload type should go to the router fallback");
+   requireStringEquals("route", dispatchText(router, "kvpOnlyWithFallback", ""), "route's own fallback should take precedence");
+}
+
+//******************************************************************************
+
+void TestMessageRouter::testHooks() {
+   TEST_CASE("testHooks");
+
+   std::vector<std::string> calls;
+   bool allow = true;
+
+   MessageRouter router;
+   router.route("guarded")
+      .before([&](const Message&, Message&) {
+         calls.push_back("before");
+         return allow;
+      })
+      .onText([&](const Message&, Message&, const std::string&, std::string& responsePayload) {
+         calls.push_back("handler");
+         responsePayload = "handled";
+      })
+      .after([&](const Message&, Message&) {
+         calls.push_back("after");
+      });
+
+   requireStringEquals("handled", dispatchText(router, "guarded", ""), "request should be handled when the before hook allows it");
+   require(calls.size() == 3, "before hook, handler and after hook should each run");
+   requireStringEquals("before", calls[0], "before hook runs first");
+   requireStringEquals("after", calls[2], "after hook runs last");
+
+   calls.clear();
+   allow = false;
+   requireStringEquals("", dispatchText(router, "guarded", ""), "request should not be handled when the before hook refuses it");
+   require(calls.size() == 1, "only the before hook should run when it refuses the request");
+}
+
+//******************************************************************************
@@ -0,0 +1,32 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTMESSAGEROUTER_H
+#define TONNERRE_TESTMESSAGEROUTER_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestMessageRouter : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testRouteKey();
+   void testRoute();
+   void testManyRoutes();
+   void testFallback();
+   void testRouteFallback();
+   void testHooks();
+
+public:
+   TestMessageRouter();
+
+};
+
+}
+
+#endif
+
@@ -25,6 +25,7 @@ void TestMessaging::runTests() {
    testSetMessaging();
    testGetMessaging();
    testInitialize();
+   testInitializeWithPath();
    testIsInitialized();
 
    testConstructor();
@@ -34,6 +35,8 @@ void TestMessaging::runTests() {
    testGetInfoForService();
    testSocketForService();
    testReturnSocketForService();
+   testGetOptionsForService();
+   testBatchingSenderForService();
 }
 
 //******************************************************************************
@@ -84,6 +87,32 @@ void TestMessaging::testInitialize() {
 
 //******************************************************************************
 
+void TestMessaging::testInitializeWithPath() {
+   TEST_CASE("testInitializeWithPath");
+
+   const std::string configPath = getTempFile();
+   std::ofstream configFile(configPath.c_str());
+   configFile << "[services]\n";
+   configFile << "sidecar = Sidecar\n";
+   configFile << "\n";
+   configFile << "[Sidecar]\n";
+   configFile << "path = /run/sidecar.sock\n";
+   configFile.close();
+
+   Messaging::initialize(configPath);
+
+   std::shared_ptr<Messaging> messaging = Messaging::getMessaging();
+   require(nullptr != messaging, "initialize should establish a Messaging singleton");
+   require(messaging->isServiceRegistered("sidecar"), "a service with only a path should be registered");
+   const ServiceInfo serviceInfo = messaging->getInfoForService("sidecar");
+   requireStringEquals("/run/sidecar.sock", serviceInfo.host(), "the path should stand in for the host");
+   require(serviceInfo.port() == 0, "a unix socket service should have no port");
+
+   deleteFile(configPath);
+}
+
+//******************************************************************************
+
 void TestMessaging::testIsInitialized() {
    TEST_CASE("testIsInitialized");
 
@@ -194,3 +223,38 @@ void TestMessaging::testReturnSocketForService() {
 }
 
 //******************************************************************************
+
+void TestMessaging::testGetOptionsForService() {
+   TEST_CASE("testGetOptionsForService");
+
+   Messaging messaging;
+   requireFalse(messaging.getOptionsForService("unknownService").isAsyncOneWay(), "unknown service should get default options");
+
+   ServiceOptions options;
+   options.setAsyncOneWay(true);
+   messaging.setOptionsForService("optionsService", options);
+   require(messaging.getOptionsForService("optionsService").isAsyncOneWay(), "options should be retrievable after being set");
+}
+
+//******************************************************************************
+
+void TestMessaging::testBatchingSenderForService() {
+   TEST_CASE("testBatchingSenderForService");
+
+   Messaging messaging;
+   ServiceInfo syncInfo("syncService", "127.0.0.1", 34723);
+   messaging.registerService("syncService", syncInfo);
+   require(nullptr == messaging.batchingSenderForService("syncService"), "a service without async should not get a sender");
+
+   ServiceInfo asyncInfo("asyncService", "127.0.0.1", 34724);
+   ServiceOptions options;
+   options.setAsyncOneWay(true);
+   messaging.registerService("asyncService", asyncInfo);
+   messaging.setOptionsForService("asyncService", options);
+
+   BatchingSender* sender = messaging.batchingSenderForService("asyncService");
+   require(nullptr != sender, "an async service should get a sender");
+   require(sender == messaging.batchingSenderForService("asyncService"), "the sender should be created once and reused");
+}
+
+//******************************************************************************
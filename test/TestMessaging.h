@@ -17,6 +17,7 @@ protected:
    void testSetMessaging();
    void testGetMessaging();
    void testInitialize();
+   void testInitializeWithPath();
    void testIsInitialized();
 
    void testConstructor();
@@ -26,6 +27,8 @@ protected:
    void testGetInfoForService();
    void testSocketForService();
    void testReturnSocketForService();
+   void testGetOptionsForService();
+   void testBatchingSenderForService();
 
 public:
    TestMessaging();
@@ -38,6 +38,33 @@ public:
    }
 };
 
+// Answers every text request with a fixed reply, so tests can tell which
+// service's handler a request was routed to.
+class FixedReplyMessageHandler : public tonnerre::MessageHandler {
+public:
+   explicit FixedReplyMessageHandler(const std::string& reply) :
+      m_reply(reply) {
+   }
+
+   void handleTextMessage(const Message&,
+                          Message&,
+                          const std::string&,
+                          const std::string&,
+                          std::string& responsePayload) override {
+      responsePayload = m_reply;
+   }
+
+   void handleKeyValuesMessage(const Message&,
+                               Message&,
+                               const std::string&,
+                               const chaudiere::KeyValuePairs&,
+                               chaudiere::KeyValuePairs&) override {
+   }
+
+private:
+   std::string m_reply;
+};
+
 // Unused by these tests directly, but required to construct a SocketRequest.
 class NoOpSocketServiceHandler : public chaudiere::SocketServiceHandler {
 public:
@@ -74,6 +101,7 @@ void TestMessagingServer::runTests() {
    testHandlerForSocket();
    testHandlerForSocketRequest();
    testCreateSocketServiceHandler();
+   testRegisterService();
 }
 
 //******************************************************************************
@@ -210,3 +238,57 @@ void TestMessagingServer::testCreateSocketServiceHandler() {
 }
 
 //******************************************************************************
+
+void TestMessagingServer::testRegisterService() {
+   TEST_CASE("testRegisterService");
+
+   const std::string configPath = getTempFile();
+   writeServerConfig(configPath, 34731);
+
+   FixedReplyMessageHandler serverInfoHandler("server_info");
+   FixedReplyMessageHandler echoHandler("echo_service");
+
+   MessagingServer server(configPath, "server_info", &serverInfoHandler);
+   server.registerService("echo_service", &echoHandler);
+   require(server.getServiceDispatcher().getNumberServices() == 2, "both services should be registered");
+
+   const int connPort = 34732;
+   tonnerre_test::LoopbackConnection conn(connPort);
+
+   // one request per service, plus one that doesn't name a service
+   std::string requests;
+   const char* serviceNames[] = { "echo_service", "server_info", nullptr };
+   for (const char* serviceName : serviceNames) {
+      Message request("whichService", MessageTypeText);
+      if (serviceName != nullptr) {
+         request.setHeader("service", serviceName);
+      }
+      requests += request.toString();
+   }
+   require(conn.clientSocket->write(requests), "writing requests should succeed");
+
+   // SocketRequest-based handlers don't own the socket, so one connection
+   // can be serviced by a handler per request
+   NoOpSocketServiceHandler socketServiceHandler;
+   Socket* serverSocket = conn.serverSideSocket;
+   conn.serverSideSocket = nullptr; // ownership transferred to the SocketRequest below
+   SocketRequest* socketRequest = new SocketRequest(serverSocket, &socketServiceHandler);
+
+   for (int i = 0; i < 3; ++i) {
+      RequestHandler* requestHandler = server.handlerForSocketRequest(socketRequest);
+      requestHandler->run();
+      delete requestHandler;
+   }
+
+   const char* expectedReplies[] = { "echo_service", "server_info", "server_info" };
+   for (const char* expected : expectedReplies) {
+      Message response;
+      require(response.reconstitute(conn.clientSocket), "client should receive a response per request");
+      requireStringEquals(expected, response.getTextPayload(), "request should be routed to its service's handler");
+   }
+
+   delete socketRequest;
+   deleteFile(configPath);
+}
+
+//******************************************************************************
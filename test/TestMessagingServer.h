@@ -19,6 +19,7 @@ protected:
    void testHandlerForSocket();
    void testHandlerForSocketRequest();
    void testCreateSocketServiceHandler();
+   void testRegisterService();
 
 public:
    TestMessagingServer();
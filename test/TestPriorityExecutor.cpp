@@ -0,0 +1,197 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "TestPriorityExecutor.h"
+#include "PriorityExecutor.h"
+#include "Runnable.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+namespace {
+
+// Holds the executor's only worker until released, so that the tasks
+// queued meanwhile are all waiting when the worker picks its next one.
+class GateTask : public chaudiere::Runnable {
+public:
+   GateTask(std::atomic<bool>& isStarted, std::atomic<bool>& isReleased) :
+      m_isStarted(isStarted),
+      m_isReleased(isReleased) {
+   }
+
+   void run() override {
+      m_isStarted = true;
+      while (!m_isReleased) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+   }
+
+private:
+   std::atomic<bool>& m_isStarted;
+   std::atomic<bool>& m_isReleased;
+};
+
+// Appends its tag to a shared string when run, recording the run order.
+class RecordingTask : public chaudiere::Runnable {
+public:
+   RecordingTask(std::string& order, std::mutex& mutex, char tag) :
+      m_order(order),
+      m_mutex(mutex),
+      m_tag(tag) {
+   }
+
+   void run() override {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_order += m_tag;
+   }
+
+private:
+   std::string& m_order;
+   std::mutex& m_mutex;
+   char m_tag;
+};
+
+// Counts deletions so tests can check the executor took ownership.
+class DeletionTask : public chaudiere::Runnable {
+public:
+   explicit DeletionTask(std::atomic<int>& deleteCount) :
+      m_deleteCount(deleteCount) {
+   }
+
+   ~DeletionTask() {
+      ++m_deleteCount;
+   }
+
+   void run() override {
+   }
+
+private:
+   std::atomic<int>& m_deleteCount;
+};
+
+void holdWorker(PriorityExecutor& executor,
+                std::atomic<bool>& isStarted,
+                std::atomic<bool>& isReleased) {
+   // (normal priority: the tests below queue only high and low tasks, so
+   // the turn the gate takes doesn't shift their order)
+   executor.execute(new GateTask(isStarted, isReleased), MessagePriorityNormal);
+   while (!isStarted) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+   }
+}
+
+}
+
+//******************************************************************************
+
+TestPriorityExecutor::TestPriorityExecutor() :
+   poivre::TestSuite("TestPriorityExecutor") {
+}
+
+//******************************************************************************
+
+void TestPriorityExecutor::runTests() {
+   testNumberWorkers();
+   testStrictOrder();
+   testWeightedOrder();
+   testExecuteAfterStop();
+}
+
+//******************************************************************************
+
+void TestPriorityExecutor::testNumberWorkers() {
+   TEST_CASE("testNumberWorkers");
+
+   PriorityExecutor executor(3, false, std::vector<int>());
+   require(executor.getNumberWorkers() == 3, "should start the requested number of workers");
+
+   PriorityExecutor minimum(0, false, std::vector<int>());
+   require(minimum.getNumberWorkers() == 1, "should start at least one worker");
+}
+
+//******************************************************************************
+
+void TestPriorityExecutor::testStrictOrder() {
+   TEST_CASE("testStrictOrder");
+
+   std::atomic<bool> isStarted(false);
+   std::atomic<bool> isReleased(false);
+   std::string order;
+   std::mutex mutex;
+
+   PriorityExecutor executor(1, false, std::vector<int>());
+   holdWorker(executor, isStarted, isReleased);
+
+   executor.execute(new RecordingTask(order, mutex, 'l'), MessagePriorityLow);
+   executor.execute(new RecordingTask(order, mutex, 'n'));
+   executor.execute(new RecordingTask(order, mutex, 'l'), MessagePriorityLow);
+   executor.execute(new RecordingTask(order, mutex, 'h'), MessagePriorityHigh);
+   executor.execute(new RecordingTask(order, mutex, 'n'), MessagePriorityNormal);
+   executor.execute(new RecordingTask(order, mutex, 'h'), MessagePriorityHigh);
+
+   require(executor.getQueuedCount(MessagePriorityHigh) == 2, "high tasks should wait in the high queue");
+   require(executor.getQueuedCount(MessagePriorityNormal) == 2, "untagged tasks should wait in the normal queue");
+   require(executor.getQueuedCount(MessagePriorityLow) == 2, "low tasks should wait in the low queue");
+
+   isReleased = true;
+   executor.stop();
+
+   requireStringEquals("hhnnll", order, "strict scheduling should drain higher classes first");
+}
+
+//******************************************************************************
+
+void TestPriorityExecutor::testWeightedOrder() {
+   TEST_CASE("testWeightedOrder");
+
+   std::atomic<bool> isStarted(false);
+   std::atomic<bool> isReleased(false);
+   std::string order;
+   std::mutex mutex;
+
+   // (weights apply per round: two high turns for every low one)
+   std::vector<int> weights;
+   weights.push_back(2);
+   weights.push_back(1);
+   weights.push_back(1);
+
+   PriorityExecutor executor(1, true, weights);
+   holdWorker(executor, isStarted, isReleased);
+
+   for (int i = 0; i < 4; ++i) {
+      executor.execute(new RecordingTask(order, mutex, 'l'), MessagePriorityLow);
+   }
+   for (int i = 0; i < 4; ++i) {
+      executor.execute(new RecordingTask(order, mutex, 'h'), MessagePriorityHigh);
+   }
+
+   isReleased = true;
+   executor.stop();
+
+   requireStringEquals("hhlhhlll", order, "weighted scheduling should interleave classes by weight");
+}
+
+//******************************************************************************
+
+void TestPriorityExecutor::testExecuteAfterStop() {
+   TEST_CASE("testExecuteAfterStop");
+
+   std::atomic<int> deleteCount(0);
+
+   PriorityExecutor executor(2, false, std::vector<int>());
+   require(executor.execute(new DeletionTask(deleteCount), MessagePriorityLow), "running executor should accept tasks");
+   executor.stop();
+   require(deleteCount == 1, "accepted task should be deleted after running");
+
+   requireFalse(executor.execute(new DeletionTask(deleteCount), MessagePriorityHigh), "stopped executor should reject tasks");
+   require(deleteCount == 2, "rejected task should still be deleted");
+   requireFalse(executor.execute(nullptr), "null task should be rejected");
+}
+
+//******************************************************************************
@@ -0,0 +1,29 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTPRIORITYEXECUTOR_H
+#define TONNERRE_TESTPRIORITYEXECUTOR_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestPriorityExecutor : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testNumberWorkers();
+   void testStrictOrder();
+   void testWeightedOrder();
+   void testExecuteAfterStop();
+
+public:
+   TestPriorityExecutor();
+
+};
+
+}
+
+#endif
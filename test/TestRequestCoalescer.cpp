@@ -0,0 +1,167 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <thread>
+
+#include "TestRequestCoalescer.h"
+#include "RequestCoalescer.h"
+#include "Message.h"
+
+using namespace tonnerre;
+
+//******************************************************************************
+
+TestRequestCoalescer::TestRequestCoalescer() :
+   poivre::TestSuite("TestRequestCoalescer") {
+}
+
+//******************************************************************************
+
+void TestRequestCoalescer::runTests() {
+   testKeyFor();
+   testJoinLeader();
+   testJoinFollower();
+   testJoinDifferentRequest();
+   testComplete();
+   testWait();
+   testWaitFailure();
+}
+
+//******************************************************************************
+
+void TestRequestCoalescer::testKeyFor() {
+   TEST_CASE("testKeyFor");
+
+   const std::string a = RequestCoalescer::keyFor("svc", "get", "payload-a");
+   const std::string a2 = RequestCoalescer::keyFor("svc", "get", "payload-a");
+   const std::string b = RequestCoalescer::keyFor("svc", "get", "payload-b");
+   const std::string c = RequestCoalescer::keyFor("other", "get", "payload-a");
+
+   requireStringEquals(a, a2, "identical requests should produce identical keys");
+   require(a != b, "different payloads should produce different keys");
+   require(a != c, "different services should produce different keys");
+}
+
+//******************************************************************************
+
+void TestRequestCoalescer::testJoinLeader() {
+   TEST_CASE("testJoinLeader");
+
+   RequestCoalescer coalescer;
+   bool isLeader = false;
+   std::shared_ptr<RequestCoalescer::Call> call =
+      coalescer.join("key", "request", isLeader);
+
+   require(nullptr != call, "first join should return a call");
+   require(isLeader, "first join should be the leader");
+   require(coalescer.getInFlightCount() == 1, "call should be in flight");
+}
+
+//******************************************************************************
+
+void TestRequestCoalescer::testJoinFollower() {
+   TEST_CASE("testJoinFollower");
+
+   RequestCoalescer coalescer;
+   bool isLeader = false;
+   std::shared_ptr<RequestCoalescer::Call> leaderCall =
+      coalescer.join("key", "request", isLeader);
+
+   bool followerIsLeader = true;
+   std::shared_ptr<RequestCoalescer::Call> followerCall =
+      coalescer.join("key", "request", followerIsLeader);
+
+   requireFalse(followerIsLeader, "second join should be a follower");
+   require(leaderCall == followerCall, "follower should share the leader's call");
+   require(coalescer.getInFlightCount() == 1, "only one call should be in flight");
+}
+
+//******************************************************************************
+
+void TestRequestCoalescer::testJoinDifferentRequest() {
+   TEST_CASE("testJoinDifferentRequest");
+
+   RequestCoalescer coalescer;
+   bool isLeader = false;
+   coalescer.join("key", "request-1", isLeader);
+
+   bool otherIsLeader = true;
+   std::shared_ptr<RequestCoalescer::Call> other =
+      coalescer.join("key", "request-2", otherIsLeader);
+
+   require(nullptr == other, "a different request under the same key must not be coalesced");
+   requireFalse(otherIsLeader, "a rejected join should not be the leader");
+}
+
+//******************************************************************************
+
+void TestRequestCoalescer::testComplete() {
+   TEST_CASE("testComplete");
+
+   RequestCoalescer coalescer;
+   bool isLeader = false;
+   std::shared_ptr<RequestCoalescer::Call> call =
+      coalescer.join("key", "request", isLeader);
+
+   Message response("reply", MessageTypeText);
+   coalescer.complete("key", call, true, response);
+
+   require(coalescer.getInFlightCount() == 0, "completed call should no longer be in flight");
+
+   bool nextIsLeader = false;
+   coalescer.join("key", "request", nextIsLeader);
+   require(nextIsLeader, "a request after completion should start a new round trip");
+}
+
+//******************************************************************************
+
+void TestRequestCoalescer::testWait() {
+   TEST_CASE("testWait");
+
+   RequestCoalescer coalescer;
+   bool isLeader = false;
+   std::shared_ptr<RequestCoalescer::Call> leaderCall =
+      coalescer.join("key", "request", isLeader);
+
+   bool followerIsLeader = true;
+   std::shared_ptr<RequestCoalescer::Call> followerCall =
+      coalescer.join("key", "request", followerIsLeader);
+
+   Message followerResponse;
+   bool followerResult = false;
+   std::thread follower([&]() {
+      followerResult = coalescer.wait(followerCall, followerResponse);
+   });
+
+   Message response("reply", MessageTypeText);
+   response.setTextPayload("shared answer");
+   coalescer.complete("key", leaderCall, true, response);
+   follower.join();
+
+   require(followerResult, "follower should see the leader's success");
+   requireStringEquals("shared answer", followerResponse.getTextPayload(), "follower should receive a copy of the leader's response");
+   requireStringEquals("reply", followerResponse.getRequestName(), "follower response should carry the request name");
+}
+
+//******************************************************************************
+
+void TestRequestCoalescer::testWaitFailure() {
+   TEST_CASE("testWaitFailure");
+
+   RequestCoalescer coalescer;
+   bool isLeader = false;
+   std::shared_ptr<RequestCoalescer::Call> leaderCall =
+      coalescer.join("key", "request", isLeader);
+
+   bool followerIsLeader = true;
+   std::shared_ptr<RequestCoalescer::Call> followerCall =
+      coalescer.join("key", "request", followerIsLeader);
+
+   Message empty;
+   coalescer.complete("key", leaderCall, false, empty);
+
+   Message followerResponse;
+   requireFalse(coalescer.wait(followerCall, followerResponse), "follower should see the leader's failure");
+}
+
+//******************************************************************************
@@ -0,0 +1,33 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTREQUESTCOALESCER_H
+#define TONNERRE_TESTREQUESTCOALESCER_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestRequestCoalescer : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testKeyFor();
+   void testJoinLeader();
+   void testJoinFollower();
+   void testJoinDifferentRequest();
+   void testComplete();
+   void testWait();
+   void testWaitFailure();
+
+public:
+   TestRequestCoalescer();
+
+};
+
+}
+
+#endif
+
@@ -0,0 +1,176 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "TestRequestTrace.h"
+#include "RequestTrace.h"
+#include "Message.h"
+
+using namespace tonnerre;
+
+//******************************************************************************
+
+static void stampAll(Message& message) {
+   // 1ms of encoding, 10us each for accept->read->parse->handler start,
+   // a 100us handler, 10us to respond; the client waits 400us in all
+   const std::int64_t clientStamps[] = { 1000000, 2000000, 2400000 };
+   const std::int64_t serverStamps[] = { 500000, 510000, 520000, 530000, 630000, 640000 };
+
+   RequestTrace::stamp(message, RequestTrace::StageClientEncode, clientStamps[0]);
+   RequestTrace::stamp(message, RequestTrace::StageClientWrite, clientStamps[1]);
+   RequestTrace::stamp(message, RequestTrace::StageClientReceive, clientStamps[2]);
+
+   for (int i = RequestTrace::StageServerAccept; i <= RequestTrace::StageServerWrite; ++i) {
+      RequestTrace::stamp(message, (RequestTrace::Stage) i,
+                          serverStamps[i - RequestTrace::StageServerAccept]);
+   }
+}
+
+//******************************************************************************
+
+TestRequestTrace::TestRequestTrace() :
+   poivre::TestSuite("TestRequestTrace") {
+}
+
+//******************************************************************************
+
+void TestRequestTrace::runTests() {
+   testStamp();
+   testCopyStamps();
+   testStampReceipt();
+   testStampServerStages();
+   testBreakdown();
+   testIncomplete();
+}
+
+//******************************************************************************
+
+void TestRequestTrace::testStamp() {
+   TEST_CASE("testStamp");
+
+   Message message("lookup", MessageTypeText);
+   require(RequestTrace::getStamp(message, RequestTrace::StageHandlerStart) == 0,
+           "unstamped stages should read as 0");
+
+   RequestTrace::stamp(message, RequestTrace::StageHandlerStart, 123456789);
+   require(RequestTrace::getStamp(message, RequestTrace::StageHandlerStart) == 123456789,
+           "getStamp should return the stamped time");
+   requireStringEquals("123456789", message.getHeader("trace.handler_start"),
+                       "stamps should travel as trace.<stage> headers");
+
+   Message received;
+   require(received.reconstituteFromFrame(message.toString()), "reconstitute should succeed");
+   require(RequestTrace::getStamp(received, RequestTrace::StageHandlerStart) == 123456789,
+           "stamps should survive the round trip");
+
+   require(RequestTrace::now() > 0, "now should read the monotonic clock");
+}
+
+//******************************************************************************
+
+void TestRequestTrace::testCopyStamps() {
+   TEST_CASE("testCopyStamps");
+
+   Message source("lookup", MessageTypeText);
+   stampAll(source);
+   source.setHeader("unrelated", "value");
+
+   Message destination("lookup", MessageTypeText);
+   RequestTrace::copyStamps(source, destination);
+
+   for (int i = 0; i < RequestTrace::NUMBER_STAGES; ++i) {
+      const RequestTrace::Stage stage = (RequestTrace::Stage) i;
+      require(RequestTrace::getStamp(destination, stage) == RequestTrace::getStamp(source, stage),
+              "every stage should be copied");
+   }
+   requireFalse(destination.hasHeader("unrelated"), "other headers should not be copied");
+}
+
+//******************************************************************************
+
+void TestRequestTrace::testStampReceipt() {
+   TEST_CASE("testStampReceipt");
+
+   Message request("lookup", MessageTypeText);
+   request.setTextPayload("payload");
+   request.setTraced(true);
+
+   const std::int64_t before = RequestTrace::now();
+   Message received;
+   require(received.reconstituteFromFrame(request.toString()), "reconstitute should succeed");
+   const std::int64_t after = RequestTrace::now();
+
+   require(received.hasHeader("trace.read"), "traced messages should be stamped when read");
+   require(received.hasHeader("trace.parse"), "traced messages should be stamped when parsed");
+
+   Message response("lookup", MessageTypeText);
+   RequestTrace::stampServerStages(received, response, 0, after, 0);
+   const std::int64_t readNanos = RequestTrace::getStamp(response, RequestTrace::StageServerRead);
+   const std::int64_t parseNanos = RequestTrace::getStamp(response, RequestTrace::StageServerParse);
+   require((readNanos >= before) && (readNanos <= parseNanos) && (parseNanos <= after),
+           "receipt should be stamped while the message was decoded");
+   require(RequestTrace::getStamp(response, RequestTrace::StageServerAccept) == readNanos,
+           "accept should default to the read stage");
+}
+
+//******************************************************************************
+
+void TestRequestTrace::testStampServerStages() {
+   TEST_CASE("testStampServerStages");
+
+   Message request("lookup", MessageTypeText);
+   RequestTrace::stampReceipt(request, 200, 300);
+
+   Message response("lookup", MessageTypeText);
+   RequestTrace::stampServerStages(request, response, 100, 400, 0);
+   require(response.isTraced(), "stamped responses should be marked traced");
+   require(RequestTrace::getStamp(response, RequestTrace::StageServerAccept) == 100, "accept");
+   require(RequestTrace::getStamp(response, RequestTrace::StageServerRead) == 200, "read");
+   require(RequestTrace::getStamp(response, RequestTrace::StageServerParse) == 300, "parse");
+   require(RequestTrace::getStamp(response, RequestTrace::StageHandlerStart) == 400, "handler start");
+   require(RequestTrace::getStamp(response, RequestTrace::StageHandlerEnd) == 0,
+           "handler end should be left for later when not yet known");
+
+   RequestTrace::stampServerStages(request, response, 100, 400, 500);
+   require(RequestTrace::getStamp(response, RequestTrace::StageHandlerEnd) == 500, "handler end");
+}
+
+//******************************************************************************
+
+void TestRequestTrace::testBreakdown() {
+   TEST_CASE("testBreakdown");
+
+   Message response("lookup", MessageTypeText);
+   stampAll(response);
+
+   const RequestTrace trace(response);
+   require(trace.isComplete(), "every stage was stamped");
+   require(trace.getMicros(RequestTrace::StageClientEncode, RequestTrace::StageClientWrite) == 1000, "encode");
+   require(trace.getMicros(RequestTrace::StageHandlerStart, RequestTrace::StageHandlerEnd) == 100, "handler");
+   require(trace.getNetworkMicros() == 260, "network is the client's wait less the server's time");
+   require(trace.getTotalMicros() == 1400, "total runs from encode to receipt");
+
+   requireStringEquals("encode=1000us network=260us read=10us parse=10us queue=10us "
+                       "handler=100us respond=10us total=1400us",
+                       trace.toString(), "toString should format the breakdown");
+
+   const RequestTrace copy(trace);
+   require(copy.getTotalMicros() == 1400, "copies should keep the stamps");
+}
+
+//******************************************************************************
+
+void TestRequestTrace::testIncomplete() {
+   TEST_CASE("testIncomplete");
+
+   Message response("lookup", MessageTypeText);
+   RequestTrace::stamp(response, RequestTrace::StageHandlerStart, 1000);
+
+   const RequestTrace trace(response);
+   requireFalse(trace.isComplete(), "missing stages should leave the breakdown incomplete");
+   require(trace.getMicros(RequestTrace::StageHandlerStart, RequestTrace::StageHandlerEnd) == 0,
+           "intervals with a missing stage should read as 0");
+   require(trace.getNetworkMicros() == 0, "network needs both sides' stages");
+   require(trace.getTotalMicros() == 0, "total needs the client's stages");
+}
+
+//******************************************************************************
@@ -0,0 +1,31 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTREQUESTTRACE_H
+#define TONNERRE_TESTREQUESTTRACE_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestRequestTrace : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testStamp();
+   void testCopyStamps();
+   void testStampReceipt();
+   void testStampServerStages();
+   void testBreakdown();
+   void testIncomplete();
+
+public:
+   TestRequestTrace();
+
+};
+
+}
+
+#endif
@@ -0,0 +1,186 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <memory>
+#include <thread>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "TestResponder.h"
+#include "Responder.h"
+#include "ResponseQueue.h"
+#include "Message.h"
+#include "KeyValuePairs.h"
+#include "LoopbackConnection.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+//******************************************************************************
+
+TestResponder::TestResponder() :
+   poivre::TestSuite("TestResponder") {
+}
+
+//******************************************************************************
+
+void TestResponder::runTests() {
+   testCompleteWritesResponse();
+   testCompleteOnce();
+   testDestroyWithoutComplete();
+   testOneWay();
+   testCompletion();
+   testResponseQueue();
+}
+
+//******************************************************************************
+
+void TestResponder::testCompleteWritesResponse() {
+   TEST_CASE("testCompleteWritesResponse");
+
+   tonnerre_test::LoopbackConnection conn(34733);
+
+   std::shared_ptr<Responder::Connection> connection(
+      new Responder::Connection(conn.serverSideSocket));
+   conn.serverSideSocket = nullptr; // ownership transferred to the connection
+
+   Message request("lookup", MessageTypeKeyValues);
+   std::shared_ptr<Responder> responder(new Responder(connection, request));
+   requireFalse(responder->isComplete(), "responder should start incomplete");
+
+   // completed from another thread, as a real async handler would
+   std::thread completer([responder]() {
+      KeyValuePairs kvp;
+      kvp.addPair("answer", "42");
+      responder->complete(kvp);
+   });
+   completer.join();
+
+   require(responder->isComplete(), "responder should be complete");
+
+   Message response;
+   require(response.reconstitute(conn.clientSocket), "client should receive the response");
+   requireStringEquals("lookup", response.getRequestName(), "response should carry the request name");
+   requireStringEquals("42", response.getKeyValuesPayload().getValue("answer"), "response should carry the completed payload");
+}
+
+//******************************************************************************
+
+void TestResponder::testCompleteOnce() {
+   TEST_CASE("testCompleteOnce");
+
+   std::shared_ptr<Responder::Completion> completion(new Responder::Completion);
+   Message request("once", MessageTypeText);
+   Responder responder(completion, request);
+
+   require(responder.complete(std::string("first")), "first completion should succeed");
+   requireFalse(responder.complete(std::string("second")), "second completion should be refused");
+   requireStringEquals("first", completion->wait().getTextPayload(), "first completion should win");
+}
+
+//******************************************************************************
+
+void TestResponder::testDestroyWithoutComplete() {
+   TEST_CASE("testDestroyWithoutComplete");
+
+   tonnerre_test::LoopbackConnection conn(34734);
+
+   std::shared_ptr<Responder::Connection> connection(
+      new Responder::Connection(conn.serverSideSocket));
+   conn.serverSideSocket = nullptr; // ownership transferred to the connection
+
+   {
+      Message request("forgotten", MessageTypeText);
+      Responder responder(connection, request);
+   }
+
+   Message response;
+   require(response.reconstitute(conn.clientSocket), "client should still get a response");
+   requireStringEquals("forgotten", response.getRequestName(), "response should carry the request name");
+   require(response.getTextPayload().empty(), "response payload should be empty");
+}
+
+//******************************************************************************
+
+void TestResponder::testOneWay() {
+   TEST_CASE("testOneWay");
+
+   tonnerre_test::LoopbackConnection conn(34736);
+
+   std::shared_ptr<Responder::Connection> connection(
+      new Responder::Connection(conn.serverSideSocket));
+   conn.serverSideSocket = nullptr; // ownership transferred to the connection
+
+   Message request("event", MessageTypeText);
+   request.setOneWay(true);
+   {
+      Responder responder(connection, request);
+      require(responder.complete(std::string("ignored")), "completing a one-way responder should succeed");
+   }
+
+   connection.reset();  // closes the server side
+
+   char responseByte;
+   require(::recv(conn.clientSocket->getFileDescriptor(), &responseByte, 1, 0) == 0,
+           "nothing should be written for a one-way message");
+}
+
+//******************************************************************************
+
+void TestResponder::testCompletion() {
+   TEST_CASE("testCompletion");
+
+   std::shared_ptr<Responder::Completion> completion(new Responder::Completion);
+   Message request("deferred", MessageTypeText);
+   std::shared_ptr<Responder> responder(new Responder(completion, request));
+
+   std::thread completer([responder]() {
+      responder->getResponseMessage().setHeader("extra", "yes");
+      responder->complete(std::string("done"));
+   });
+
+   const Message& response = completion->wait();
+   completer.join();
+
+   requireStringEquals("done", response.getTextPayload(), "waiter should see the completed payload");
+   requireStringEquals("yes", response.getHeader("extra"), "waiter should see changes made to the response message");
+}
+
+//******************************************************************************
+
+void TestResponder::testResponseQueue() {
+   TEST_CASE("testResponseQueue");
+
+   int wakes = 0;
+   std::shared_ptr<ResponseQueue> queue =
+      std::make_shared<ResponseQueue>([&wakes] { ++wakes; });
+
+   Message request("queued", MessageTypeText);
+   std::shared_ptr<Responder> first(new Responder(queue->connectionFor(7), request));
+   std::shared_ptr<Responder> second(new Responder(queue->connectionFor(9), request));
+
+   std::thread completer([first, second]() {
+      first->complete(std::string("one"));
+      second->complete(std::string("two"));
+   });
+   completer.join();
+
+   require(wakes == 1, "only the first response of a batch should wake the server");
+
+   std::vector<ResponseQueue::Response> responses;
+   queue->take(responses);
+   require(responses.size() == 2, "every completed response should be queued");
+   require(responses[0].first == 7, "responses should carry their connection's key");
+   require(responses[1].first == 9, "responses should be taken in the order they completed");
+
+   Message response;
+   require(response.reconstituteFromFrame(responses[0].second), "queued response should be a whole frame");
+   requireStringEquals("one", response.getTextPayload(), "queued response should carry the payload");
+
+   queue->close();
+   std::shared_ptr<Responder> late(new Responder(queue->connectionFor(7), request));
+   requireFalse(late->complete(std::string("late")), "a closed queue should refuse responses");
+   require(wakes == 1, "a closed queue should not wake the server");
+}
+
+//******************************************************************************
@@ -0,0 +1,32 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTRESPONDER_H
+#define TONNERRE_TESTRESPONDER_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestResponder : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testCompleteWritesResponse();
+   void testCompleteOnce();
+   void testDestroyWithoutComplete();
+   void testOneWay();
+   void testCompletion();
+   void testResponseQueue();
+
+public:
+   TestResponder();
+
+};
+
+}
+
+#endif
+
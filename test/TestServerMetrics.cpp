@@ -0,0 +1,227 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "TestServerMetrics.h"
+#include "ServerMetrics.h"
+#include "MetricsDumper.h"
+#include "Message.h"
+#include "KeyValuePairs.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+static std::chrono::microseconds micros(long long value) {
+   return std::chrono::microseconds(value);
+}
+
+//******************************************************************************
+
+TestServerMetrics::TestServerMetrics() :
+   poivre::TestSuite("TestServerMetrics") {
+}
+
+//******************************************************************************
+
+void TestServerMetrics::runTests() {
+   testRecord();
+   testRecordFromThreads();
+   testRequestNameLimit();
+   testPrometheus();
+   testRespondToStats();
+   testDumper();
+}
+
+//******************************************************************************
+
+void TestServerMetrics::testRecord() {
+   TEST_CASE("testRecord");
+
+   ServerMetrics metrics;
+   require(metrics.getRequestStats().empty(), "new metrics should be empty");
+
+   metrics.record("echo", false, 100, 200, micros(10), micros(20), micros(30));
+   metrics.record("echo", true, 100, 50, micros(0), micros(5), micros(8));
+   metrics.record("add", false, 30, 40, micros(1), micros(2), micros(3));
+
+   const std::vector<ServerMetrics::RequestStats> stats = metrics.getRequestStats();
+   require(stats.size() == 2, "there should be stats per request name");
+   requireStringEquals("add", stats[0].requestName, "stats should be ordered by name");
+
+   const ServerMetrics::RequestStats& echo = stats[1];
+   requireStringEquals("echo", echo.requestName, "stats should be ordered by name");
+   require(echo.requests == 2, "requests should be counted");
+   require(echo.errors == 1, "errors should be counted");
+   require(echo.bytesIn == 200, "bytes in should be summed");
+   require(echo.bytesOut == 250, "bytes out should be summed");
+   require(echo.handlerLatency.getCount() == 2, "handler latency should be recorded per request");
+   require(echo.totalLatency.getMax() == 30, "total latency should be recorded");
+   require(echo.queueLatency.getValueAtPercentile(50.0) == 0, "queue latency should be recorded");
+}
+
+//******************************************************************************
+
+void TestServerMetrics::testRecordFromThreads() {
+   TEST_CASE("testRecordFromThreads");
+
+   const int numberThreads = 4;
+   const int requestsPerThread = 5000;
+
+   ServerMetrics metrics;
+   std::vector<std::thread> threads;
+   for (int t = 0; t < numberThreads; ++t) {
+      threads.emplace_back([&metrics, requestsPerThread]() {
+         for (int i = 0; i < requestsPerThread; ++i) {
+            metrics.record((i % 2) ? "odd" : "even", false, 10, 20,
+                           micros(1), micros(i % 100), micros(i % 100 + 1));
+         }
+      });
+   }
+
+   // reading while the threads record must be safe (and see partial counts)
+   for (int i = 0; i < 10; ++i) {
+      metrics.getRequestStats();
+   }
+
+   for (auto& thread : threads) {
+      thread.join();
+   }
+
+   const std::vector<ServerMetrics::RequestStats> stats = metrics.getRequestStats();
+   require(stats.size() == 2, "stats should be merged across threads");
+   const std::uint64_t expected = numberThreads * requestsPerThread / 2;
+   require(stats[0].requests == expected, "every request should be counted once");
+   require(stats[1].requests == expected, "every request should be counted once");
+   require(stats[0].handlerLatency.getCount() == expected, "every latency should be recorded once");
+   require(stats[0].bytesOut == expected * 20, "bytes should be summed across threads");
+}
+
+//******************************************************************************
+
+void TestServerMetrics::testRequestNameLimit() {
+   TEST_CASE("testRequestNameLimit");
+
+   ServerMetrics metrics;
+   const std::size_t extraNames = 10;
+   for (std::size_t i = 0; i < ServerMetrics::MAX_REQUEST_NAMES + extraNames; ++i) {
+      metrics.record("name" + std::to_string(i), false, 1, 1,
+                     micros(0), micros(1), micros(1));
+   }
+
+   // a name that already has its own metrics keeps them
+   metrics.record("name0", false, 1, 1, micros(0), micros(1), micros(1));
+
+   // (threads agree on which names are their own)
+   std::thread other([&metrics]() {
+      metrics.record("name1", false, 1, 1, micros(0), micros(1), micros(1));
+      metrics.record("unseen", false, 1, 1, micros(0), micros(1), micros(1));
+   });
+   other.join();
+
+   const std::vector<ServerMetrics::RequestStats> stats = metrics.getRequestStats();
+   require(stats.size() == ServerMetrics::MAX_REQUEST_NAMES + 1, "names beyond the limit should share one entry");
+
+   std::uint64_t otherRequests = 0;
+   std::uint64_t name0Requests = 0;
+   std::uint64_t name1Requests = 0;
+   for (const ServerMetrics::RequestStats& requestStats : stats) {
+      if (requestStats.requestName == ServerMetrics::OTHER_REQUEST_NAME) {
+         otherRequests = requestStats.requests;
+      } else if (requestStats.requestName == "name0") {
+         name0Requests = requestStats.requests;
+      } else if (requestStats.requestName == "name1") {
+         name1Requests = requestStats.requests;
+      }
+   }
+
+   require(otherRequests == extraNames + 1, "requests with names beyond the limit should be counted together");
+   require(name0Requests == 2, "a tracked name should keep being counted on its own");
+   require(name1Requests == 2, "a tracked name should be its own on every thread");
+}
+
+//******************************************************************************
+
+void TestServerMetrics::testPrometheus() {
+   TEST_CASE("testPrometheus");
+
+   ServerMetrics metrics;
+   metrics.record("echo", false, 100, 200, micros(0), micros(1500), micros(2000));
+   metrics.record("say \"hi\"", true, 1, 1, micros(0), micros(1), micros(1));
+
+   const std::string text = metrics.toPrometheus();
+   require(text.find("# TYPE tonnerre_requests_total counter\n") != std::string::npos,
+           "counters should be typed");
+   require(text.find("tonnerre_requests_total{request=\"echo\"} 1\n") != std::string::npos,
+           "request counts should be labelled by request name");
+   require(text.find("tonnerre_request_errors_total{request=\"say \\\"hi\\\"\"} 1\n") != std::string::npos,
+           "label values should be escaped");
+   require(text.find("# TYPE tonnerre_request_seconds summary\n") != std::string::npos,
+           "latencies should be summaries");
+   require(text.find("tonnerre_request_seconds_count{request=\"echo\"} 1\n") != std::string::npos,
+           "summaries should carry a count");
+   require(text.find("tonnerre_request_handler_seconds_sum{request=\"echo\"} 0.001500\n") != std::string::npos,
+           "summaries should carry a sum in seconds");
+   require(text.find("tonnerre_request_seconds{request=\"echo\",quantile=\"0.99\"} 0.002") != std::string::npos,
+           "summaries should carry quantiles in seconds");
+   require(text.find("\ntonnerre_log_records_dropped_total ") != std::string::npos,
+           "dropped log records should be counted");
+}
+
+//******************************************************************************
+
+void TestServerMetrics::testRespondToStats() {
+   TEST_CASE("testRespondToStats");
+
+   ServerMetrics metrics;
+   metrics.record("echo", false, 100, 200, micros(5), micros(20), micros(30));
+
+   Message kvpRequest(ServerMetrics::STATS_REQUEST_NAME, MessageTypeKeyValues);
+   require(ServerMetrics::isStatsRequest(kvpRequest), "the reserved name should be a stats request");
+   requireFalse(ServerMetrics::isStatsRequest(Message("echo", MessageTypeText)),
+                "other names should not be stats requests");
+
+   Message kvpResponse(ServerMetrics::STATS_REQUEST_NAME, MessageTypeKeyValues);
+   metrics.respondToStats(kvpRequest, kvpResponse);
+   const KeyValuePairs& kvp = kvpResponse.getKeyValuesPayload();
+   requireStringEquals("1", kvp.getValue("echo.requests"), "key/value stats should count requests");
+   requireStringEquals("200", kvp.getValue("echo.bytes_out"), "key/value stats should sum bytes");
+   requireStringEquals("30", kvp.getValue("echo.total_us.p99"), "key/value stats should give percentiles");
+   requireStringEquals("5", kvp.getValue("echo.queue_us.max"), "key/value stats should give the max");
+   require(kvp.hasKey("log.records_dropped"), "key/value stats should count dropped log records");
+
+   Message textRequest(ServerMetrics::STATS_REQUEST_NAME, MessageTypeText);
+   Message textResponse(ServerMetrics::STATS_REQUEST_NAME, MessageTypeText);
+   metrics.respondToStats(textRequest, textResponse);
+   require(textResponse.getTextPayload() == metrics.toPrometheus(),
+           "text stats should be the Prometheus text");
+}
+
+//******************************************************************************
+
+void TestServerMetrics::testDumper() {
+   TEST_CASE("testDumper");
+
+   ServerMetrics metrics;
+   metrics.record("echo", false, 1, 1, micros(1), micros(1), micros(1));
+
+   const std::string dumpPath = getTempFile();
+   {
+      // a long interval: only the final dump on stop should happen
+      MetricsDumper dumper(metrics, dumpPath, 60000);
+      dumper.stop();
+   }
+
+   std::ifstream dumpFile(dumpPath.c_str());
+   std::stringstream contents;
+   contents << dumpFile.rdbuf();
+   require(contents.str() == metrics.toPrometheus(), "stopping should write the metrics one last time");
+
+   deleteFile(dumpPath);
+}
+
+//******************************************************************************
@@ -0,0 +1,31 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTSERVERMETRICS_H
+#define TONNERRE_TESTSERVERMETRICS_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestServerMetrics : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testRecord();
+   void testRecordFromThreads();
+   void testRequestNameLimit();
+   void testPrometheus();
+   void testRespondToStats();
+   void testDumper();
+
+public:
+   TestServerMetrics();
+
+};
+
+}
+
+#endif
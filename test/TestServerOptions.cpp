@@ -0,0 +1,148 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <fstream>
+
+#include "TestServerOptions.h"
+#include "ServerOptions.h"
+#include "KeyValuePairs.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+//******************************************************************************
+
+TestServerOptions::TestServerOptions() :
+   poivre::TestSuite("TestServerOptions") {
+}
+
+//******************************************************************************
+
+void TestServerOptions::runTests() {
+   testDefaults();
+   testPopulate();
+   testReadConfigFile();
+}
+
+//******************************************************************************
+
+void TestServerOptions::testDefaults() {
+   TEST_CASE("testDefaults");
+
+   ServerOptions options;
+   requireFalse(options.isIngestionMode(), "ingestion mode should be off by default");
+   requireFalse(options.isKeepAlive(), "keep-alive should be off by default");
+   require(options.getKeepAliveIdleTimeoutMillis() == 30000, "default idle timeout");
+   require(options.getKeepAliveLingerMillis() == 1, "default linger time");
+   require(options.getKeepAliveMaxRequests() == 0, "requests per connection should be unlimited by default");
+   require(options.getWorkerThreads() > 0, "default worker threads should be positive");
+   require(options.getPort() == 9000, "default port");
+   requireFalse(options.isWorkStealing(), "work stealing should be off by default");
+   requireFalse(options.isSharded(), "sharding should be off by default");
+   requireFalse(options.isIoUring(), "io_uring should be off by default");
+   require(options.getShards() > 0, "default shard count should be positive");
+   requireFalse(options.hasAdmissionControl(), "admission control should be off by default");
+   require(options.getCodelIntervalMillis() == 100, "default CoDel interval");
+   requireFalse(options.isPriorityScheduling(), "priority scheduling should be off by default");
+   requireFalse(options.isMetrics(), "metrics should be off by default");
+   require(options.getMetricsDumpIntervalMillis() == 0, "metrics should not be dumped by default");
+   requireFalse(options.isAsyncLogging(), "async logging should be off by default");
+   requireFalse(options.isShm(), "shared memory transport should be off by default");
+   require(options.isInProcess(), "in-process dispatch should be on by default");
+   requireFalse(options.isUdp(), "udp transport should be off by default");
+   require(options.getPriorityWeights().size() == 3, "there should be a default weight per priority class");
+   require(options.getRequestPriority("healthCheck") == MessagePriorityNormal, "requests should default to normal priority");
+}
+
+//******************************************************************************
+
+void TestServerOptions::testPopulate() {
+   TEST_CASE("testPopulate");
+
+   KeyValuePairs kvp;
+   kvp.addPair("port", "9000");
+   kvp.addPair("ingestion", "true");
+   kvp.addPair("keep_alive", "true");
+   kvp.addPair("keep_alive_idle_timeout_ms", "5000");
+   kvp.addPair("keep_alive_linger_ms", "3");
+   kvp.addPair("keep_alive_max_requests", "100");
+   kvp.addPair("worker_threads", "6");
+   kvp.addPair("threading", "workstealing");
+   kvp.addPair("io_backend", "io_uring");
+   kvp.addPair("max_in_flight", "64");
+   kvp.addPair("max_queue_depth", "256");
+   kvp.addPair("codel_target_ms", "5");
+   kvp.addPair("codel_interval_ms", "50");
+   kvp.addPair("scheduling", "weighted");
+   kvp.addPair("priority_weights", "6,3,1");
+   kvp.addPair("priority.healthCheck", "high");
+   kvp.addPair("priority.bulkExport", "low");
+   kvp.addPair("metrics", "true");
+   kvp.addPair("metrics_dump_interval_ms", "10000");
+   kvp.addPair("metrics_dump_path", "/var/lib/node_exporter/tonnerre.prom");
+   kvp.addPair("async_logging", "true");
+   kvp.addPair("shm", "true");
+   kvp.addPair("path", "/run/tonnerre.sock");
+   kvp.addPair("in_process", "false");
+   kvp.addPair("udp", "true");
+   kvp.addPair("shm_channels", "16");
+   kvp.addPair("shm_ring_bytes", "32768");
+
+   ServerOptions options;
+   options.populate(kvp);
+   require(options.isIngestionMode(), "ingestion mode should be read from config");
+   require(options.isKeepAlive(), "keep-alive should be read from config");
+   require(options.getKeepAliveIdleTimeoutMillis() == 5000, "idle timeout should be read from config");
+   require(options.getKeepAliveLingerMillis() == 3, "linger time should be read from config");
+   require(options.getKeepAliveMaxRequests() == 100, "max requests should be read from config");
+   require(options.getWorkerThreads() == 6, "worker threads should be read from config");
+   require(options.getPort() == 9000, "port should be read from config");
+   require(options.isWorkStealing(), "work stealing should be selected by the threading value");
+   require(options.isIoUring(), "io_uring should be selected by the io_backend value");
+   require(options.getMaxInFlight() == 64, "max in-flight should be read from config");
+   require(options.getMaxQueueDepth() == 256, "max queue depth should be read from config");
+   require(options.getCodelTargetMillis() == 5, "CoDel target should be read from config");
+   require(options.getCodelIntervalMillis() == 50, "CoDel interval should be read from config");
+   require(options.hasAdmissionControl(), "admission limits should enable admission control");
+   require(options.isPriorityScheduling(), "scheduling should be read from config");
+   require(options.isWeightedScheduling(), "weighted scheduling should be selected by the scheduling value");
+   require(options.getPriorityWeights()[0] == 6 && options.getPriorityWeights()[2] == 1, "priority weights should be read from config");
+   require(options.getRequestPriority("healthCheck") == MessagePriorityHigh, "request priorities should be read from config");
+   require(options.getRequestPriority("bulkExport") == MessagePriorityLow, "request priorities should be read from config");
+   require(options.getRequestPriority("echo") == MessagePriorityNormal, "unlisted requests should keep normal priority");
+   require(options.isMetrics(), "metrics should be read from config");
+   require(options.getMetricsDumpIntervalMillis() == 10000, "metrics dump interval should be read from config");
+   requireStringEquals("/var/lib/node_exporter/tonnerre.prom", options.getMetricsDumpPath(), "metrics dump path should be read from config");
+   require(options.isAsyncLogging(), "async logging should be read from config");
+   require(options.isShm(), "shared memory transport should be read from config");
+   requireStringEquals("/run/tonnerre.sock", options.getSocketPath(), "unix socket path should be read from config");
+   requireFalse(options.isInProcess(), "in-process dispatch should be read from config");
+   require(options.isUdp(), "udp transport should be read from config");
+   require(options.getShmChannels() == 16, "shared memory channels should be read from config");
+   require(options.getShmRingBytes() == 32768, "shared memory ring size should be read from config");
+}
+
+//******************************************************************************
+
+void TestServerOptions::testReadConfigFile() {
+   TEST_CASE("testReadConfigFile");
+
+   const std::string configPath = getTempFile();
+   std::ofstream configFile(configPath.c_str());
+   configFile << "[server]\n";
+   configFile << "port = 34730\n";
+   configFile << "ingestion = true\n";
+   configFile << "threading = sharded\n";
+   configFile << "shards = 3\n";
+   configFile.close();
+
+   ServerOptions options;
+   options.readConfigFile(configPath);
+   require(options.isIngestionMode(), "ingestion mode should be read from the [server] section");
+   require(options.isSharded(), "sharded threading should be read from the [server] section");
+   require(options.getShards() == 3, "shard count should be read from the [server] section");
+
+   deleteFile(configPath);
+}
+
+//******************************************************************************
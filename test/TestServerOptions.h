@@ -0,0 +1,29 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTSERVEROPTIONS_H
+#define TONNERRE_TESTSERVEROPTIONS_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestServerOptions : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testDefaults();
+   void testPopulate();
+   void testReadConfigFile();
+
+public:
+   TestServerOptions();
+
+};
+
+}
+
+#endif
+
@@ -0,0 +1,164 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "TestServerShard.h"
+#include "ServerShard.h"
+#include "MessageSocketServiceHandler.h"
+#include "MessageHandler.h"
+#include "Message.h"
+#include "ServerOptions.h"
+#include "ServerSocket.h"
+#include "Socket.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+namespace {
+
+// Echoes the request payload back as the response payload.
+class EchoMessageHandler : public tonnerre::MessageHandler {
+public:
+   void handleTextMessage(const Message&,
+                          Message&,
+                          const std::string&,
+                          const std::string& requestPayload,
+                          std::string& responsePayload) override {
+      responsePayload = requestPayload;
+   }
+
+   void handleKeyValuesMessage(const Message&,
+                               Message&,
+                               const std::string&,
+                               const chaudiere::KeyValuePairs& requestPayload,
+                               chaudiere::KeyValuePairs& responsePayload) override {
+      responsePayload = requestPayload;
+   }
+};
+
+}
+
+//******************************************************************************
+
+TestServerShard::TestServerShard() :
+   poivre::TestSuite("TestServerShard") {
+}
+
+//******************************************************************************
+
+void TestServerShard::runTests() {
+   testStart();
+   testServeRequests();
+   testPortInUse();
+   testIngestionStreamYields();
+}
+
+//******************************************************************************
+
+void TestServerShard::testStart() {
+   TEST_CASE("testStart");
+
+   const int port = 34739;
+   EchoMessageHandler echoHandler;
+
+   // shards share their port
+   ServerShard first(port, new MessageSocketServiceHandler(&echoHandler), -1);
+   ServerShard second(port, new MessageSocketServiceHandler(&echoHandler), 0);
+   require(first.start(), "first shard should start");
+   require(second.start(), "second shard should bind the same port");
+   requireFalse(first.start(), "a running shard can't be started again");
+
+   first.stop();
+   first.waitUntilStopped();
+   second.stop();
+   require(first.getConnectionCount() == 0, "stopped shard should have no connections");
+}
+
+//******************************************************************************
+
+void TestServerShard::testServeRequests() {
+   TEST_CASE("testServeRequests");
+
+   const int port = 34740;
+   EchoMessageHandler echoHandler;
+   ServerShard shard(port, new MessageSocketServiceHandler(&echoHandler), -1);
+   require(shard.start(), "shard should start");
+
+   Socket client("127.0.0.1", port);
+
+   // the connection stays with the shard between requests
+   for (int i = 0; i < 3; ++i) {
+      Message request("shardTest", MessageTypeText);
+      request.setTextPayload("request " + std::to_string(i));
+      require(client.write(request.toString()), "writing request should succeed");
+
+      Message response;
+      require(response.reconstitute(&client), "client should receive a response per request");
+      requireStringEquals("request " + std::to_string(i), response.getTextPayload(), "response should echo the request");
+   }
+
+   require(shard.getAcceptCount() == 1, "one connection should have been accepted");
+   require(shard.getConnectionCount() == 1, "the connection should still be open");
+
+   client.close();
+   shard.stop();
+}
+
+//******************************************************************************
+
+void TestServerShard::testPortInUse() {
+   TEST_CASE("testPortInUse");
+
+   const int port = 34741;
+   ServerSocket listener(port);
+
+   EchoMessageHandler echoHandler;
+   ServerShard shard(port, new MessageSocketServiceHandler(&echoHandler), -1);
+   requireFalse(shard.start(), "shard shouldn't start on a port held without SO_REUSEPORT");
+
+   // never started, so there's nothing to wait for
+   shard.waitUntilStopped();
+}
+
+//******************************************************************************
+
+void TestServerShard::testIngestionStreamYields() {
+   TEST_CASE("testIngestionStreamYields");
+
+   const int port = 34765;
+   EchoMessageHandler echoHandler;
+   ServerOptions serverOptions;
+   serverOptions.setIngestionMode(true);
+   ServerShard shard(port, new MessageSocketServiceHandler(&echoHandler, &serverOptions), -1);
+   require(shard.start(), "shard should start");
+
+   // an ingestion stream that goes quiet without closing
+   Socket streamClient("127.0.0.1", port);
+   Message event("shardEvent", MessageTypeText);
+   event.setOneWay(true);
+   event.setTextPayload("event");
+   require(streamClient.write(event.toString()), "writing one-way message should succeed");
+
+   Socket client("127.0.0.1", port);
+   struct timeval timeout;
+   timeout.tv_sec = 5;
+   timeout.tv_usec = 0;
+   ::setsockopt(client.getFileDescriptor(), SOL_SOCKET, SO_RCVTIMEO,
+                &timeout, sizeof(timeout));
+
+   Message request("shardTest", MessageTypeText);
+   request.setTextPayload("behind a stream");
+   require(client.write(request.toString()), "writing request should succeed");
+
+   Message response;
+   require(response.reconstitute(&client), "an idle stream shouldn't keep the shard's thread");
+   requireStringEquals("behind a stream", response.getTextPayload(), "response should echo the request");
+
+   client.close();
+   streamClient.close();
+   shard.stop();
+}
+
+//******************************************************************************
@@ -0,0 +1,30 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTSERVERSHARD_H
+#define TONNERRE_TESTSERVERSHARD_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestServerShard : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testStart();
+   void testServeRequests();
+   void testPortInUse();
+   void testIngestionStreamYields();
+
+public:
+   TestServerShard();
+
+};
+
+}
+
+#endif
+
@@ -0,0 +1,144 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "TestServiceDispatcher.h"
+#include "ServiceDispatcher.h"
+#include "MessageRequestHandler.h"
+#include "Message.h"
+#include "KeyValuePairs.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+namespace {
+
+// Answers every request with a fixed reply, so tests can tell which
+// handler a request was given to.
+class FixedReplyMessageHandler : public tonnerre::MessageHandler {
+public:
+   explicit FixedReplyMessageHandler(const std::string& reply) :
+      m_reply(reply) {
+   }
+
+   void handleTextMessage(const Message&,
+                          Message&,
+                          const std::string&,
+                          const std::string&,
+                          std::string& responsePayload) override {
+      responsePayload = m_reply;
+   }
+
+   void handleKeyValuesMessage(const Message&,
+                               Message&,
+                               const std::string&,
+                               const chaudiere::KeyValuePairs&,
+                               chaudiere::KeyValuePairs& responsePayload) override {
+      responsePayload.addPair("reply", m_reply);
+   }
+
+private:
+   std::string m_reply;
+};
+
+}
+
+//******************************************************************************
+
+TestServiceDispatcher::TestServiceDispatcher() :
+   poivre::TestSuite("TestServiceDispatcher") {
+}
+
+//******************************************************************************
+
+void TestServiceDispatcher::runTests() {
+   testRegisterService();
+   testDefaultHandler();
+   testHandlerForService();
+   testDispatch();
+}
+
+//******************************************************************************
+
+void TestServiceDispatcher::testRegisterService() {
+   TEST_CASE("testRegisterService");
+
+   FixedReplyMessageHandler first("first");
+   FixedReplyMessageHandler second("second");
+
+   ServiceDispatcher dispatcher;
+   require(dispatcher.getNumberServices() == 0, "no services should be registered initially");
+
+   dispatcher.registerService("first", &first);
+   dispatcher.registerService("second", &second);
+   require(dispatcher.getNumberServices() == 2, "both services should be registered");
+   require(dispatcher.hasService("first"), "first service should be registered");
+   requireFalse(dispatcher.hasService("third"), "unregistered service should not be reported");
+
+   dispatcher.registerService("second", nullptr);
+   requireFalse(dispatcher.hasService("second"), "registering a null handler should remove the service");
+}
+
+//******************************************************************************
+
+void TestServiceDispatcher::testDefaultHandler() {
+   TEST_CASE("testDefaultHandler");
+
+   FixedReplyMessageHandler first("first");
+   FixedReplyMessageHandler second("second");
+
+   ServiceDispatcher dispatcher;
+   require(dispatcher.getDefaultHandler() == nullptr, "no default handler initially");
+
+   dispatcher.registerService("first", &first);
+   dispatcher.registerService("second", &second);
+   require(dispatcher.getDefaultHandler() == &first, "first registered handler should become the default");
+
+   dispatcher.setDefaultHandler(&second);
+   require(dispatcher.getDefaultHandler() == &second, "default handler should be settable");
+}
+
+//******************************************************************************
+
+void TestServiceDispatcher::testHandlerForService() {
+   TEST_CASE("testHandlerForService");
+
+   FixedReplyMessageHandler first("first");
+   FixedReplyMessageHandler second("second");
+
+   ServiceDispatcher dispatcher;
+   require(dispatcher.handlerForService("first") == nullptr, "no handler without registrations");
+
+   dispatcher.registerService("first", &first);
+   dispatcher.registerService("second", &second);
+   require(dispatcher.handlerForService("second") == &second, "registered service should get its handler");
+   require(dispatcher.handlerForService("unknown") == &first, "unknown service should get the default handler");
+   require(dispatcher.handlerForService("") == &first, "unnamed service should get the default handler");
+}
+
+//******************************************************************************
+
+void TestServiceDispatcher::testDispatch() {
+   TEST_CASE("testDispatch");
+
+   FixedReplyMessageHandler first("first");
+
+   ServiceDispatcher dispatcher;
+
+   // with nothing registered the request is dropped (and logged), not crashed on
+   Message request("whichService", MessageTypeText);
+   Message response("whichService", MessageTypeText);
+   MessageRequestHandler::dispatch(&dispatcher, request, response);
+   require(response.getTextPayload().empty(), "no response payload without a handler");
+
+   dispatcher.registerService("first", &first);
+
+   Message kvpRequest("whichService", MessageTypeKeyValues);
+   Message kvpResponse("whichService", MessageTypeKeyValues);
+   MessageRequestHandler::dispatch(&dispatcher, kvpRequest, kvpResponse);
+   requireStringEquals("first", kvpResponse.getKeyValuesPayload().getValue("reply"), "key-value request should be forwarded");
+
+   MessageRequestHandler::dispatch(&dispatcher, request, response);
+   requireStringEquals("first", response.getTextPayload(), "text request should be forwarded");
+}
+
+//******************************************************************************
@@ -0,0 +1,30 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTSERVICEDISPATCHER_H
+#define TONNERRE_TESTSERVICEDISPATCHER_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestServiceDispatcher : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testRegisterService();
+   void testDefaultHandler();
+   void testHandlerForService();
+   void testDispatch();
+
+public:
+   TestServiceDispatcher();
+
+};
+
+}
+
+#endif
+
@@ -0,0 +1,146 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include "TestServiceOptions.h"
+#include "ServiceOptions.h"
+#include "KeyValuePairs.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+//******************************************************************************
+
+TestServiceOptions::TestServiceOptions() :
+   poivre::TestSuite("TestServiceOptions") {
+}
+
+//******************************************************************************
+
+void TestServiceOptions::runTests() {
+   testDefaults();
+   testPopulateAsync();
+   testPopulateBackpressure();
+   testPopulateInvalidValues();
+   testPopulateTraceSampleRate();
+   testPopulateTransport();
+}
+
+//******************************************************************************
+
+void TestServiceOptions::testDefaults() {
+   TEST_CASE("testDefaults");
+
+   ServiceOptions options;
+   requireFalse(options.isAsyncOneWay(), "async one-way should be off by default");
+   require(options.getAsyncQueueSize() == ServiceOptions::DEFAULT_ASYNC_QUEUE_SIZE, "default queue size");
+   require(options.getAsyncBatchBytes() == ServiceOptions::DEFAULT_ASYNC_BATCH_BYTES, "default batch bytes");
+   require(options.getAsyncLingerMillis() == ServiceOptions::DEFAULT_ASYNC_LINGER_MILLIS, "default linger");
+   require(options.getAsyncBackpressure() == BackpressureBlock, "default backpressure should be block");
+   require(options.getTraceSampleRate() == 0.0, "tracing should be off by default");
+   require(options.getTransport() == TransportTcp, "default transport should be TCP");
+}
+
+//******************************************************************************
+
+void TestServiceOptions::testPopulateAsync() {
+   TEST_CASE("testPopulateAsync");
+
+   KeyValuePairs kvp;
+   kvp.addPair("host", "127.0.0.1");
+   kvp.addPair("port", "9000");
+   kvp.addPair("async", "true");
+   kvp.addPair("async_queue_size", "128");
+   kvp.addPair("async_batch_bytes", "1024");
+   kvp.addPair("async_linger_ms", "20");
+
+   ServiceOptions options;
+   options.populate(kvp);
+
+   require(options.isAsyncOneWay(), "async should be enabled");
+   require(options.getAsyncQueueSize() == 128, "queue size should be read from config");
+   require(options.getAsyncBatchBytes() == 1024, "batch bytes should be read from config");
+   require(options.getAsyncLingerMillis() == 20, "linger should be read from config");
+}
+
+//******************************************************************************
+
+void TestServiceOptions::testPopulateBackpressure() {
+   TEST_CASE("testPopulateBackpressure");
+
+   KeyValuePairs dropOldest;
+   dropOldest.addPair("async_backpressure", "drop_oldest");
+   ServiceOptions dropOptions;
+   dropOptions.populate(dropOldest);
+   require(dropOptions.getAsyncBackpressure() == BackpressureDropOldest, "drop_oldest");
+
+   KeyValuePairs fail;
+   fail.addPair("async_backpressure", "fail");
+   ServiceOptions failOptions;
+   failOptions.populate(fail);
+   require(failOptions.getAsyncBackpressure() == BackpressureFail, "fail");
+}
+
+//******************************************************************************
+
+void TestServiceOptions::testPopulateInvalidValues() {
+   TEST_CASE("testPopulateInvalidValues");
+
+   KeyValuePairs kvp;
+   kvp.addPair("async_queue_size", "-5");
+   kvp.addPair("async_backpressure", "whatever");
+
+   ServiceOptions options;
+   options.populate(kvp);
+   require(options.getAsyncQueueSize() == ServiceOptions::DEFAULT_ASYNC_QUEUE_SIZE, "invalid queue size should keep the default");
+   require(options.getAsyncBackpressure() == BackpressureBlock, "unrecognized policy should keep the default");
+}
+
+//******************************************************************************
+
+void TestServiceOptions::testPopulateTraceSampleRate() {
+   TEST_CASE("testPopulateTraceSampleRate");
+
+   KeyValuePairs kvp;
+   kvp.addPair("trace_sample_rate", "0.25");
+   ServiceOptions options;
+   options.populate(kvp);
+   require(options.getTraceSampleRate() == 0.25, "sample rate should be read from config");
+
+   KeyValuePairs tooHigh;
+   tooHigh.addPair("trace_sample_rate", "4");
+   ServiceOptions highOptions;
+   highOptions.populate(tooHigh);
+   require(highOptions.getTraceSampleRate() == 1.0, "sample rate should be capped at 1");
+
+   KeyValuePairs negative;
+   negative.addPair("trace_sample_rate", "-1");
+   ServiceOptions negativeOptions;
+   negativeOptions.populate(negative);
+   require(negativeOptions.getTraceSampleRate() == 0.0, "negative sample rate should turn tracing off");
+}
+
+//******************************************************************************
+
+void TestServiceOptions::testPopulateTransport() {
+   TEST_CASE("testPopulateTransport");
+
+   KeyValuePairs kvp;
+   kvp.addPair("transport", "shm");
+   ServiceOptions options;
+   options.populate(kvp);
+   require(options.getTransport() == TransportShm, "transport should be read from config");
+
+   KeyValuePairs udp;
+   udp.addPair("transport", "udp");
+   ServiceOptions udpOptions;
+   udpOptions.populate(udp);
+   require(udpOptions.getTransport() == TransportUdp, "udp transport should be read from config");
+
+   KeyValuePairs unknown;
+   unknown.addPair("transport", "carrier_pigeon");
+   ServiceOptions unknownOptions;
+   unknownOptions.populate(unknown);
+   require(unknownOptions.getTransport() == TransportTcp, "unknown transport should leave TCP");
+}
+
+//******************************************************************************
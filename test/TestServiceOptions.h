@@ -0,0 +1,32 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTSERVICEOPTIONS_H
+#define TONNERRE_TESTSERVICEOPTIONS_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestServiceOptions : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testDefaults();
+   void testPopulateAsync();
+   void testPopulateBackpressure();
+   void testPopulateInvalidValues();
+   void testPopulateTraceSampleRate();
+   void testPopulateTransport();
+
+public:
+   TestServiceOptions();
+
+};
+
+}
+
+#endif
+
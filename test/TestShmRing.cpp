@@ -0,0 +1,181 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include "TestShmRing.h"
+#include "ShmRing.h"
+#include "ShmSegment.h"
+
+using namespace tonnerre;
+
+//******************************************************************************
+
+TestShmRing::TestShmRing() :
+   poivre::TestSuite("TestShmRing") {
+}
+
+//******************************************************************************
+
+void TestShmRing::runTests() {
+   testPushPop();
+   testWrapAround();
+   testFull();
+   testClear();
+   testCorruptLength();
+   testSegment();
+}
+
+//******************************************************************************
+
+void TestShmRing::testPushPop() {
+   TEST_CASE("testPushPop");
+
+   std::atomic<std::uint64_t> head(0);
+   std::atomic<std::uint64_t> tail(0);
+   char buffer[256];
+   ShmRing ring(&head, &tail, buffer, sizeof(buffer));
+
+   require(ring.isEmpty(), "new ring should be empty");
+   require(ring.push("first"), "push should succeed");
+   require(ring.push(""), "an empty frame should be pushed");
+   require(ring.push("third"), "push should succeed");
+   requireFalse(ring.isEmpty(), "ring should hold the frames");
+
+   std::string frame;
+   require(ring.pop(frame), "pop should succeed");
+   requireStringEquals("first", frame, "frames should pop in order");
+   require(ring.pop(frame), "pop should succeed");
+   require(frame.empty(), "empty frame should pop as empty");
+   require(ring.pop(frame), "pop should succeed");
+   requireStringEquals("third", frame, "frames should pop in order");
+   requireFalse(ring.pop(frame), "pop on an empty ring should fail");
+   require(ring.isEmpty(), "drained ring should be empty");
+}
+
+//******************************************************************************
+
+void TestShmRing::testWrapAround() {
+   TEST_CASE("testWrapAround");
+
+   std::atomic<std::uint64_t> head(0);
+   std::atomic<std::uint64_t> tail(0);
+   char buffer[64];
+   ShmRing ring(&head, &tail, buffer, sizeof(buffer));
+
+   // 13-byte frames (17 with the length) never line up with the end
+   for (int i = 0; i < 50; ++i) {
+      const std::string sent = "frame-" + std::to_string(1000000 + i);
+      require(ring.push(sent), "push should succeed once the last frame was popped");
+      std::string received;
+      require(ring.pop(received), "pop should succeed");
+      requireStringEquals(sent, received, "wrapped frames should come back intact");
+   }
+}
+
+//******************************************************************************
+
+void TestShmRing::testFull() {
+   TEST_CASE("testFull");
+
+   std::atomic<std::uint64_t> head(0);
+   std::atomic<std::uint64_t> tail(0);
+   char buffer[64];
+   ShmRing ring(&head, &tail, buffer, sizeof(buffer));
+
+   require(ShmRing::maxFrameLength(sizeof(buffer)) == 60, "max frame should leave room for the length");
+   requireFalse(ring.push(std::string(61, 'x')), "frame larger than the ring should be refused");
+
+   require(ring.push(std::string(28, 'a')), "push should succeed");
+   require(ring.push(std::string(28, 'b')), "push filling the ring should succeed");
+   requireFalse(ring.push("c"), "push into a full ring should fail");
+
+   std::string frame;
+   require(ring.pop(frame), "pop should succeed");
+   require(ring.push(std::string(28, 'c')), "popping should make room");
+   require(ring.pop(frame) && (frame == std::string(28, 'b')), "frames should pop in order");
+   require(ring.pop(frame) && (frame == std::string(28, 'c')), "frames should pop in order");
+}
+
+//******************************************************************************
+
+void TestShmRing::testClear() {
+   TEST_CASE("testClear");
+
+   std::atomic<std::uint64_t> head(0);
+   std::atomic<std::uint64_t> tail(0);
+   char buffer[64];
+   ShmRing ring(&head, &tail, buffer, sizeof(buffer));
+
+   ring.push("left");
+   ring.push("behind");
+   ring.clear();
+   require(ring.isEmpty(), "cleared ring should be empty");
+   require(ring.push("next"), "cleared ring should accept frames");
+   std::string frame;
+   require(ring.pop(frame), "pop should succeed");
+   requireStringEquals("next", frame, "only frames pushed after the clear should pop");
+}
+
+//******************************************************************************
+
+void TestShmRing::testCorruptLength() {
+   TEST_CASE("testCorruptLength");
+
+   std::atomic<std::uint64_t> head(0);
+   std::atomic<std::uint64_t> tail(0);
+   char buffer[64];
+   ShmRing ring(&head, &tail, buffer, sizeof(buffer));
+   std::string frame;
+
+   // longer than the ring could ever hold
+   require(ring.push("abc"), "push should succeed");
+   const std::uint32_t tooLong = 1000000;
+   std::memcpy(buffer, &tooLong, sizeof(tooLong));
+   requireFalse(ring.pop(frame), "frame longer than the ring should be refused");
+   require(ring.isEmpty(), "corrupt ring should be emptied");
+
+   // fits the ring, but more than was pushed
+   require(ring.push("abc"), "push after a corrupt frame should succeed");
+   const std::uint32_t pastTail = 20;
+   std::memcpy(buffer + (head.load() % sizeof(buffer)), &pastTail, sizeof(pastTail));
+   requireFalse(ring.pop(frame), "frame past the producer's position should be refused");
+   require(ring.isEmpty(), "corrupt ring should be emptied");
+
+   require(ring.push("good"), "push should succeed");
+   require(ring.pop(frame), "pop should succeed");
+   requireStringEquals("good", frame, "ring should work after a corrupt frame");
+}
+
+//******************************************************************************
+
+void TestShmRing::testSegment() {
+   TEST_CASE("testSegment");
+
+   const std::string name = ShmSegment::nameForPort(34750);
+   requireStringEquals("/tonnerre-34750", name, "segment should be named for the port");
+
+   ShmSegment server;
+   require(server.create(name, 4, 5000), "segment should be created");
+   require(server.getNumberChannels() == 4, "segment should have the channels asked for");
+   require(server.getMaxFrameLength() == 8188, "ring size should round up to a power of 2");
+
+   ShmSegment client;
+   require(client.attach(name), "client should attach to the segment");
+   require(client.getNumberChannels() == 4, "client should see the server's layout");
+
+   ShmRing clientRequests = client.requestRing(2);
+   require(clientRequests.push("over the segment"), "client should push a request");
+   std::string frame;
+   requireFalse(server.requestRing(1).pop(frame), "other channels should be untouched");
+   require(server.requestRing(2).pop(frame), "server should pop the client's request");
+   requireStringEquals("over the segment", frame, "request should cross the mapping intact");
+
+   server.unlink();
+   ShmSegment late;
+   requireFalse(late.attach(name), "an unlinked segment can't be attached");
+}
+
+//******************************************************************************
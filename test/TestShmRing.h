@@ -0,0 +1,31 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTSHMRING_H
+#define TONNERRE_TESTSHMRING_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestShmRing : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testPushPop();
+   void testWrapAround();
+   void testFull();
+   void testClear();
+   void testCorruptLength();
+   void testSegment();
+
+public:
+   TestShmRing();
+
+};
+
+}
+
+#endif
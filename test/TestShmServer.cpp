@@ -0,0 +1,433 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "TestShmServer.h"
+#include "ShmServer.h"
+#include "ShmClient.h"
+#include "AsyncMessageHandler.h"
+#include "MessageHandler.h"
+#include "Message.h"
+#include "Messaging.h"
+#include "ServerOptions.h"
+#include "ServiceInfo.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+namespace {
+
+// Echoes the request payload back as the response payload, counting the
+// requests it sees.
+class CountingEchoHandler : public tonnerre::MessageHandler {
+public:
+   CountingEchoHandler() : m_count(0) {}
+
+   void handleTextMessage(const Message&,
+                          Message&,
+                          const std::string&,
+                          const std::string& requestPayload,
+                          std::string& responsePayload) override {
+      m_count.fetch_add(1);
+      responsePayload = requestPayload;
+   }
+
+   void handleKeyValuesMessage(const Message&,
+                               Message&,
+                               const std::string&,
+                               const chaudiere::KeyValuePairs& requestPayload,
+                               chaudiere::KeyValuePairs& responsePayload) override {
+      m_count.fetch_add(1);
+      responsePayload = requestPayload;
+   }
+
+   int getCount() const {
+      return m_count.load();
+   }
+
+private:
+   std::atomic<int> m_count;
+};
+
+// Responds with the request payload repeated many times over.
+class InflatingHandler : public tonnerre::MessageHandler {
+public:
+   static const int REPEAT = 1000;
+
+   void handleTextMessage(const Message&,
+                          Message&,
+                          const std::string&,
+                          const std::string& requestPayload,
+                          std::string& responsePayload) override {
+      for (int i = 0; i < REPEAT; ++i) {
+         responsePayload += requestPayload;
+      }
+   }
+
+   void handleKeyValuesMessage(const Message&,
+                               Message&,
+                               const std::string&,
+                               const chaudiere::KeyValuePairs& requestPayload,
+                               chaudiere::KeyValuePairs& responsePayload) override {
+      responsePayload = requestPayload;
+   }
+};
+
+// Holds the responder for 'hold' requests until released; completes the
+// rest at once.
+class HoldingAsyncHandler : public tonnerre::AsyncMessageHandler {
+public:
+   void handleTextMessageAsync(const Message&,
+                               const std::string& requestName,
+                               const std::string& requestPayload,
+                               std::shared_ptr<Responder> responder) override {
+      if (requestName == "hold") {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_held = responder;
+      } else {
+         responder->complete(requestPayload);
+      }
+   }
+
+   void handleKeyValuesMessageAsync(const Message&,
+                                    const std::string&,
+                                    const chaudiere::KeyValuePairs& requestPayload,
+                                    std::shared_ptr<Responder> responder) override {
+      responder->complete(requestPayload);
+   }
+
+   bool awaitHeld() {
+      for (int i = 0; i < 500; ++i) {
+         {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_held != nullptr) {
+               return true;
+            }
+         }
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      return false;
+   }
+
+   bool release(const std::string& payload) {
+      std::shared_ptr<Responder> held;
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         held.swap(m_held);
+      }
+      return (held != nullptr) && held->complete(payload);
+   }
+
+private:
+   std::mutex m_mutex;
+   std::shared_ptr<Responder> m_held;
+};
+
+}
+
+//******************************************************************************
+
+TestShmServer::TestShmServer() :
+   poivre::TestSuite("TestShmServer") {
+}
+
+//******************************************************************************
+
+void TestShmServer::runTests() {
+   testStartStop();
+   testCall();
+   testOneWay();
+   testConcurrentCallers();
+   testFrameTooLarge();
+   testLargeResponse();
+   testMessageSend();
+   testAsyncHandler();
+}
+
+//******************************************************************************
+
+void TestShmServer::testStartStop() {
+   TEST_CASE("testStartStop");
+
+   CountingEchoHandler handler;
+   ServerOptions options;
+   ShmServer server(34751, &handler, &options);
+
+   ShmClient early(server.getSegmentName());
+   requireFalse(early.isServing(), "client should find nothing to attach before start");
+
+   require(server.start(), "server should start");
+   ShmClient client(server.getSegmentName());
+   require(client.isServing(), "client should attach to a started server");
+
+   server.stop();
+   requireFalse(client.isServing(), "client should see the server stop");
+
+   Message request("afterStop", MessageTypeText);
+   std::string responseFrame;
+   bool isSent = true;
+   requireFalse(client.call(request.toString(), responseFrame, isSent), "call to a stopped server should fail");
+   requireFalse(isSent, "request to a stopped server should not be sent");
+}
+
+//******************************************************************************
+
+void TestShmServer::testCall() {
+   TEST_CASE("testCall");
+
+   CountingEchoHandler handler;
+   ServerOptions options;
+   ShmServer server(34752, &handler, &options);
+   require(server.start(), "server should start");
+
+   ShmClient client(server.getSegmentName());
+
+   // larger than a page, and wraps the ring on the later calls
+   const std::string largePayload(20000, 'x');
+
+   for (int i = 0; i < 10; ++i) {
+      Message request("shmTest", MessageTypeText);
+      const std::string payload = (i % 3 == 1) ? largePayload : "request " + std::to_string(i);
+      request.setTextPayload(payload);
+
+      std::string responseFrame;
+      bool isSent = false;
+      require(client.call(request.toString(), responseFrame, isSent), "call should receive a response");
+      require(isSent, "request should be sent");
+
+      Message response;
+      require(response.reconstituteFromFrame(responseFrame), "response frame should decode");
+      requireStringEquals(payload, response.getTextPayload(), "response should echo the request");
+   }
+
+   require(server.getRequestCount() == 10, "server should count every request");
+   server.stop();
+}
+
+//******************************************************************************
+
+void TestShmServer::testOneWay() {
+   TEST_CASE("testOneWay");
+
+   CountingEchoHandler handler;
+   ServerOptions options;
+   ShmServer server(34753, &handler, &options);
+   require(server.start(), "server should start");
+
+   ShmClient client(server.getSegmentName());
+   for (int i = 0; i < 100; ++i) {
+      Message request("event", MessageTypeText);
+      request.setTextPayload(std::to_string(i));
+      request.setOneWay(true);
+      require(client.sendOneWay(request.toString()), "one-way send should succeed");
+   }
+
+   // requests on a channel are handled in order, so once this is answered
+   // every one-way message before it has been handled (and none answered)
+   Message request("sync", MessageTypeText);
+   std::string responseFrame;
+   bool isSent = false;
+   require(client.call(request.toString(), responseFrame, isSent), "call after one-way sends should be answered");
+
+   Message response;
+   require(response.reconstituteFromFrame(responseFrame), "response frame should decode");
+   requireStringEquals("sync", response.getRequestName(), "response should be the call's, not a one-way message's");
+   require(handler.getCount() == 101, "every one-way message should be handled");
+
+   server.stop();
+}
+
+//******************************************************************************
+
+void TestShmServer::testConcurrentCallers() {
+   TEST_CASE("testConcurrentCallers");
+
+   CountingEchoHandler handler;
+   ServerOptions options;
+   options.setShmChannels(4);
+   ShmServer server(34754, &handler, &options);
+   require(server.start(), "server should start");
+
+   ShmClient client(server.getSegmentName());
+   const int numberThreads = 4;
+   const int callsPerThread = 200;
+   std::atomic<int> mismatches(0);
+   std::vector<std::thread> threads;
+
+   for (int t = 0; t < numberThreads; ++t) {
+      threads.emplace_back([&client, &mismatches, t, callsPerThread]() {
+         for (int i = 0; i < callsPerThread; ++i) {
+            Message request("concurrent", MessageTypeText);
+            const std::string payload = std::to_string(t) + ":" + std::to_string(i);
+            request.setTextPayload(payload);
+
+            std::string responseFrame;
+            bool isSent = false;
+            Message response;
+            if (!client.call(request.toString(), responseFrame, isSent) ||
+                !response.reconstituteFromFrame(responseFrame) ||
+                (response.getTextPayload() != payload)) {
+               mismatches.fetch_add(1);
+            }
+         }
+      });
+   }
+
+   for (auto& thread : threads) {
+      thread.join();
+   }
+
+   require(mismatches.load() == 0, "every caller should get its own response");
+   require(handler.getCount() == numberThreads * callsPerThread, "every call should be handled");
+   server.stop();
+}
+
+//******************************************************************************
+
+void TestShmServer::testFrameTooLarge() {
+   TEST_CASE("testFrameTooLarge");
+
+   CountingEchoHandler handler;
+   ServerOptions options;
+   options.setShmRingBytes(4096);
+   ShmServer server(34755, &handler, &options);
+   require(server.start(), "server should start");
+
+   ShmClient client(server.getSegmentName());
+   require(client.getMaxFrameLength() == 4092, "max frame should follow the ring size");
+
+   Message request("tooLarge", MessageTypeText);
+   request.setTextPayload(std::string(5000, 'x'));
+   std::string responseFrame;
+   bool isSent = true;
+   requireFalse(client.call(request.toString(), responseFrame, isSent), "oversized request should not be sent");
+   requireFalse(isSent, "oversized request should be left for another transport");
+   require(client.isServing(), "an oversized request should not break the client");
+
+   server.stop();
+}
+
+//******************************************************************************
+
+void TestShmServer::testLargeResponse() {
+   TEST_CASE("testLargeResponse");
+
+   InflatingHandler handler;
+   ServerOptions options;
+   options.setShmRingBytes(4096);
+   ShmServer server(34771, &handler, &options);
+   require(server.start(), "server should start");
+
+   ShmClient client(server.getSegmentName());
+
+   // each response is several times the ring; the small one in between
+   // checks that the channel is back to whole frames afterwards
+   const std::string payloads[] = { "abcdefghij", "z", "0123456789abcdefghij" };
+   for (const std::string& payload : payloads) {
+      Message request("inflate", MessageTypeText);
+      request.setTextPayload(payload);
+
+      std::string responseFrame;
+      bool isSent = false;
+      require(client.call(request.toString(), responseFrame, isSent), "large response should be received");
+      require(isSent, "request should be sent");
+
+      Message response;
+      require(response.reconstituteFromFrame(responseFrame), "reassembled response should decode");
+      require(response.getTextPayload().length() == payload.length() * InflatingHandler::REPEAT,
+              "response should arrive whole");
+   }
+
+   require(client.isServing(), "large responses should not break the channel");
+   server.stop();
+}
+
+//******************************************************************************
+
+void TestShmServer::testMessageSend() {
+   TEST_CASE("testMessageSend");
+
+   // nothing listens on the port, so only the segment can answer
+   const int port = 34756;
+   CountingEchoHandler handler;
+   ServerOptions serverOptions;
+   ShmServer server(port, &handler, &serverOptions);
+   require(server.start(), "server should start");
+
+   Messaging* messaging = new Messaging();
+   messaging->registerService("shmService", ServiceInfo("shmService", "127.0.0.1", (unsigned short) port));
+   ServiceOptions serviceOptions;
+   serviceOptions.setTransport(TransportShm);
+   messaging->setOptionsForService("shmService", serviceOptions);
+   Messaging::setMessaging(messaging);
+
+   Message request("viaMessaging", MessageTypeText);
+   request.setTextPayload("same host");
+   Message response;
+   require(request.send("shmService", response), "send should be answered over shared memory");
+   requireStringEquals("same host", response.getTextPayload(), "response should echo the request");
+
+   Message event("oneWay", MessageTypeText);
+   event.setTextPayload("fire and forget");
+   require(event.send("shmService"), "one-way send should go over shared memory");
+
+   Message sync("sync", MessageTypeText);
+   require(sync.send("shmService", response), "send should be answered over shared memory");
+   require(handler.getCount() == 3, "every message should reach the handler");
+
+   Messaging::setMessaging(nullptr);
+   server.stop();
+}
+
+//******************************************************************************
+
+void TestShmServer::testAsyncHandler() {
+   TEST_CASE("testAsyncHandler");
+
+   HoldingAsyncHandler handler;
+   ServerOptions options;
+   options.setShmChannels(2);
+   ShmServer server(34767, &handler, &options);
+   require(server.start(), "server should start");
+
+   ShmClient client(server.getSegmentName());
+
+   std::string heldPayload;
+   std::thread heldCaller([&client, &heldPayload]() {
+      Message request("hold", MessageTypeText);
+      std::string responseFrame;
+      bool isSent = false;
+      Message response;
+      if (client.call(request.toString(), responseFrame, isSent) &&
+          response.reconstituteFromFrame(responseFrame)) {
+         heldPayload = response.getTextPayload();
+      }
+   });
+
+   require(handler.awaitHeld(), "held request should reach the handler");
+
+   // the server's thread goes on serving while a responder is outstanding
+   Message request("echo", MessageTypeText);
+   request.setTextPayload("not held up");
+   std::string responseFrame;
+   bool isSent = false;
+   require(client.call(request.toString(), responseFrame, isSent), "an outstanding responder shouldn't stall the server");
+   Message response;
+   require(response.reconstituteFromFrame(responseFrame), "response frame should decode");
+   requireStringEquals("not held up", response.getTextPayload(), "response should carry the completed payload");
+
+   // completed from this thread, not the server's
+   require(handler.release("released"), "held responder should complete");
+   heldCaller.join();
+   requireStringEquals("released", heldPayload, "held response should be pushed once completed");
+
+   server.stop();
+}
+
+//******************************************************************************
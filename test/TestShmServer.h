@@ -0,0 +1,33 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTSHMSERVER_H
+#define TONNERRE_TESTSHMSERVER_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestShmServer : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testStartStop();
+   void testCall();
+   void testOneWay();
+   void testConcurrentCallers();
+   void testFrameTooLarge();
+   void testLargeResponse();
+   void testMessageSend();
+   void testAsyncHandler();
+
+public:
+   TestShmServer();
+
+};
+
+}
+
+#endif
@@ -0,0 +1,101 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <atomic>
+
+#include "TestThreadPoolExecutor.h"
+#include "ThreadPoolExecutor.h"
+#include "Runnable.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+namespace {
+
+// Bumps a shared counter when run and another when deleted, so tests can
+// check both that tasks ran and that the executor took ownership.
+class CountingTask : public chaudiere::Runnable {
+public:
+   CountingTask(std::atomic<int>& runCount, std::atomic<int>& deleteCount) :
+      m_runCount(runCount),
+      m_deleteCount(deleteCount) {
+   }
+
+   ~CountingTask() {
+      ++m_deleteCount;
+   }
+
+   void run() override {
+      ++m_runCount;
+   }
+
+private:
+   std::atomic<int>& m_runCount;
+   std::atomic<int>& m_deleteCount;
+};
+
+}
+
+//******************************************************************************
+
+TestThreadPoolExecutor::TestThreadPoolExecutor() :
+   poivre::TestSuite("TestThreadPoolExecutor") {
+}
+
+//******************************************************************************
+
+void TestThreadPoolExecutor::runTests() {
+   testNumberWorkers();
+   testExecute();
+   testExecuteAfterStop();
+}
+
+//******************************************************************************
+
+void TestThreadPoolExecutor::testNumberWorkers() {
+   TEST_CASE("testNumberWorkers");
+
+   ThreadPoolExecutor executor(3);
+   require(executor.getNumberWorkers() == 3, "should start the requested number of workers");
+
+   ThreadPoolExecutor minimum(0);
+   require(minimum.getNumberWorkers() == 1, "should start at least one worker");
+}
+
+//******************************************************************************
+
+void TestThreadPoolExecutor::testExecute() {
+   TEST_CASE("testExecute");
+
+   std::atomic<int> runCount(0);
+   std::atomic<int> deleteCount(0);
+
+   ThreadPoolExecutor executor(4);
+   for (int i = 0; i < 100; ++i) {
+      require(executor.execute(new CountingTask(runCount, deleteCount)), "running executor should accept tasks");
+   }
+
+   // stop drains whatever is still queued
+   executor.stop();
+   require(runCount == 100, "every accepted task should be run");
+   require(deleteCount == 100, "every task should be deleted after running");
+}
+
+//******************************************************************************
+
+void TestThreadPoolExecutor::testExecuteAfterStop() {
+   TEST_CASE("testExecuteAfterStop");
+
+   std::atomic<int> runCount(0);
+   std::atomic<int> deleteCount(0);
+
+   ThreadPoolExecutor executor(2);
+   executor.stop();
+
+   requireFalse(executor.execute(new CountingTask(runCount, deleteCount)), "stopped executor should reject tasks");
+   require(runCount == 0, "rejected task should not be run");
+   require(deleteCount == 1, "rejected task should still be deleted");
+   requireFalse(executor.execute(nullptr), "null task should be rejected");
+}
+
+//******************************************************************************
@@ -0,0 +1,29 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTTHREADPOOLEXECUTOR_H
+#define TONNERRE_TESTTHREADPOOLEXECUTOR_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestThreadPoolExecutor : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testNumberWorkers();
+   void testExecute();
+   void testExecuteAfterStop();
+
+public:
+   TestThreadPoolExecutor();
+
+};
+
+}
+
+#endif
+
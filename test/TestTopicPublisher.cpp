@@ -0,0 +1,171 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <memory>
+
+#include "TestTopicPublisher.h"
+#include "TopicPublisher.h"
+#include "TopicSubscriber.h"
+#include "InProcessRegistry.h"
+#include "Message.h"
+#include "Messaging.h"
+#include "ServerSocket.h"
+#include "ServiceInfo.h"
+#include "ServiceOptions.h"
+#include "Socket.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+//******************************************************************************
+
+TestTopicPublisher::TestTopicPublisher() :
+   poivre::TestSuite("TestTopicPublisher") {
+}
+
+//******************************************************************************
+
+void TestTopicPublisher::runTests() {
+   testSubscribe();
+   testPublishFanOut();
+   testSlowSubscriber();
+   testRemoteSubscription();
+}
+
+//******************************************************************************
+
+void TestTopicPublisher::testSubscribe() {
+   TEST_CASE("testSubscribe");
+
+   TopicPublisher publisher;
+   const ServiceInfo first("first", "127.0.0.1", 34761);
+   const ServiceInfo second("second", "127.0.0.1", 34762);
+
+   publisher.subscribe("prices", first);
+   publisher.subscribe("prices", second);
+   publisher.subscribe("prices", first);
+   publisher.subscribe("news", first);
+   require(publisher.getSubscriberCount("prices") == 2, "subscribing again should have no effect");
+   require(publisher.getSubscriberCount("news") == 1, "topics should be independent");
+   require(publisher.getSubscriberCount("weather") == 0, "unknown topic has no subscribers");
+
+   std::shared_ptr<TopicSubscriber> subscriber(publisher.getSubscriber(first));
+   require(subscriber != nullptr, "subscriber should be known");
+   require(subscriber == publisher.getSubscriber(first), "a service should keep one connection across topics");
+
+   require(publisher.unsubscribe("prices", first), "unsubscribe should succeed");
+   require(!publisher.unsubscribe("prices", first), "unsubscribing twice should fail");
+   require(publisher.getSubscriberCount("prices") == 1, "one subscriber should remain");
+   require(publisher.getSubscriber(first) != nullptr, "subscriber with a topic left should remain");
+
+   require(publisher.unsubscribe("news", first), "unsubscribe should succeed");
+   require(publisher.getSubscriber(first) == nullptr, "subscriber with no topics should be removed");
+   require(publisher.getSubscriberCount("news") == 0, "topic should have no subscribers");
+}
+
+//******************************************************************************
+
+void TestTopicPublisher::testPublishFanOut() {
+   TEST_CASE("testPublishFanOut");
+
+   const int firstPort = 34761;
+   const int secondPort = 34762;
+   ServerSocket firstListener(firstPort);
+   ServerSocket secondListener(secondPort);
+
+   const ServiceInfo first("first", "127.0.0.1", (unsigned short) firstPort);
+   const ServiceInfo second("second", "127.0.0.1", (unsigned short) secondPort);
+
+   TopicPublisher publisher;
+   publisher.subscribe("prices", first);
+   publisher.subscribe("prices", second);
+   publisher.subscribe("news", first);
+
+   Message price("tick", MessageTypeText);
+   price.setTextPayload("ACME 101.5");
+   require(publisher.publish("prices", price) == 2, "price should be queued for both subscribers");
+   require(price.isOneWay(), "published message should be one-way");
+
+   Message headline("headline", MessageTypeText);
+   headline.setTextPayload("markets open");
+   require(publisher.publish("news", headline) == 1, "headline should be queued for one subscriber");
+
+   Message nobody("ignored", MessageTypeText);
+   require(publisher.publish("weather", nobody) == 0, "topic without subscribers reaches nobody");
+
+   std::unique_ptr<Socket> firstAccepted(firstListener.accept());
+   require(firstAccepted != nullptr, "publisher should connect to the first subscriber");
+   Message received;
+   require(received.reconstitute(firstAccepted.get()), "first subscriber should read the price");
+   requireStringEquals("ACME 101.5", received.getTextPayload(), "first subscriber should see the price");
+   requireStringEquals("prices", received.getServiceName(), "message should be addressed to the topic");
+   require(received.isOneWay(), "subscriber should see a one-way message");
+   Message news;
+   require(news.reconstitute(firstAccepted.get()), "first subscriber should read the headline");
+   requireStringEquals("news", news.getServiceName(), "headline should be addressed to its topic");
+
+   std::unique_ptr<Socket> secondAccepted(secondListener.accept());
+   require(secondAccepted != nullptr, "publisher should connect to the second subscriber");
+   Message copy;
+   require(copy.reconstitute(secondAccepted.get()), "second subscriber should read the price");
+   requireStringEquals("ACME 101.5", copy.getTextPayload(), "second subscriber should see the price");
+
+   publisher.getSubscriber(second)->stop();
+   require(publisher.getSubscriber(second)->getSentCount() == 1, "second subscriber should be sent one message");
+}
+
+//******************************************************************************
+
+void TestTopicPublisher::testSlowSubscriber() {
+   TEST_CASE("testSlowSubscriber");
+
+   const int port = 34763;
+   ServiceOptions options;
+   options.setAsyncQueueSize(2);
+   options.setAsyncBackpressure(BackpressureDropOldest);
+
+   // (declared first so that the subscriber's end closes before the
+   // publisher drains)
+   TopicPublisher publisher(options);
+   ServerSocket listener(port);
+   const ServiceInfo slow("slow", "127.0.0.1", (unsigned short) port);
+   publisher.subscribe("bulk", slow);
+
+   // the subscriber never reads, so its socket buffers soon fill up and
+   // its queue overflows -- without ever holding up the publisher
+   const std::string payload(1024 * 1024, 'x');
+   for (int i = 0; i < 40; ++i) {
+      Message message("chunk", MessageTypeText);
+      message.setTextPayload(payload);
+      require(publisher.publish("bulk", message) == 1, "drop-oldest should always queue the new message");
+   }
+
+   std::unique_ptr<Socket> accepted(listener.accept());
+   require(accepted != nullptr, "publisher should connect to the subscriber");
+   require(publisher.getSubscriber(slow)->getDroppedCount() > 0, "slow subscriber should drop messages");
+}
+
+//******************************************************************************
+
+void TestTopicPublisher::testRemoteSubscription() {
+   TEST_CASE("testRemoteSubscription");
+
+   // the publisher is hosted as a service in this process, so the
+   // subscription requests reach it without a network round trip
+   Messaging::setMessaging(nullptr);
+   TopicPublisher publisher;
+   InProcessRegistry::registerService("publisher", &publisher, nullptr, nullptr);
+
+   const ServiceInfo subscriber("subscriber", "127.0.0.1", 34764);
+   require(TopicPublisher::requestSubscription("publisher", "news", subscriber), "subscription should be accepted");
+   require(publisher.getSubscriberCount("news") == 1, "publisher should record the subscription");
+   require(publisher.getSubscriber(subscriber) != nullptr, "subscriber should be known by its address");
+
+   require(TopicPublisher::requestUnsubscription("publisher", "news", subscriber), "unsubscription should be accepted");
+   require(publisher.getSubscriberCount("news") == 0, "publisher should remove the subscription");
+   require(!TopicPublisher::requestUnsubscription("publisher", "news", subscriber), "unknown subscription should be refused");
+
+   InProcessRegistry::unregisterService("publisher");
+}
+
+//******************************************************************************
@@ -0,0 +1,29 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTTOPICPUBLISHER_H
+#define TONNERRE_TESTTOPICPUBLISHER_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestTopicPublisher : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testSubscribe();
+   void testPublishFanOut();
+   void testSlowSubscriber();
+   void testRemoteSubscription();
+
+public:
+   TestTopicPublisher();
+
+};
+
+}
+
+#endif
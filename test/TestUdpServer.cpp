@@ -0,0 +1,250 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "TestUdpServer.h"
+#include "UdpServer.h"
+#include "UdpSender.h"
+#include "MessageHandler.h"
+#include "Message.h"
+#include "Messaging.h"
+#include "ServiceInfo.h"
+#include "ServiceOptions.h"
+#include "ServerMetrics.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+namespace {
+
+// Counts the messages it sees, keeping the last text payload.
+class CountingHandler : public tonnerre::MessageHandler {
+public:
+   CountingHandler() : m_count(0) {}
+
+   void handleTextMessage(const Message&,
+                          Message&,
+                          const std::string&,
+                          const std::string& requestPayload,
+                          std::string&) override {
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_lastPayload = requestPayload;
+      }
+      m_count.fetch_add(1);
+   }
+
+   void handleKeyValuesMessage(const Message&,
+                               Message&,
+                               const std::string&,
+                               const chaudiere::KeyValuePairs&,
+                               chaudiere::KeyValuePairs&) override {
+      m_count.fetch_add(1);
+   }
+
+   int getCount() const {
+      return m_count.load();
+   }
+
+   std::string getLastPayload() {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_lastPayload;
+   }
+
+   // datagrams arrive asynchronously; loopback doesn't lose them, but they
+   // take a moment
+   bool awaitCount(int count) {
+      for (int i = 0; (i < 200) && (getCount() < count); ++i) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      return getCount() >= count;
+   }
+
+private:
+   std::atomic<int> m_count;
+   std::mutex m_mutex;
+   std::string m_lastPayload;
+};
+
+}
+
+//******************************************************************************
+
+TestUdpServer::TestUdpServer() :
+   poivre::TestSuite("TestUdpServer") {
+}
+
+//******************************************************************************
+
+void TestUdpServer::runTests() {
+   testStartStop();
+   testSendAndReceive();
+   testOversizedMessage();
+   testMalformedDatagram();
+   testStatsRequestDropped();
+   testMessageSend();
+}
+
+//******************************************************************************
+
+void TestUdpServer::testStartStop() {
+   TEST_CASE("testStartStop");
+
+   CountingHandler handler;
+   UdpServer server(34757, &handler);
+   require(server.start(), "server should start");
+   server.stop();
+   server.stop();
+
+   // the port is free again once stopped
+   UdpServer restarted(34757, &handler);
+   require(restarted.start(), "server should restart on the same port");
+}
+
+//******************************************************************************
+
+void TestUdpServer::testSendAndReceive() {
+   TEST_CASE("testSendAndReceive");
+
+   const int port = 34758;
+   CountingHandler handler;
+   UdpServer server(port, &handler);
+   require(server.start(), "server should start");
+
+   ServiceOptions options;
+   UdpSender sender(ServiceInfo("udpService", "127.0.0.1", (unsigned short) port), options);
+   require(sender.isOpen(), "sender should open its socket");
+
+   const int numberMessages = 100;
+   for (int i = 0; i < numberMessages; ++i) {
+      Message event("metric", MessageTypeText);
+      event.setOneWay(true);
+      event.setTextPayload("value=" + std::to_string(i));
+      require(sender.enqueue(event.encodeForService("udpService")), "message should be queued");
+   }
+
+   require(handler.awaitCount(numberMessages), "every datagram should reach the handler");
+   require(server.getRequestCount() == (std::uint64_t) numberMessages, "server should count the messages");
+   require(server.getDroppedCount() == 0, "nothing should be dropped");
+
+   sender.stop();
+   require(sender.getSentCount() == (std::uint64_t) numberMessages, "sender should count the datagrams");
+   require(sender.getBatchCount() <= sender.getSentCount(), "datagrams should go out in batches");
+   require(!sender.enqueue("late"), "a stopped sender should refuse messages");
+}
+
+//******************************************************************************
+
+void TestUdpServer::testOversizedMessage() {
+   TEST_CASE("testOversizedMessage");
+
+   ServiceOptions options;
+   UdpSender sender(ServiceInfo("udpService", "127.0.0.1", 34759), options);
+   require(sender.isOpen(), "sender should open its socket");
+
+   const std::string oversized(UdpSender::MAX_DATAGRAM_BYTES + 1, 'x');
+   require(!sender.enqueue(oversized), "a message larger than a datagram should be refused");
+   require(sender.getDroppedCount() == 0, "a refused message isn't a dropped one");
+}
+
+//******************************************************************************
+
+void TestUdpServer::testMalformedDatagram() {
+   TEST_CASE("testMalformedDatagram");
+
+   const int port = 34759;
+   CountingHandler handler;
+   UdpServer server(port, &handler);
+   require(server.start(), "server should start");
+
+   const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+   require(fd >= 0, "raw socket should open");
+   struct sockaddr_in address;
+   ::memset(&address, 0, sizeof(address));
+   address.sin_family = AF_INET;
+   address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   address.sin_port = htons((unsigned short) port);
+   const char garbage[] = "not a tonnerre message";
+   ::sendto(fd, garbage, sizeof(garbage), 0, (struct sockaddr*) &address, sizeof(address));
+   ::close(fd);
+
+   for (int i = 0; (i < 200) && (server.getDroppedCount() == 0); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+   }
+   require(server.getDroppedCount() == 1, "malformed datagram should be dropped");
+   require(handler.getCount() == 0, "handler should not see it");
+}
+
+//******************************************************************************
+
+void TestUdpServer::testStatsRequestDropped() {
+   TEST_CASE("testStatsRequestDropped");
+
+   const int port = 34768;
+   CountingHandler handler;
+   UdpServer server(port, &handler);
+   require(server.start(), "server should start");
+
+   ServiceOptions options;
+   UdpSender sender(ServiceInfo("udpService", "127.0.0.1", (unsigned short) port), options);
+   require(sender.isOpen(), "sender should open its socket");
+
+   Message statsRequest(ServerMetrics::STATS_REQUEST_NAME, MessageTypeKeyValues);
+   statsRequest.setOneWay(true);
+   require(sender.enqueue(statsRequest.encodeForService("udpService")), "stats request should be queued");
+
+   Message event("metric", MessageTypeText);
+   event.setOneWay(true);
+   event.setTextPayload("value=1");
+   require(sender.enqueue(event.encodeForService("udpService")), "message should be queued");
+
+   require(handler.awaitCount(1), "the ordinary datagram should reach the handler");
+   for (int i = 0; (i < 200) && (server.getDroppedCount() == 0); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+   }
+   require(server.getDroppedCount() == 1, "stats datagram should be dropped");
+   require(server.getRequestCount() == 1, "only the ordinary datagram is a request");
+   requireStringEquals("value=1", handler.getLastPayload(), "handler should see the ordinary payload");
+}
+
+//******************************************************************************
+
+void TestUdpServer::testMessageSend() {
+   TEST_CASE("testMessageSend");
+
+   // nothing listens for TCP on the port, so only datagrams get through
+   const int port = 34760;
+   CountingHandler handler;
+   UdpServer server(port, &handler);
+   require(server.start(), "server should start");
+
+   Messaging* messaging = new Messaging();
+   messaging->registerService("udpService", ServiceInfo("udpService", "127.0.0.1", (unsigned short) port));
+   ServiceOptions serviceOptions;
+   serviceOptions.setTransport(TransportUdp);
+   messaging->setOptionsForService("udpService", serviceOptions);
+   Messaging::setMessaging(messaging);
+
+   Message event("oneWay", MessageTypeText);
+   event.setTextPayload("fire and forget");
+   require(event.send("udpService"), "one-way send should go as a datagram");
+   require(handler.awaitCount(1), "datagram should reach the handler");
+   requireStringEquals("fire and forget", handler.getLastPayload(), "handler should see the payload");
+
+   // only one-way messages travel as datagrams
+   Message request("twoWay", MessageTypeText);
+   Message response;
+   require(!request.send("udpService", response), "a request expecting a response should use TCP");
+
+   Messaging::setMessaging(nullptr);
+}
+
+//******************************************************************************
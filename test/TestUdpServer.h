@@ -0,0 +1,31 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTUDPSERVER_H
+#define TONNERRE_TESTUDPSERVER_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestUdpServer : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testStartStop();
+   void testSendAndReceive();
+   void testOversizedMessage();
+   void testMalformedDatagram();
+   void testStatsRequestDropped();
+   void testMessageSend();
+
+public:
+   TestUdpServer();
+
+};
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "TestUnixSocket.h"
+#include "UnixSocket.h"
+#include "MessageHandler.h"
+#include "MessageRequestHandler.h"
+#include "Message.h"
+#include "Messaging.h"
+#include "ServiceInfo.h"
+#include "Socket.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+namespace {
+
+// Echoes the request payload back as the response payload.
+class EchoMessageHandler : public tonnerre::MessageHandler {
+public:
+   void handleTextMessage(const Message&,
+                          Message&,
+                          const std::string&,
+                          const std::string& requestPayload,
+                          std::string& responsePayload) override {
+      responsePayload = requestPayload;
+   }
+
+   void handleKeyValuesMessage(const Message&,
+                               Message&,
+                               const std::string&,
+                               const chaudiere::KeyValuePairs& requestPayload,
+                               chaudiere::KeyValuePairs& responsePayload) override {
+      responsePayload = requestPayload;
+   }
+};
+
+std::string socketPath(const std::string& name) {
+   return "/tmp/tonnerre-test-" + std::to_string(::getpid()) + "-" + name + ".sock";
+}
+
+}
+
+//******************************************************************************
+
+TestUnixSocket::TestUnixSocket() :
+   poivre::TestSuite("TestUnixSocket") {
+}
+
+//******************************************************************************
+
+void TestUnixSocket::runTests() {
+   testIsUnixService();
+   testListenConnect();
+   testConnectFailure();
+   testMessageSend();
+}
+
+//******************************************************************************
+
+void TestUnixSocket::testIsUnixService() {
+   TEST_CASE("testIsUnixService");
+
+   require(UnixSocket::isUnixService(ServiceInfo("sidecar", "/run/sidecar.sock", 0)), "a path with no port should be a unix socket service");
+   requireFalse(UnixSocket::isUnixService(ServiceInfo("remote", "127.0.0.1", 9000)), "a host and port should be a TCP service");
+}
+
+//******************************************************************************
+
+void TestUnixSocket::testListenConnect() {
+   TEST_CASE("testListenConnect");
+
+   const std::string path = socketPath("listen");
+   const int listenFd = UnixSocket::listen(path);
+   require(listenFd >= 0, "listen should succeed");
+
+   std::unique_ptr<Socket> client(UnixSocket::connect(path));
+   require(client != nullptr, "connect should succeed");
+   require(client->isConnected(), "connected socket should report connected");
+
+   const int serverFd = ::accept(listenFd, nullptr, nullptr);
+   require(serverFd >= 0, "server should accept the connection");
+   Socket server(serverFd);
+
+   require(client->write("hello"), "client write should succeed");
+   char buffer[5];
+   require(server.read(buffer, sizeof(buffer)), "server read should succeed");
+   requireStringEquals("hello", std::string(buffer, sizeof(buffer)), "bytes should arrive intact");
+
+   ::close(listenFd);
+
+   // a later server replaces the stale socket file
+   const int relistenFd = UnixSocket::listen(path);
+   require(relistenFd >= 0, "listen should replace a stale socket file");
+   ::close(relistenFd);
+   ::unlink(path.c_str());
+}
+
+//******************************************************************************
+
+void TestUnixSocket::testConnectFailure() {
+   TEST_CASE("testConnectFailure");
+
+   require(UnixSocket::connect(socketPath("missing")) == nullptr, "connect to a missing socket should fail");
+   require(UnixSocket::connect("/tmp/" + std::string(200, 'x')) == nullptr, "connect to an overlong path should fail");
+   require(UnixSocket::listen("") < 0, "listen on an empty path should fail");
+}
+
+//******************************************************************************
+
+void TestUnixSocket::testMessageSend() {
+   TEST_CASE("testMessageSend");
+
+   const std::string path = socketPath("send");
+   const int listenFd = UnixSocket::listen(path);
+   require(listenFd >= 0, "listen should succeed");
+
+   EchoMessageHandler echoHandler;
+   std::thread server([listenFd, &echoHandler]() {
+      const int fd = ::accept(listenFd, nullptr, nullptr);
+      if (fd >= 0) {
+         MessageRequestHandler handler(new Socket(fd), &echoHandler);
+         handler.run();
+      }
+   });
+
+   Messaging* messaging = new Messaging();
+   messaging->registerService("sidecar", ServiceInfo("sidecar", path, 0));
+   Messaging::setMessaging(messaging);
+
+   Message request("overUnixSocket", MessageTypeText);
+   request.setTextPayload("local");
+   Message response;
+   const bool isSent = request.send("sidecar", response);
+
+   server.join();
+   require(isSent, "send should be answered over the unix socket");
+   requireStringEquals("local", response.getTextPayload(), "response should echo the request");
+
+   Messaging::setMessaging(nullptr);
+   ::close(listenFd);
+   ::unlink(path.c_str());
+}
+
+//******************************************************************************
@@ -0,0 +1,29 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTUNIXSOCKET_H
+#define TONNERRE_TESTUNIXSOCKET_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestUnixSocket : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testIsUnixService();
+   void testListenConnect();
+   void testConnectFailure();
+   void testMessageSend();
+
+public:
+   TestUnixSocket();
+
+};
+
+}
+
+#endif
@@ -0,0 +1,149 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "TestWorkStealingDeque.h"
+#include "WorkStealingDeque.h"
+
+using namespace tonnerre;
+
+//******************************************************************************
+
+TestWorkStealingDeque::TestWorkStealingDeque() :
+   poivre::TestSuite("TestWorkStealingDeque") {
+}
+
+//******************************************************************************
+
+void TestWorkStealingDeque::runTests() {
+   testPushPop();
+   testSteal();
+   testCapacity();
+   testConcurrentSteal();
+}
+
+//******************************************************************************
+
+void TestWorkStealingDeque::testPushPop() {
+   TEST_CASE("testPushPop");
+
+   WorkStealingDeque<int> deque(8);
+   require(deque.empty(), "new deque should be empty");
+
+   int value = 0;
+   requireFalse(deque.pop(value), "pop from empty deque should fail");
+
+   require(deque.push(1), "push should succeed");
+   require(deque.push(2), "push should succeed");
+   require(deque.push(3), "push should succeed");
+   require(deque.sizeApprox() == 3, "size should reflect pushes");
+
+   require(deque.pop(value) && value == 3, "owner pops the newest entry first");
+   require(deque.pop(value) && value == 2, "owner pops the newest entry first");
+   require(deque.pop(value) && value == 1, "owner pops the newest entry first");
+   requireFalse(deque.pop(value), "deque should be empty again");
+   require(deque.empty(), "deque should be empty again");
+}
+
+//******************************************************************************
+
+void TestWorkStealingDeque::testSteal() {
+   TEST_CASE("testSteal");
+
+   WorkStealingDeque<int> deque(8);
+   int value = 0;
+   requireFalse(deque.steal(value), "steal from empty deque should fail");
+
+   deque.push(1);
+   deque.push(2);
+   deque.push(3);
+
+   require(deque.steal(value) && value == 1, "thieves take the oldest entry");
+   require(deque.pop(value) && value == 3, "owner still takes the newest entry");
+   require(deque.steal(value) && value == 2, "thieves take the oldest entry");
+   requireFalse(deque.steal(value), "deque should be empty");
+}
+
+//******************************************************************************
+
+void TestWorkStealingDeque::testCapacity() {
+   TEST_CASE("testCapacity");
+
+   WorkStealingDeque<int> deque(5);
+   require(deque.capacity() == 8, "capacity should round up to a power of 2");
+
+   for (int i = 0; i < 8; ++i) {
+      require(deque.push(i), "push within capacity should succeed");
+   }
+   requireFalse(deque.push(8), "push into a full deque should fail");
+
+   int value = 0;
+   require(deque.steal(value), "steal should make room");
+   require(deque.push(8), "push should succeed once there's room");
+
+   // wrap around the ring several times
+   for (int i = 0; i < 100; ++i) {
+      require(deque.pop(value), "pop should succeed");
+      require(deque.push(value), "push should succeed");
+   }
+   require(deque.sizeApprox() == 8, "size should be unchanged by pop/push pairs");
+}
+
+//******************************************************************************
+
+void TestWorkStealingDeque::testConcurrentSteal() {
+   TEST_CASE("testConcurrentSteal");
+
+   const int numberItems = 20000;
+   const int numberThieves = 3;
+
+   WorkStealingDeque<int> deque(numberItems);
+   std::vector<std::atomic<int>> taken(numberItems);
+   for (auto& count : taken) {
+      count.store(0);
+   }
+
+   std::atomic<bool> ownerDone(false);
+   std::vector<std::thread> thieves;
+   for (int i = 0; i < numberThieves; ++i) {
+      thieves.emplace_back([&deque, &taken, &ownerDone]() {
+         int value = 0;
+         while (!ownerDone.load() || !deque.empty()) {
+            if (deque.steal(value)) {
+               ++taken[value];
+            }
+         }
+      });
+   }
+
+   // the owner pushes everything and pops some of it back, racing the
+   // thieves for the last entries
+   int value = 0;
+   for (int i = 0; i < numberItems; ++i) {
+      deque.push(i);
+      if ((i % 3) == 0 && deque.pop(value)) {
+         ++taken[value];
+      }
+   }
+   while (deque.pop(value)) {
+      ++taken[value];
+   }
+   ownerDone.store(true);
+
+   for (auto& thief : thieves) {
+      thief.join();
+   }
+
+   bool eachTakenOnce = true;
+   for (auto& count : taken) {
+      if (count.load() != 1) {
+         eachTakenOnce = false;
+      }
+   }
+   require(eachTakenOnce, "every entry should be taken exactly once");
+}
+
+//******************************************************************************
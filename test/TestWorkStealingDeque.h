@@ -0,0 +1,30 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTWORKSTEALINGDEQUE_H
+#define TONNERRE_TESTWORKSTEALINGDEQUE_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestWorkStealingDeque : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testPushPop();
+   void testSteal();
+   void testCapacity();
+   void testConcurrentSteal();
+
+public:
+   TestWorkStealingDeque();
+
+};
+
+}
+
+#endif
+
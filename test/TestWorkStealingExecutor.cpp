@@ -0,0 +1,149 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#include <atomic>
+
+#include "TestWorkStealingExecutor.h"
+#include "WorkStealingExecutor.h"
+#include "Runnable.h"
+
+using namespace tonnerre;
+using namespace chaudiere;
+
+namespace {
+
+// Bumps a shared counter when run and another when deleted, so tests can
+// check both that tasks ran and that the executor took ownership.
+class CountingTask : public chaudiere::Runnable {
+public:
+   CountingTask(std::atomic<int>& runCount, std::atomic<int>& deleteCount) :
+      m_runCount(runCount),
+      m_deleteCount(deleteCount) {
+   }
+
+   ~CountingTask() {
+      ++m_deleteCount;
+   }
+
+   void run() override {
+      ++m_runCount;
+   }
+
+private:
+   std::atomic<int>& m_runCount;
+   std::atomic<int>& m_deleteCount;
+};
+
+// Queues a number of CountingTasks from within the executor, which puts
+// them on the running worker's own deque for the others to steal.
+class SpawningTask : public chaudiere::Runnable {
+public:
+   SpawningTask(WorkStealingExecutor& executor,
+                int numberChildren,
+                std::atomic<int>& runCount,
+                std::atomic<int>& deleteCount) :
+      m_executor(executor),
+      m_numberChildren(numberChildren),
+      m_runCount(runCount),
+      m_deleteCount(deleteCount) {
+   }
+
+   void run() override {
+      for (int i = 0; i < m_numberChildren; ++i) {
+         m_executor.execute(new CountingTask(m_runCount, m_deleteCount));
+      }
+   }
+
+private:
+   WorkStealingExecutor& m_executor;
+   int m_numberChildren;
+   std::atomic<int>& m_runCount;
+   std::atomic<int>& m_deleteCount;
+};
+
+}
+
+//******************************************************************************
+
+TestWorkStealingExecutor::TestWorkStealingExecutor() :
+   poivre::TestSuite("TestWorkStealingExecutor") {
+}
+
+//******************************************************************************
+
+void TestWorkStealingExecutor::runTests() {
+   testNumberWorkers();
+   testExecute();
+   testExecuteFromTask();
+   testExecuteAfterStop();
+}
+
+//******************************************************************************
+
+void TestWorkStealingExecutor::testNumberWorkers() {
+   TEST_CASE("testNumberWorkers");
+
+   WorkStealingExecutor executor(3);
+   require(executor.getNumberWorkers() == 3, "should start the requested number of workers");
+
+   WorkStealingExecutor minimum(0);
+   require(minimum.getNumberWorkers() == 1, "should start at least one worker");
+}
+
+//******************************************************************************
+
+void TestWorkStealingExecutor::testExecute() {
+   TEST_CASE("testExecute");
+
+   std::atomic<int> runCount(0);
+   std::atomic<int> deleteCount(0);
+
+   // a small injection queue makes the submitter wait for the workers
+   WorkStealingExecutor executor(4, 16, 16);
+   for (int i = 0; i < 1000; ++i) {
+      require(executor.execute(new CountingTask(runCount, deleteCount)), "running executor should accept tasks");
+   }
+
+   // stop drains whatever is still queued
+   executor.stop();
+   require(runCount == 1000, "every accepted task should be run");
+   require(deleteCount == 1000, "every task should be deleted after running");
+}
+
+//******************************************************************************
+
+void TestWorkStealingExecutor::testExecuteFromTask() {
+   TEST_CASE("testExecuteFromTask");
+
+   std::atomic<int> runCount(0);
+   std::atomic<int> deleteCount(0);
+
+   // more children than a deque holds, so some overflow to the injection queue
+   WorkStealingExecutor executor(4, 64);
+   for (int i = 0; i < 10; ++i) {
+      executor.execute(new SpawningTask(executor, 100, runCount, deleteCount));
+   }
+
+   executor.stop();
+   require(runCount == 1000, "tasks queued from tasks should all be run");
+   require(deleteCount == 1000, "tasks queued from tasks should all be deleted");
+}
+
+//******************************************************************************
+
+void TestWorkStealingExecutor::testExecuteAfterStop() {
+   TEST_CASE("testExecuteAfterStop");
+
+   std::atomic<int> runCount(0);
+   std::atomic<int> deleteCount(0);
+
+   WorkStealingExecutor executor(2);
+   executor.stop();
+
+   requireFalse(executor.execute(new CountingTask(runCount, deleteCount)), "stopped executor should reject tasks");
+   require(runCount == 0, "rejected task should not be run");
+   require(deleteCount == 1, "rejected task should still be deleted");
+   requireFalse(executor.execute(nullptr), "null task should be rejected");
+}
+
+//******************************************************************************
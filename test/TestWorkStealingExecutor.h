@@ -0,0 +1,30 @@
+// Copyright Paul Dardeau, SwampBits LLC 2014
+// BSD License
+
+#ifndef TONNERRE_TESTWORKSTEALINGEXECUTOR_H
+#define TONNERRE_TESTWORKSTEALINGEXECUTOR_H
+
+#include "TestSuite.h"
+
+
+namespace tonnerre {
+
+class TestWorkStealingExecutor : public poivre::TestSuite {
+
+protected:
+   void runTests();
+
+   void testNumberWorkers();
+   void testExecute();
+   void testExecuteFromTask();
+   void testExecuteAfterStop();
+
+public:
+   TestWorkStealingExecutor();
+
+};
+
+}
+
+#endif
+
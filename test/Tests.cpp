@@ -7,6 +7,35 @@
 #include "TestMessage.h"
 #include "TestMessageRequestHandler.h"
 #include "TestMessageSocketServiceHandler.h"
+#include "TestRequestCoalescer.h"
+#include "TestBoundedQueue.h"
+#include "TestServiceOptions.h"
+#include "TestBatchingSender.h"
+#include "TestAsyncWriter.h"
+#include "TestServerOptions.h"
+#include "TestThreadPoolExecutor.h"
+#include "TestWorkStealingDeque.h"
+#include "TestWorkStealingExecutor.h"
+#include "TestServerShard.h"
+#include "TestIoUringServer.h"
+#include "TestAdmissionController.h"
+#include "TestPriorityExecutor.h"
+#include "TestLatencyHistogram.h"
+#include "TestServerMetrics.h"
+#include "TestRequestTrace.h"
+#include "TestLogRateLimiter.h"
+#include "TestAsyncLogSink.h"
+#include "TestShmRing.h"
+#include "TestShmServer.h"
+#include "TestUnixSocket.h"
+#include "TestInProcessRegistry.h"
+#include "TestUdpServer.h"
+#include "TestTopicPublisher.h"
+#include "TestIdleConnectionMonitor.h"
+#include "TestServiceDispatcher.h"
+#include "TestMessageRouter.h"
+#include "TestResponder.h"
+#include "TestCoroutineMessageHandler.h"
 
 using namespace tonnerre;
 
@@ -27,6 +56,35 @@ void run_tests() {
    run_test(new TestMessage);
    run_test(new TestMessageRequestHandler);
    run_test(new TestMessageSocketServiceHandler);
+   run_test(new TestRequestCoalescer);
+   run_test(new TestBoundedQueue);
+   run_test(new TestServiceOptions);
+   run_test(new TestBatchingSender);
+   run_test(new TestAsyncWriter);
+   run_test(new TestServerOptions);
+   run_test(new TestThreadPoolExecutor);
+   run_test(new TestWorkStealingDeque);
+   run_test(new TestWorkStealingExecutor);
+   run_test(new TestIdleConnectionMonitor);
+   run_test(new TestServiceDispatcher);
+   run_test(new TestMessageRouter);
+   run_test(new TestResponder);
+   run_test(new TestCoroutineMessageHandler);
+   run_test(new TestServerShard);
+   run_test(new TestIoUringServer);
+   run_test(new TestAdmissionController);
+   run_test(new TestPriorityExecutor);
+   run_test(new TestLatencyHistogram);
+   run_test(new TestServerMetrics);
+   run_test(new TestRequestTrace);
+   run_test(new TestLogRateLimiter);
+   run_test(new TestAsyncLogSink);
+   run_test(new TestShmRing);
+   run_test(new TestShmServer);
+   run_test(new TestUnixSocket);
+   run_test(new TestInProcessRegistry);
+   run_test(new TestUdpServer);
+   run_test(new TestTopicPublisher);
 }
 
 //******************************************************************************